@@ -8,73 +8,220 @@ LICENSE file in the root directory of this source tree.
 
 #include "AnimNode_OculusXRBodyTracking.h"
 #include "OculusXRAnimNodeBodyRetargeter.h"
-#include "OculusXRMovement.h"
 #include "OculusXRRetargeting.h"
+#include "OculusXRRetargetBudgetManager.h"
+#include "Animation/AnimInstance.h"
 #include "Animation/AnimInstanceProxy.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "OculusXRRetargetingUtils.h"
 #include "DrawDebugHelpers.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Body Retargeting"), STAT_OculusXRBodyRetargeting, STATGROUP_OculusXRMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Body Evaluations - Retargeted"), STAT_OculusXRBodyEvaluationsRetargeted, STATGROUP_OculusXRMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Body Evaluations - Interpolated"), STAT_OculusXRBodyEvaluationsInterpolated, STATGROUP_OculusXRMovement);
 
 void FAnimNode_OculusXRBodyTracking::Initialize_AnyThread(const FAnimationInitializeContext& Context)
 {
 	InputPose.Initialize(Context);
 
-	// This animation node is executed during the packaging step.
-	// During that time, the MetaXR plugin is not available and any calls to it will crash the editor,
-	// preventing the packaging process from completing.
-	// To avoid this, we check if the plugin is available before calling any of its functions.
-	if (!GEngine || !GEngine->XRSystem.IsValid())
+	if (!RetargeterInstance)
 	{
-		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("XR tracking is not loaded and available. Cannot retarget body at this time."));
-		return;
+		RetargeterInstance = FOculusXRBodyRetargeter::Create();
 	}
 
-	SkeletalMeshComponent = Context.AnimInstanceProxy->GetSkelMeshComponent();
+	// Force the retargeter to pick up the current configuration, even if nothing changed since the last initialization
+	AppliedConfigGeneration = INDEX_NONE;
+	FramesSinceRetarget = INDEX_NONE;
+}
 
-	if (SkeletalMeshComponent == nullptr)
-		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("SkeletalMeshComponent is null"))
+void FAnimNode_OculusXRBodyTracking::CacheBones_AnyThread(const FAnimationCacheBonesContext& Context)
+{
+	InputPose.CacheBones(Context);
 
-	if (!FOculusXRRetargetingUtils::GetUnitScaleFactorFromSettings(SkeletalMeshComponent->GetWorld(), Scale))
+	if (RetargeterInstance)
 	{
-		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Cannot get world settings for body retargetting asset."));
+		ApplyConfig(GetActiveConfig());
 	}
 }
 
-void FAnimNode_OculusXRBodyTracking::PreUpdate(const UAnimInstance* InAnimInstance) {}
+const TMap<EOculusXRBoneID, FName>& FAnimNode_OculusXRBodyTracking::GetBoneRemapping() const
+{
+	if (RemapAsset && !RemapAsset->BoneRemapping.IsEmpty())
+	{
+		return RemapAsset->BoneRemapping;
+	}
+	return BoneRemapping.IsEmpty() ? UOculusXRBodyRemapAsset::GetDefaultBoneRemapping() : BoneRemapping;
+}
 
-void FAnimNode_OculusXRBodyTracking::Evaluate_AnyThread(FPoseContext& Output)
+void FAnimNode_OculusXRBodyTracking::PreUpdate(const UAnimInstance* InAnimInstance)
 {
-	InputPose.Evaluate(Output);
+	const int32 CurrentIndex = FPlatformAtomics::AtomicRead(&ActiveConfigIndex);
+	const FNodeConfig& CurrentConfig = Configs[CurrentIndex];
+	FNodeConfig& PendingConfig = Configs[1 - CurrentIndex];
+
+	PendingConfig.RetargetingMode = RetargetingMode;
+	PendingConfig.RootMotionBehavior = RootMotionBehavior;
+	PendingConfig.ForwardMesh = ForwardMesh;
+	PendingConfig.UnmappedSubtreeMode = UnmappedSubtreeMode;
+	PendingConfig.RetargetedRegions = static_cast<EOculusXRBodyRegion>(RetargetedRegions) & EOculusXRBodyRegion::All;
+	PendingConfig.DebugPoseMode = DebugPoseMode;
+	PendingConfig.DebugDrawMode = DebugDrawMode;
+	PendingConfig.bSkipOverriddenInputPose = bSkipOverriddenInputPose;
+	const TMap<EOculusXRBoneID, FName>& BoneRemappingSource = GetBoneRemapping();
+	const uint32 BoneRemappingChangeCount = RemapAsset ? RemapAsset->GetChangeCount() : 0;
+	const bool bBoneRemappingChanged = !CurrentConfig.BoneRemapping
+		|| CurrentConfig.BoneRemappingSource != &BoneRemappingSource
+		|| CurrentConfig.BoneRemappingChangeCount != BoneRemappingChangeCount;
+	PendingConfig.BoneRemapping = bBoneRemappingChanged ? MakeShared<const TMap<EOculusXRBoneID, FName>>(BoneRemappingSource) : CurrentConfig.BoneRemapping;
+	PendingConfig.BoneRemappingSource = &BoneRemappingSource;
+	PendingConfig.BoneRemappingChangeCount = BoneRemappingChangeCount;
+	PendingConfig.WorldScale = CurrentConfig.WorldScale;
+
 	// This animation node is executed during the packaging step.
 	// During that time, the MetaXR plugin is not available and any calls to it will crash the editor,
 	// preventing the packaging process from completing.
 	// To avoid this, we check if the plugin is available before calling any of its functions.
-	if (!GEngine || !GEngine->XRSystem.IsValid())
+	// Recorded or synthetic providers stand in for the platform when there is no XR system.
+	const USkeletalMeshComponent* SkeletalMeshComponent = InAnimInstance ? InAnimInstance->GetSkelMeshComponent() : nullptr;
+	PendingConfig.DataProvider = FOculusXRMovementDataProviderRegistry::FindProvider(SkeletalMeshComponent);
+	const bool bIsTrackingAvailable = PendingConfig.DataProvider->IsAvailable();
+	if (!bIsTrackingAvailable && CurrentConfig.bIsTrackingAvailable)
 	{
 		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("XR tracking is not loaded and available. Cannot retarget body at this time."));
+	}
+
+	if (SkeletalMeshComponent)
+	{
+		PendingConfig.ComponentTransform = SkeletalMeshComponent->GetComponentTransform();
+		PendingConfig.bIsGameWorld = SkeletalMeshComponent->GetWorld() && SkeletalMeshComponent->GetWorld()->IsGameWorld();
+		if (!FOculusXRRetargetingUtils::GetUnitScaleFactorFromSettings(SkeletalMeshComponent->GetWorld(), PendingConfig.WorldScale))
+		{
+			UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Cannot get world settings for body retargetting asset."));
+		}
+	}
+	PendingConfig.bIsTrackingAvailable = bIsTrackingAvailable && SkeletalMeshComponent != nullptr;
+
+	PendingConfig.FidelityTier = FidelityTier;
+	PendingConfig.EvaluationRateDivisor = FMath::Max(EvaluationRateDivisor, 1);
+	PendingConfig.bUseRetargetBudget = bUseRetargetBudget && PendingConfig.bIsTrackingAvailable && PendingConfig.bIsGameWorld;
+	if (PendingConfig.bUseRetargetBudget)
+	{
+		if (BudgetAvatarId == 0)
+		{
+			BudgetAvatarId = FOculusXRRetargetBudgetManager::AllocateAvatarId();
+		}
+		bool bIsLocallyControlled = false;
+		const float Significance = FOculusXRRetargetBudgetManager::ComputeSignificance(SkeletalMeshComponent, bIsLocallyControlled);
+		PendingConfig.FidelityTier = FOculusXRRetargetBudgetManager::Get().RequestTier(BudgetAvatarId, Significance, bIsLocallyControlled, FidelityTier);
+		if (!bIsLocallyControlled)
+		{
+			PendingConfig.EvaluationRateDivisor = FMath::Max(PendingConfig.EvaluationRateDivisor, FOculusXRRetargetBudgetManager::GetEvaluationRateDivisorForSignificance(Significance));
+		}
+	}
+	// The Frozen tier holds a single pose, there is nothing to interpolate
+	if (PendingConfig.FidelityTier == EOculusXRBodyFidelityTier::Frozen)
+	{
+		PendingConfig.EvaluationRateDivisor = 1;
+	}
+
+	PendingConfig.Generation = CurrentConfig.Generation + (PendingConfig.RequiresReinitialization(CurrentConfig) ? 1 : 0);
+
+	// Publish - evaluation only ever reads the active entry
+	FPlatformAtomics::InterlockedExchange(&ActiveConfigIndex, 1 - CurrentIndex);
+}
+
+void FAnimNode_OculusXRBodyTracking::ApplyConfig(const FNodeConfig& Config)
+{
+	// Nothing to apply before the first PreUpdate, evaluation passes the input pose through until then
+	if (AppliedConfigGeneration != Config.Generation && Config.BoneRemapping)
+	{
+		AppliedBoneRemapping = Config.BoneRemapping;
+		RetargeterInstance->Initialize(Config.RetargetingMode, Config.RootMotionBehavior, Config.ForwardMesh, AppliedBoneRemapping.Get());
+		RetargeterInstance->SetUnmappedSubtreeMode(Config.UnmappedSubtreeMode);
+		RetargeterInstance->SetRetargetedRegions(Config.RetargetedRegions);
+		RetargeterInstance->SetDebugPoseMode(Config.DebugPoseMode);
+		RetargeterInstance->SetDebugDrawMode(Config.DebugDrawMode);
+		AppliedConfigGeneration = Config.Generation;
+	}
+}
+
+void FAnimNode_OculusXRBodyTracking::Evaluate_AnyThread(FPoseContext& Output)
+{
+	// Everything used below was gathered on the game thread in PreUpdate - no UObject access from here on
+	const FNodeConfig& Config = GetActiveConfig();
+	if (!Config.bIsTrackingAvailable || !RetargeterInstance)
+	{
+		InputPose.Evaluate(Output);
 		return;
 	}
 
-	FOculusXRBodyState BodyState;
-	OculusXRMovement::GetBodyState(BodyState, Scale);
+	// The retargeter is set up in CacheBones and Update, a config published after the update waits for the next one
+	if (AppliedConfigGeneration != Config.Generation || AppliedDataProvider != Config.DataProvider.Get())
+	{
+		InputPose.Evaluate(Output);
+		return;
+	}
 
-	if (!RetargeterInstance)
+	// When the whole skeleton is retargeted, the upstream bones would be entirely overwritten - skip the graph if allowed to
+	const bool bSkipInputPose = Config.SkipsInputPose();
+	if (bSkipInputPose)
+	{
+		Output.ResetToRefPose();
+	}
+	else
+	{
+		InputPose.Evaluate(Output);
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_OculusXRBodyRetargeting);
+
+	// Reduced rate - blend the cached poses in between retargeted frames
+	const int32 Divisor = Config.EvaluationRateDivisor;
+	if (Divisor > 1 && FramesSinceRetarget > 0 && FramesSinceRetarget < Divisor)
 	{
-		RetargeterInstance = TSharedPtr<FOculusXRBodyRetargeter>(reinterpret_cast<FOculusXRBodyRetargeter*>(new FOculusXRAnimNodeBodyRetargeter()));
-		RetargeterInstance->Initialize(RetargetingMode, RootMotionBehavior, ForwardMesh, &BoneRemapping);
+		if (RetargeterInstance->BlendCachedFrames(static_cast<float>(FramesSinceRetarget) / Divisor, Output.Pose))
+		{
+			++FramesSinceRetarget;
+			INC_DWORD_STAT(STAT_OculusXRBodyEvaluationsInterpolated);
+			return;
+		}
 	}
-	if (RetargetingMode != RetargeterInstance->GetRetargetingMode() || RootMotionBehavior != RetargeterInstance->GetRootMotionBehavior())
+
+	const uint64 StartCycles = Config.bUseRetargetBudget ? FPlatformTime::Cycles64() : 0;
+
+	FOculusXRBodyState BodyState;
+	Config.DataProvider->GetBodyState(BodyState, Config.WorldScale);
+
+	if (RetargeterInstance->RetargetFromBodyState(BodyState, Config.ComponentTransform, Config.WorldScale, Output.Pose))
 	{
-		RetargeterInstance->Initialize(RetargetingMode, RootMotionBehavior, ForwardMesh, &BoneRemapping);
+		INC_DWORD_STAT(STAT_OculusXRBodyEvaluationsRetargeted);
+		FramesSinceRetarget = 1;
+		if (Divisor > 1)
+		{
+			// Output lags one retargeted frame behind so the following frames can blend towards the newest pose
+			RetargeterInstance->BlendCachedFrames(0.0f, Output.Pose);
+		}
 	}
-	if (!RetargeterInstance->RetargetFromBodyState(BodyState, SkeletalMeshComponent, Scale, Output))
+	else
 	{
-		if (SkeletalMeshComponent && SkeletalMeshComponent->GetWorld()->IsGameWorld())
+		FramesSinceRetarget = INDEX_NONE;
+		if (bSkipInputPose)
+		{
+			// Nothing was retargeted, fall back to the input
+			InputPose.Evaluate(Output);
+		}
+		if (Config.bIsGameWorld)
 		{
 			UE_LOG(LogOculusXRRetargeting, Warning, TEXT("No valid delta rotations or skeletons"));
 		}
 	}
-	RetargeterInstance->SetDebugPoseMode(DebugPoseMode);
-	RetargeterInstance->SetDebugDrawMode(DebugDrawMode);
+
+	if (Config.bUseRetargetBudget)
+	{
+		// The budget charges every avatar each frame, a retarget serves Divisor frames
+		FOculusXRRetargetBudgetManager::Get().ReportCost(Config.FidelityTier, FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) / Divisor);
+	}
 }
 
 void FAnimNode_OculusXRBodyTracking::Update_AnyThread(const FAnimationUpdateContext& Context)
@@ -82,4 +229,17 @@ void FAnimNode_OculusXRBodyTracking::Update_AnyThread(const FAnimationUpdateCont
 	InputPose.Update(Context);
 	// Evaluate pin inputs
 	GetEvaluateGraphExposedInputs().Execute(Context);
+
+	// Setup for the config PreUpdate staged, so evaluation only retargets
+	const FNodeConfig& Config = GetActiveConfig();
+	if (RetargeterInstance && Config.bIsTrackingAvailable)
+	{
+		ApplyConfig(Config);
+		RetargeterInstance->SetFidelityTier(Config.FidelityTier);
+		if (AppliedDataProvider != Config.DataProvider.Get())
+		{
+			RetargeterInstance->SetDataProvider(Config.DataProvider);
+			AppliedDataProvider = Config.DataProvider.Get();
+		}
+	}
 }
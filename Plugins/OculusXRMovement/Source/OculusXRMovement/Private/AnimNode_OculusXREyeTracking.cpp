@@ -7,8 +7,8 @@ LICENSE file in the root directory of this source tree.
 */
 
 #include "AnimNode_OculusXREyeTracking.h"
-#include "OculusXRMovement.h"
 #include "OculusXRRetargeting.h"
+#include "Animation/AnimInstance.h"
 #include "Animation/AnimInstanceProxy.h"
 #include "OculusXRRetargetingUtils.h"
 
@@ -16,18 +16,14 @@ void FAnimNode_OculusXREyeTracking::Initialize_AnyThread(const FAnimationInitial
 {
 	InputPose.Initialize(Context);
 
-	// This animation node is executed during the packaging step.
-	// During that time, the MetaXR plugin is not available and any calls to it will crash the editor,
-	// preventing the packaging process from completing.
-	// To avoid this, we check if the plugin is available before calling any of its functions.
-	if (!GEngine || !GEngine->XRSystem.IsValid())
-	{
-		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("XR tracking is not loaded and available. Cannot retarget body at this time."));
-		return;
-	}
+	CompiledGazeFilter.Reset(bFilterGaze ? 8 : 0, GazeFilter);
+	bHasFilteredGazes = false;
 }
 
-void FAnimNode_OculusXREyeTracking::PreUpdate(const UAnimInstance* InAnimInstance) {}
+void FAnimNode_OculusXREyeTracking::PreUpdate(const UAnimInstance* InAnimInstance)
+{
+	DataProvider = FOculusXRMovementDataProviderRegistry::FindProvider(InAnimInstance ? InAnimInstance->GetSkelMeshComponent() : nullptr);
+}
 
 void FAnimNode_OculusXREyeTracking::Evaluate_AnyThread(FPoseContext& Output)
 {
@@ -39,8 +35,8 @@ void FAnimNode_OculusXREyeTracking::Evaluate_AnyThread(FPoseContext& Output)
 	// This animation node is executed during the packaging step.
 	// During that time, the MetaXR plugin is not available and any calls to it will crash the editor,
 	// preventing the packaging process from completing.
-	// To avoid this, we check if the plugin is available before calling any of its functions.
-	if (!GEngine || !GEngine->XRSystem.IsValid())
+	// To avoid this, we check if the provider is available before calling any of its functions.
+	if (!DataProvider || !DataProvider->IsAvailable())
 	{
 		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("XR tracking is not loaded and available. Cannot retarget body at this time."));
 		return;
@@ -52,7 +48,14 @@ void FAnimNode_OculusXREyeTracking::Evaluate_AnyThread(FPoseContext& Output)
 		RecalculateInitialRotations(BoneContainer);
 
 	FOculusXREyeGazesState GazesState;
-	OculusXRMovement::GetEyeGazesState(GazesState);
+	// Only the gaze orientations are used, the world scale doesn't matter
+	if (!DataProvider->GetEyeGazesState(GazesState, 100.0f) || GazesState.EyeGazes.Num() < 2)
+	{
+		return;
+	}
+
+	FQuat Gazes[2];
+	FilterGazes(GazesState, Gazes);
 
 	// Left eye
 
@@ -63,7 +66,7 @@ void FAnimNode_OculusXREyeTracking::Evaluate_AnyThread(FPoseContext& Output)
 		FCompactPoseBoneIndex LeftEyeId = BoneContainer.MakeCompactPoseIndex(FMeshPoseBoneIndex(LeftEyeIndex));
 
 		FTransform CurrentTransform = MeshPoses.GetComponentSpaceTransform(LeftEyeId);
-		FTransform GazeTransform = FTransform(GazesState.EyeGazes[0].Orientation, FVector::ZeroVector);
+		FTransform GazeTransform = FTransform(Gazes[0], FVector::ZeroVector);
 
 		CurrentTransform.SetRotation(GazeTransform.GetRotation() * InitialLeftRotation);
 		MeshPoses.SetComponentSpaceTransform(LeftEyeId, CurrentTransform);
@@ -78,7 +81,7 @@ void FAnimNode_OculusXREyeTracking::Evaluate_AnyThread(FPoseContext& Output)
 		FCompactPoseBoneIndex RightEyeId = BoneContainer.MakeCompactPoseIndex(FMeshPoseBoneIndex(RightEyeIndex));
 
 		FTransform CurrentTransform = MeshPoses.GetComponentSpaceTransform(RightEyeId);
-		FTransform GazeTransform = FTransform(GazesState.EyeGazes[1].Orientation, FVector::ZeroVector);
+		FTransform GazeTransform = FTransform(Gazes[1], FVector::ZeroVector);
 
 		CurrentTransform.SetRotation(GazeTransform.GetRotation() * InitialRightRotation);
 		MeshPoses.SetComponentSpaceTransform(RightEyeId, CurrentTransform);
@@ -90,6 +93,54 @@ void FAnimNode_OculusXREyeTracking::Evaluate_AnyThread(FPoseContext& Output)
 void FAnimNode_OculusXREyeTracking::Update_AnyThread(const FAnimationUpdateContext& Context)
 {
 	InputPose.Update(Context);
+	PendingDeltaTime += Context.GetDeltaTime();
+}
+
+void FAnimNode_OculusXREyeTracking::FilterGazes(const FOculusXREyeGazesState& GazesState, FQuat OutGazes[2])
+{
+	OutGazes[0] = FQuat(GazesState.EyeGazes[0].Orientation);
+	OutGazes[1] = FQuat(GazesState.EyeGazes[1].Orientation);
+	if (CompiledGazeFilter.GetNumChannels() == 0)
+	{
+		return;
+	}
+
+	// Same sample as the last evaluation, stepping the filter again would count its time twice.
+	// Providers without sample times leave them at zero, their samples are stepped by the frame time instead.
+	const bool bHasSampleTimes = GazesState.Time != 0.0f;
+	if (bHasFilteredGazes && bHasSampleTimes && GazesState.Time == LastGazeTime)
+	{
+		OutGazes[0] = FQuat(FilteredGazes[0]);
+		OutGazes[1] = FQuat(FilteredGazes[1]);
+		return;
+	}
+
+	// Quaternions are filtered component wise, on the hemisphere of the previous output so q and -q don't average out
+	float Channels[8];
+	for (int32 Eye = 0; Eye < 2; ++Eye)
+	{
+		FQuat4f Gaze(OutGazes[Eye]);
+		if ((Gaze | FilteredGazes[Eye]) < 0.0f)
+		{
+			Gaze = -Gaze;
+		}
+		Channels[Eye * 4 + 0] = Gaze.X;
+		Channels[Eye * 4 + 1] = Gaze.Y;
+		Channels[Eye * 4 + 2] = Gaze.Z;
+		Channels[Eye * 4 + 3] = Gaze.W;
+	}
+
+	const float SampleDeltaTime = GazesState.Time - LastGazeTime;
+	CompiledGazeFilter.Apply(Channels, Channels, SampleDeltaTime > 0.0f && SampleDeltaTime < 1.0f ? SampleDeltaTime : PendingDeltaTime);
+	LastGazeTime = GazesState.Time;
+	PendingDeltaTime = 0.0f;
+	bHasFilteredGazes = true;
+
+	for (int32 Eye = 0; Eye < 2; ++Eye)
+	{
+		FilteredGazes[Eye] = FQuat4f(Channels[Eye * 4 + 0], Channels[Eye * 4 + 1], Channels[Eye * 4 + 2], Channels[Eye * 4 + 3]).GetNormalized();
+		OutGazes[Eye] = FQuat(FilteredGazes[Eye]);
+	}
 }
 
 void FAnimNode_OculusXREyeTracking::RecalculateInitialRotations(FBoneContainer BoneContainer)
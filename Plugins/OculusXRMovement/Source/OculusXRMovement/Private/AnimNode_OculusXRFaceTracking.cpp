@@ -7,29 +7,164 @@ LICENSE file in the root directory of this source tree.
 */
 
 #include "AnimNode_OculusXRFaceTracking.h"
-#include "OculusXRMovement.h"
 #include "OculusXRRetargeting.h"
+#include "Animation/AnimInstance.h"
 #include "Animation/AnimInstanceProxy.h"
+#include "Animation/AnimCurveUtils.h"
+#include "Animation/MorphTarget.h"
+#include "Animation/Skeleton.h"
+#include "Engine/SkeletalMesh.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/ObjectKey.h"
 #include "OculusXRRetargetingUtils.h"
 
+DECLARE_CYCLE_STAT(TEXT("Face Curves"), STAT_OculusXRFaceCurves, STATGROUP_OculusXRMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Face Curves - Written"), STAT_OculusXRFaceCurvesWritten, STATGROUP_OculusXRMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Face Curves - Held"), STAT_OculusXRFaceCurvesHeld, STATGROUP_OculusXRMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Face Curves - Culled"), STAT_OculusXRFaceCurvesCulled, STATGROUP_OculusXRMovement);
+
+namespace
+{
+	bool IsCurveUsedAtLOD(const USkeletalMesh* Mesh, const USkeleton* Skeleton, const FName CurveName, const int32 LODIndex)
+	{
+		const FCurveMetaData* MetaData = Skeleton ? Skeleton->GetCurveMetaData(CurveName) : nullptr;
+		if (MetaData && LODIndex > MetaData->MaxLOD)
+		{
+			return false;
+		}
+
+		// Morph targets are stripped from lower LODs, their curves can still drive material parameters
+		UMorphTarget* MorphTarget = Mesh ? Mesh->FindMorphTarget(CurveName) : nullptr;
+		if (MorphTarget && !MorphTarget->HasDataForLOD(LODIndex))
+		{
+			return MetaData && MetaData->Type.bMaterial;
+		}
+		return true;
+	}
+
+	// Keeps its source alive, so no other matrix gets the source's address while this is cached
+	struct FSharedLODMatrix
+	{
+		TSharedPtr<const FOculusXRFaceRetargetMatrix> Source;
+		FOculusXRFaceRetargetMatrix Matrix;
+	};
+
+	using FLODMatrixKey = TTuple<const FOculusXRFaceRetargetMatrix*, TObjectKey<USkeletalMesh>, int32>;
+	FCriticalSection LODMatricesLock;
+	TMap<FLODMatrixKey, TWeakPtr<const FSharedLODMatrix>> LODMatrices;
+
+	// Every node with the same matrix on the same mesh LOD gets the same trimmed matrix
+	TSharedPtr<const FOculusXRFaceRetargetMatrix> FindOrAddLODMatrix(const TSharedPtr<const FOculusXRFaceRetargetMatrix>& Source, const USkeletalMesh* Mesh, const USkeleton* Skeleton, const int32 LODIndex)
+	{
+		const FLODMatrixKey Key(Source.Get(), TObjectKey<USkeletalMesh>(Mesh), LODIndex);
+
+		FScopeLock ScopeLock(&LODMatricesLock);
+		if (TSharedPtr<const FSharedLODMatrix> Shared = LODMatrices.FindRef(Key).Pin())
+		{
+			return TSharedPtr<const FOculusXRFaceRetargetMatrix>(Shared, &Shared->Matrix);
+		}
+
+		// Drop the matrices no node uses anymore
+		for (auto It = LODMatrices.CreateIterator(); It; ++It)
+		{
+			if (!It.Value().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		TSharedRef<FSharedLODMatrix> Shared = MakeShared<FSharedLODMatrix>();
+		Shared->Source = Source;
+		Shared->Matrix = Source->Trim([Mesh, Skeleton, LODIndex](const FName CurveName) {
+			return IsCurveUsedAtLOD(Mesh, Skeleton, CurveName, LODIndex);
+		});
+		LODMatrices.Add(Key, Shared);
+		return TSharedPtr<const FOculusXRFaceRetargetMatrix>(Shared, &Shared->Matrix);
+	}
+} // namespace
+
 void FAnimNode_OculusXRFaceTracking::Initialize_AnyThread(const FAnimationInitializeContext& Context)
 {
 	InputPose.Initialize(Context);
 
-	// This animation node is executed during the packaging step.
-	// During that time, the MetaXR plugin is not available and any calls to it will crash the editor,
-	// preventing the packaging process from completing.
-	// To avoid this, we check if the plugin is available before calling any of its functions.
-	if (!GEngine || !GEngine->XRSystem.IsValid())
+	SkeletalMeshComponent = Context.AnimInstanceProxy->GetSkelMeshComponent();
+	bIsCompiled = false;
+}
+
+void FAnimNode_OculusXRFaceTracking::CacheBones_AnyThread(const FAnimationCacheBonesContext& Context)
+{
+	InputPose.CacheBones(Context);
+
+	// Bones are cached again on every LOD change, the curves are only compiled once
+	if (!bIsCompiled)
 	{
-		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("XR tracking is not loaded and available. Cannot retarget body at this time."));
-		return;
+		CompileExpressionCurves();
+		bIsCompiled = true;
 	}
+	SelectLODCurves(Context.AnimInstanceProxy->GetRequiredBones());
+}
 
-	SkeletalMeshComponent = Context.AnimInstanceProxy->GetSkelMeshComponent();
+void FAnimNode_OculusXRFaceTracking::CompileExpressionCurves()
+{
+	const int32 NumExpressions = static_cast<int32>(EOculusXRFaceExpression::COUNT);
+	CompiledModifiers.Reset(NumExpressions);
+	for (const auto& Modifier : ExpressionModifiers)
+	{
+		if (static_cast<int32>(Modifier.Key) < NumExpressions)
+		{
+			CompiledModifiers.Set(static_cast<int32>(Modifier.Key), Modifier.Value);
+		}
+	}
+
+	if (RetargetAsset)
+	{
+		CompiledMatrix = RetargetAsset->GetSharedMatrix();
+	}
+	else if (ExpressionNames.IsEmpty())
+	{
+		CompiledMatrix = UOculusXRFaceRetargetAsset::GetDefaultMatrix();
+	}
+	else
+	{
+		CompiledMatrix = MakeShared<FOculusXRFaceRetargetMatrix>(FOculusXRFaceRetargetMatrix::Build(ExpressionNames));
+	}
+
+	CompiledFilter.Reset(bFilterExpressions ? NumExpressions : 0, ExpressionFilter);
+	if (bFilterExpressions)
+	{
+		for (const auto& FilterOverride : ExpressionFilterOverrides)
+		{
+			if (static_cast<int32>(FilterOverride.Key) < NumExpressions)
+			{
+				CompiledFilter.Set(static_cast<int32>(FilterOverride.Key), FilterOverride.Value);
+			}
+		}
+	}
+
+	LODMatrix.Reset();
 }
 
-void FAnimNode_OculusXRFaceTracking::PreUpdate(const UAnimInstance* InAnimInstance) {}
+void FAnimNode_OculusXRFaceTracking::SelectLODCurves(const FBoneContainer& RequiredBones)
+{
+	const USkeletalMesh* Mesh = RequiredBones.GetSkeletalMeshAsset();
+	const int32 LODIndex = RequiredBones.GetCalculatedForLOD();
+	LODMatrix.Reset();
+	if (bCullCurvesByLOD && Mesh && LODIndex != INDEX_NONE)
+	{
+		LODMatrix = FindOrAddLODMatrix(CompiledMatrix, Mesh, RequiredBones.GetSkeletonAsset(), LODIndex);
+	}
+
+	// Emitted curves are indexed by the rows of the previous table
+	LastExpressionWeights.Reset();
+	EmittedCurveValues.Reset();
+	EmittedCurves.Empty();
+	bHasEmittedCurves = false;
+}
+
+void FAnimNode_OculusXRFaceTracking::PreUpdate(const UAnimInstance* InAnimInstance)
+{
+	DataProvider = FOculusXRMovementDataProviderRegistry::FindProvider(InAnimInstance ? InAnimInstance->GetSkelMeshComponent() : nullptr);
+}
 
 void FAnimNode_OculusXRFaceTracking::Evaluate_AnyThread(FPoseContext& Output)
 {
@@ -38,40 +173,84 @@ void FAnimNode_OculusXRFaceTracking::Evaluate_AnyThread(FPoseContext& Output)
 	// This animation node is executed during the packaging step.
 	// During that time, the MetaXR plugin is not available and any calls to it will crash the editor,
 	// preventing the packaging process from completing.
-	// To avoid this, we check if the plugin is available before calling any of its functions.
-	if (!GEngine || !GEngine->XRSystem.IsValid())
+	// To avoid this, we check if the provider is available before calling any of its functions.
+	if (!DataProvider || !DataProvider->IsAvailable())
 	{
 		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("XR tracking is not loaded and available. Cannot retarget body at this time."));
 		return;
 	}
 
+	SCOPE_CYCLE_COUNTER(STAT_OculusXRFaceCurves);
+
 	FOculusXRFaceState FaceState;
-	OculusXRMovement::GetFaceState(FaceState);
+	DataProvider->GetFaceState(FaceState);
+	const int32 NumExpressions = CompiledModifiers.GetNumExpressions();
+	if (!bIsCompiled || FaceState.ExpressionWeights.Num() < NumExpressions)
+	{
+		return;
+	}
+	const FOculusXRFaceRetargetMatrix& Matrix = LODMatrix ? *LODMatrix : *CompiledMatrix;
+	const int32 NumCurves = Matrix.GetNumCurves();
+	INC_DWORD_STAT_BY(STAT_OculusXRFaceCurvesCulled, CompiledMatrix->GetNumCurves() - NumCurves);
+	if (NumCurves == 0)
+	{
+		return;
+	}
 
-	for (int32 FaceExpressionIndex = 0; FaceExpressionIndex < FaceState.ExpressionWeights.Num(); ++FaceExpressionIndex)
+	// Same sample as last evaluation, e.g. the tracker runs slower than the game or the avatar is evaluated twice
+	if (bHasEmittedCurves && FMemory::Memcmp(FaceState.ExpressionWeights.GetData(), LastExpressionWeights.GetData(), NumExpressions * sizeof(float)) == 0)
 	{
-		const auto FaceExpression = static_cast<EOculusXRFaceExpression>(FaceExpressionIndex);
-		if (ExpressionNames.Contains(FaceExpression))
-		{
-			auto ExpressionCurves = ExpressionNames[FaceExpression];
-			float Value = FaceState.ExpressionWeights[FaceExpressionIndex];
+		INC_DWORD_STAT_BY(STAT_OculusXRFaceCurvesHeld, NumCurves);
+		Output.Curve.Combine(EmittedCurves);
+		return;
+	}
+	LastExpressionWeights.SetNumUninitialized(NumExpressions, EAllowShrinking::No);
+	FMemory::Memcpy(LastExpressionWeights.GetData(), FaceState.ExpressionWeights.GetData(), NumExpressions * sizeof(float));
 
-			// Apply Facial Expression Modifiers
-			if (ExpressionModifiers.Contains(FaceExpression))
-			{
-				FOculusXRFaceExpressionModifierNew Modifier = ExpressionModifiers[FaceExpression];
-				Value = FMath::Clamp(Value * Modifier.Multiplier, Modifier.MinValue, Modifier.MaxValue);
-			}
+	// The filter and the modifiers go over the whole weight vector at once
+	ModifiedWeights.SetNumUninitialized(NumExpressions, EAllowShrinking::No);
+	const float* Weights = FaceState.ExpressionWeights.GetData();
+	if (CompiledFilter.GetNumChannels() > 0)
+	{
+		const float SampleDeltaTime = FaceState.Time - LastFaceTime;
+		CompiledFilter.Apply(Weights, ModifiedWeights.GetData(), SampleDeltaTime > 0.0f && SampleDeltaTime < 1.0f ? SampleDeltaTime : PendingDeltaTime);
+		Weights = ModifiedWeights.GetData();
+	}
+	LastFaceTime = FaceState.Time;
+	PendingDeltaTime = 0.0f;
+	CompiledModifiers.Apply(Weights, ModifiedWeights.GetData());
 
-			for (const auto& CurveName : ExpressionCurves.CurveNames)
-			{
-				Output.Curve.Set(CurveName, Value);
-			}
-		}
+	// Mixing is a sparse matrix-vector product
+	CurveValues.SetNumUninitialized(NumCurves, EAllowShrinking::No);
+	Matrix.Multiply(ModifiedWeights.GetData(), CurveValues.GetData());
+
+	// Curves within the threshold keep their emitted value, the face curves are only rebuilt when one of them moved
+	int32 NumWritten = NumCurves;
+	if (bHasEmittedCurves)
+	{
+		NumWritten = FOculusXRRetargetingUtils::UpdateChangedValues(CurveValues, EmittedCurveValues, CurveChangeThreshold);
+	}
+	else
+	{
+		EmittedCurveValues = CurveValues;
+	}
+	INC_DWORD_STAT_BY(STAT_OculusXRFaceCurvesWritten, NumWritten);
+	INC_DWORD_STAT_BY(STAT_OculusXRFaceCurvesHeld, NumCurves - NumWritten);
+
+	// The matrix rows are already sorted, the face curves are built in one pass and merged with the input pose's
+	if (NumWritten > 0)
+	{
+		EmittedCurves.Empty();
+		UE::Anim::FCurveUtils::BuildSorted(EmittedCurves, NumCurves,
+			[&Matrix](const int32 Index) { return Matrix.CurveNames[Index]; },
+			[this](const int32 Index) { return EmittedCurveValues[Index]; });
+		bHasEmittedCurves = true;
 	}
+	Output.Curve.Combine(EmittedCurves);
 }
 
 void FAnimNode_OculusXRFaceTracking::Update_AnyThread(const FAnimationUpdateContext& Context)
 {
 	InputPose.Update(Context);
+	PendingDeltaTime += Context.GetDeltaTime();
 }
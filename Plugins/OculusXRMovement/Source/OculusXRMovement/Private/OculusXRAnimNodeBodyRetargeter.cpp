@@ -106,6 +106,11 @@ const TSet<EOculusXRBoneID> FOculusXRAnimNodeBodyRetargeter::kTPOSE_SPECIAL_HAND
 	EOculusXRBoneID::BodyRightHandLittleProximal,
 });
 
+TSharedRef<FOculusXRBodyRetargeter> FOculusXRBodyRetargeter::Create()
+{
+	return MakeShared<FOculusXRAnimNodeBodyRetargeter>();
+}
+
 void FOculusXRAnimNodeBodyRetargeter::Initialize(
 	const EOculusXRBodyRetargetingMode RetargetingMode,
 	const EOculusXRBodyRetargetingRootMotionBehavior RootMotionBehavior,
@@ -135,10 +140,11 @@ bool FOculusXRAnimNodeBodyRetargeter::IsInitialized() const
 bool FOculusXRAnimNodeBodyRetargeter::UpdateSkeleton(
 	const FOculusXRBodyState& BodyState,
 	const FBoneContainer& BoneContainer,
-	const USkeletalMeshComponent* SkeletalMeshComponent,
+	const FTransform& ComponentTransform,
 	const float WorldScale)
 {
-	if (BodyState.IsActive && IsInitialized() && SourceReferenceInfo.RequiresUpdate(BodyState.SkeletonChangedCount, BoneContainer.GetSerialNumber()) && OculusXRMovement::GetBodySkeleton(SourceReferenceInfo.SourceReferenceSkeleton, WorldScale))
+	if (BodyState.IsActive && IsInitialized() && SourceReferenceInfo.RequiresUpdate(BodyState.SkeletonChangedCount, BoneContainer.GetSerialNumber())
+		&& (DataProvider ? DataProvider->GetBodySkeleton(SourceReferenceInfo.SourceReferenceSkeleton, WorldScale) : OculusXRMovement::GetBodySkeleton(SourceReferenceInfo.SourceReferenceSkeleton, WorldScale)))
 
 	{
 #if OCULUS_XR_TRACKING_ENABLE_DEBUG_DRAW
@@ -212,11 +218,20 @@ bool FOculusXRAnimNodeBodyRetargeter::UpdateSkeleton(
 
 		InitializeScaleAndOffsetData();
 
+		CacheRetargetedRegions();
+
+		CacheFrozenSubtrees();
+
+		CacheFidelityTiers();
+
+		LastFrameLocalPose.Reset();
+		PrevFrameLocalPose.Reset();
+
 #if OCULUS_XR_TRACKING_ENABLE_DEBUG_DRAW
-		if (SkeletalMeshComponent && (DebugDrawMode == EOculusXRBodyDebugDrawMode::RestPose || DebugDrawMode == EOculusXRBodyDebugDrawMode::RestPoseWithMapping))
+		if (DebugDrawMode == EOculusXRBodyDebugDrawMode::RestPose || DebugDrawMode == EOculusXRBodyDebugDrawMode::RestPoseWithMapping)
 
 		{
-			const FTransform& MeshTransform = SkeletalMeshComponent->GetComponentTransform();
+			const FTransform& MeshTransform = ComponentTransform;
 			DebugDrawUtility.AddSkeleton(SourceReferenceInfo.SourceSkeleton, MeshTransform, FColor::Yellow, kRestPoseDebugDrawCategory);
 			DebugDrawUtility.AddSkeleton(TargetAdjustedRestPoseData, MeshTransform, FColor::Green, kRestPoseDebugDrawCategory);
 
@@ -241,21 +256,41 @@ bool FOculusXRAnimNodeBodyRetargeter::UpdateSkeleton(
 
 bool FOculusXRAnimNodeBodyRetargeter::ProcessFrameRetargeting(
 	const FOculusXRBodyState& BodyState,
-	const USkeletalMeshComponent* SkeletalMeshComponent,
-	FPoseContext& Output)
+	const FTransform& ComponentTransform,
+	FCompactPose& OutPose)
 {
 	// Sanity Check - these should all be valid for this function to execute
-	if (!(SkeletalMeshComponent && SourceReferenceInfo.IsValid()))
+	if (!SourceReferenceInfo.IsValid())
 	{
 		return false;
 	}
 
+	// The Frozen tier holds the last retargeted pose
+	if (FidelityTier == EOculusXRBodyFidelityTier::Frozen && LastFrameLocalPose.Num() == TargetAdjustedRestPoseData.GetNumBones())
+	{
+		for (int iBoneIdx = 0; iBoneIdx < TargetAdjustedRestPoseData.GetNumBones(); ++iBoneIdx)
+		{
+			const auto& jointEntry = TargetAdjustedRestPoseData.PoseData[iBoneIdx];
+			if (IsJointWrittenDuringFrame(jointEntry))
+			{
+				OutPose[jointEntry.BoneId] = LastFrameLocalPose[iBoneIdx];
+			}
+		}
+		return true;
+	}
+
 	FCSPose<FCompactPose> MeshPoses;
-	MeshPoses.InitPose(Output.Pose);
+	MeshPoses.InitPose(OutPose);
 	TArray<TTuple<FCompactPoseBoneIndex, FTransform, float>> FramePoses;
 
 	FramePoses.Reserve(TargetAdjustedRestPoseData.GetNumBones());
 
+	// Joints fixed in the active tier (frozen subtrees, fingers, ...) only get a placeholder entry, their local transforms are written as one block at the end.
+	// Without an active tier every joint is retargeted.
+	const FidelityTierData* activeTier = nullptr;
+	// Joints outside the retargeted regions with nothing retargeted below them only get a placeholder entry
+	bool bSkipPassThroughJoints = false;
+
 #if OCULUS_XR_TRACKING_ENABLE_DEBUG_DRAW
 	// Feature to Retarget to Rest Pose ONLY available in non-shipping builds
 	if (DebugPoseMode == EOculusXRBodyDebugPoseMode::RestPose)
@@ -284,9 +319,28 @@ bool FOculusXRAnimNodeBodyRetargeter::ProcessFrameRetargeting(
 				SourceReferenceInfo.SourceReferenceSkeleton, InitData.TrackingSpaceToComponentSpace, InitData.RootMotionBehavior);
 		}
 
+		// The Frozen tier falls back to Full until a frame has been retargeted
+		activeTier = &TargetAdjustedRestPoseData.FidelityTiers[FidelityTier == EOculusXRBodyFidelityTier::Frozen ? 0 : static_cast<int>(FidelityTier)];
+		bSkipPassThroughJoints = true;
+#if OCULUS_XR_TRACKING_ENABLE_DEBUG_DRAW
+		// Drawing the frame pose needs the full component space pose
+		if (DebugDrawMode == EOculusXRBodyDebugDrawMode::FramePose || DebugDrawMode == EOculusXRBodyDebugDrawMode::FramePoseWithMapping)
+		{
+			activeTier = nullptr;
+			bSkipPassThroughJoints = false;
+		}
+#endif // OCULUS_XR_TRACKING_ENABLE_DEBUG_DRAW
+		const bool bAlignParentJoints = !activeTier || activeTier->bAlignParentJoints;
+
 		for (int iBoneIdx = 0; iBoneIdx < TargetAdjustedRestPoseData.GetNumBones(); ++iBoneIdx)
 		{
 			const auto& jointEntry = TargetAdjustedRestPoseData.PoseData[iBoneIdx];
+			if ((activeTier && activeTier->FixedJoints[iBoneIdx]) || (bSkipPassThroughJoints && jointEntry.bPassThrough))
+			{
+				FramePoses.Add({ jointEntry.BoneId, jointEntry.ComponentTransform, jointEntry.componentSpaceScale });
+				continue;
+			}
+
 			FTransform jointFrameTransform = jointEntry.ComponentTransform;
 			if (jointEntry.ParentIdx != INDEX_NONE)
 			{
@@ -329,7 +383,7 @@ bool FOculusXRAnimNodeBodyRetargeter::ProcessFrameRetargeting(
 					else
 					{
 						// Check to see whether we need to modify the parent orientation due to deformation.
-						if (!IsHipOrRootSourceJoint(jointEntry.sourceJointID) && jointEntry.ParentIdx != INDEX_NONE && jointEntry.sourceJointLocalOffset.GetLocation().Length() > 0.0f)
+						if (bAlignParentJoints && !IsHipOrRootSourceJoint(jointEntry.sourceJointID) && jointEntry.ParentIdx != INDEX_NONE && jointEntry.sourceJointLocalOffset.GetLocation().Length() > 0.0f)
 						{
 							// Check to see if the parent only has one non-twist child joint.
 							// We can rotate it if we're the only child joint that matters.
@@ -381,10 +435,14 @@ bool FOculusXRAnimNodeBodyRetargeter::ProcessFrameRetargeting(
 	}
 
 	// Twist Joints
-	ProcessFrameInterpolateTwistJoints(FramePoses);
+	if (!activeTier || activeTier->bInterpolateTwistJoints)
+	{
+		ProcessFrameInterpolateTwistJoints(FramePoses);
+	}
 
 	// Update the hand scale joint scale
-	if (InitData.RetargetingMode == EOculusXRBodyRetargetingMode::RotationAndPositions)
+	if (InitData.RetargetingMode == EOculusXRBodyRetargetingMode::RotationAndPositions && EnumHasAnyFlags(InitData.RetargetedRegions, EOculusXRBodyRegion::Hands)
+		&& (!activeTier || activeTier->bUpdateHandScale))
 	{
 		// Rotation and Positions retargeting is the only mode where the hand sizes are changed based on the frame data
 		if (SourceReferenceInfo.SourceToTargetIdxMap.Contains(EOculusXRBoneID::BodyLeftHandWrist) && SourceReferenceInfo.SourceToTargetIdxMap.Contains(EOculusXRBoneID::BodyRightHandWrist))
@@ -394,18 +452,48 @@ bool FOculusXRAnimNodeBodyRetargeter::ProcessFrameRetargeting(
 		}
 	}
 
-	// Now Apply the FramePoses to the MeshPoses struct
-	for (auto& framePoseEntry : FramePoses)
+	// Now Apply the FramePoses to the MeshPoses struct.
+	// A retargeted region under a joint that keeps the input pose (the hands alone, say) keeps its tracked transforms
+	// relative to that parent, so it stays attached to the input pose instead of floating at the tracked position.
+	const bool bAnchorRegions = InitData.RetargetedRegions != EOculusXRBodyRegion::All;
+	if (bAnchorRegions)
 	{
+		AnchoredFramePose.SetNumUninitialized(FramePoses.Num(), EAllowShrinking::No);
+	}
+	for (int iBoneIdx = 0; iBoneIdx < FramePoses.Num(); ++iBoneIdx)
+	{
+		// Joints outside the retargeted regions keep the input pose
+		const auto& jointEntry = TargetAdjustedRestPoseData.PoseData[iBoneIdx];
+		if (!jointEntry.bRetargeted || (activeTier && activeTier->FixedJoints[iBoneIdx]))
+		{
+			continue;
+		}
+
+		auto& framePoseEntry = FramePoses[iBoneIdx];
+		if (bAnchorRegions && jointEntry.ParentIdx != INDEX_NONE)
+		{
+			const int parentIdx = jointEntry.ParentIdx;
+			const FTransform trackedLocal = framePoseEntry.Get<FTransform>().GetRelativeTransform(FramePoses[parentIdx].Get<FTransform>());
+			const FTransform& anchoredParent = TargetAdjustedRestPoseData.PoseData[parentIdx].bRetargeted
+				? AnchoredFramePose[parentIdx]
+				: MeshPoses.GetComponentSpaceTransform(TargetAdjustedRestPoseData.PoseData[parentIdx].BoneId);
+			AnchoredFramePose[iBoneIdx] = trackedLocal * anchoredParent;
+		}
+		else if (bAnchorRegions)
+		{
+			AnchoredFramePose[iBoneIdx] = framePoseEntry.Get<FTransform>();
+		}
+
 		// Apply Scale here so it won't affect child transforms
-		framePoseEntry.Get<FTransform>().SetScale3D(FVector::OneVector * framePoseEntry.Get<float>());
-		MeshPoses.SetComponentSpaceTransform(framePoseEntry.Get<FCompactPoseBoneIndex>(), framePoseEntry.Get<FTransform>());
+		FTransform componentTransform = bAnchorRegions ? AnchoredFramePose[iBoneIdx] : framePoseEntry.Get<FTransform>();
+		componentTransform.SetScale3D(FVector::OneVector * framePoseEntry.Get<float>());
+		MeshPoses.SetComponentSpaceTransform(framePoseEntry.Get<FCompactPoseBoneIndex>(), componentTransform);
 	}
 
 #if OCULUS_XR_TRACKING_ENABLE_DEBUG_DRAW
 	if (DebugDrawMode == EOculusXRBodyDebugDrawMode::FramePose || DebugDrawMode == EOculusXRBodyDebugDrawMode::FramePoseWithMapping)
 	{
-		const FTransform& MeshTransform = SkeletalMeshComponent->GetComponentTransform();
+		const FTransform& MeshTransform = ComponentTransform;
 
 #if OCULUS_XR_DEBUG_DRAW_MODIFIED_ROOT_MOTION_BEHAVIOR
 		if (IsModifiedRootBehavior(InitData.RootMotionBehavior) && BodyState.IsActive)
@@ -431,7 +519,23 @@ bool FOculusXRAnimNodeBodyRetargeter::ProcessFrameRetargeting(
 	}
 #endif // OCULUS_XR_TRACKING_ENABLE_DEBUG_DRAW
 
-	FCSPose<FCompactPose>::ConvertComponentPosesToLocalPosesSafe(MeshPoses, Output.Pose);
+	FCSPose<FCompactPose>::ConvertComponentPosesToLocalPosesSafe(MeshPoses, OutPose);
+
+	// Fixed joints were never marked as component space, so they still hold the input pose at this point
+	if (activeTier)
+	{
+		for (const auto& fixedEntry : activeTier->FixedLocalTransforms)
+		{
+			OutPose[fixedEntry.Get<FCompactPoseBoneIndex>()] = fixedEntry.Get<FTransform>();
+		}
+	}
+
+	Swap(PrevFrameLocalPose, LastFrameLocalPose);
+	LastFrameLocalPose.SetNumUninitialized(TargetAdjustedRestPoseData.GetNumBones());
+	for (int iBoneIdx = 0; iBoneIdx < TargetAdjustedRestPoseData.GetNumBones(); ++iBoneIdx)
+	{
+		LastFrameLocalPose[iBoneIdx] = OutPose[TargetAdjustedRestPoseData.PoseData[iBoneIdx].BoneId];
+	}
 	return true;
 }
 
@@ -528,17 +632,38 @@ TTuple<float, float> FOculusXRAnimNodeBodyRetargeter::GetFrameMaxCurrentAndUnMod
 
 bool FOculusXRAnimNodeBodyRetargeter::RetargetFromBodyState(
 	const FOculusXRBodyState& BodyState,
-	const USkeletalMeshComponent* SkeletalMeshComponent,
+	const FTransform& ComponentTransform,
 	const float WorldScale,
-	FPoseContext& Output)
+	FCompactPose& OutPose)
 {
-	if (SkeletalMeshComponent && UpdateSkeleton(BodyState, Output.Pose.GetBoneContainer(), SkeletalMeshComponent, WorldScale))
+	if (UpdateSkeleton(BodyState, OutPose.GetBoneContainer(), ComponentTransform, WorldScale))
 	{
-		return ProcessFrameRetargeting(BodyState, SkeletalMeshComponent, Output);
+		return ProcessFrameRetargeting(BodyState, ComponentTransform, OutPose);
 	}
 	return false;
 }
 
+bool FOculusXRAnimNodeBodyRetargeter::BlendCachedFrames(const float Alpha, FCompactPose& OutPose) const
+{
+	const int numBones = TargetAdjustedRestPoseData.GetNumBones();
+	if (!SourceReferenceInfo.IsValid() || SourceReferenceInfo.BoneContainerSerialNumber != OutPose.GetBoneContainer().GetSerialNumber() || LastFrameLocalPose.Num() != numBones)
+	{
+		return false;
+	}
+
+	// Only a single frame has been retargeted so far
+	const TArray<FTransform>& fromPose = PrevFrameLocalPose.Num() == numBones ? PrevFrameLocalPose : LastFrameLocalPose;
+	for (int iBoneIdx = 0; iBoneIdx < numBones; ++iBoneIdx)
+	{
+		const auto& jointEntry = TargetAdjustedRestPoseData.PoseData[iBoneIdx];
+		if (IsJointWrittenDuringFrame(jointEntry))
+		{
+			OutPose[jointEntry.BoneId].Blend(fromPose[iBoneIdx], LastFrameLocalPose[iBoneIdx], Alpha);
+		}
+	}
+	return true;
+}
+
 void FOculusXRAnimNodeBodyRetargeter::SetTargetToTPose()
 {
 	TMap<int, TArray<int>> AncestorToChildTPoseAlignmentMap;
@@ -1045,6 +1170,171 @@ void FOculusXRAnimNodeBodyRetargeter::InitializeScaleAndOffsetData()
 	}
 }
 
+// Assigns every target joint to a body region: mapped joints use the region of their source joint,
+// unmapped joints inherit the region of their parent.  Joints outside the retargeted regions keep the input pose,
+// and whole subtrees of them are skipped during the frame.
+void FOculusXRAnimNodeBodyRetargeter::CacheRetargetedRegions()
+{
+	// NOTE: Assumption is that joints are sorted from Parent -> Child
+	TArray<EOculusXRBoneID> sourceJoints;
+	TArray<int32> parentIndices;
+	GetJointHierarchy(sourceJoints, parentIndices);
+	TArray<EOculusXRBodyRegion> jointRegions;
+	GetJointRegions(sourceJoints, parentIndices, jointRegions);
+	for (int i = 0; i < TargetAdjustedRestPoseData.GetNumBones(); ++i)
+	{
+		TargetAdjustedRestPoseData.PoseData[i].bRetargeted = EnumHasAnyFlags(InitData.RetargetedRegions, jointRegions[i]);
+	}
+
+	// Twist joints and the joints driving them are always evaluated since the chains are interpolated between them
+	const TSet<int> twistDrivingJoints = GetTwistDrivingJoints();
+
+	for (int i = TargetAdjustedRestPoseData.GetNumBones() - 1; i >= 0; --i)
+	{
+		TargetSkeletonJointEntry& jointEntry = TargetAdjustedRestPoseData.PoseData[i];
+		bool bPassThrough = !jointEntry.bRetargeted && !TargetAdjustedRestPoseData.TwistJoints.Contains(i) && !twistDrivingJoints.Contains(i);
+		for (int childIdx : jointEntry.childJoints)
+		{
+			bPassThrough &= TargetAdjustedRestPoseData.PoseData[childIdx].bPassThrough;
+		}
+		jointEntry.bPassThrough = bPassThrough;
+	}
+}
+
+void FOculusXRAnimNodeBodyRetargeter::GetJointHierarchy(TArray<EOculusXRBoneID>& outSourceJoints, TArray<int32>& outParentIndices) const
+{
+	outSourceJoints.Reset(TargetAdjustedRestPoseData.GetNumBones());
+	outParentIndices.Reset(TargetAdjustedRestPoseData.GetNumBones());
+	for (const TargetSkeletonJointEntry& jointEntry : TargetAdjustedRestPoseData.PoseData)
+	{
+		outSourceJoints.Add(jointEntry.sourceJointID);
+		outParentIndices.Add(jointEntry.ParentIdx);
+	}
+}
+
+// Identifies rigid subtrees of unmapped joints (facial bones, helpers, accessories) that can skip per-frame retargeting.
+// A joint qualifies if it is unmapped, is not a twist joint, has a parent, and all of its children qualify.
+// Joints whose scale changes per frame (hands in Rotation & Positions mode) never qualify.
+void FOculusXRAnimNodeBodyRetargeter::CacheFrozenSubtrees()
+{
+	if (InitData.UnmappedSubtreeMode == EOculusXRBodyUnmappedSubtreeMode::Retarget)
+	{
+		return;
+	}
+
+	const bool bHasFrameHandScaling = InitData.RetargetingMode == EOculusXRBodyRetargetingMode::RotationAndPositions;
+	const int RightWristBoneIndex = SourceReferenceInfo.SourceToTargetIdxMap.Contains(EOculusXRBoneID::BodyRightHandWrist) ? SourceReferenceInfo.SourceToTargetIdxMap[EOculusXRBoneID::BodyRightHandWrist] : INDEX_NONE;
+	const int LeftWristBoneIndex = SourceReferenceInfo.SourceToTargetIdxMap.Contains(EOculusXRBoneID::BodyLeftHandWrist) ? SourceReferenceInfo.SourceToTargetIdxMap[EOculusXRBoneID::BodyLeftHandWrist] : INDEX_NONE;
+
+	// NOTE: Assumption is that joints are sorted from Parent -> Child, so walking backwards visits children first
+	for (int i = TargetAdjustedRestPoseData.GetNumBones() - 1; i >= 0; --i)
+	{
+		TargetSkeletonJointEntry& jointEntry = TargetAdjustedRestPoseData.PoseData[i];
+		bool bFreezable = jointEntry.bRetargeted && jointEntry.ParentIdx != INDEX_NONE && !TargetAdjustedRestPoseData.IsJointMappedToSource(i) && !TargetAdjustedRestPoseData.TwistJoints.Contains(i);
+
+		if (bFreezable && bHasFrameHandScaling)
+		{
+			bFreezable = !(TargetAdjustedRestPoseData.IsAncestorToBoneIndex(RightWristBoneIndex, i) || TargetAdjustedRestPoseData.IsAncestorToBoneIndex(LeftWristBoneIndex, i));
+		}
+
+		for (int childIdx : jointEntry.childJoints)
+		{
+			const TargetSkeletonJointEntry& childEntry = TargetAdjustedRestPoseData.PoseData[childIdx];
+			bFreezable &= childEntry.bFrozen || childEntry.bPassThrough;
+		}
+		jointEntry.bFrozen = bFreezable;
+	}
+}
+
+// Precompiles the joint subset of each fidelity tier.  Frozen subtrees are fixed in every tier, No Fingers also fixes
+// every joint driven by a finger and drops the per-frame hand scale, Core Only additionally fixes unmapped leaf subtrees
+// and drops twist interpolation and parent alignment.
+void FOculusXRAnimNodeBodyRetargeter::CacheFidelityTiers()
+{
+	const int numBones = TargetAdjustedRestPoseData.GetNumBones();
+
+	// Unmapped joints belong to the finger of their closest mapped ancestor
+	TArray<EOculusXRBoneID> sourceJoints;
+	TArray<int32> parentIndices;
+	GetJointHierarchy(sourceJoints, parentIndices);
+	TBitArray<> fingerJoints;
+	GetFingerJoints(sourceJoints, parentIndices, fingerJoints);
+
+	const TSet<int> twistDrivingJoints = GetTwistDrivingJoints();
+	for (int tierIdx = 0; tierIdx < UE_ARRAY_COUNT(TargetAdjustedRestPoseData.FidelityTiers); ++tierIdx)
+	{
+		const EOculusXRBodyFidelityTier tier = static_cast<EOculusXRBodyFidelityTier>(tierIdx);
+		FidelityTierData& tierData = TargetAdjustedRestPoseData.FidelityTiers[tierIdx];
+		tierData.bUpdateHandScale = tier == EOculusXRBodyFidelityTier::Full;
+		tierData.bInterpolateTwistJoints = tier != EOculusXRBodyFidelityTier::CoreOnly;
+		tierData.bAlignParentJoints = tier != EOculusXRBodyFidelityTier::CoreOnly;
+		tierData.FixedJoints.Init(false, numBones);
+		tierData.FixedLocalTransforms.Empty();
+
+		// NOTE: Assumption is that joints are sorted from Parent -> Child, so walking backwards visits children first
+		for (int i = numBones - 1; i >= 0; --i)
+		{
+			const TargetSkeletonJointEntry& jointEntry = TargetAdjustedRestPoseData.PoseData[i];
+			if (jointEntry.bFrozen)
+			{
+				tierData.FixedJoints[i] = true;
+				continue;
+			}
+
+			bool bFixed = tier != EOculusXRBodyFidelityTier::Full && jointEntry.bRetargeted && jointEntry.ParentIdx != INDEX_NONE;
+			if (bFixed && tierData.bInterpolateTwistJoints)
+			{
+				bFixed = !TargetAdjustedRestPoseData.TwistJoints.Contains(i) && !twistDrivingJoints.Contains(i);
+			}
+			if (bFixed)
+			{
+				bFixed = fingerJoints[i] || (tier == EOculusXRBodyFidelityTier::CoreOnly && !TargetAdjustedRestPoseData.IsJointMappedToSource(i));
+			}
+			for (int childIdx : jointEntry.childJoints)
+			{
+				bFixed &= tierData.FixedJoints[childIdx] || TargetAdjustedRestPoseData.PoseData[childIdx].bPassThrough;
+			}
+			tierData.FixedJoints[i] = bFixed;
+		}
+
+		for (int i = 0; i < numBones; ++i)
+		{
+			const TargetSkeletonJointEntry& jointEntry = TargetAdjustedRestPoseData.PoseData[i];
+			// Frozen joints that keep the input pose are left untouched
+			if (tierData.FixedJoints[i] && !(jointEntry.bFrozen && InitData.UnmappedSubtreeMode == EOculusXRBodyUnmappedSubtreeMode::InputPose))
+			{
+				tierData.FixedLocalTransforms.Add({ jointEntry.BoneId, GetScaledLocalRestTransform(i) });
+			}
+		}
+	}
+}
+
+// Bakes the scale each joint receives during the frame so a fixed block matches what a full retarget would produce.
+// Parent and child only ever move rigidly together, so the relative transform is constant.
+FTransform FOculusXRAnimNodeBodyRetargeter::GetScaledLocalRestTransform(const int JointIdx) const
+{
+	const TargetSkeletonJointEntry& jointEntry = TargetAdjustedRestPoseData.PoseData[JointIdx];
+	const TargetSkeletonJointEntry& parentEntry = TargetAdjustedRestPoseData.PoseData[jointEntry.ParentIdx];
+	FTransform scaledComponentTransform = jointEntry.ComponentTransform;
+	scaledComponentTransform.SetScale3D(FVector::OneVector * jointEntry.componentSpaceScale);
+	FTransform scaledParentComponentTransform = parentEntry.ComponentTransform;
+	scaledParentComponentTransform.SetScale3D(FVector::OneVector * parentEntry.componentSpaceScale);
+
+	FTransform localTransform = scaledComponentTransform.GetRelativeTransform(scaledParentComponentTransform);
+	localTransform.NormalizeRotation();
+	return localTransform;
+}
+
+TSet<int> FOculusXRAnimNodeBodyRetargeter::GetTwistDrivingJoints() const
+{
+	TSet<int> twistDrivingJoints;
+	for (const auto& twistEntry : TargetAdjustedRestPoseData.TwistJoints)
+	{
+		twistDrivingJoints.Add(twistEntry.Value.TargetSourceJointIdx);
+	}
+	return twistDrivingJoints;
+}
+
 TTuple<float, float> FOculusXRAnimNodeBodyRetargeter::GetMaxCurrentAndUnModifiedJointLengths(int targetJointIndex, float currentLength, float unmodifiedLength) const
 {
 	TTuple<float, float> retVal({ currentLength, unmodifiedLength });
@@ -1196,6 +1486,39 @@ TMap<FCompactPoseBoneIndex, EOculusXRBoneID> FOculusXRAnimNodeBodyRetargeter::Re
 	return TargetToSourceMap;
 }
 
+void FOculusXRAnimNodeBodyRetargeter::SetUnmappedSubtreeMode(const EOculusXRBodyUnmappedSubtreeMode mode)
+{
+	if (InitData.UnmappedSubtreeMode != mode)
+	{
+		InitData.UnmappedSubtreeMode = mode;
+
+		// Frozen subtrees are identified during setup
+		SourceReferenceInfo.Invalidate();
+	}
+}
+
+void FOculusXRAnimNodeBodyRetargeter::SetRetargetedRegions(const EOculusXRBodyRegion regions)
+{
+	if (InitData.RetargetedRegions != regions)
+	{
+		InitData.RetargetedRegions = regions;
+
+		// Per-joint region flags are compiled during setup
+		SourceReferenceInfo.Invalidate();
+	}
+}
+
+void FOculusXRAnimNodeBodyRetargeter::SetDataProvider(const TSharedPtr<IOculusXRMovementDataProvider>& provider)
+{
+	if (DataProvider != provider)
+	{
+		DataProvider = provider;
+
+		// A different source may come with a different skeleton
+		SourceReferenceInfo.Invalidate();
+	}
+}
+
 void FOculusXRAnimNodeBodyRetargeter::SetDebugPoseMode(const EOculusXRBodyDebugPoseMode mode)
 {
 #if OCULUS_XR_TRACKING_ENABLE_DEBUG_DRAW
@@ -30,15 +30,24 @@ public:
 		const TMap<EOculusXRBoneID, FName>* SourceToTargetNameMap) override;
 
 	virtual bool RetargetFromBodyState(const FOculusXRBodyState& BodyState,
-		const USkeletalMeshComponent* SkeletalMeshComponent,
+		const FTransform& ComponentTransform,
 		const float WorldScale,
-		FPoseContext& Output) override;
+		FCompactPose& OutPose) override;
+
+	virtual void SetUnmappedSubtreeMode(const EOculusXRBodyUnmappedSubtreeMode mode) override;
+	virtual void SetRetargetedRegions(const EOculusXRBodyRegion regions) override;
+	virtual void SetFidelityTier(const EOculusXRBodyFidelityTier tier) override { FidelityTier = tier; }
+	virtual bool BlendCachedFrames(const float Alpha, FCompactPose& OutPose) const override;
+	virtual void SetDataProvider(const TSharedPtr<IOculusXRMovementDataProvider>& provider) override;
 
 	virtual void SetDebugPoseMode(const EOculusXRBodyDebugPoseMode mode) override;
 	virtual void SetDebugDrawMode(const EOculusXRBodyDebugDrawMode mode) override;
 
 	virtual EOculusXRBodyRetargetingMode GetRetargetingMode() override { return InitData.RetargetingMode; }
-	virtual EOculusXRBodyRetargetingRootMotionBehavior GetRootMotionBehavior() { return InitData.RootMotionBehavior; }
+	virtual EOculusXRBodyRetargetingRootMotionBehavior GetRootMotionBehavior() override { return InitData.RootMotionBehavior; }
+
+	// Finger joints of the left hand then the right hand, each finger from its metacarpal to its tip
+	static const TArray<EOculusXRBoneID> kALIGNABLE_HAND_JOINTS;
 
 private:
 	struct InitializationData
@@ -46,6 +55,8 @@ private:
 		EOculusXRBodyRetargetingMode RetargetingMode = EOculusXRBodyRetargetingMode::RotationAndPositions;
 		EOculusXRBodyRetargetingRootMotionBehavior RootMotionBehavior = EOculusXRBodyRetargetingRootMotionBehavior::CombineToRoot;
 		EOculusXRAxis MeshForwardFacingDir = EOculusXRAxis::Y;
+		EOculusXRBodyUnmappedSubtreeMode UnmappedSubtreeMode = EOculusXRBodyUnmappedSubtreeMode::RestPose;
+		EOculusXRBodyRegion RetargetedRegions = EOculusXRBodyRegion::All;
 
 		FTransform TargetFacingTransform = FTransform::Identity;
 		FTransform TrackingSpaceToComponentSpace = FTransform::Identity;
@@ -86,6 +97,9 @@ private:
 		int mappedAncestorIdx = INDEX_NONE; // Closest Parent that is mapped
 		FTransform sourceJointLocalOffset = FTransform::Identity;
 		float componentSpaceScale = 1.0f; // Scale is based on the difference between the joint lengths after the character is adjusted
+		bool bFrozen = false;			  // Part of a rigid unmapped subtree - not retargeted per frame
+		bool bRetargeted = true;		  // Belongs to one of the retargeted body regions
+		bool bPassThrough = false;		  // Neither this joint nor anything below it is retargeted - keeps the input pose
 
 		TArray<int> childJoints;	  // Array of all Children for this Joint
 		TArray<int> childTwistJoints; // Array of Children that are Twist Joints (subset of childJoints)
@@ -107,6 +121,16 @@ private:
 		const bool isRotateable = true;
 	};
 
+	// Precompiled joint subset for a fidelity tier, switching tiers never rebuilds the skeleton
+	struct FidelityTierData
+	{
+		TBitArray<> FixedJoints;												// Joints that follow their parent with a constant local transform
+		TArray<TTuple<FCompactPoseBoneIndex, FTransform>> FixedLocalTransforms; // Parent relative transforms, written as a single block after retargeting
+		bool bUpdateHandScale = true;
+		bool bInterpolateTwistJoints = true;
+		bool bAlignParentJoints = true;
+	};
+
 	// Extends FAbstractRetargetSkeleton specifically to reduce code needed to debug draw as a skeleton
 	struct TargetSkeletonPoseData : public FAbstractRetargetSkeleton
 	{
@@ -189,6 +213,9 @@ private:
 		// Store Identified Twist Joint Chains here
 		TMap<int, TwistJointEntry> TwistJoints;
 
+		// Indexed by EOculusXRBodyFidelityTier, the Frozen tier reuses the last frame instead
+		FidelityTierData FidelityTiers[static_cast<int>(EOculusXRBodyFidelityTier::Frozen)];
+
 		// This scale is based on the overall height scaling to align the
 		// wrists of the target rig on the Z-Axis
 		float GlobalComponentSpaceScale = 1.0f;
@@ -202,12 +229,12 @@ private:
 	// Separated so we can better identify/mark in a profiler capture.
 	bool UpdateSkeleton(const FOculusXRBodyState& BodyState,
 		const FBoneContainer& BoneContainer,
-		const USkeletalMeshComponent* SkeletalMeshComponent,
+		const FTransform& ComponentTransform,
 		const float WorldScale);
 
 	bool ProcessFrameRetargeting(const FOculusXRBodyState& BodyState,
-		const USkeletalMeshComponent* SkeletalMeshComponent,
-		FPoseContext& Output);
+		const FTransform& ComponentTransform,
+		FCompactPose& OutPose);
 
 	// Called from within ProcessFrameRetargeting
 	void ProcessFrameInterpolateTwistJoints(TArray<TTuple<FCompactPoseBoneIndex, FTransform, float>>& FramePoses) const;
@@ -223,6 +250,12 @@ private:
 	void CacheTwistJoints();
 	void ApplyScaleAndProportion();
 	void InitializeScaleAndOffsetData();
+	void CacheRetargetedRegions();
+	void CacheFrozenSubtrees();
+	void CacheFidelityTiers();
+	TSet<int> GetTwistDrivingJoints() const;
+	void GetJointHierarchy(TArray<EOculusXRBoneID>& outSourceJoints, TArray<int32>& outParentIndices) const;
+	FTransform GetScaledLocalRestTransform(const int JointIdx) const;
 	TTuple<float, float> GetMaxCurrentAndUnModifiedJointLengths(int targetJointIndex, float currentLength = 0.0f, float unmodifiedLength = 0.0f) const;
 
 	// End of Setup/Calculation section
@@ -236,7 +269,6 @@ private:
 
 	static const float kTWIST_JOINT_MIN_ANGLE_THRESHOLD;
 	static const TSet<EOculusXRBoneID> GenerateTPoseJointSet();
-	static const TArray<EOculusXRBoneID> kALIGNABLE_HAND_JOINTS;
 	static const TSet<EOculusXRBoneID> kTPOSE_ADJUSTABLE_JOINT_SET;
 	static const TSet<EOculusXRBoneID> kTPOSE_SPECIAL_HANDLING_ADJUSTABLE_HAND_JOINTS;
 
@@ -245,6 +277,19 @@ private:
 	TMap<FCompactPoseBoneIndex, EOculusXRBoneID> TargetToSourceMap;
 	TargetSkeletonPoseData TargetAdjustedRestPoseData;
 
+	EOculusXRBodyFidelityTier FidelityTier = EOculusXRBodyFidelityTier::Full;
+	TSharedPtr<IOculusXRMovementDataProvider> DataProvider;
+	// Local transforms written during the last two retargeted frames, reused by the Frozen tier and for reduced rate evaluation
+	TArray<FTransform> LastFrameLocalPose;
+	TArray<FTransform> PrevFrameLocalPose;
+	// Component space transforms of the retargeted joints moved onto the input pose of their region's parent, unscaled
+	TArray<FTransform> AnchoredFramePose;
+
+	inline bool IsJointWrittenDuringFrame(const TargetSkeletonJointEntry& jointEntry) const
+	{
+		return jointEntry.bRetargeted && !(jointEntry.bFrozen && InitData.UnmappedSubtreeMode == EOculusXRBodyUnmappedSubtreeMode::InputPose);
+	}
+
 #if OCULUS_XR_TRACKING_ENABLE_DEBUG_DRAW
 	static const FString kRestPoseDebugDrawCategory;
 
@@ -0,0 +1,520 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRBodyStateCodec.h"
+#include "OculusXRBodyRetargeter.h"
+#include "OculusXRHandPoseCodec.h"
+#include "Misc/Crc.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+namespace
+{
+	constexpr int32 kNumBones = static_cast<int32>(EOculusXRBoneID::COUNT);
+	constexpr int32 kLayoutHashBits = 16;
+	constexpr int32 kTierBits = 2;
+	constexpr int32 kNumTiers = static_cast<int32>(EOculusXRBodyFidelityTier::Frozen) + 1;
+	constexpr int32 kConfidenceBits = 8;
+	constexpr int32 kMaxRotationBits = 16;
+	constexpr int32 kMaxPositionBits = 24;
+	// SerializeIntPacked uses up to 5 bytes
+	constexpr int32 kMaxPackedIntBits = 40;
+	// Smallest three components of a unit quaternion lie within +/- 1/sqrt(2)
+	constexpr float kSmallestThreeRange = UE_INV_SQRT_2;
+
+	void WriteBits(FBitWriter& Writer, uint32 Value, const int32 NumBits)
+	{
+		Writer.SerializeBits(&Value, NumBits);
+	}
+
+	uint32 ReadBits(FBitReader& Reader, const int32 NumBits)
+	{
+		uint32 value = 0;
+		Reader.SerializeBits(&value, NumBits);
+		return value;
+	}
+
+	uint32 QuantizeUnit(const float Value, const float Range, const int32 NumBits)
+	{
+		const uint32 maxValue = (1u << NumBits) - 1;
+		const float normalized = FMath::Clamp((Value + Range) / (2.0f * Range), 0.0f, 1.0f);
+		return static_cast<uint32>(FMath::RoundToInt32(normalized * maxValue));
+	}
+
+	float DequantizeUnit(const uint32 Value, const float Range, const int32 NumBits)
+	{
+		const uint32 maxValue = (1u << NumBits) - 1;
+		return static_cast<float>(Value) / maxValue * 2.0f * Range - Range;
+	}
+} // namespace
+
+FOculusXRBodyStateCodecSettings::FOculusXRBodyStateCodecSettings()
+{
+	for (int32 i = 0; i < kNumBones; ++i)
+	{
+		// Finger joints are short, the same angular error moves them much less than the limbs
+		RotationBits[i] = FOculusXRBodyRetargeter::IsFingerSourceJoint(static_cast<EOculusXRBoneID>(i)) ? 9 : 12;
+	}
+}
+
+FOculusXRBodyStateCodec::FOculusXRBodyStateCodec(const FOculusXRBodyStateCodecSettings& InSettings, const TMap<EOculusXRBoneID, FName>* BoneRemapping)
+	: Settings(InSettings)
+{
+	Settings.PositionPrecision = FMath::Max(Settings.PositionPrecision, UE_KINDA_SMALL_NUMBER);
+	Settings.PositionRange = FMath::Max(Settings.PositionRange, Settings.PositionPrecision);
+
+	for (int32 i = 0; i < kNumBones; ++i)
+	{
+		const EOculusXRBoneID boneId = static_cast<EOculusXRBoneID>(i);
+		const FName* targetBone = BoneRemapping ? BoneRemapping->Find(boneId) : nullptr;
+		const bool bIsMapped = !BoneRemapping || (targetBone && !targetBone->IsNone());
+		const bool bIsInHandPose = UsesHandPoses() && FOculusXRBodyRetargeter::IsFingerSourceJoint(boneId);
+		if ((bIsMapped && !bIsInHandPose && IsJointSentAtTier(boneId, Settings.FidelityTier)) || FOculusXRBodyRetargeter::IsHipOrRootSourceJoint(boneId))
+		{
+			if (boneId == EOculusXRBoneID::BodyHips)
+			{
+				HipsJointIndex = EncodedJoints.Num();
+			}
+			EncodedJoints.Add(boneId);
+			JointRotationBits.Add(static_cast<uint8>(FMath::Clamp<int32>(Settings.RotationBits[i], 2, kMaxRotationBits)));
+		}
+	}
+
+	const double numSteps = FMath::CeilToDouble(2.0 * Settings.PositionRange / Settings.PositionPrecision);
+	PositionBits = FMath::Clamp<int32>(FMath::CeilLogTwo64(static_cast<uint64>(numSteps) + 1), 1, kMaxPositionBits);
+	MaxPositionValue = (1u << PositionBits) - 1;
+	// The quantization step is derived from the bit count so encode and decode agree exactly
+	Settings.PositionRange = static_cast<float>(Settings.PositionPrecision * MaxPositionValue * 0.5);
+
+	uint32 hash = FCrc::MemCrc32(EncodedJoints.GetData(), EncodedJoints.Num() * EncodedJoints.GetTypeSize());
+	hash = FCrc::MemCrc32(JointRotationBits.GetData(), JointRotationBits.Num(), hash);
+	const uint32 positionLayout[] = { Settings.bEncodePositions ? 1u : 0u, static_cast<uint32>(PositionBits) };
+	hash = FCrc::MemCrc32(positionLayout, sizeof(positionLayout), hash);
+	hash = FCrc::MemCrc32(&Settings.PositionPrecision, sizeof(Settings.PositionPrecision), hash);
+	if (UsesHandPoses())
+	{
+		const uint32 handPoseHash = Settings.HandPoseCodec->GetHash();
+		hash = FCrc::MemCrc32(&handPoseHash, sizeof(handPoseHash), hash);
+	}
+	LayoutHash = static_cast<uint16>(hash ^ (hash >> 16));
+}
+
+bool FOculusXRBodyStateCodec::IsJointSentAtTier(const EOculusXRBoneID BoneId, const EOculusXRBodyFidelityTier Tier)
+{
+	switch (Tier)
+	{
+		case EOculusXRBodyFidelityTier::Full:
+			return true;
+		case EOculusXRBodyFidelityTier::NoFingers:
+			return !FOculusXRBodyRetargeter::IsFingerSourceJoint(BoneId);
+		case EOculusXRBodyFidelityTier::CoreOnly:
+			switch (BoneId)
+			{
+				case EOculusXRBoneID::BodyRoot:
+				case EOculusXRBoneID::BodyHips:
+				case EOculusXRBoneID::BodySpineLower:
+				case EOculusXRBoneID::BodySpineMiddle:
+				case EOculusXRBoneID::BodySpineUpper:
+				case EOculusXRBoneID::BodyChest:
+				case EOculusXRBoneID::BodyNeck:
+				case EOculusXRBoneID::BodyHead:
+				case EOculusXRBoneID::BodyLeftShoulder:
+				case EOculusXRBoneID::BodyLeftArmUpper:
+				case EOculusXRBoneID::BodyLeftArmLower:
+				case EOculusXRBoneID::BodyLeftHandWrist:
+				case EOculusXRBoneID::BodyRightShoulder:
+				case EOculusXRBoneID::BodyRightArmUpper:
+				case EOculusXRBoneID::BodyRightArmLower:
+				case EOculusXRBoneID::BodyRightHandWrist:
+				case EOculusXRBoneID::BodyLeftUpperLeg:
+				case EOculusXRBoneID::BodyLeftLowerLeg:
+				case EOculusXRBoneID::BodyLeftFootAnkle:
+				case EOculusXRBoneID::BodyLeftFootBall:
+				case EOculusXRBoneID::BodyRightUpperLeg:
+				case EOculusXRBoneID::BodyRightLowerLeg:
+				case EOculusXRBoneID::BodyRightFootAnkle:
+				case EOculusXRBoneID::BodyRightFootBall:
+					return true;
+				default:
+					return false;
+			}
+		default:
+			return FOculusXRBodyRetargeter::IsHipOrRootSourceJoint(BoneId);
+	}
+}
+
+int64 FOculusXRBodyStateCodec::GetMaxEncodedBits() const
+{
+	int64 numBits = kLayoutHashBits + 1 + kConfidenceBits + kMaxPackedIntBits + 32 + 3 * 32;
+	for (int32 i = 0; i < EncodedJoints.Num(); ++i)
+	{
+		numBits += 1 + 2 + 3 * JointRotationBits[i];
+		if (Settings.bEncodePositions && i != HipsJointIndex)
+		{
+			numBits += 3 * PositionBits;
+		}
+	}
+	if (UsesHandPoses())
+	{
+		numBits += 2 + Settings.HandPoseCodec->GetEncodedBits(0) + Settings.HandPoseCodec->GetEncodedBits(1);
+	}
+	return numBits;
+}
+
+float FOculusXRBodyStateCodec::GetMaxRotationErrorDegrees(const int32 EncodedJointIndex) const
+{
+	// Half a step on each of the three components, plus the resulting error of the reconstructed largest component
+	const int32 numBits = JointRotationBits[EncodedJointIndex];
+	const float halfStep = kSmallestThreeRange / ((1u << numBits) - 1);
+	return FMath::RadiansToDegrees(4.0f * UE_SQRT_3 * halfStep);
+}
+
+void FOculusXRBodyStateCodec::Quantize(const FOculusXRBodyState& BodyState, FOculusXRQuantizedBodyState& outQuantized) const
+{
+	outQuantized.IsActive = BodyState.IsActive;
+	outQuantized.Confidence = static_cast<uint8>(FMath::RoundToInt32(FMath::Clamp(BodyState.Confidence, 0.0f, 1.0f) * 255.0f));
+	outQuantized.SkeletonChangedCount = static_cast<uint32>(BodyState.SkeletonChangedCount);
+	outQuantized.Time = BodyState.Time;
+
+	const int32 hipsIdx = static_cast<int32>(EOculusXRBoneID::BodyHips);
+	const FVector hipsPosition = BodyState.Joints.IsValidIndex(hipsIdx) ? BodyState.Joints[hipsIdx].Position : FVector::ZeroVector;
+	outQuantized.HipsPosition = FVector3f(hipsPosition);
+
+	for (int32 hand = 0; hand < 2; ++hand)
+	{
+		outQuantized.bIsHandValid[hand] = UsesHandPoses() && Settings.HandPoseCodec->Encode(BodyState, hand, outQuantized.HandCoefficients[hand]);
+	}
+
+	outQuantized.Joints.SetNum(EncodedJoints.Num());
+	for (int32 i = 0; i < EncodedJoints.Num(); ++i)
+	{
+		const int32 boneIdx = static_cast<int32>(EncodedJoints[i]);
+		FOculusXRQuantizedBodyJoint& quantizedJoint = outQuantized.Joints[i];
+		quantizedJoint = FOculusXRQuantizedBodyJoint();
+		if (!BodyState.Joints.IsValidIndex(boneIdx) || !BodyState.Joints[boneIdx].bIsValid)
+		{
+			continue;
+		}
+
+		const auto& joint = BodyState.Joints[boneIdx];
+		quantizedJoint.bIsValid = true;
+
+		const FQuat4f rotation = FQuat4f(joint.Orientation.Quaternion().GetNormalized());
+		const float components[4] = { rotation.X, rotation.Y, rotation.Z, rotation.W };
+		int32 largest = 0;
+		for (int32 c = 1; c < 4; ++c)
+		{
+			largest = FMath::Abs(components[c]) > FMath::Abs(components[largest]) ? c : largest;
+		}
+		// q and -q are the same rotation, the largest component is sent implicitly as positive
+		const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+		quantizedJoint.LargestComponent = static_cast<uint8>(largest);
+		for (int32 c = 0, out = 0; c < 4; ++c)
+		{
+			if (c != largest)
+			{
+				quantizedJoint.Rotation[out++] = QuantizeUnit(sign * components[c], kSmallestThreeRange, JointRotationBits[i]);
+			}
+		}
+
+		if (Settings.bEncodePositions && i != HipsJointIndex)
+		{
+			const FVector offset = joint.Position - hipsPosition;
+			for (int32 axis = 0; axis < 3; ++axis)
+			{
+				quantizedJoint.Position[axis] = QuantizeUnit(static_cast<float>(offset[axis]), Settings.PositionRange, PositionBits);
+			}
+		}
+	}
+}
+
+void FOculusXRBodyStateCodec::DequantizeJoint(const int32 EncodedJointIndex, const FOculusXRQuantizedBodyJoint& Joint, const FVector& HipsPosition, FQuat& outRotation, FVector& outPosition) const
+{
+	float components[4];
+	float sumSquares = 0.0f;
+	for (int32 c = 0, in = 0; c < 4; ++c)
+	{
+		if (c != Joint.LargestComponent)
+		{
+			components[c] = DequantizeUnit(Joint.Rotation[in++], kSmallestThreeRange, JointRotationBits[EncodedJointIndex]);
+			sumSquares += components[c] * components[c];
+		}
+	}
+	components[Joint.LargestComponent] = FMath::Sqrt(FMath::Max(0.0f, 1.0f - sumSquares));
+	outRotation = FQuat(FQuat4f(components[0], components[1], components[2], components[3]).GetNormalized());
+
+	if (EncodedJointIndex == HipsJointIndex)
+	{
+		outPosition = HipsPosition;
+	}
+	else if (Settings.bEncodePositions)
+	{
+		outPosition = HipsPosition
+			+ FVector(DequantizeUnit(Joint.Position[0], Settings.PositionRange, PositionBits),
+				DequantizeUnit(Joint.Position[1], Settings.PositionRange, PositionBits),
+				DequantizeUnit(Joint.Position[2], Settings.PositionRange, PositionBits));
+	}
+	else
+	{
+		outPosition = HipsPosition;
+	}
+}
+
+void FOculusXRBodyStateCodec::Dequantize(const FOculusXRQuantizedBodyState& Quantized, FOculusXRBodyState& outBodyState) const
+{
+	outBodyState.IsActive = Quantized.IsActive;
+	outBodyState.Confidence = Quantized.Confidence / 255.0f;
+	outBodyState.SkeletonChangedCount = static_cast<int32>(Quantized.SkeletonChangedCount);
+	outBodyState.Time = Quantized.Time;
+
+	outBodyState.Joints.SetNum(kNumBones);
+	for (auto& joint : outBodyState.Joints)
+	{
+		joint.bIsValid = false;
+	}
+
+	const FVector hipsPosition(Quantized.HipsPosition);
+	for (int32 i = 0; i < EncodedJoints.Num() && i < Quantized.Joints.Num(); ++i)
+	{
+		const FOculusXRQuantizedBodyJoint& quantizedJoint = Quantized.Joints[i];
+		if (!quantizedJoint.bIsValid)
+		{
+			continue;
+		}
+
+		auto& joint = outBodyState.Joints[static_cast<int32>(EncodedJoints[i])];
+		FQuat rotation;
+		DequantizeJoint(i, quantizedJoint, hipsPosition, rotation, joint.Position);
+		joint.Orientation = rotation.Rotator();
+		joint.bIsValid = true;
+	}
+	DequantizeHands(Quantized, outBodyState);
+}
+
+void FOculusXRBodyStateCodec::DequantizeHands(const FOculusXRQuantizedBodyState& Quantized, FOculusXRBodyState& outBodyState) const
+{
+	if (!UsesHandPoses())
+	{
+		return;
+	}
+	for (int32 hand = 0; hand < 2; ++hand)
+	{
+		if (Quantized.bIsHandValid[hand])
+		{
+			Settings.HandPoseCodec->Decode(Quantized.HandCoefficients[hand], hand, Settings.WorldToMeters, outBodyState);
+		}
+		else
+		{
+			for (const EOculusXRBoneID boneId : FOculusXRHandPoseCodec::GetHandJoints(hand))
+			{
+				outBodyState.Joints[static_cast<int32>(boneId)].bIsValid = false;
+			}
+		}
+	}
+}
+
+void FOculusXRBodyStateCodec::WriteHeader(const FOculusXRQuantizedBodyState& Quantized, FBitWriter& Writer) const
+{
+	WriteBits(Writer, LayoutHash, kLayoutHashBits);
+	Writer.WriteBit(Quantized.IsActive ? 1 : 0);
+	WriteBits(Writer, Quantized.Confidence, kConfidenceBits);
+	uint32 skeletonChangedCount = Quantized.SkeletonChangedCount;
+	Writer.SerializeIntPacked(skeletonChangedCount);
+	float time = Quantized.Time;
+	Writer << time;
+	FVector3f hipsPosition = Quantized.HipsPosition;
+	Writer << hipsPosition.X << hipsPosition.Y << hipsPosition.Z;
+
+	if (UsesHandPoses())
+	{
+		for (int32 hand = 0; hand < 2; ++hand)
+		{
+			Writer.WriteBit(Quantized.bIsHandValid[hand] ? 1 : 0);
+			if (Quantized.bIsHandValid[hand])
+			{
+				Settings.HandPoseCodec->WriteCoefficients(Quantized.HandCoefficients[hand], Writer);
+			}
+		}
+	}
+}
+
+bool FOculusXRBodyStateCodec::ReadHeader(FBitReader& Reader, FOculusXRQuantizedBodyState& outQuantized) const
+{
+	if (ReadBits(Reader, kLayoutHashBits) != LayoutHash)
+	{
+		Reader.SetError();
+		return false;
+	}
+	outQuantized.IsActive = Reader.ReadBit() != 0;
+	outQuantized.Confidence = static_cast<uint8>(ReadBits(Reader, kConfidenceBits));
+	Reader.SerializeIntPacked(outQuantized.SkeletonChangedCount);
+	Reader << outQuantized.Time;
+	Reader << outQuantized.HipsPosition.X << outQuantized.HipsPosition.Y << outQuantized.HipsPosition.Z;
+
+	for (int32 hand = 0; hand < 2; ++hand)
+	{
+		outQuantized.bIsHandValid[hand] = UsesHandPoses() && Reader.ReadBit() != 0;
+		if (outQuantized.bIsHandValid[hand])
+		{
+			Settings.HandPoseCodec->ReadCoefficients(Reader, outQuantized.HandCoefficients[hand], hand);
+		}
+		else
+		{
+			outQuantized.HandCoefficients[hand].Reset();
+		}
+	}
+	return !Reader.IsError();
+}
+
+void FOculusXRBodyStateCodec::WriteJoint(const int32 EncodedJointIndex, const FOculusXRQuantizedBodyJoint& Joint, FBitWriter& Writer) const
+{
+	Writer.WriteBit(Joint.bIsValid ? 1 : 0);
+	if (!Joint.bIsValid)
+	{
+		return;
+	}
+
+	WriteBits(Writer, Joint.LargestComponent, 2);
+	for (int32 c = 0; c < 3; ++c)
+	{
+		WriteBits(Writer, Joint.Rotation[c], JointRotationBits[EncodedJointIndex]);
+	}
+	if (Settings.bEncodePositions && EncodedJointIndex != HipsJointIndex)
+	{
+		for (int32 axis = 0; axis < 3; ++axis)
+		{
+			WriteBits(Writer, Joint.Position[axis], PositionBits);
+		}
+	}
+}
+
+void FOculusXRBodyStateCodec::ReadJoint(const int32 EncodedJointIndex, FBitReader& Reader, FOculusXRQuantizedBodyJoint& outJoint) const
+{
+	outJoint = FOculusXRQuantizedBodyJoint();
+	outJoint.bIsValid = Reader.ReadBit() != 0;
+	if (!outJoint.bIsValid)
+	{
+		return;
+	}
+
+	outJoint.LargestComponent = static_cast<uint8>(ReadBits(Reader, 2));
+	for (int32 c = 0; c < 3; ++c)
+	{
+		outJoint.Rotation[c] = ReadBits(Reader, JointRotationBits[EncodedJointIndex]);
+	}
+	if (Settings.bEncodePositions && EncodedJointIndex != HipsJointIndex)
+	{
+		for (int32 axis = 0; axis < 3; ++axis)
+		{
+			outJoint.Position[axis] = ReadBits(Reader, PositionBits);
+		}
+	}
+}
+
+void FOculusXRBodyStateCodec::Write(const FOculusXRQuantizedBodyState& Quantized, FBitWriter& Writer) const
+{
+	check(Quantized.Joints.Num() == EncodedJoints.Num());
+	WriteHeader(Quantized, Writer);
+	for (int32 i = 0; i < EncodedJoints.Num(); ++i)
+	{
+		WriteJoint(i, Quantized.Joints[i], Writer);
+	}
+}
+
+bool FOculusXRBodyStateCodec::Read(FBitReader& Reader, FOculusXRQuantizedBodyState& outQuantized) const
+{
+	if (!ReadHeader(Reader, outQuantized))
+	{
+		return false;
+	}
+	outQuantized.Joints.SetNum(EncodedJoints.Num());
+	for (int32 i = 0; i < EncodedJoints.Num(); ++i)
+	{
+		ReadJoint(i, Reader, outQuantized.Joints[i]);
+	}
+	return !Reader.IsError();
+}
+
+void FOculusXRBodyStateCodec::Encode(const FOculusXRBodyState& BodyState, FBitWriter& Writer) const
+{
+	FOculusXRQuantizedBodyState quantized;
+	Quantize(BodyState, quantized);
+	Write(quantized, Writer);
+}
+
+bool FOculusXRBodyStateCodec::Decode(FBitReader& Reader, FOculusXRBodyState& outBodyState) const
+{
+	FOculusXRQuantizedBodyState quantized;
+	if (!Read(Reader, quantized))
+	{
+		return false;
+	}
+	Dequantize(quantized, outBodyState);
+	return true;
+}
+
+FOculusXRTieredBodyStateCodec::FOculusXRTieredBodyStateCodec(const FOculusXRBodyStateCodecSettings& InSettings, const TMap<EOculusXRBoneID, FName>* BoneRemapping)
+{
+	FOculusXRBodyStateCodecSettings tierSettings = InSettings;
+	Codecs.Reserve(kNumTiers);
+	for (int32 tier = 0; tier < kNumTiers; ++tier)
+	{
+		tierSettings.FidelityTier = static_cast<EOculusXRBodyFidelityTier>(tier);
+		Codecs.Emplace(tierSettings, BoneRemapping);
+	}
+}
+
+void FOculusXRTieredBodyStateCodec::Encode(const EOculusXRBodyFidelityTier Tier, const FOculusXRBodyState& BodyState, FBitWriter& Writer) const
+{
+	WriteBits(Writer, static_cast<uint32>(Tier), kTierBits);
+	GetCodec(Tier).Encode(BodyState, Writer);
+}
+
+bool FOculusXRTieredBodyStateCodec::Decode(FBitReader& Reader, FOculusXRBodyState& outBodyState, EOculusXRBodyFidelityTier& outTier) const
+{
+	const uint32 tier = ReadBits(Reader, kTierBits);
+	if (Reader.IsError() || tier >= static_cast<uint32>(kNumTiers))
+	{
+		return false;
+	}
+	outTier = static_cast<EOculusXRBodyFidelityTier>(tier);
+	return GetCodec(outTier).Decode(Reader, outBodyState);
+}
+
+int64 FOculusXRTieredBodyStateCodec::GetMaxEncodedBits(const EOculusXRBodyFidelityTier Tier) const
+{
+	return kTierBits + GetCodec(Tier).GetMaxEncodedBits();
+}
+
+void FOculusXRBodyStateCodecErrorStats::Add(const FOculusXRBodyState& Original, const FOculusXRBodyState& Decoded)
+{
+	const int32 numJoints = FMath::Min(Original.Joints.Num(), Decoded.Joints.Num());
+	for (int32 i = 0; i < numJoints; ++i)
+	{
+		const auto& originalJoint = Original.Joints[i];
+		const auto& decodedJoint = Decoded.Joints[i];
+		if (!originalJoint.bIsValid || !decodedJoint.bIsValid)
+		{
+			continue;
+		}
+
+		const double rotationError = FMath::RadiansToDegrees(originalJoint.Orientation.Quaternion().AngularDistance(decodedJoint.Orientation.Quaternion()));
+		const double positionError = FVector::Distance(originalJoint.Position, decodedJoint.Position);
+		++NumJoints;
+		SumRotationErrorDegrees += rotationError;
+		MaxRotationErrorDegrees = FMath::Max(MaxRotationErrorDegrees, rotationError);
+		SumPositionError += positionError;
+		MaxPositionError = FMath::Max(MaxPositionError, positionError);
+	}
+}
+
+FString FOculusXRBodyStateCodecErrorStats::ToString() const
+{
+	return FString::Printf(TEXT("%d joints, rotation error mean %.4f max %.4f degrees, position error mean %.4f max %.4f"),
+		NumJoints, GetMeanRotationErrorDegrees(), MaxRotationErrorDegrees, GetMeanPositionError(), MaxPositionError);
+}
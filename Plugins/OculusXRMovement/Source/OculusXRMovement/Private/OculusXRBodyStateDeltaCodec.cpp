@@ -0,0 +1,206 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRBodyStateDeltaCodec.h"
+#include "OculusXRBodyRetargeter.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+namespace
+{
+	constexpr int32 kNumBones = static_cast<int32>(EOculusXRBoneID::COUNT);
+} // namespace
+
+FOculusXRBodyStateDeltaSettings::FOculusXRBodyStateDeltaSettings()
+{
+	for (int32 i = 0; i < kNumBones; ++i)
+	{
+		const bool bIsFinger = FOculusXRBodyRetargeter::IsFingerSourceJoint(static_cast<EOculusXRBoneID>(i));
+		RotationErrorDegrees[i] = bIsFinger ? 2.0f : 0.5f;
+		PositionError[i] = bIsFinger ? 0.5f : 0.25f;
+	}
+}
+
+FOculusXRBodyStateDeltaEncoder::FOculusXRBodyStateDeltaEncoder(const TSharedRef<const FOculusXRBodyStateCodec>& InCodec, const FOculusXRBodyStateDeltaSettings& InSettings)
+	: Codec(InCodec)
+	, Settings(InSettings)
+	, Baselines(InSettings.KeyframeInterval, InSettings.MaxPendingBaselines)
+{
+	for (const EOculusXRBoneID boneId : Codec->GetEncodedJoints())
+	{
+		JointRotationErrorRadians.Add(FMath::DegreesToRadians(Settings.RotationErrorDegrees[static_cast<int32>(boneId)]));
+		JointPositionError.Add(Settings.PositionError[static_cast<int32>(boneId)]);
+	}
+}
+
+void FOculusXRBodyStateDeltaEncoder::Reset()
+{
+	Baselines.Reset();
+}
+
+void FOculusXRBodyStateDeltaEncoder::Ack(const uint16 Sequence)
+{
+	Baselines.Ack(Sequence);
+}
+
+bool FOculusXRBodyStateDeltaEncoder::IsJointChanged(const int32 EncodedJointIndex, const FOculusXRQuantizedBodyJoint& Joint, const FVector& HipsPosition, const FOculusXRQuantizedBodyJoint& BaselineJoint, const FVector& BaselineHipsPosition) const
+{
+	if (Joint.bIsValid != BaselineJoint.bIsValid)
+	{
+		return true;
+	}
+	if (!Joint.bIsValid || Joint == BaselineJoint)
+	{
+		return false;
+	}
+
+	FQuat rotation, baselineRotation;
+	FVector position, baselinePosition;
+	Codec->DequantizeJoint(EncodedJointIndex, Joint, HipsPosition, rotation, position);
+	Codec->DequantizeJoint(EncodedJointIndex, BaselineJoint, BaselineHipsPosition, baselineRotation, baselinePosition);
+
+	// The receiver keeps the baseline offset from the hips, compare what it would reconstruct with the new hips
+	return rotation.AngularDistance(baselineRotation) > JointRotationErrorRadians[EncodedJointIndex]
+		|| FVector::DistSquared(position - HipsPosition, baselinePosition - BaselineHipsPosition) > FMath::Square(JointPositionError[EncodedJointIndex]);
+}
+
+uint16 FOculusXRBodyStateDeltaEncoder::Encode(const FOculusXRBodyState& BodyState, FBitWriter& Writer)
+{
+	Codec->Quantize(BodyState, Current);
+
+	uint16 sequence = 0;
+	const FOculusXRQuantizedBodyState* baseline = Baselines.BeginPacket(Writer, sequence);
+	const bool bKeyframe = baseline == nullptr;
+	Codec->WriteHeader(Current, Writer);
+
+	// Current becomes what the receiver reconstructs: the joints that are not sent keep their baseline value
+	const int32 numJoints = Codec->GetEncodedJoints().Num();
+	LastNumChangedJoints = 0;
+	if (bKeyframe)
+	{
+		for (int32 i = 0; i < numJoints; ++i)
+		{
+			Codec->WriteJoint(i, Current.Joints[i], Writer);
+		}
+		LastNumChangedJoints = numJoints;
+	}
+	else
+	{
+		const FVector hipsPosition(Current.HipsPosition);
+		const FVector baselineHipsPosition(baseline->HipsPosition);
+		for (int32 i = 0; i < numJoints; ++i)
+		{
+			const bool bChanged = IsJointChanged(i, Current.Joints[i], hipsPosition, baseline->Joints[i], baselineHipsPosition);
+			Writer.WriteBit(bChanged ? 1 : 0);
+			if (bChanged)
+			{
+				Codec->WriteJoint(i, Current.Joints[i], Writer);
+				++LastNumChangedJoints;
+			}
+			else
+			{
+				Current.Joints[i] = baseline->Joints[i];
+			}
+		}
+	}
+	bLastPacketKeyframe = bKeyframe;
+
+	Baselines.EndPacket(sequence, Current);
+	return sequence;
+}
+
+FOculusXRBodyStateDeltaDecoder::FOculusXRBodyStateDeltaDecoder(const TSharedRef<const FOculusXRBodyStateCodec>& InCodec, const int32 InMaxBaselines)
+	: Codec(InCodec)
+	, Baselines(InMaxBaselines)
+{
+}
+
+bool FOculusXRBodyStateDeltaDecoder::Decode(FBitReader& Reader, FOculusXRBodyState& outBodyState, uint16& outSequence)
+{
+	uint16 sequence = 0;
+	const FOculusXRQuantizedBodyState* baseline = nullptr;
+	if (!Baselines.BeginPacket(Reader, sequence, baseline))
+	{
+		return false;
+	}
+	const bool bKeyframe = baseline == nullptr;
+
+	FOculusXRQuantizedBodyState decoded;
+	if (!Codec->ReadHeader(Reader, decoded))
+	{
+		return false;
+	}
+
+	const int32 numJoints = Codec->GetEncodedJoints().Num();
+	decoded.Joints.SetNum(numJoints);
+	for (int32 i = 0; i < numJoints; ++i)
+	{
+		if (bKeyframe || Reader.ReadBit())
+		{
+			Codec->ReadJoint(i, Reader, decoded.Joints[i]);
+		}
+		else
+		{
+			decoded.Joints[i] = baseline->Joints[i];
+		}
+	}
+	if (Reader.IsError())
+	{
+		return false;
+	}
+
+	// Convert only the joints that differ from the last decoded state
+	const bool bHasCache = LastDecoded.Joints.Num() == numJoints;
+	CachedOrientations.SetNum(numJoints);
+	CachedOffsets.SetNum(numJoints);
+	LastNumConvertedJoints = 0;
+
+	const FVector hipsPosition(decoded.HipsPosition);
+	outBodyState.IsActive = decoded.IsActive;
+	outBodyState.Confidence = decoded.Confidence / 255.0f;
+	outBodyState.SkeletonChangedCount = static_cast<int32>(decoded.SkeletonChangedCount);
+	outBodyState.Time = decoded.Time;
+	if (outBodyState.Joints.Num() != kNumBones)
+	{
+		outBodyState.Joints.SetNum(kNumBones);
+		for (auto& joint : outBodyState.Joints)
+		{
+			joint.bIsValid = false;
+		}
+	}
+
+	for (int32 i = 0; i < numJoints; ++i)
+	{
+		const FOculusXRQuantizedBodyJoint& joint = decoded.Joints[i];
+		auto& outJoint = outBodyState.Joints[static_cast<int32>(Codec->GetEncodedJoints()[i])];
+		outJoint.bIsValid = joint.bIsValid;
+		if (!joint.bIsValid)
+		{
+			continue;
+		}
+
+		if (!bHasCache || !(joint == LastDecoded.Joints[i]))
+		{
+			FQuat rotation;
+			FVector position;
+			Codec->DequantizeJoint(i, joint, FVector::ZeroVector, rotation, position);
+			CachedOrientations[i] = rotation.Rotator();
+			CachedOffsets[i] = position;
+			++LastNumConvertedJoints;
+		}
+		outJoint.Orientation = CachedOrientations[i];
+		outJoint.Position = hipsPosition + CachedOffsets[i];
+	}
+	// Hand poses are sent in every header, they only depend on the wrists decoded above
+	Codec->DequantizeHands(decoded, outBodyState);
+
+	Baselines.EndPacket(sequence, decoded);
+	LastDecoded = MoveTemp(decoded);
+	outSequence = sequence;
+	return true;
+}
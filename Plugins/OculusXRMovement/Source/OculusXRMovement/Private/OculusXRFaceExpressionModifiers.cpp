@@ -0,0 +1,75 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRFaceExpressionModifiers.h"
+#include "AnimNode_OculusXRFaceTracking.h"
+
+namespace
+{
+	constexpr int32 kLanes = 4;
+	constexpr float kMinExponent = 0.01f;
+} // namespace
+
+FOculusXRFaceExpressionModifiers::FOculusXRFaceExpressionModifiers(const int32 InNumExpressions)
+{
+	Reset(InNumExpressions);
+}
+
+void FOculusXRFaceExpressionModifiers::Reset(const int32 InNumExpressions)
+{
+	NumExpressions = FMath::Max(InNumExpressions, 0);
+	bHasResponse = false;
+	const int32 numPadded = Align(NumExpressions, kLanes);
+	Exponents.Init(1.0f, numPadded);
+	Multipliers.Init(1.0f, numPadded);
+	MinValues.Init(-UE_MAX_FLT, numPadded);
+	MaxValues.Init(UE_MAX_FLT, numPadded);
+}
+
+void FOculusXRFaceExpressionModifiers::Set(const int32 ExpressionIndex, const FOculusXRFaceExpressionModifierNew& Modifier)
+{
+	check(ExpressionIndex >= 0 && ExpressionIndex < NumExpressions);
+	Exponents[ExpressionIndex] = FMath::Max(Modifier.ResponseExponent, kMinExponent);
+	Multipliers[ExpressionIndex] = Modifier.Multiplier;
+	MinValues[ExpressionIndex] = Modifier.MinValue;
+	MaxValues[ExpressionIndex] = Modifier.MaxValue;
+	bHasResponse |= Exponents[ExpressionIndex] != 1.0f;
+}
+
+float FOculusXRFaceExpressionModifiers::Apply(const FOculusXRFaceExpressionModifierNew& Modifier, const float Weight)
+{
+	const float exponent = FMath::Max(Modifier.ResponseExponent, kMinExponent);
+	const float response = exponent != 1.0f ? FMath::Pow(FMath::Max(Weight, 0.0f), exponent) : Weight;
+	return FMath::Clamp(response * Modifier.Multiplier, Modifier.MinValue, Modifier.MaxValue);
+}
+
+void FOculusXRFaceExpressionModifiers::Apply(const float* InWeights, float* OutWeights) const
+{
+	const int32 numVectorized = NumExpressions - NumExpressions % kLanes;
+	const VectorRegister4Float zero = VectorZeroFloat();
+	const VectorRegister4Float one = VectorOneFloat();
+	for (int32 i = 0; i < numVectorized; i += kLanes)
+	{
+		VectorRegister4Float weights = VectorLoad(InWeights + i);
+		if (bHasResponse)
+		{
+			// Lanes without a response keep their weight as is, negative ones included, like the scalar paths
+			const VectorRegister4Float exponents = VectorLoadAligned(Exponents.GetData() + i);
+			weights = VectorSelect(VectorCompareEQ(exponents, one), weights, VectorPow(VectorMax(weights, zero), exponents));
+		}
+		weights = VectorMultiply(weights, VectorLoadAligned(Multipliers.GetData() + i));
+		weights = VectorMin(VectorMax(weights, VectorLoadAligned(MinValues.GetData() + i)), VectorLoadAligned(MaxValues.GetData() + i));
+		VectorStore(weights, OutWeights + i);
+	}
+
+	for (int32 i = numVectorized; i < NumExpressions; ++i)
+	{
+		const float response = bHasResponse && Exponents[i] != 1.0f ? FMath::Pow(FMath::Max(InWeights[i], 0.0f), Exponents[i]) : InWeights[i];
+		OutWeights[i] = FMath::Clamp(response * Multipliers[i], MinValues[i], MaxValues[i]);
+	}
+}
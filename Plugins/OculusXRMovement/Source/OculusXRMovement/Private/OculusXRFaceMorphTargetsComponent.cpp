@@ -0,0 +1,162 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRFaceMorphTargetsComponent.h"
+#include "OculusXRRetargeting.h"
+#include "Animation/MorphTarget.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Face Morph Targets"), STAT_OculusXRFaceMorphTargets, STATGROUP_OculusXRMovement);
+
+void FOculusXRFaceMorphTargetWriter::Initialize(const FOculusXRFaceRetargetMatrix& InMatrix, const USkeletalMesh* InMesh)
+{
+	Initialize(InMatrix, [InMesh](const FName CurveName) {
+		int32 morphTargetIndex = INDEX_NONE;
+		return InMesh && InMesh->FindMorphTargetAndIndex(CurveName, morphTargetIndex) ? morphTargetIndex : INDEX_NONE;
+	});
+
+	Mesh = InMesh;
+	MorphTargets.Reset(MorphTargetIndices.Num());
+	for (const int32 morphTargetIndex : MorphTargetIndices)
+	{
+		MorphTargets.Add(InMesh->GetMorphTargets()[morphTargetIndex]);
+	}
+}
+
+void FOculusXRFaceMorphTargetWriter::Initialize(const FOculusXRFaceRetargetMatrix& InMatrix, TFunctionRef<int32(FName)> FindMorphTargetIndex)
+{
+	MorphTargetIndices.Reset();
+	MorphTargets.Reset();
+	Mesh.Reset();
+	// Rows are visited in order, the indices line up with the kept rows
+	Matrix = InMatrix.Trim([&](const FName CurveName) {
+		const int32 morphTargetIndex = FindMorphTargetIndex(CurveName);
+		if (morphTargetIndex == INDEX_NONE)
+		{
+			return false;
+		}
+		MorphTargetIndices.Add(morphTargetIndex);
+		return true;
+	});
+	Values.SetNumZeroed(Matrix.GetNumCurves());
+}
+
+void FOculusXRFaceMorphTargetWriter::Write(const float* ExpressionWeights, TArrayView<float> InOutMorphTargetWeights) const
+{
+	Matrix.Multiply(ExpressionWeights, Values.GetData());
+	for (int32 row = 0; row < MorphTargetIndices.Num(); ++row)
+	{
+		InOutMorphTargetWeights[MorphTargetIndices[row]] = Values[row];
+	}
+}
+
+void FOculusXRFaceMorphTargetWriter::Write(const float* ExpressionWeights, USkinnedMeshComponent& Component) const
+{
+	const USkeletalMesh* componentMesh = Mesh.Get();
+	if (!componentMesh || Component.GetSkinnedAsset() != componentMesh)
+	{
+		return;
+	}
+	const int32 numMorphTargets = componentMesh->GetMorphTargets().Num();
+	if (Component.MorphTargetWeights.Num() != numMorphTargets)
+	{
+		Component.MorphTargetWeights.SetNumZeroed(numMorphTargets);
+	}
+
+	Write(ExpressionWeights, Component.MorphTargetWeights);
+	for (int32 row = 0; row < MorphTargets.Num(); ++row)
+	{
+		Component.ActiveMorphTargets.Add(MorphTargets[row], MorphTargetIndices[row]);
+	}
+	Component.MarkRenderDynamicDataDirty();
+}
+
+UOculusXRFaceMorphTargetsComponent::UOculusXRFaceMorphTargetsComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+}
+
+void UOculusXRFaceMorphTargetsComponent::SetTargetMesh(USkeletalMeshComponent* InTargetMesh)
+{
+	if (TargetMesh)
+	{
+		RemoveTickPrerequisiteComponent(TargetMesh);
+	}
+	TargetMesh = InTargetMesh;
+	if (TargetMesh)
+	{
+		// Animation rebuilds the active morph targets when the mesh ticks, these weights go on top
+		AddTickPrerequisiteComponent(TargetMesh);
+	}
+	CompiledMesh.Reset();
+}
+
+void UOculusXRFaceMorphTargetsComponent::Recompile()
+{
+	CompiledMesh.Reset();
+}
+
+void UOculusXRFaceMorphTargetsComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!TargetMesh && GetOwner())
+	{
+		SetTargetMesh(GetOwner()->FindComponentByClass<USkeletalMeshComponent>());
+	}
+}
+
+void UOculusXRFaceMorphTargetsComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	SCOPE_CYCLE_COUNTER(STAT_OculusXRFaceMorphTargets);
+
+	const USkeletalMesh* Mesh = TargetMesh ? TargetMesh->GetSkeletalMeshAsset() : nullptr;
+	if (!Mesh)
+	{
+		return;
+	}
+
+	const TSharedRef<IOculusXRMovementDataProvider> Provider = FOculusXRMovementDataProviderRegistry::FindProvider(TargetMesh);
+	if (!Provider->IsAvailable() || !Provider->GetFaceState(FaceState) || !FaceState.bIsValid)
+	{
+		return;
+	}
+
+	// Indices are resolved once per mesh
+	if (Mesh != CompiledMesh.Get())
+	{
+		const int32 numExpressions = static_cast<int32>(EOculusXRFaceExpression::COUNT);
+		CompiledModifiers.Reset(numExpressions);
+		for (const auto& modifier : ExpressionModifiers)
+		{
+			if (static_cast<int32>(modifier.Key) < numExpressions)
+			{
+				CompiledModifiers.Set(static_cast<int32>(modifier.Key), modifier.Value);
+			}
+		}
+		Writer.Initialize(RetargetAsset ? RetargetAsset->GetMatrix() : *UOculusXRFaceRetargetAsset::GetDefaultMatrix(), Mesh);
+		ModifiedWeights.SetNumZeroed(numExpressions);
+		CompiledMesh = Mesh;
+		if (Writer.GetNumMorphTargets() == 0)
+		{
+			UE_LOG(LogOculusXRRetargeting, Warning, TEXT("No face curve of %s matches a morph target of %s."), *GetPathName(), *Mesh->GetPathName());
+		}
+	}
+	if (FaceState.ExpressionWeights.Num() < CompiledModifiers.GetNumExpressions())
+	{
+		return;
+	}
+
+	CompiledModifiers.Apply(FaceState.ExpressionWeights.GetData(), ModifiedWeights.GetData());
+	Writer.Write(ModifiedWeights.GetData(), *TargetMesh);
+}
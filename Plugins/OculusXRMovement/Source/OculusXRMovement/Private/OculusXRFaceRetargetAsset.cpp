@@ -0,0 +1,494 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRFaceRetargetAsset.h"
+#include "AnimNode_OculusXRFaceTracking.h"
+#include "OculusXRRetargeting.h"
+#include "Algo/Sort.h"
+#include "Algo/StableSort.h"
+#include "Animation/Skeleton.h"
+#include "Misc/DataValidation.h"
+#include "Serialization/CustomVersion.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#define LOCTEXT_NAMESPACE "OculusXRFaceRetargetAsset"
+
+namespace
+{
+	constexpr int32 kNumExpressions = static_cast<int32>(EOculusXRFaceExpression::COUNT);
+
+	struct FFaceRetargetAssetVersion
+	{
+		enum Type
+		{
+			Initial = 0,
+			// The compiled matrix follows the properties
+			CompiledMatrix,
+			// The compiled matrix is saved as a sized blob, so a bad one can be skipped
+			CompiledMatrixBlob,
+
+			VersionPlusOne,
+			LatestVersion = VersionPlusOne - 1
+		};
+
+		static const FGuid GUID;
+	};
+
+	const FGuid FFaceRetargetAssetVersion::GUID(0x5E0B2C71, 0x4A6D4F19, 0x9C3E8B27, 0xD1F6A403);
+	FCustomVersionRegistration GRegisterFaceRetargetAssetVersion(FFaceRetargetAssetVersion::GUID, FFaceRetargetAssetVersion::LatestVersion, TEXT("OculusXRFaceRetargetAsset"));
+
+	struct FMatrixEntry
+	{
+		FName CurveName;
+		int32 Column;
+		float Value;
+	};
+
+	// Entries must be sorted by curve name, then by column
+	FOculusXRFaceRetargetMatrix BuildFromSortedEntries(const TArray<FMatrixEntry>& Entries, const bool bClampOutput)
+	{
+		FOculusXRFaceRetargetMatrix matrix;
+		matrix.bClampOutput = bClampOutput;
+		matrix.RowOffsets.Add(0);
+		for (int32 i = 0; i < Entries.Num(); ++i)
+		{
+			const FMatrixEntry& entry = Entries[i];
+			if (matrix.CurveNames.IsEmpty() || matrix.CurveNames.Last() != entry.CurveName)
+			{
+				if (!matrix.CurveNames.IsEmpty())
+				{
+					matrix.RowOffsets.Add(matrix.Columns.Num());
+				}
+				matrix.CurveNames.Add(entry.CurveName);
+			}
+			else if (matrix.Columns.Num() > matrix.RowOffsets.Last() && matrix.Columns.Last() == entry.Column)
+			{
+				matrix.Values.Last() += entry.Value;
+				continue;
+			}
+			matrix.Columns.Add(entry.Column);
+			matrix.Values.Add(entry.Value);
+		}
+		if (!matrix.CurveNames.IsEmpty())
+		{
+			matrix.RowOffsets.Add(matrix.Columns.Num());
+		}
+		return matrix;
+	}
+
+	void SortEntries(TArray<FMatrixEntry>& Entries)
+	{
+		Algo::StableSort(Entries, [](const FMatrixEntry& A, const FMatrixEntry& B) {
+			if (A.CurveName != B.CurveName)
+			{
+				return A.CurveName.FastLess(B.CurveName);
+			}
+			return A.Column < B.Column;
+		});
+	}
+
+	// FastLess compares name table indices, which differ between processes, so loaded rows are sorted again
+	void SortRows(FOculusXRFaceRetargetMatrix& Matrix)
+	{
+		if (Matrix.AreRowsSorted())
+		{
+			return;
+		}
+
+		TArray<int32> order;
+		order.Reserve(Matrix.GetNumCurves());
+		for (int32 row = 0; row < Matrix.GetNumCurves(); ++row)
+		{
+			order.Add(row);
+		}
+		Algo::Sort(order, [&Matrix](const int32 A, const int32 B) { return Matrix.CurveNames[A].FastLess(Matrix.CurveNames[B]); });
+
+		TArray<FName> curveNames;
+		TArray<int32> rowOffsets;
+		TArray<int32> columns;
+		TArray<float> values;
+		curveNames.Reserve(order.Num());
+		rowOffsets.Reserve(order.Num() + 1);
+		columns.Reserve(Matrix.Columns.Num());
+		values.Reserve(Matrix.Values.Num());
+		rowOffsets.Add(0);
+		for (const int32 row : order)
+		{
+			curveNames.Add(Matrix.CurveNames[row]);
+			for (int32 i = Matrix.RowOffsets[row]; i < Matrix.RowOffsets[row + 1]; ++i)
+			{
+				columns.Add(Matrix.Columns[i]);
+				values.Add(Matrix.Values[i]);
+			}
+			rowOffsets.Add(columns.Num());
+		}
+		Matrix.CurveNames = MoveTemp(curveNames);
+		Matrix.RowOffsets = MoveTemp(rowOffsets);
+		Matrix.Columns = MoveTemp(columns);
+		Matrix.Values = MoveTemp(values);
+	}
+} // namespace
+
+FOculusXRFaceRetargetMatrix FOculusXRFaceRetargetMatrix::Build(TArrayView<const FOculusXRFaceRetargetCurve> Curves, const bool bClampOutput)
+{
+	TArray<FMatrixEntry> entries;
+	for (const FOculusXRFaceRetargetCurve& curve : Curves)
+	{
+		if (curve.CurveName.IsNone())
+		{
+			continue;
+		}
+		for (const FOculusXRFaceRetargetWeight& weight : curve.Expressions)
+		{
+			const int32 column = static_cast<int32>(weight.Expression);
+			if (column < kNumExpressions && weight.Weight != 0.0f)
+			{
+				entries.Add({ curve.CurveName, column, weight.Weight });
+			}
+		}
+	}
+	SortEntries(entries);
+
+	FOculusXRFaceRetargetMatrix matrix = BuildFromSortedEntries(entries, bClampOutput);
+	matrix.NumExpressions = kNumExpressions;
+	return matrix;
+}
+
+FOculusXRFaceRetargetMatrix FOculusXRFaceRetargetMatrix::Build(const TMap<EOculusXRFaceExpression, FOculusXRExpressionCurves>& ExpressionNames)
+{
+	// Later expressions replace earlier ones for the same curve
+	TMap<FName, int32> curveExpressions;
+	for (int32 expressionIndex = 0; expressionIndex < kNumExpressions; ++expressionIndex)
+	{
+		if (const FOculusXRExpressionCurves* expressionCurves = ExpressionNames.Find(static_cast<EOculusXRFaceExpression>(expressionIndex)))
+		{
+			for (const FName& curveName : expressionCurves->CurveNames)
+			{
+				if (!curveName.IsNone())
+				{
+					curveExpressions.Add(curveName, expressionIndex);
+				}
+			}
+		}
+	}
+
+	TArray<FMatrixEntry> entries;
+	entries.Reserve(curveExpressions.Num());
+	for (const auto& curveExpression : curveExpressions)
+	{
+		entries.Add({ curveExpression.Key, curveExpression.Value, 1.0f });
+	}
+	SortEntries(entries);
+
+	// Weights keep their modified range, as when they were written to the curves directly
+	FOculusXRFaceRetargetMatrix matrix = BuildFromSortedEntries(entries, false);
+	matrix.NumExpressions = kNumExpressions;
+	return matrix;
+}
+
+void FOculusXRFaceRetargetMatrix::Multiply(const float* Weights, float* OutCurveValues) const
+{
+	const int32* columns = Columns.GetData();
+	const float* values = Values.GetData();
+	for (int32 row = 0; row < CurveNames.Num(); ++row)
+	{
+		float sum = 0.0f;
+		for (int32 i = RowOffsets[row]; i < RowOffsets[row + 1]; ++i)
+		{
+			sum += values[i] * Weights[columns[i]];
+		}
+		OutCurveValues[row] = bClampOutput ? FMath::Clamp(sum, 0.0f, 1.0f) : sum;
+	}
+}
+
+FOculusXRFaceRetargetMatrix FOculusXRFaceRetargetMatrix::Trim(TFunctionRef<bool(FName)> KeepCurve) const
+{
+	FOculusXRFaceRetargetMatrix trimmed;
+	trimmed.bClampOutput = bClampOutput;
+	trimmed.NumExpressions = NumExpressions;
+	trimmed.RowOffsets.Add(0);
+	for (int32 row = 0; row < CurveNames.Num(); ++row)
+	{
+		if (!KeepCurve(CurveNames[row]))
+		{
+			continue;
+		}
+		trimmed.CurveNames.Add(CurveNames[row]);
+		for (int32 i = RowOffsets[row]; i < RowOffsets[row + 1]; ++i)
+		{
+			trimmed.Columns.Add(Columns[i]);
+			trimmed.Values.Add(Values[i]);
+		}
+		trimmed.RowOffsets.Add(trimmed.Columns.Num());
+	}
+	return trimmed;
+}
+
+bool FOculusXRFaceRetargetMatrix::Serialize(FArchive& Ar)
+{
+	uint32 magic = kMagic;
+	uint32 version = kCurrentVersion;
+	Ar << magic;
+	Ar << version;
+	if (Ar.IsLoading() && (magic != kMagic || version == 0 || version > kCurrentVersion))
+	{
+		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Unsupported face retarget matrix (magic 0x%08x, version %u)."), magic, version);
+		*this = FOculusXRFaceRetargetMatrix();
+		return false;
+	}
+
+	Ar << NumExpressions;
+	uint8 clampOutput = bClampOutput ? 1 : 0;
+	Ar << clampOutput;
+	bClampOutput = clampOutput != 0;
+	Ar << CurveNames;
+	RowOffsets.BulkSerialize(Ar);
+	Columns.BulkSerialize(Ar);
+	Values.BulkSerialize(Ar);
+
+	// Offsets and columns are used without bound checks when evaluating, and callers size their weights to every expression
+	if (Ar.IsLoading())
+	{
+		bool bIsValid = NumExpressions > 0 && NumExpressions <= kNumExpressions && RowOffsets.Num() == CurveNames.Num() + 1 && Columns.Num() == Values.Num() && RowOffsets[0] == 0 && RowOffsets.Last() == Columns.Num();
+		for (int32 row = 0; bIsValid && row < CurveNames.Num(); ++row)
+		{
+			bIsValid = RowOffsets[row] <= RowOffsets[row + 1];
+		}
+		for (int32 i = 0; bIsValid && i < Columns.Num(); ++i)
+		{
+			bIsValid = Columns[i] >= 0 && Columns[i] < NumExpressions;
+		}
+		if (bIsValid && !Ar.IsError())
+		{
+			SortRows(*this);
+			for (int32 row = 1; bIsValid && row < CurveNames.Num(); ++row)
+			{
+				bIsValid = CurveNames[row - 1] != CurveNames[row];
+			}
+		}
+		if (!bIsValid || Ar.IsError())
+		{
+			UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Corrupt face retarget matrix."));
+			*this = FOculusXRFaceRetargetMatrix();
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FOculusXRFaceRetargetMatrix::AreRowsSorted() const
+{
+	for (int32 row = 1; row < CurveNames.Num(); ++row)
+	{
+		if (!CurveNames[row - 1].FastLess(CurveNames[row]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void FOculusXRFaceRetargetMatrix::FindCoverage(TConstArrayView<FName> TargetCurveNames, TArray<FName>& OutUncoveredCurves, TArray<FName>& OutUnknownCurves) const
+{
+	OutUncoveredCurves.Reset();
+	OutUnknownCurves.Reset();
+	const TSet<FName> targetCurves(TargetCurveNames);
+	const TSet<FName> rowCurves(CurveNames);
+	for (const FName& curveName : TargetCurveNames)
+	{
+		if (!rowCurves.Contains(curveName))
+		{
+			OutUncoveredCurves.AddUnique(curveName);
+		}
+	}
+	for (const FName& curveName : CurveNames)
+	{
+		if (!targetCurves.Contains(curveName))
+		{
+			OutUnknownCurves.Add(curveName);
+		}
+	}
+}
+
+void UOculusXRFaceRetargetAsset::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+	Ar.UsingCustomVersion(FFaceRetargetAssetVersion::GUID);
+	if (Ar.IsLoading() && Ar.CustomVer(FFaceRetargetAssetVersion::GUID) < FFaceRetargetAssetVersion::CompiledMatrix)
+	{
+		return;
+	}
+
+	if (Ar.IsSaving() && !bIsMatrixLoaded && Matrix->RowOffsets.IsEmpty())
+	{
+		// Never compiled, e.g. saved right after creation
+		CompileMatrix();
+	}
+	// The matrix goes through its own archive, a bad one is dropped and recompiled in PostLoad without failing the package
+	if (Ar.IsLoading())
+	{
+		// Nodes may still use the previous matrix, the loaded one replaces it
+		TSharedRef<FOculusXRFaceRetargetMatrix> loadedMatrix = MakeShared<FOculusXRFaceRetargetMatrix>();
+		if (Ar.CustomVer(FFaceRetargetAssetVersion::GUID) < FFaceRetargetAssetVersion::CompiledMatrixBlob)
+		{
+			bIsMatrixLoaded = loadedMatrix->Serialize(Ar);
+		}
+		else
+		{
+			TArray<uint8> matrixData;
+			Ar << matrixData;
+			FMemoryReader matrixReader(matrixData);
+			bIsMatrixLoaded = loadedMatrix->Serialize(matrixReader);
+			if (!bIsMatrixLoaded)
+			{
+				UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Recompiling the face retarget matrix of %s."), *GetPathName());
+			}
+		}
+		Matrix = loadedMatrix;
+	}
+	else if (Ar.IsSaving())
+	{
+		TArray<uint8> matrixData;
+		FMemoryWriter matrixWriter(matrixData);
+		// Saving only reads the matrix
+		const_cast<FOculusXRFaceRetargetMatrix&>(*Matrix).Serialize(matrixWriter);
+		Ar << matrixData;
+	}
+}
+
+void UOculusXRFaceRetargetAsset::PostLoad()
+{
+	Super::PostLoad();
+	if (!bIsMatrixLoaded)
+	{
+		CompileMatrix();
+	}
+}
+
+#if WITH_EDITOR
+void UOculusXRFaceRetargetAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	CompileMatrix();
+}
+
+EDataValidationResult UOculusXRFaceRetargetAsset::IsDataValid(FDataValidationContext& Context) const
+{
+	EDataValidationResult result = CombineDataValidationResults(Super::IsDataValid(Context), EDataValidationResult::Valid);
+	if (!TargetSkeleton)
+	{
+		return result;
+	}
+
+	TArray<FName> skeletonCurves;
+	TargetSkeleton->GetCurveMetaDataNames(skeletonCurves);
+	TArray<FName> uncoveredCurves, unknownCurves;
+	Matrix->FindCoverage(skeletonCurves, uncoveredCurves, unknownCurves);
+	for (const FName& curveName : unknownCurves)
+	{
+		Context.AddError(FText::Format(LOCTEXT("UnknownCurve", "Curve {0} is not a curve of {1}."), FText::FromName(curveName), FText::FromString(TargetSkeleton->GetName())));
+		result = EDataValidationResult::Invalid;
+	}
+	for (const FName& curveName : uncoveredCurves)
+	{
+		Context.AddWarning(FText::Format(LOCTEXT("UncoveredCurve", "Curve {0} of {1} is not driven by any expression."), FText::FromName(curveName), FText::FromString(TargetSkeleton->GetName())));
+	}
+	return result;
+}
+#endif
+
+void UOculusXRFaceRetargetAsset::CompileMatrix()
+{
+	Matrix = MakeShared<FOculusXRFaceRetargetMatrix>(FOculusXRFaceRetargetMatrix::Build(Curves, bClampOutput));
+	bIsMatrixLoaded = false;
+}
+
+const TMap<EOculusXRFaceExpression, FOculusXRExpressionCurves>& UOculusXRFaceRetargetAsset::GetDefaultExpressionNames()
+{
+	static const TMap<EOculusXRFaceExpression, FOculusXRExpressionCurves> defaultExpressionNames = {
+		{ EOculusXRFaceExpression::BrowLowererL, FOculusXRExpressionCurves{ { FName("browLowerer_L") } } },
+		{ EOculusXRFaceExpression::BrowLowererR, FOculusXRExpressionCurves{ { FName("browLowerer_R") } } },
+		{ EOculusXRFaceExpression::CheekPuffL, FOculusXRExpressionCurves{ { FName("cheekPuff_L") } } },
+		{ EOculusXRFaceExpression::CheekPuffR, FOculusXRExpressionCurves{ { FName("cheekPuff_R") } } },
+		{ EOculusXRFaceExpression::CheekRaiserL, FOculusXRExpressionCurves{ { FName("cheekRaiser_L") } } },
+		{ EOculusXRFaceExpression::CheekRaiserR, FOculusXRExpressionCurves{ { FName("cheekRaiser_R") } } },
+		{ EOculusXRFaceExpression::CheekSuckL, FOculusXRExpressionCurves{ { FName("cheekSuck_L") } } },
+		{ EOculusXRFaceExpression::CheekSuckR, FOculusXRExpressionCurves{ { FName("cheekSuck_R") } } },
+		{ EOculusXRFaceExpression::ChinRaiserB, FOculusXRExpressionCurves{ { FName("chinRaiser_B") } } },
+		{ EOculusXRFaceExpression::ChinRaiserT, FOculusXRExpressionCurves{ { FName("chinRaiser_T") } } },
+		{ EOculusXRFaceExpression::DimplerL, FOculusXRExpressionCurves{ { FName("dimpler_L") } } },
+		{ EOculusXRFaceExpression::DimplerR, FOculusXRExpressionCurves{ { FName("dimpler_R") } } },
+		{ EOculusXRFaceExpression::EyesClosedL, FOculusXRExpressionCurves{ { FName("eyesClosed_L") } } },
+		{ EOculusXRFaceExpression::EyesClosedR, FOculusXRExpressionCurves{ { FName("eyesClosed_R") } } },
+		{ EOculusXRFaceExpression::EyesLookDownL, FOculusXRExpressionCurves{ { FName("eyesLookDown_L") } } },
+		{ EOculusXRFaceExpression::EyesLookDownR, FOculusXRExpressionCurves{ { FName("eyesLookDown_R") } } },
+		{ EOculusXRFaceExpression::EyesLookLeftL, FOculusXRExpressionCurves{ { FName("eyesLookLeft_L") } } },
+		{ EOculusXRFaceExpression::EyesLookLeftR, FOculusXRExpressionCurves{ { FName("eyesLookLeft_R") } } },
+		{ EOculusXRFaceExpression::EyesLookRightL, FOculusXRExpressionCurves{ { FName("eyesLookRight_L") } } },
+		{ EOculusXRFaceExpression::EyesLookRightR, FOculusXRExpressionCurves{ { FName("eyesLookRight_R") } } },
+		{ EOculusXRFaceExpression::EyesLookUpL, FOculusXRExpressionCurves{ { FName("eyesLookUp_L") } } },
+		{ EOculusXRFaceExpression::EyesLookUpR, FOculusXRExpressionCurves{ { FName("eyesLookUp_R") } } },
+		{ EOculusXRFaceExpression::InnerBrowRaiserL, FOculusXRExpressionCurves{ { FName("innerBrowRaiser_L") } } },
+		{ EOculusXRFaceExpression::InnerBrowRaiserR, FOculusXRExpressionCurves{ { FName("innerBrowRaiser_R") } } },
+		{ EOculusXRFaceExpression::JawDrop, FOculusXRExpressionCurves{ { FName("jawDrop") } } },
+		{ EOculusXRFaceExpression::JawSidewaysLeft, FOculusXRExpressionCurves{ { FName("jawSidewaysLeft") } } },
+		{ EOculusXRFaceExpression::JawSidewaysRight, FOculusXRExpressionCurves{ { FName("jawSidewaysRight") } } },
+		{ EOculusXRFaceExpression::JawThrust, FOculusXRExpressionCurves{ { FName("jawThrust") } } },
+		{ EOculusXRFaceExpression::LidTightenerL, FOculusXRExpressionCurves{ { FName("lidTightener_L") } } },
+		{ EOculusXRFaceExpression::LidTightenerR, FOculusXRExpressionCurves{ { FName("lidTightener_R") } } },
+		{ EOculusXRFaceExpression::LipCornerDepressorL, FOculusXRExpressionCurves{ { FName("lipCornerDepressor_L") } } },
+		{ EOculusXRFaceExpression::LipCornerDepressorR, FOculusXRExpressionCurves{ { FName("lipCornerDepressor_R") } } },
+		{ EOculusXRFaceExpression::LipCornerPullerL, FOculusXRExpressionCurves{ { FName("lipCornerPuller_L") } } },
+		{ EOculusXRFaceExpression::LipCornerPullerR, FOculusXRExpressionCurves{ { FName("lipCornerPuller_R") } } },
+		{ EOculusXRFaceExpression::LipFunnelerLB, FOculusXRExpressionCurves{ { FName("lipFunneler_LB") } } },
+		{ EOculusXRFaceExpression::LipFunnelerLT, FOculusXRExpressionCurves{ { FName("lipFunneler_LT") } } },
+		{ EOculusXRFaceExpression::LipFunnelerRB, FOculusXRExpressionCurves{ { FName("lipFunneler_RB") } } },
+		{ EOculusXRFaceExpression::LipFunnelerRT, FOculusXRExpressionCurves{ { FName("lipFunneler_RT") } } },
+		{ EOculusXRFaceExpression::LipPressorL, FOculusXRExpressionCurves{ { FName("lipPressor_L") } } },
+		{ EOculusXRFaceExpression::LipPressorR, FOculusXRExpressionCurves{ { FName("lipPressor_R") } } },
+		{ EOculusXRFaceExpression::LipPuckerL, FOculusXRExpressionCurves{ { FName("lipPucker_L") } } },
+		{ EOculusXRFaceExpression::LipPuckerR, FOculusXRExpressionCurves{ { FName("lipPucker_R") } } },
+		{ EOculusXRFaceExpression::LipStretcherL, FOculusXRExpressionCurves{ { FName("lipStretcher_L") } } },
+		{ EOculusXRFaceExpression::LipStretcherR, FOculusXRExpressionCurves{ { FName("lipStretcher_R") } } },
+		{ EOculusXRFaceExpression::LipSuckLB, FOculusXRExpressionCurves{ { FName("lipSuck_LB") } } },
+		{ EOculusXRFaceExpression::LipSuckLT, FOculusXRExpressionCurves{ { FName("lipSuck_LT") } } },
+		{ EOculusXRFaceExpression::LipSuckRB, FOculusXRExpressionCurves{ { FName("lipSuck_RB") } } },
+		{ EOculusXRFaceExpression::LipSuckRT, FOculusXRExpressionCurves{ { FName("lipSuck_RT") } } },
+		{ EOculusXRFaceExpression::LipTightenerL, FOculusXRExpressionCurves{ { FName("lipTightener_L") } } },
+		{ EOculusXRFaceExpression::LipTightenerR, FOculusXRExpressionCurves{ { FName("lipTightener_R") } } },
+		{ EOculusXRFaceExpression::LipsToward, FOculusXRExpressionCurves{ { FName("lipsToward") } } },
+		{ EOculusXRFaceExpression::LowerLipDepressorL, FOculusXRExpressionCurves{ { FName("lowerLipDepressor_L") } } },
+		{ EOculusXRFaceExpression::LowerLipDepressorR, FOculusXRExpressionCurves{ { FName("lowerLipDepressor_R") } } },
+		{ EOculusXRFaceExpression::MouthLeft, FOculusXRExpressionCurves{ { FName("mouthLeft") } } },
+		{ EOculusXRFaceExpression::MouthRight, FOculusXRExpressionCurves{ { FName("mouthRight") } } },
+		{ EOculusXRFaceExpression::NoseWrinklerL, FOculusXRExpressionCurves{ { FName("noseWrinkler_L") } } },
+		{ EOculusXRFaceExpression::NoseWrinklerR, FOculusXRExpressionCurves{ { FName("noseWrinkler_R") } } },
+		{ EOculusXRFaceExpression::OuterBrowRaiserL, FOculusXRExpressionCurves{ { FName("outerBrowRaiser_L") } } },
+		{ EOculusXRFaceExpression::OuterBrowRaiserR, FOculusXRExpressionCurves{ { FName("outerBrowRaiser_R") } } },
+		{ EOculusXRFaceExpression::UpperLidRaiserL, FOculusXRExpressionCurves{ { FName("upperLidRaiser_L") } } },
+		{ EOculusXRFaceExpression::UpperLidRaiserR, FOculusXRExpressionCurves{ { FName("upperLidRaiser_R") } } },
+		{ EOculusXRFaceExpression::UpperLipRaiserL, FOculusXRExpressionCurves{ { FName("upperLipRaiser_L") } } },
+		{ EOculusXRFaceExpression::UpperLipRaiserR, FOculusXRExpressionCurves{ { FName("upperLipRaiser_R") } } },
+		{ EOculusXRFaceExpression::TongueTipInterdental, FOculusXRExpressionCurves{ { FName("tongueTipInterdental") } } },
+		{ EOculusXRFaceExpression::TongueTipAlveolar, FOculusXRExpressionCurves{ { FName("tongueTipAlveolar") } } },
+		{ EOculusXRFaceExpression::TongueFrontDorsalPalate, FOculusXRExpressionCurves{ { FName("tongueFrontDorsalPalate") } } },
+		{ EOculusXRFaceExpression::TongueMidDorsalPalate, FOculusXRExpressionCurves{ { FName("tongueMidDorsalPalate") } } },
+		{ EOculusXRFaceExpression::TongueBackDorsalVelar, FOculusXRExpressionCurves{ { FName("tongueBackDorsalVelar") } } },
+		{ EOculusXRFaceExpression::TongueOut, FOculusXRExpressionCurves{ { FName("tongueOut") } } }
+	};
+	return defaultExpressionNames;
+}
+
+TSharedRef<const FOculusXRFaceRetargetMatrix> UOculusXRFaceRetargetAsset::GetDefaultMatrix()
+{
+	static const TSharedRef<const FOculusXRFaceRetargetMatrix> defaultMatrix = MakeShared<FOculusXRFaceRetargetMatrix>(FOculusXRFaceRetargetMatrix::Build(GetDefaultExpressionNames()));
+	return defaultMatrix;
+}
+
+#undef LOCTEXT_NAMESPACE
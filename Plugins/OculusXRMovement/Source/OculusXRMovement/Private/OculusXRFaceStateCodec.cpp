@@ -0,0 +1,462 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRFaceStateCodec.h"
+#include "OculusXRMovementRecording.h"
+#include "OculusXRRetargetingUtils.h"
+#include "Misc/Crc.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+namespace
+{
+	constexpr int32 kNumExpressions = static_cast<int32>(EOculusXRFaceExpression::COUNT);
+	constexpr int32 kLayoutHashBits = 16;
+	constexpr int32 kConfidenceBits = 8;
+	constexpr int32 kMaxConfidences = 8;
+	constexpr int32 kMaxWeightBits = 16;
+	// SerializeIntPacked uses up to 5 bytes
+	constexpr int32 kMaxPackedIntBits = 40;
+	// Components explaining no variance still get a usable quantization range
+	constexpr float kMinRange = 1.e-3f;
+
+	void WriteBits(FBitWriter& Writer, uint32 Value, const int32 NumBits)
+	{
+		Writer.SerializeBits(&Value, NumBits);
+	}
+
+	uint32 ReadBits(FBitReader& Reader, const int32 NumBits)
+	{
+		uint32 value = 0;
+		Reader.SerializeBits(&value, NumBits);
+		return value;
+	}
+
+	uint32 QuantizeUnit(const float Value, const float Range, const int32 NumBits)
+	{
+		const uint32 maxValue = (1u << NumBits) - 1;
+		const float normalized = FMath::Clamp((Value + Range) / (2.0f * Range), 0.0f, 1.0f);
+		return static_cast<uint32>(FMath::RoundToInt32(normalized * maxValue));
+	}
+
+	float DequantizeUnit(const uint32 Value, const float Range, const int32 NumBits)
+	{
+		const uint32 maxValue = (1u << NumBits) - 1;
+		return static_cast<float>(Value) / maxValue * 2.0f * Range - Range;
+	}
+} // namespace
+
+bool FOculusXRFaceExpressionBasis::IsValid() const
+{
+	return Mean.Num() == kNumExpressions && Ranges.Num() > 0 && Components.Num() == Ranges.Num() * kNumExpressions;
+}
+
+void FOculusXRFaceExpressionBasis::Serialize(FArchive& Ar)
+{
+	Ar << Mean;
+	Ar << Components;
+	Ar << Ranges;
+	Ar << ExplainedVariance;
+}
+
+void FOculusXRFaceExpressionBasisFitter::AddFaceState(const FOculusXRFaceState& FaceState)
+{
+	if (!FaceState.bIsValid || FaceState.ExpressionWeights.Num() != kNumExpressions)
+	{
+		return;
+	}
+	Samples.Append(FaceState.ExpressionWeights);
+}
+
+void FOculusXRFaceExpressionBasisFitter::AddRecording(const FOculusXRMovementRecording& Recording)
+{
+	for (const FOculusXRMovementRecording::FFaceFrame& frame : Recording.FaceFrames)
+	{
+		AddFaceState(frame.State);
+	}
+}
+
+int32 FOculusXRFaceExpressionBasisFitter::GetNumSamples() const
+{
+	return Samples.Num() / kNumExpressions;
+}
+
+bool FOculusXRFaceExpressionBasisFitter::Fit(const int32 MaxComponents, const float MinExplainedVariance, FOculusXRFaceExpressionBasis& outBasis) const
+{
+	outBasis = FOculusXRFaceExpressionBasis();
+	TArray<float> variances;
+	if (!FOculusXRRetargetingUtils::FitPrincipalComponents(Samples, kNumExpressions, MaxComponents, MinExplainedVariance,
+			outBasis.Mean, outBasis.Components, variances, outBasis.ExplainedVariance))
+	{
+		return false;
+	}
+	for (const float variance : variances)
+	{
+		// Three standard deviations cover nearly every expression, the rest is clamped
+		outBasis.Ranges.Add(FMath::Max(3.0f * FMath::Sqrt(variance), kMinRange));
+	}
+	return true;
+}
+
+FOculusXRFaceStateCodec::FOculusXRFaceStateCodec(const FOculusXRFaceStateCodecSettings& InSettings)
+	: Settings(InSettings)
+{
+	Settings.WeightBits = FMath::Clamp(Settings.WeightBits, 2, kMaxWeightBits);
+	Settings.ZeroThreshold = FMath::Clamp(Settings.ZeroThreshold, 0.0f, 1.0f);
+	if (Settings.Basis.IsValid() && !Settings.Basis->IsValid())
+	{
+		Settings.Basis.Reset();
+	}
+	NumValues = UsesBasis() ? Settings.Basis->GetNumComponents() : kNumExpressions;
+	MaxValue = (1u << Settings.WeightBits) - 1;
+
+	const int32 layout[] = { Settings.WeightBits, NumValues, UsesBasis() ? 1 : 0 };
+	uint32 hash = FCrc::MemCrc32(layout, sizeof(layout));
+	hash = FCrc::MemCrc32(&Settings.ZeroThreshold, sizeof(Settings.ZeroThreshold), hash);
+	if (UsesBasis())
+	{
+		const FOculusXRFaceExpressionBasis& basis = *Settings.Basis;
+		hash = FCrc::MemCrc32(basis.Mean.GetData(), basis.Mean.Num() * sizeof(float), hash);
+		hash = FCrc::MemCrc32(basis.Components.GetData(), basis.Components.Num() * sizeof(float), hash);
+		hash = FCrc::MemCrc32(basis.Ranges.GetData(), basis.Ranges.Num() * sizeof(float), hash);
+	}
+	LayoutHash = static_cast<uint16>(hash ^ (hash >> 16));
+}
+
+int64 FOculusXRFaceStateCodec::GetMaxEncodedBits() const
+{
+	const int64 headerBits = kLayoutHashBits + 2 + 32 + kMaxPackedIntBits + kMaxConfidences * kConfidenceBits;
+	return headerBits + static_cast<int64>(NumValues) * (Settings.WeightBits + (UsesBasis() ? 0 : 1));
+}
+
+float FOculusXRFaceStateCodec::GetMaxWeightError() const
+{
+	return FMath::Max(Settings.ZeroThreshold, 0.5f / MaxValue);
+}
+
+void FOculusXRFaceStateCodec::Quantize(const FOculusXRFaceState& FaceState, FOculusXRQuantizedFaceState& outQuantized) const
+{
+	outQuantized.bIsValid = FaceState.bIsValid;
+	outQuantized.bIsEyeFollowingBlendshapesValid = FaceState.bIsEyeFollowingBlendshapesValid;
+	outQuantized.Time = FaceState.Time;
+
+	const int32 numConfidences = FMath::Min(FaceState.ExpressionWeightConfidences.Num(), kMaxConfidences);
+	outQuantized.Confidences.SetNumUninitialized(numConfidences);
+	for (int32 i = 0; i < numConfidences; ++i)
+	{
+		outQuantized.Confidences[i] = static_cast<uint8>(FMath::RoundToInt32(FMath::Clamp(FaceState.ExpressionWeightConfidences[i], 0.0f, 1.0f) * 255.0f));
+	}
+
+	float weights[kNumExpressions];
+	for (int32 i = 0; i < kNumExpressions; ++i)
+	{
+		weights[i] = FaceState.ExpressionWeights.IsValidIndex(i) ? FMath::Clamp(FaceState.ExpressionWeights[i], 0.0f, 1.0f) : 0.0f;
+	}
+
+	outQuantized.Values.SetNumUninitialized(NumValues);
+	if (!UsesBasis())
+	{
+		for (int32 i = 0; i < kNumExpressions; ++i)
+		{
+			outQuantized.Values[i] = weights[i] < Settings.ZeroThreshold ? 0 : static_cast<uint32>(FMath::RoundToInt32(weights[i] * MaxValue));
+		}
+		return;
+	}
+
+	// Components are orthonormal, projecting is a dot product with each of them
+	const FOculusXRFaceExpressionBasis& basis = *Settings.Basis;
+	for (int32 i = 0; i < kNumExpressions; ++i)
+	{
+		weights[i] -= basis.Mean[i];
+	}
+	for (int32 k = 0; k < NumValues; ++k)
+	{
+		const float* component = basis.Components.GetData() + k * kNumExpressions;
+		float coefficient = 0.0f;
+		for (int32 i = 0; i < kNumExpressions; ++i)
+		{
+			coefficient += component[i] * weights[i];
+		}
+		outQuantized.Values[k] = QuantizeUnit(coefficient, basis.Ranges[k], Settings.WeightBits);
+	}
+}
+
+void FOculusXRFaceStateCodec::Dequantize(const FOculusXRQuantizedFaceState& Quantized, FOculusXRFaceState& outFaceState) const
+{
+	outFaceState.bIsValid = Quantized.bIsValid;
+	outFaceState.bIsEyeFollowingBlendshapesValid = Quantized.bIsEyeFollowingBlendshapesValid;
+	outFaceState.Time = Quantized.Time;
+
+	if (outFaceState.ExpressionWeightConfidences.Num() != Quantized.Confidences.Num())
+	{
+		outFaceState.ExpressionWeightConfidences.SetNumUninitialized(Quantized.Confidences.Num());
+	}
+	for (int32 i = 0; i < Quantized.Confidences.Num(); ++i)
+	{
+		outFaceState.ExpressionWeightConfidences[i] = Quantized.Confidences[i] / 255.0f;
+	}
+
+	if (outFaceState.ExpressionWeights.Num() != kNumExpressions)
+	{
+		outFaceState.ExpressionWeights.SetNumUninitialized(kNumExpressions);
+	}
+	float* weights = outFaceState.ExpressionWeights.GetData();
+	const int32 numValues = FMath::Min(NumValues, Quantized.Values.Num());
+	if (!UsesBasis())
+	{
+		const float step = GetWeightStep();
+		for (int32 i = 0; i < kNumExpressions; ++i)
+		{
+			weights[i] = i < numValues ? Quantized.Values[i] * step : 0.0f;
+		}
+		return;
+	}
+
+	const FOculusXRFaceExpressionBasis& basis = *Settings.Basis;
+	FMemory::Memcpy(weights, basis.Mean.GetData(), kNumExpressions * sizeof(float));
+	for (int32 k = 0; k < numValues; ++k)
+	{
+		const float coefficient = DequantizeUnit(Quantized.Values[k], basis.Ranges[k], Settings.WeightBits);
+		const float* component = basis.Components.GetData() + k * kNumExpressions;
+		for (int32 i = 0; i < kNumExpressions; ++i)
+		{
+			weights[i] += coefficient * component[i];
+		}
+	}
+	for (int32 i = 0; i < kNumExpressions; ++i)
+	{
+		weights[i] = FMath::Clamp(weights[i], 0.0f, 1.0f);
+	}
+}
+
+void FOculusXRFaceStateCodec::WriteHeader(const FOculusXRQuantizedFaceState& Quantized, FBitWriter& Writer) const
+{
+	WriteBits(Writer, LayoutHash, kLayoutHashBits);
+	Writer.WriteBit(Quantized.bIsValid ? 1 : 0);
+	Writer.WriteBit(Quantized.bIsEyeFollowingBlendshapesValid ? 1 : 0);
+	float time = Quantized.Time;
+	Writer << time;
+	uint32 numConfidences = FMath::Min(Quantized.Confidences.Num(), kMaxConfidences);
+	Writer.SerializeIntPacked(numConfidences);
+	for (uint32 i = 0; i < numConfidences; ++i)
+	{
+		WriteBits(Writer, Quantized.Confidences[i], kConfidenceBits);
+	}
+}
+
+bool FOculusXRFaceStateCodec::ReadHeader(FBitReader& Reader, FOculusXRQuantizedFaceState& outQuantized) const
+{
+	if (ReadBits(Reader, kLayoutHashBits) != LayoutHash)
+	{
+		Reader.SetError();
+		return false;
+	}
+	outQuantized.bIsValid = Reader.ReadBit() != 0;
+	outQuantized.bIsEyeFollowingBlendshapesValid = Reader.ReadBit() != 0;
+	Reader << outQuantized.Time;
+	uint32 numConfidences = 0;
+	Reader.SerializeIntPacked(numConfidences);
+	if (Reader.IsError() || numConfidences > kMaxConfidences)
+	{
+		Reader.SetError();
+		return false;
+	}
+	outQuantized.Confidences.SetNumUninitialized(numConfidences);
+	for (uint8& confidence : outQuantized.Confidences)
+	{
+		confidence = static_cast<uint8>(ReadBits(Reader, kConfidenceBits));
+	}
+	return !Reader.IsError();
+}
+
+void FOculusXRFaceStateCodec::WriteValue(const uint32 Value, FBitWriter& Writer) const
+{
+	if (!UsesBasis())
+	{
+		Writer.WriteBit(Value != 0 ? 1 : 0);
+		if (Value == 0)
+		{
+			return;
+		}
+	}
+	WriteBits(Writer, Value, Settings.WeightBits);
+}
+
+uint32 FOculusXRFaceStateCodec::ReadValue(FBitReader& Reader) const
+{
+	if (!UsesBasis() && !Reader.ReadBit())
+	{
+		return 0;
+	}
+	return ReadBits(Reader, Settings.WeightBits);
+}
+
+void FOculusXRFaceStateCodec::Write(const FOculusXRQuantizedFaceState& Quantized, FBitWriter& Writer) const
+{
+	check(Quantized.Values.Num() == NumValues);
+	WriteHeader(Quantized, Writer);
+	for (const uint32 value : Quantized.Values)
+	{
+		WriteValue(value, Writer);
+	}
+}
+
+bool FOculusXRFaceStateCodec::Read(FBitReader& Reader, FOculusXRQuantizedFaceState& outQuantized) const
+{
+	if (!ReadHeader(Reader, outQuantized))
+	{
+		return false;
+	}
+	outQuantized.Values.SetNumUninitialized(NumValues);
+	for (uint32& value : outQuantized.Values)
+	{
+		value = ReadValue(Reader);
+	}
+	return !Reader.IsError();
+}
+
+void FOculusXRFaceStateCodec::Encode(const FOculusXRFaceState& FaceState, FBitWriter& Writer) const
+{
+	FOculusXRQuantizedFaceState quantized;
+	Quantize(FaceState, quantized);
+	Write(quantized, Writer);
+}
+
+bool FOculusXRFaceStateCodec::Decode(FBitReader& Reader, FOculusXRFaceState& outFaceState) const
+{
+	FOculusXRQuantizedFaceState quantized;
+	if (!Read(Reader, quantized))
+	{
+		return false;
+	}
+	Dequantize(quantized, outFaceState);
+	return true;
+}
+
+FOculusXRFaceStateDeltaEncoder::FOculusXRFaceStateDeltaEncoder(const TSharedRef<const FOculusXRFaceStateCodec>& InCodec, const FOculusXRFaceStateDeltaSettings& InSettings)
+	: Codec(InCodec)
+	, Settings(InSettings)
+	, Baselines(InSettings.KeyframeInterval, InSettings.MaxPendingBaselines)
+{
+	Settings.DeadbandSteps = FMath::Max(Settings.DeadbandSteps, 0);
+}
+
+void FOculusXRFaceStateDeltaEncoder::Reset()
+{
+	Baselines.Reset();
+}
+
+void FOculusXRFaceStateDeltaEncoder::Ack(const uint16 Sequence)
+{
+	Baselines.Ack(Sequence);
+}
+
+uint16 FOculusXRFaceStateDeltaEncoder::Encode(const FOculusXRFaceState& FaceState, FBitWriter& Writer)
+{
+	Codec->Quantize(FaceState, Current);
+
+	uint16 sequence = 0;
+	const FOculusXRQuantizedFaceState* baseline = Baselines.BeginPacket(Writer, sequence);
+	const bool bKeyframe = baseline == nullptr;
+	Codec->WriteHeader(Current, Writer);
+
+	// Current becomes what the receiver reconstructs: the values that are not sent keep their baseline value
+	const int32 numValues = Codec->GetNumValues();
+	LastNumChangedValues = 0;
+	if (bKeyframe)
+	{
+		for (int32 i = 0; i < numValues; ++i)
+		{
+			Codec->WriteValue(Current.Values[i], Writer);
+		}
+		LastNumChangedValues = numValues;
+	}
+	else
+	{
+		for (int32 i = 0; i < numValues; ++i)
+		{
+			const int64 difference = static_cast<int64>(Current.Values[i]) - baseline->Values[i];
+			const bool bChanged = FMath::Abs(difference) > Settings.DeadbandSteps;
+			Writer.WriteBit(bChanged ? 1 : 0);
+			if (bChanged)
+			{
+				Codec->WriteValue(Current.Values[i], Writer);
+				++LastNumChangedValues;
+			}
+			else
+			{
+				Current.Values[i] = baseline->Values[i];
+			}
+		}
+	}
+	bLastPacketKeyframe = bKeyframe;
+
+	Baselines.EndPacket(sequence, Current);
+	return sequence;
+}
+
+FOculusXRFaceStateDeltaDecoder::FOculusXRFaceStateDeltaDecoder(const TSharedRef<const FOculusXRFaceStateCodec>& InCodec, const int32 InMaxBaselines)
+	: Codec(InCodec)
+	, Baselines(InMaxBaselines)
+{
+}
+
+bool FOculusXRFaceStateDeltaDecoder::Decode(FBitReader& Reader, FOculusXRFaceState& outFaceState, uint16& outSequence)
+{
+	uint16 sequence = 0;
+	const FOculusXRQuantizedFaceState* baseline = nullptr;
+	if (!Baselines.BeginPacket(Reader, sequence, baseline))
+	{
+		return false;
+	}
+	const bool bKeyframe = baseline == nullptr;
+
+	FOculusXRQuantizedFaceState decoded;
+	if (!Codec->ReadHeader(Reader, decoded))
+	{
+		return false;
+	}
+
+	const int32 numValues = Codec->GetNumValues();
+	decoded.Values.SetNumUninitialized(numValues);
+	for (int32 i = 0; i < numValues; ++i)
+	{
+		decoded.Values[i] = bKeyframe || Reader.ReadBit() ? Codec->ReadValue(Reader) : baseline->Values[i];
+	}
+	if (Reader.IsError())
+	{
+		return false;
+	}
+
+	Codec->Dequantize(decoded, outFaceState);
+	Baselines.EndPacket(sequence, MoveTemp(decoded));
+	outSequence = sequence;
+	return true;
+}
+
+void FOculusXRFaceStateCodecErrorStats::Add(const FOculusXRFaceState& Original, const FOculusXRFaceState& Decoded)
+{
+	if (!Original.bIsValid || !Decoded.bIsValid)
+	{
+		return;
+	}
+
+	const int32 numWeights = FMath::Min(Original.ExpressionWeights.Num(), Decoded.ExpressionWeights.Num());
+	for (int32 i = 0; i < numWeights; ++i)
+	{
+		const double weightError = FMath::Abs(Original.ExpressionWeights[i] - Decoded.ExpressionWeights[i]);
+		++NumWeights;
+		SumWeightError += weightError;
+		MaxWeightError = FMath::Max(MaxWeightError, weightError);
+	}
+}
+
+FString FOculusXRFaceStateCodecErrorStats::ToString() const
+{
+	return FString::Printf(TEXT("%d weights, error mean %.4f max %.4f"), NumWeights, GetMeanWeightError(), MaxWeightError);
+}
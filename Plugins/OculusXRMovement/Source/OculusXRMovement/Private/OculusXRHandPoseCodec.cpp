@@ -0,0 +1,297 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRHandPoseCodec.h"
+#include "OculusXRAnimNodeBodyRetargeter.h"
+#include "OculusXRMovementRecording.h"
+#include "OculusXRRetargetingUtils.h"
+#include "Misc/Crc.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+namespace
+{
+	constexpr int32 kNumHandJoints = FOculusXRHandPoseCodec::kNumHandJoints;
+	constexpr int32 kNumFeatures = FOculusXRHandPoseCodec::kNumFeatures;
+	constexpr int32 kMaxCoefficientBits = 16;
+	// Components explaining no variance still get a usable quantization range
+	constexpr float kMinRange = 1.e-3f;
+
+	uint32 QuantizeUnit(const float Value, const float Range, const int32 NumBits)
+	{
+		const uint32 maxValue = (1u << NumBits) - 1;
+		const float normalized = FMath::Clamp((Value + Range) / (2.0f * Range), 0.0f, 1.0f);
+		return static_cast<uint32>(FMath::RoundToInt32(normalized * maxValue));
+	}
+
+	float DequantizeUnit(const uint32 Value, const float Range, const int32 NumBits)
+	{
+		const uint32 maxValue = (1u << NumBits) - 1;
+		return static_cast<float>(Value) / maxValue * 2.0f * Range - Range;
+	}
+} // namespace
+
+bool FOculusXRHandPoseBasis::IsValid() const
+{
+	return Mean.Num() == kNumFeatures && Ranges.Num() > 0 && Components.Num() == Ranges.Num() * kNumFeatures && Offsets.Num() == kNumHandJoints;
+}
+
+void FOculusXRHandPoseBasis::Serialize(FArchive& Ar)
+{
+	Ar << Mean;
+	Ar << Components;
+	Ar << Ranges;
+	Ar << Offsets;
+	Ar << ExplainedVariance;
+}
+
+TConstArrayView<EOculusXRBoneID> FOculusXRHandPoseCodec::GetHandJoints(const int32 Hand)
+{
+	check(Hand == 0 || Hand == 1);
+	return TConstArrayView<EOculusXRBoneID>(FOculusXRAnimNodeBodyRetargeter::kALIGNABLE_HAND_JOINTS).Slice(Hand * kNumHandJoints, kNumHandJoints);
+}
+
+EOculusXRBoneID FOculusXRHandPoseCodec::GetWristJoint(const int32 Hand)
+{
+	return Hand == 0 ? EOculusXRBoneID::BodyLeftHandWrist : EOculusXRBoneID::BodyRightHandWrist;
+}
+
+int32 FOculusXRHandPoseCodec::GetParentIndex(const int32 HandJointIndex)
+{
+	// Thumb has 4 joints, the other fingers 5, every metacarpal hangs off the wrist
+	const bool bIsMetacarpal = HandJointIndex == 0 || (HandJointIndex >= 4 && (HandJointIndex - 4) % 5 == 0);
+	return bIsMetacarpal ? INDEX_NONE : HandJointIndex - 1;
+}
+
+bool FOculusXRHandPoseCodec::ComputeFeatures(const FOculusXRBodyState& BodyState, const int32 Hand, float* outFeatures)
+{
+	const int32 wristIdx = static_cast<int32>(GetWristJoint(Hand));
+	if (!BodyState.Joints.IsValidIndex(wristIdx) || !BodyState.Joints[wristIdx].bIsValid)
+	{
+		return false;
+	}
+
+	const TConstArrayView<EOculusXRBoneID> handJoints = GetHandJoints(Hand);
+	FQuat rotations[kNumHandJoints];
+	for (int32 i = 0; i < kNumHandJoints; ++i)
+	{
+		const int32 boneIdx = static_cast<int32>(handJoints[i]);
+		if (!BodyState.Joints.IsValidIndex(boneIdx) || !BodyState.Joints[boneIdx].bIsValid)
+		{
+			return false;
+		}
+		rotations[i] = BodyState.Joints[boneIdx].Orientation.Quaternion();
+	}
+
+	const FQuat wristRotation = BodyState.Joints[wristIdx].Orientation.Quaternion();
+	for (int32 i = 0; i < kNumHandJoints; ++i)
+	{
+		const int32 parentIdx = GetParentIndex(i);
+		FQuat local = (parentIdx == INDEX_NONE ? wristRotation : rotations[parentIdx]).Inverse() * rotations[i];
+		if (local.W < 0.0)
+		{
+			local = local * -1.0;
+		}
+		const FVector rotationVector = local.ToRotationVector();
+		outFeatures[i * 3 + 0] = static_cast<float>(rotationVector.X);
+		outFeatures[i * 3 + 1] = static_cast<float>(rotationVector.Y);
+		outFeatures[i * 3 + 2] = static_cast<float>(rotationVector.Z);
+	}
+	return true;
+}
+
+void FOculusXRHandPoseBasisFitter::AddBodyState(const FOculusXRBodyState& BodyState, const float WorldToMeters)
+{
+	for (int32 hand = 0; hand < 2; ++hand)
+	{
+		float features[kNumFeatures];
+		if (!FOculusXRHandPoseCodec::ComputeFeatures(BodyState, hand, features))
+		{
+			continue;
+		}
+		Samples[hand].Append(features, kNumFeatures);
+
+		if (OffsetSums[hand].IsEmpty())
+		{
+			OffsetSums[hand].Init(FVector3f::ZeroVector, kNumHandJoints);
+		}
+		const auto& wrist = BodyState.Joints[static_cast<int32>(FOculusXRHandPoseCodec::GetWristJoint(hand))];
+		const TConstArrayView<EOculusXRBoneID> handJoints = FOculusXRHandPoseCodec::GetHandJoints(hand);
+		for (int32 i = 0; i < kNumHandJoints; ++i)
+		{
+			const int32 parentIdx = FOculusXRHandPoseCodec::GetParentIndex(i);
+			const auto& parent = parentIdx == INDEX_NONE ? wrist : BodyState.Joints[static_cast<int32>(handJoints[parentIdx])];
+			const auto& joint = BodyState.Joints[static_cast<int32>(handJoints[i])];
+			OffsetSums[hand][i] += FVector3f(parent.Orientation.UnrotateVector(joint.Position - parent.Position) / WorldToMeters);
+		}
+	}
+}
+
+void FOculusXRHandPoseBasisFitter::AddRecording(const FOculusXRMovementRecording& Recording)
+{
+	for (const FOculusXRMovementRecording::FBodyFrame& frame : Recording.BodyFrames)
+	{
+		AddBodyState(frame.State, Recording.WorldToMeters);
+	}
+}
+
+int32 FOculusXRHandPoseBasisFitter::GetNumSamples(const int32 Hand) const
+{
+	return Samples[Hand].Num() / kNumFeatures;
+}
+
+bool FOculusXRHandPoseBasisFitter::Fit(const int32 Hand, const int32 MaxComponents, const float MinExplainedVariance, FOculusXRHandPoseBasis& outBasis) const
+{
+	const int32 numSamples = GetNumSamples(Hand);
+	if (numSamples < 2)
+	{
+		return false;
+	}
+
+	outBasis = FOculusXRHandPoseBasis();
+	TArray<float> variances;
+	if (!FOculusXRRetargetingUtils::FitPrincipalComponents(Samples[Hand], kNumFeatures, MaxComponents, MinExplainedVariance,
+			outBasis.Mean, outBasis.Components, variances, outBasis.ExplainedVariance))
+	{
+		return false;
+	}
+	for (const float variance : variances)
+	{
+		// Three standard deviations cover nearly every pose, the rest is clamped
+		outBasis.Ranges.Add(FMath::Max(3.0f * FMath::Sqrt(variance), kMinRange));
+	}
+
+	outBasis.Offsets.SetNumUninitialized(kNumHandJoints);
+	for (int32 i = 0; i < kNumHandJoints; ++i)
+	{
+		outBasis.Offsets[i] = OffsetSums[Hand][i] / numSamples;
+	}
+	return true;
+}
+
+FOculusXRHandPoseCodec::FOculusXRHandPoseCodec(const FOculusXRHandPoseBasis& InLeftBasis, const FOculusXRHandPoseBasis& InRightBasis, const int32 InCoefficientBits)
+	: CoefficientBits(FMath::Clamp(InCoefficientBits, 2, kMaxCoefficientBits))
+{
+	Bases[0] = InLeftBasis;
+	Bases[1] = InRightBasis;
+
+	Hash = FCrc::MemCrc32(&CoefficientBits, sizeof(CoefficientBits));
+	for (FOculusXRHandPoseBasis& basis : Bases)
+	{
+		if (!basis.IsValid())
+		{
+			// Hands without a usable basis are never sent
+			basis = FOculusXRHandPoseBasis();
+		}
+		Hash = FCrc::MemCrc32(basis.Mean.GetData(), basis.Mean.Num() * sizeof(float), Hash);
+		Hash = FCrc::MemCrc32(basis.Components.GetData(), basis.Components.Num() * sizeof(float), Hash);
+		Hash = FCrc::MemCrc32(basis.Ranges.GetData(), basis.Ranges.Num() * sizeof(float), Hash);
+		Hash = FCrc::MemCrc32(basis.Offsets.GetData(), basis.Offsets.Num() * sizeof(FVector3f), Hash);
+	}
+}
+
+bool FOculusXRHandPoseCodec::Encode(const FOculusXRBodyState& BodyState, const int32 Hand, TArray<uint32>& outCoefficients) const
+{
+	const FOculusXRHandPoseBasis& basis = Bases[Hand];
+	float features[kNumFeatures];
+	if (basis.GetNumComponents() == 0 || !ComputeFeatures(BodyState, Hand, features))
+	{
+		outCoefficients.Reset();
+		return false;
+	}
+
+	for (int32 f = 0; f < kNumFeatures; ++f)
+	{
+		features[f] -= basis.Mean[f];
+	}
+
+	// Components are orthonormal, projecting is a dot product with each of them
+	const int32 numComponents = basis.GetNumComponents();
+	outCoefficients.SetNumUninitialized(numComponents);
+	for (int32 k = 0; k < numComponents; ++k)
+	{
+		const float* component = basis.Components.GetData() + k * kNumFeatures;
+		float coefficient = 0.0f;
+		for (int32 f = 0; f < kNumFeatures; ++f)
+		{
+			coefficient += component[f] * features[f];
+		}
+		outCoefficients[k] = QuantizeUnit(coefficient, basis.Ranges[k], CoefficientBits);
+	}
+	return true;
+}
+
+bool FOculusXRHandPoseCodec::Decode(const TArray<uint32>& Coefficients, const int32 Hand, const float WorldToMeters, FOculusXRBodyState& inOutBodyState) const
+{
+	const FOculusXRHandPoseBasis& basis = Bases[Hand];
+	const TConstArrayView<EOculusXRBoneID> handJoints = GetHandJoints(Hand);
+	if (inOutBodyState.Joints.Num() < static_cast<int32>(EOculusXRBoneID::COUNT))
+	{
+		inOutBodyState.Joints.SetNum(static_cast<int32>(EOculusXRBoneID::COUNT));
+	}
+
+	const auto& wrist = inOutBodyState.Joints[static_cast<int32>(GetWristJoint(Hand))];
+	if (!wrist.bIsValid || basis.GetNumComponents() == 0 || Coefficients.Num() != basis.GetNumComponents())
+	{
+		for (const EOculusXRBoneID boneId : handJoints)
+		{
+			inOutBodyState.Joints[static_cast<int32>(boneId)].bIsValid = false;
+		}
+		return false;
+	}
+
+	float features[kNumFeatures];
+	FMemory::Memcpy(features, basis.Mean.GetData(), sizeof(features));
+	for (int32 k = 0; k < Coefficients.Num(); ++k)
+	{
+		const float coefficient = DequantizeUnit(Coefficients[k], basis.Ranges[k], CoefficientBits);
+		const float* component = basis.Components.GetData() + k * kNumFeatures;
+		for (int32 f = 0; f < kNumFeatures; ++f)
+		{
+			features[f] += coefficient * component[f];
+		}
+	}
+
+	const FQuat wristRotation = wrist.Orientation.Quaternion();
+	const FVector wristPosition = wrist.Position;
+	FQuat rotations[kNumHandJoints];
+	FVector positions[kNumHandJoints];
+	for (int32 i = 0; i < kNumHandJoints; ++i)
+	{
+		const int32 parentIdx = GetParentIndex(i);
+		const FQuat& parentRotation = parentIdx == INDEX_NONE ? wristRotation : rotations[parentIdx];
+		const FVector& parentPosition = parentIdx == INDEX_NONE ? wristPosition : positions[parentIdx];
+		const FVector rotationVector(features[i * 3 + 0], features[i * 3 + 1], features[i * 3 + 2]);
+		rotations[i] = parentRotation * FQuat::MakeFromRotationVector(rotationVector);
+		positions[i] = parentPosition + parentRotation.RotateVector(FVector(basis.Offsets[i]) * WorldToMeters);
+
+		auto& joint = inOutBodyState.Joints[static_cast<int32>(handJoints[i])];
+		joint.bIsValid = true;
+		joint.Orientation = rotations[i].Rotator();
+		joint.Position = positions[i];
+	}
+	return true;
+}
+
+void FOculusXRHandPoseCodec::WriteCoefficients(const TArray<uint32>& Coefficients, FBitWriter& Writer) const
+{
+	for (uint32 coefficient : Coefficients)
+	{
+		Writer.SerializeBits(&coefficient, CoefficientBits);
+	}
+}
+
+void FOculusXRHandPoseCodec::ReadCoefficients(FBitReader& Reader, TArray<uint32>& outCoefficients, const int32 Hand) const
+{
+	outCoefficients.SetNumUninitialized(Bases[Hand].GetNumComponents());
+	for (uint32& coefficient : outCoefficients)
+	{
+		coefficient = 0;
+		Reader.SerializeBits(&coefficient, CoefficientBits);
+	}
+}
@@ -0,0 +1,79 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRMovementDataProvider.h"
+#include "OculusXRMovement.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/Engine.h"
+
+FCriticalSection FOculusXRMovementDataProviderRegistry::ProvidersLock;
+TSharedPtr<IOculusXRMovementDataProvider> FOculusXRMovementDataProviderRegistry::DefaultProvider;
+TMap<TObjectKey<USkeletalMeshComponent>, TSharedPtr<IOculusXRMovementDataProvider>> FOculusXRMovementDataProviderRegistry::ComponentProviders;
+
+bool FOculusXRLiveMovementDataProvider::IsAvailable() const
+{
+	return GEngine && GEngine->XRSystem.IsValid();
+}
+
+bool FOculusXRLiveMovementDataProvider::GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters)
+{
+	return OculusXRMovement::GetBodyState(outBodyState, WorldToMeters);
+}
+
+bool FOculusXRLiveMovementDataProvider::GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters)
+{
+	return OculusXRMovement::GetBodySkeleton(outBodySkeleton, WorldToMeters);
+}
+
+bool FOculusXRLiveMovementDataProvider::GetFaceState(FOculusXRFaceState& outFaceState)
+{
+	return OculusXRMovement::GetFaceState(outFaceState);
+}
+
+bool FOculusXRLiveMovementDataProvider::GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters)
+{
+	return OculusXRMovement::GetEyeGazesState(outEyeGazesState, WorldToMeters);
+}
+
+TSharedRef<IOculusXRMovementDataProvider> FOculusXRMovementDataProviderRegistry::GetLiveProvider()
+{
+	static TSharedRef<IOculusXRMovementDataProvider> LiveProvider = MakeShared<FOculusXRLiveMovementDataProvider>();
+	return LiveProvider;
+}
+
+void FOculusXRMovementDataProviderRegistry::SetDefaultProvider(const TSharedPtr<IOculusXRMovementDataProvider>& Provider)
+{
+	FScopeLock scopeLock(&ProvidersLock);
+	DefaultProvider = Provider;
+}
+
+void FOculusXRMovementDataProviderRegistry::SetProviderForComponent(const USkeletalMeshComponent* Component, const TSharedPtr<IOculusXRMovementDataProvider>& Provider)
+{
+	FScopeLock scopeLock(&ProvidersLock);
+	if (Provider)
+	{
+		ComponentProviders.Add(Component, Provider);
+	}
+	else
+	{
+		ComponentProviders.Remove(Component);
+	}
+}
+
+TSharedRef<IOculusXRMovementDataProvider> FOculusXRMovementDataProviderRegistry::FindProvider(const USkeletalMeshComponent* Component)
+{
+	FScopeLock scopeLock(&ProvidersLock);
+	if (Component && !ComponentProviders.IsEmpty())
+	{
+		if (const TSharedPtr<IOculusXRMovementDataProvider>* ComponentProvider = ComponentProviders.Find(Component))
+		{
+			return ComponentProvider->ToSharedRef();
+		}
+	}
+	return DefaultProvider ? DefaultProvider.ToSharedRef() : GetLiveProvider();
+}
@@ -0,0 +1,416 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRMovementJitterBuffer.h"
+#include "OculusXRRetargeting.h"
+#include "Algo/BinarySearch.h"
+
+DECLARE_CYCLE_STAT(TEXT("Movement Jitter Buffer Evaluate"), STAT_OculusXRMovementJitterBufferEvaluate, STATGROUP_OculusXRMovement);
+
+namespace
+{
+	// Slerp that keeps rotating at the same rate past B when extrapolating
+	FQuat InterpolateRotation(const FQuat& A, const FQuat& B, const float Alpha)
+	{
+		if (Alpha <= 1.0f)
+		{
+			return FQuat::Slerp(A, B, Alpha);
+		}
+
+		FQuat delta = B * A.Inverse();
+		if (delta.W < 0.0)
+		{
+			delta = delta * -1.0;
+		}
+		FVector axis;
+		double angle;
+		delta.ToAxisAndAngle(axis, angle);
+		return (FQuat(axis, angle * Alpha) * A).GetNormalized();
+	}
+
+	FRotator InterpolateRotator(const FRotator& A, const FRotator& B, const float Alpha)
+	{
+		return InterpolateRotation(A.Quaternion(), B.Quaternion(), Alpha).Rotator();
+	}
+
+	void InterpolateState(const FOculusXRBodyState& A, const FOculusXRBodyState& B, const float Alpha, FOculusXRBodyState& outState)
+	{
+		const FOculusXRBodyState& nearest = Alpha < 0.5f ? A : B;
+		outState.IsActive = nearest.IsActive;
+		outState.SkeletonChangedCount = nearest.SkeletonChangedCount;
+		outState.Confidence = FMath::Clamp(FMath::Lerp(A.Confidence, B.Confidence, Alpha), 0.0f, 1.0f);
+		outState.Time = FMath::Lerp(A.Time, B.Time, Alpha);
+
+		// Poses from different skeletons do not blend
+		if (A.Joints.Num() != B.Joints.Num() || A.SkeletonChangedCount != B.SkeletonChangedCount)
+		{
+			outState.Joints = nearest.Joints;
+			return;
+		}
+
+		outState.Joints.SetNum(A.Joints.Num());
+		for (int32 i = 0; i < A.Joints.Num(); ++i)
+		{
+			const auto& jointA = A.Joints[i];
+			const auto& jointB = B.Joints[i];
+			auto& joint = outState.Joints[i];
+			if (jointA.bIsValid && jointB.bIsValid)
+			{
+				joint.bIsValid = true;
+				joint.Orientation = InterpolateRotator(jointA.Orientation, jointB.Orientation, Alpha);
+				joint.Position = FMath::Lerp(jointA.Position, jointB.Position, static_cast<double>(Alpha));
+			}
+			else
+			{
+				joint = Alpha < 0.5f ? jointA : jointB;
+			}
+		}
+	}
+
+	void InterpolateState(const FOculusXRFaceState& A, const FOculusXRFaceState& B, const float Alpha, FOculusXRFaceState& outState)
+	{
+		const FOculusXRFaceState& nearest = Alpha < 0.5f ? A : B;
+		outState.bIsValid = nearest.bIsValid;
+		outState.bIsEyeFollowingBlendshapesValid = nearest.bIsEyeFollowingBlendshapesValid;
+		outState.Time = FMath::Lerp(A.Time, B.Time, Alpha);
+
+		if (A.ExpressionWeights.Num() != B.ExpressionWeights.Num() || A.ExpressionWeightConfidences.Num() != B.ExpressionWeightConfidences.Num())
+		{
+			outState.ExpressionWeights = nearest.ExpressionWeights;
+			outState.ExpressionWeightConfidences = nearest.ExpressionWeightConfidences;
+			return;
+		}
+
+		outState.ExpressionWeights.SetNumUninitialized(A.ExpressionWeights.Num());
+		for (int32 i = 0; i < A.ExpressionWeights.Num(); ++i)
+		{
+			outState.ExpressionWeights[i] = FMath::Clamp(FMath::Lerp(A.ExpressionWeights[i], B.ExpressionWeights[i], Alpha), 0.0f, 1.0f);
+		}
+		outState.ExpressionWeightConfidences.SetNumUninitialized(A.ExpressionWeightConfidences.Num());
+		for (int32 i = 0; i < A.ExpressionWeightConfidences.Num(); ++i)
+		{
+			outState.ExpressionWeightConfidences[i] = FMath::Clamp(FMath::Lerp(A.ExpressionWeightConfidences[i], B.ExpressionWeightConfidences[i], Alpha), 0.0f, 1.0f);
+		}
+	}
+
+	void InterpolateState(const FOculusXREyeGazesState& A, const FOculusXREyeGazesState& B, const float Alpha, FOculusXREyeGazesState& outState)
+	{
+		const FOculusXREyeGazesState& nearest = Alpha < 0.5f ? A : B;
+		outState.Time = FMath::Lerp(A.Time, B.Time, Alpha);
+
+		if (A.EyeGazes.Num() != B.EyeGazes.Num())
+		{
+			outState.EyeGazes = nearest.EyeGazes;
+			return;
+		}
+
+		outState.EyeGazes.SetNum(A.EyeGazes.Num());
+		for (int32 i = 0; i < A.EyeGazes.Num(); ++i)
+		{
+			const auto& gazeA = A.EyeGazes[i];
+			const auto& gazeB = B.EyeGazes[i];
+			auto& gaze = outState.EyeGazes[i];
+			if (gazeA.bIsValid && gazeB.bIsValid)
+			{
+				gaze.bIsValid = true;
+				gaze.Orientation = InterpolateRotator(gazeA.Orientation, gazeB.Orientation, Alpha);
+				gaze.Position = FMath::Lerp(gazeA.Position, gazeB.Position, static_cast<double>(Alpha));
+				gaze.Confidence = FMath::Clamp(FMath::Lerp(gazeA.Confidence, gazeB.Confidence, Alpha), 0.0f, 1.0f);
+			}
+			else
+			{
+				gaze = Alpha < 0.5f ? gazeA : gazeB;
+			}
+		}
+	}
+
+	template <typename ArrayType>
+	void RescaleJointPositions(ArrayType& Joints, const float Scale)
+	{
+		if (Scale != 1.0f)
+		{
+			for (auto& joint : Joints)
+			{
+				joint.Position *= Scale;
+			}
+		}
+	}
+} // namespace
+
+FOculusXRMovementJitterBuffer::FOculusXRMovementJitterBuffer(const FOculusXRMovementJitterBufferSettings& InSettings)
+	: Settings(InSettings)
+{
+	Settings.MaxSamples = FMath::Max(Settings.MaxSamples, 2);
+	Settings.MaxDelay = FMath::Max(Settings.MaxDelay, Settings.MinDelay);
+}
+
+template <typename StateType>
+void FOculusXRMovementJitterBuffer::PushSample(TStream<StateType>& Stream, const StateType& State, const double SendTime, const double ArrivalTime)
+{
+	const double transit = ArrivalTime - SendTime;
+	if (!bHasTransit)
+	{
+		Transit = transit;
+		LastTransit = transit;
+		bHasTransit = true;
+	}
+	else
+	{
+		Jitter += (FMath::Abs(transit - LastTransit) - Jitter) / 16.0;
+		Transit += (transit - Transit) / 16.0;
+		LastTransit = transit;
+	}
+
+	// Too late to be of any use: older than everything kept and already played
+	if (bIsPlaying && SendTime < PlaybackTime && (Stream.Samples.IsEmpty() || SendTime < Stream.Samples[0].Key))
+	{
+		++NumLateSamples;
+		return;
+	}
+
+	const int32 insertIdx = Algo::UpperBoundBy(Stream.Samples, SendTime, [](const auto& sample) { return sample.Key; });
+	if (insertIdx > 0 && Stream.Samples[insertIdx - 1].Key == SendTime)
+	{
+		++NumLateSamples;
+		return;
+	}
+	Stream.Samples.Insert(TPair<double, StateType>(SendTime, State), insertIdx);
+	if (Stream.Samples.Num() > Settings.MaxSamples)
+	{
+		Stream.Samples.RemoveAt(0, 1, EAllowShrinking::No);
+	}
+}
+
+template <typename StateType>
+void FOculusXRMovementJitterBuffer::Evaluate(TStream<StateType>& Stream)
+{
+	Stream.bEvaluated = true;
+	Stream.bEvaluatedValid = !Stream.Samples.IsEmpty();
+	if (!Stream.bEvaluatedValid)
+	{
+		return;
+	}
+
+	const int32 numSamples = Stream.Samples.Num();
+	const int32 upperIdx = Algo::UpperBoundBy(Stream.Samples, PlaybackTime, [](const auto& sample) { return sample.Key; });
+	if (upperIdx == 0 || numSamples == 1)
+	{
+		Stream.Evaluated = Stream.Samples[upperIdx == 0 ? 0 : numSamples - 1].Value;
+		return;
+	}
+
+	// Past the newest sample, keep the last motion going for a short while, then hold.
+	// Never further than one more sample interval, closely spaced samples would otherwise repeat their delta many times.
+	const int32 lowerIdx = upperIdx == numSamples ? numSamples - 2 : upperIdx - 1;
+	const auto& a = Stream.Samples[lowerIdx];
+	const auto& b = Stream.Samples[lowerIdx + 1];
+	const double time = FMath::Min(PlaybackTime, b.Key + FMath::Min<double>(Settings.MaxExtrapolation, b.Key - a.Key));
+	const float alpha = static_cast<float>((time - a.Key) / (b.Key - a.Key));
+	InterpolateState(a.Value, b.Value, alpha, Stream.Evaluated);
+}
+
+template <typename StateType>
+void FOculusXRMovementJitterBuffer::Prune(TStream<StateType>& Stream)
+{
+	Stream.bEvaluated = false;
+
+	// Keep one sample at or before the playback time to interpolate from
+	int32 numPlayed = 0;
+	while (numPlayed + 2 < Stream.Samples.Num() && Stream.Samples[numPlayed + 1].Key <= PlaybackTime)
+	{
+		++numPlayed;
+	}
+	if (numPlayed > 0)
+	{
+		Stream.Samples.RemoveAt(0, numPlayed, EAllowShrinking::No);
+	}
+}
+
+void FOculusXRMovementJitterBuffer::PushBodyState(const FOculusXRBodyState& BodyState, const double SendTime, const double ArrivalTime, const float WorldToMeters)
+{
+	FScopeLock lock(&Lock);
+	Body.WorldToMeters = WorldToMeters;
+	PushSample(Body, BodyState, SendTime, ArrivalTime);
+}
+
+void FOculusXRMovementJitterBuffer::PushFaceState(const FOculusXRFaceState& FaceState, const double SendTime, const double ArrivalTime)
+{
+	FScopeLock lock(&Lock);
+	PushSample(Face, FaceState, SendTime, ArrivalTime);
+}
+
+void FOculusXRMovementJitterBuffer::PushEyeGazesState(const FOculusXREyeGazesState& EyeGazesState, const double SendTime, const double ArrivalTime, const float WorldToMeters)
+{
+	FScopeLock lock(&Lock);
+	EyeGazes.WorldToMeters = WorldToMeters;
+	PushSample(EyeGazes, EyeGazesState, SendTime, ArrivalTime);
+}
+
+void FOculusXRMovementJitterBuffer::SetBodySkeleton(const FOculusXRBodySkeleton& InBodySkeleton, const float WorldToMeters)
+{
+	FScopeLock lock(&Lock);
+	BodySkeleton = InBodySkeleton;
+	BodySkeletonWorldToMeters = WorldToMeters;
+	bHasBodySkeleton = true;
+}
+
+void FOculusXRMovementJitterBuffer::Update(const double LocalTime)
+{
+	FScopeLock lock(&Lock);
+	if (!bHasTransit)
+	{
+		return;
+	}
+
+	const double delay = FMath::Clamp(Settings.JitterMultiplier * Jitter, Settings.MinDelay, Settings.MaxDelay);
+	const double targetTime = LocalTime - Transit - delay;
+	if (!bIsPlaying)
+	{
+		PlaybackTime = targetTime;
+		bIsPlaying = true;
+	}
+	else
+	{
+		// Play at real time, speeding up or slowing down slightly to follow the delay as it adapts
+		const double deltaTime = FMath::Max(LocalTime - LastLocalTime, 0.0);
+		PlaybackTime += deltaTime;
+		const double error = targetTime - PlaybackTime;
+		if (FMath::Abs(error) > Settings.MaxDelay)
+		{
+			// Stalled or the sender clock jumped, catching up smoothly would take too long
+			PlaybackTime = targetTime;
+		}
+		else
+		{
+			const double maxCorrection = deltaTime * Settings.MaxTimeScaleCorrection;
+			PlaybackTime += FMath::Clamp(error, -maxCorrection, maxCorrection);
+		}
+	}
+	LastLocalTime = LocalTime;
+
+	Prune(Body);
+	Prune(Face);
+	Prune(EyeGazes);
+
+	if (!Body.Samples.IsEmpty() && PlaybackTime > Body.Samples.Last().Key)
+	{
+		++NumExtrapolatedUpdates;
+	}
+}
+
+void FOculusXRMovementJitterBuffer::Reset()
+{
+	FScopeLock lock(&Lock);
+	Body = TStream<FOculusXRBodyState>();
+	Face = TStream<FOculusXRFaceState>();
+	EyeGazes = TStream<FOculusXREyeGazesState>();
+	bHasBodySkeleton = false;
+	bHasTransit = false;
+	Jitter = 0.0;
+	bIsPlaying = false;
+	NumLateSamples = 0;
+	NumExtrapolatedUpdates = 0;
+}
+
+double FOculusXRMovementJitterBuffer::GetPlaybackTime() const
+{
+	FScopeLock lock(&Lock);
+	return PlaybackTime;
+}
+
+float FOculusXRMovementJitterBuffer::GetDelay() const
+{
+	FScopeLock lock(&Lock);
+	return FMath::Clamp(Settings.JitterMultiplier * static_cast<float>(Jitter), Settings.MinDelay, Settings.MaxDelay);
+}
+
+int32 FOculusXRMovementJitterBuffer::GetNumLateSamples() const
+{
+	FScopeLock lock(&Lock);
+	return NumLateSamples;
+}
+
+int32 FOculusXRMovementJitterBuffer::GetNumExtrapolatedUpdates() const
+{
+	FScopeLock lock(&Lock);
+	return NumExtrapolatedUpdates;
+}
+
+bool FOculusXRMovementJitterBuffer::GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters)
+{
+	SCOPE_CYCLE_COUNTER(STAT_OculusXRMovementJitterBufferEvaluate);
+	FScopeLock lock(&Lock);
+	if (!bIsPlaying)
+	{
+		return false;
+	}
+	if (!Body.bEvaluated)
+	{
+		Evaluate(Body);
+	}
+	if (!Body.bEvaluatedValid)
+	{
+		return false;
+	}
+	outBodyState = Body.Evaluated;
+	RescaleJointPositions(outBodyState.Joints, WorldToMeters / Body.WorldToMeters);
+	return true;
+}
+
+bool FOculusXRMovementJitterBuffer::GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters)
+{
+	FScopeLock lock(&Lock);
+	if (!bHasBodySkeleton)
+	{
+		return false;
+	}
+	outBodySkeleton = BodySkeleton;
+	RescaleJointPositions(outBodySkeleton.Bones, WorldToMeters / BodySkeletonWorldToMeters);
+	return true;
+}
+
+bool FOculusXRMovementJitterBuffer::GetFaceState(FOculusXRFaceState& outFaceState)
+{
+	SCOPE_CYCLE_COUNTER(STAT_OculusXRMovementJitterBufferEvaluate);
+	FScopeLock lock(&Lock);
+	if (!bIsPlaying)
+	{
+		return false;
+	}
+	if (!Face.bEvaluated)
+	{
+		Evaluate(Face);
+	}
+	if (!Face.bEvaluatedValid)
+	{
+		return false;
+	}
+	outFaceState = Face.Evaluated;
+	return true;
+}
+
+bool FOculusXRMovementJitterBuffer::GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters)
+{
+	SCOPE_CYCLE_COUNTER(STAT_OculusXRMovementJitterBufferEvaluate);
+	FScopeLock lock(&Lock);
+	if (!bIsPlaying)
+	{
+		return false;
+	}
+	if (!EyeGazes.bEvaluated)
+	{
+		Evaluate(EyeGazes);
+	}
+	if (!EyeGazes.bEvaluatedValid)
+	{
+		return false;
+	}
+	outEyeGazesState = EyeGazes.Evaluated;
+	RescaleJointPositions(outEyeGazesState.EyeGazes, WorldToMeters / EyeGazes.WorldToMeters);
+	return true;
+}
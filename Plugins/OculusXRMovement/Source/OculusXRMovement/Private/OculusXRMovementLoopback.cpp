@@ -0,0 +1,95 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRMovementLoopback.h"
+#include "OculusXRMovementJitterBuffer.h"
+
+FOculusXRMovementLoopback::FOculusXRMovementLoopback(const TSharedRef<IOculusXRMovementDataProvider>& InSource, const TSharedRef<FOculusXRMovementJitterBuffer>& InReceiver, const FOculusXRMovementLoopbackSettings& InSettings)
+	: Source(InSource)
+	, Receiver(InReceiver)
+	, Settings(InSettings)
+	, Random(InSettings.Seed)
+{
+}
+
+void FOculusXRMovementLoopback::Send(const double SendTime, const float WorldToMeters)
+{
+	FPacket packet;
+	packet.SendTime = SendTime;
+	packet.WorldToMeters = WorldToMeters;
+
+	FOculusXRBodyState bodyState;
+	if (Source->GetBodyState(bodyState, WorldToMeters))
+	{
+		// Skeletons go through a reliable channel, only when they change
+		if (bodyState.SkeletonChangedCount != LastSkeletonChangedCount)
+		{
+			FOculusXRBodySkeleton bodySkeleton;
+			if (Source->GetBodySkeleton(bodySkeleton, WorldToMeters))
+			{
+				Receiver->SetBodySkeleton(bodySkeleton, WorldToMeters);
+				LastSkeletonChangedCount = bodyState.SkeletonChangedCount;
+			}
+		}
+		packet.BodyState = MoveTemp(bodyState);
+	}
+	FOculusXRFaceState faceState;
+	if (Source->GetFaceState(faceState))
+	{
+		packet.FaceState = MoveTemp(faceState);
+	}
+	FOculusXREyeGazesState eyeGazesState;
+	if (Source->GetEyeGazesState(eyeGazesState, WorldToMeters))
+	{
+		packet.EyeGazesState = MoveTemp(eyeGazesState);
+	}
+
+	++NumSent;
+	if (Random.FRand() < Settings.LossProbability)
+	{
+		++NumLost;
+		return;
+	}
+
+	packet.ArrivalTime = SendTime + Settings.Latency + Random.FRand() * Settings.Jitter;
+	if (Random.FRand() < Settings.ReorderProbability)
+	{
+		packet.ArrivalTime += Settings.ReorderDelay;
+	}
+	InFlight.Add(MoveTemp(packet));
+}
+
+void FOculusXRMovementLoopback::Deliver(const double LocalTime)
+{
+	InFlight.StableSort([](const FPacket& A, const FPacket& B) { return A.ArrivalTime < B.ArrivalTime; });
+
+	int32 numDelivered = 0;
+	for (; numDelivered < InFlight.Num() && InFlight[numDelivered].ArrivalTime <= LocalTime; ++numDelivered)
+	{
+		const FPacket& packet = InFlight[numDelivered];
+		if (packet.SendTime < LastDeliveredSendTime)
+		{
+			++NumReordered;
+		}
+		LastDeliveredSendTime = FMath::Max(LastDeliveredSendTime, packet.SendTime);
+
+		if (packet.BodyState.IsSet())
+		{
+			Receiver->PushBodyState(packet.BodyState.GetValue(), packet.SendTime, packet.ArrivalTime, packet.WorldToMeters);
+		}
+		if (packet.FaceState.IsSet())
+		{
+			Receiver->PushFaceState(packet.FaceState.GetValue(), packet.SendTime, packet.ArrivalTime);
+		}
+		if (packet.EyeGazesState.IsSet())
+		{
+			Receiver->PushEyeGazesState(packet.EyeGazesState.GetValue(), packet.SendTime, packet.ArrivalTime, packet.WorldToMeters);
+		}
+	}
+	InFlight.RemoveAt(0, numDelivered, EAllowShrinking::No);
+}
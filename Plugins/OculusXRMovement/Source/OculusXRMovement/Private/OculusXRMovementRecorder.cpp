@@ -0,0 +1,473 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRMovementRecorder.h"
+#include "OculusXRMovementRecording.h"
+#include "OculusXRRetargeting.h"
+#include "Algo/StableSort.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Movement Recorder Capture"), STAT_OculusXRMovementRecorderCapture, STATGROUP_OculusXRMovement);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Movement Recorder Backlog (KB)"), STAT_OculusXRMovementRecorderBacklog, STATGROUP_OculusXRMovement);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Movement Recorder Dropped Frames"), STAT_OculusXRMovementRecorderDroppedFrames, STATGROUP_OculusXRMovement);
+
+namespace
+{
+	// Every chunk is stored as: raw size, stored size, compressed flag, data
+	constexpr int64 kChunkHeaderSize = sizeof(int32) + sizeof(int32) + sizeof(uint8);
+
+	// Encoding scratch, reused so capturing does not allocate once warmed up
+	TArray<uint8>& GetRecordScratch()
+	{
+		thread_local TArray<uint8> Scratch;
+		Scratch.Reset();
+		return Scratch;
+	}
+} // namespace
+
+class FOculusXRAsyncMovementRecorder::FWriter : public FRunnable
+{
+public:
+	FWriter(FOculusXRAsyncMovementRecorder& InRecorder, TUniquePtr<FArchive>&& InFileWriter)
+		: Recorder(InRecorder)
+		, FileWriter(MoveTemp(InFileWriter))
+		, WorkEvent(FPlatformProcess::GetSynchEventFromPool())
+	{
+		Thread.Reset(FRunnableThread::Create(this, TEXT("OculusXRMovementRecorder"), 0, TPri_BelowNormal));
+	}
+
+	virtual ~FWriter() override
+	{
+		Flush();
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	}
+
+	void Wake()
+	{
+		WorkEvent->Trigger();
+	}
+
+	// Writes every pending chunk and stops the thread
+	void Flush()
+	{
+		if (Thread)
+		{
+			bStopping = true;
+			WorkEvent->Trigger();
+			Thread->WaitForCompletion();
+			Thread.Reset();
+			FileWriter->Close();
+		}
+	}
+
+	virtual uint32 Run() override
+	{
+		while (true)
+		{
+			const bool bWasStopping = bStopping;
+			FChunk* chunk = nullptr;
+			while (Recorder.PendingChunks.Dequeue(chunk))
+			{
+				Write(*chunk);
+				Recorder.ReleaseChunk(chunk);
+			}
+			if (bWasStopping)
+			{
+				break;
+			}
+			WorkEvent->Wait();
+		}
+		return 0;
+	}
+
+private:
+	void Write(const FChunk& Chunk)
+	{
+		int32 rawSize = Chunk.Size;
+		int32 storedSize = Chunk.Size;
+		uint8 bCompressed = 0;
+		const uint8* storedData = Chunk.Data.GetData();
+
+		if (Recorder.Settings.bCompress)
+		{
+			CompressedData.SetNumUninitialized(FCompression::CompressMemoryBound(NAME_Oodle, rawSize), EAllowShrinking::No);
+			int32 compressedSize = CompressedData.Num();
+			if (FCompression::CompressMemory(NAME_Oodle, CompressedData.GetData(), compressedSize, Chunk.Data.GetData(), rawSize) && compressedSize < rawSize)
+			{
+				storedSize = compressedSize;
+				storedData = CompressedData.GetData();
+				bCompressed = 1;
+			}
+		}
+
+		*FileWriter << rawSize;
+		*FileWriter << storedSize;
+		*FileWriter << bCompressed;
+		FileWriter->Serialize(const_cast<uint8*>(storedData), storedSize);
+	}
+
+	FOculusXRAsyncMovementRecorder& Recorder;
+	TUniquePtr<FArchive> FileWriter;
+	FEvent* WorkEvent = nullptr;
+	TUniquePtr<FRunnableThread> Thread;
+	std::atomic<bool> bStopping = false;
+	TArray<uint8> CompressedData;
+};
+
+FOculusXRAsyncMovementRecorder::FOculusXRAsyncMovementRecorder(const TSharedRef<IOculusXRMovementDataProvider>& InSource, const FString& InFilename, const FOculusXRMovementRecorderSettings& InSettings)
+	: Source(InSource)
+	, Settings(InSettings)
+{
+	Settings.ChunkSize = FMath::Max(Settings.ChunkSize, 4 * 1024);
+	Settings.NumChunks = FMath::Max(Settings.NumChunks, 2);
+
+	TUniquePtr<FArchive> fileWriter(IFileManager::Get().CreateFileWriter(*InFilename));
+	if (!fileWriter)
+	{
+		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Cannot open %s to record movement."), *InFilename);
+		return;
+	}
+	uint32 magic = kStreamMagic;
+	uint32 version = kStreamVersion;
+	*fileWriter << magic;
+	*fileWriter << version;
+
+	// All capture memory is allocated up front
+	Chunks.Reserve(Settings.NumChunks);
+	FreeChunks.Reserve(Settings.NumChunks);
+	for (int32 i = 0; i < Settings.NumChunks; ++i)
+	{
+		TUniquePtr<FChunk>& chunk = Chunks.Add_GetRef(MakeUnique<FChunk>());
+		chunk->Data.SetNumUninitialized(Settings.ChunkSize);
+		FreeChunks.Add(chunk.Get());
+	}
+	CurrentChunk = FreeChunks.Pop(EAllowShrinking::No);
+
+	Writer = MakeUnique<FWriter>(*this, MoveTemp(fileWriter));
+	bIsRecording = true;
+}
+
+FOculusXRAsyncMovementRecorder::~FOculusXRAsyncMovementRecorder()
+{
+	Stop();
+}
+
+void FOculusXRAsyncMovementRecorder::Stop()
+{
+	{
+		FScopeLock scopeLock(&CaptureLock);
+		if (!bIsRecording)
+		{
+			return;
+		}
+		bIsRecording = false;
+		if (CurrentChunk && CurrentChunk->Size > 0)
+		{
+			SubmitCurrentChunk();
+		}
+	}
+
+	Writer->Flush();
+	UpdateStats();
+	if (NumDroppedFrames > 0)
+	{
+		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Movement recorder dropped %u frames, the disk could not keep up."), GetNumDroppedFrames());
+	}
+}
+
+bool FOculusXRAsyncMovementRecorder::BeginCapture(const ERecordType Type, const float StateTime, double& outTimestamp)
+{
+	FScopeLock scopeLock(&CaptureLock);
+	if (!bIsRecording)
+	{
+		return false;
+	}
+
+	if (Type == ERecordType::BodySkeleton)
+	{
+		// Skeletons must not start the recording clock, the loader does not read their timestamp
+		const int32 skeletonChangedCount = BodySkeletonChangedCount.load(std::memory_order_relaxed);
+		if (CapturedSkeletonChangedCount.IsSet() && CapturedSkeletonChangedCount.GetValue() == skeletonChangedCount)
+		{
+			return false;
+		}
+		CapturedSkeletonChangedCount = skeletonChangedCount;
+		outTimestamp = 0.0;
+		return true;
+	}
+
+	float& lastTime = Type == ERecordType::Body ? LastBodyTime : Type == ERecordType::Face ? LastFaceTime : LastEyeTime;
+	if (lastTime == StateTime)
+	{
+		return false;
+	}
+	lastTime = StateTime;
+
+	if (!FirstStateTime.IsSet())
+	{
+		FirstStateTime = StateTime;
+	}
+	outTimestamp = FMath::Max(static_cast<double>(StateTime) - FirstStateTime.GetValue(), 0.0);
+	return true;
+}
+
+void FOculusXRAsyncMovementRecorder::Capture(const TArray<uint8>& Record)
+{
+	{
+		FScopeLock scopeLock(&CaptureLock);
+		if (bIsRecording && CurrentChunk && CurrentChunk->Size + Record.Num() > CurrentChunk->Data.Num() && CurrentChunk->Size > 0)
+		{
+			SubmitCurrentChunk();
+		}
+
+		if (bIsRecording && CurrentChunk && CurrentChunk->Size + Record.Num() <= CurrentChunk->Data.Num())
+		{
+			FMemory::Memcpy(CurrentChunk->Data.GetData() + CurrentChunk->Size, Record.GetData(), Record.Num());
+			CurrentChunk->Size += Record.Num();
+		}
+		else if (bIsRecording)
+		{
+			NumDroppedFrames.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	UpdateStats();
+}
+
+void FOculusXRAsyncMovementRecorder::SubmitCurrentChunk()
+{
+	BacklogBytes.fetch_add(CurrentChunk->Size, std::memory_order_relaxed);
+	PendingChunks.Enqueue(CurrentChunk);
+	CurrentChunk = FreeChunks.IsEmpty() ? nullptr : FreeChunks.Pop(EAllowShrinking::No);
+	Writer->Wake();
+}
+
+void FOculusXRAsyncMovementRecorder::ReleaseChunk(FChunk* Chunk)
+{
+	BacklogBytes.fetch_sub(Chunk->Size, std::memory_order_relaxed);
+	Chunk->Size = 0;
+
+	FScopeLock scopeLock(&CaptureLock);
+	if (!CurrentChunk)
+	{
+		CurrentChunk = Chunk;
+	}
+	else
+	{
+		FreeChunks.Add(Chunk);
+	}
+}
+
+void FOculusXRAsyncMovementRecorder::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_OculusXRMovementRecorderBacklog, static_cast<uint32>(GetBacklogBytes() / 1024));
+	SET_DWORD_STAT(STAT_OculusXRMovementRecorderDroppedFrames, GetNumDroppedFrames());
+}
+
+bool FOculusXRAsyncMovementRecorder::IsAvailable() const
+{
+	return Source->IsAvailable();
+}
+
+bool FOculusXRAsyncMovementRecorder::GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters)
+{
+	if (!Source->GetBodyState(outBodyState, WorldToMeters))
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_OculusXRMovementRecorderCapture);
+	BodySkeletonChangedCount.store(outBodyState.SkeletonChangedCount, std::memory_order_relaxed);
+	double timestamp = 0.0;
+	if (BeginCapture(ERecordType::Body, outBodyState.Time, timestamp))
+	{
+		TArray<uint8>& record = GetRecordScratch();
+		FMemoryWriter recordWriter(record);
+		ERecordType type = ERecordType::Body;
+		float worldToMeters = WorldToMeters;
+		recordWriter << type << timestamp << worldToMeters;
+		FOculusXRMovementRecording::SerializeBodyState(recordWriter, outBodyState);
+		Capture(record);
+	}
+	return true;
+}
+
+bool FOculusXRAsyncMovementRecorder::GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters)
+{
+	if (!Source->GetBodySkeleton(outBodySkeleton, WorldToMeters))
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_OculusXRMovementRecorderCapture);
+	double timestamp = 0.0;
+	if (BeginCapture(ERecordType::BodySkeleton, 0.0f, timestamp))
+	{
+		TArray<uint8>& record = GetRecordScratch();
+		FMemoryWriter recordWriter(record);
+		ERecordType type = ERecordType::BodySkeleton;
+		float worldToMeters = WorldToMeters;
+		recordWriter << type << timestamp << worldToMeters;
+		FOculusXRMovementRecording::SerializeBodySkeleton(recordWriter, outBodySkeleton);
+		Capture(record);
+	}
+	return true;
+}
+
+bool FOculusXRAsyncMovementRecorder::GetFaceState(FOculusXRFaceState& outFaceState)
+{
+	if (!Source->GetFaceState(outFaceState))
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_OculusXRMovementRecorderCapture);
+	double timestamp = 0.0;
+	if (BeginCapture(ERecordType::Face, outFaceState.Time, timestamp))
+	{
+		TArray<uint8>& record = GetRecordScratch();
+		FMemoryWriter recordWriter(record);
+		ERecordType type = ERecordType::Face;
+		float worldToMeters = 0.0f;
+		recordWriter << type << timestamp << worldToMeters;
+		FOculusXRMovementRecording::SerializeFaceState(recordWriter, outFaceState);
+		Capture(record);
+	}
+	return true;
+}
+
+bool FOculusXRAsyncMovementRecorder::GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters)
+{
+	if (!Source->GetEyeGazesState(outEyeGazesState, WorldToMeters))
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_OculusXRMovementRecorderCapture);
+	double timestamp = 0.0;
+	if (BeginCapture(ERecordType::Eye, outEyeGazesState.Time, timestamp))
+	{
+		TArray<uint8>& record = GetRecordScratch();
+		FMemoryWriter recordWriter(record);
+		ERecordType type = ERecordType::Eye;
+		float worldToMeters = WorldToMeters;
+		recordWriter << type << timestamp << worldToMeters;
+		FOculusXRMovementRecording::SerializeEyeGazesState(recordWriter, outEyeGazesState);
+		Capture(record);
+	}
+	return true;
+}
+
+bool FOculusXRAsyncMovementRecorder::LoadStream(const FString& Filename, FOculusXRMovementRecording& outRecording)
+{
+	outRecording.Reset();
+
+	TUniquePtr<FArchive> fileReader(IFileManager::Get().CreateFileReader(*Filename));
+	if (!fileReader)
+	{
+		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Cannot open movement stream %s."), *Filename);
+		return false;
+	}
+
+	uint32 magic = 0;
+	uint32 version = 0;
+	*fileReader << magic;
+	*fileReader << version;
+	if (magic != kStreamMagic || version == 0 || version > kStreamVersion)
+	{
+		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Unsupported movement stream %s (magic 0x%08x, version %u)."), *Filename, magic, version);
+		return false;
+	}
+
+	TArray<uint8> storedData;
+	TArray<uint8> rawData;
+	while (!fileReader->AtEnd() && fileReader->TotalSize() - fileReader->Tell() >= kChunkHeaderSize)
+	{
+		int32 rawSize = 0;
+		int32 storedSize = 0;
+		uint8 bCompressed = 0;
+		*fileReader << rawSize;
+		*fileReader << storedSize;
+		*fileReader << bCompressed;
+		if (rawSize < 0 || storedSize < 0 || storedSize > fileReader->TotalSize() - fileReader->Tell())
+		{
+			// A recorder that did not stop cleanly leaves a partial chunk, keep what was complete
+			UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Movement stream %s is truncated."), *Filename);
+			break;
+		}
+
+		storedData.SetNumUninitialized(storedSize, EAllowShrinking::No);
+		fileReader->Serialize(storedData.GetData(), storedSize);
+		if (bCompressed)
+		{
+			rawData.SetNumUninitialized(rawSize, EAllowShrinking::No);
+			if (!FCompression::UncompressMemory(NAME_Oodle, rawData.GetData(), rawSize, storedData.GetData(), storedSize))
+			{
+				UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Cannot decompress a chunk of movement stream %s."), *Filename);
+				break;
+			}
+		}
+		else
+		{
+			Swap(rawData, storedData);
+		}
+
+		FMemoryReader chunkReader(rawData);
+		while (!chunkReader.AtEnd() && !chunkReader.IsError())
+		{
+			ERecordType type = ERecordType::Body;
+			double timestamp = 0.0;
+			float worldToMeters = 0.0f;
+			chunkReader << type << timestamp << worldToMeters;
+			if (worldToMeters > 0.0f)
+			{
+				outRecording.WorldToMeters = worldToMeters;
+			}
+
+			switch (type)
+			{
+				case ERecordType::BodySkeleton:
+					FOculusXRMovementRecording::SerializeBodySkeleton(chunkReader, outRecording.BodySkeleton);
+					outRecording.bHasBodySkeleton = true;
+					break;
+				case ERecordType::Body:
+					FOculusXRMovementRecording::SerializeBodyState(chunkReader, outRecording.BodyFrames.AddDefaulted_GetRef().State);
+					outRecording.BodyFrames.Last().Timestamp = timestamp;
+					break;
+				case ERecordType::Face:
+					FOculusXRMovementRecording::SerializeFaceState(chunkReader, outRecording.FaceFrames.AddDefaulted_GetRef().State);
+					outRecording.FaceFrames.Last().Timestamp = timestamp;
+					break;
+				case ERecordType::Eye:
+					FOculusXRMovementRecording::SerializeEyeGazesState(chunkReader, outRecording.EyeFrames.AddDefaulted_GetRef().State);
+					outRecording.EyeFrames.Last().Timestamp = timestamp;
+					break;
+				default:
+					chunkReader.SetError();
+					break;
+			}
+		}
+
+		if (chunkReader.IsError())
+		{
+			UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Movement stream %s has a corrupted chunk."), *Filename);
+			break;
+		}
+	}
+
+	// Frames captured on different threads can land in the chunks slightly out of order
+	Algo::StableSortBy(outRecording.BodyFrames, &FOculusXRMovementRecording::FBodyFrame::Timestamp);
+	Algo::StableSortBy(outRecording.FaceFrames, &FOculusXRMovementRecording::FFaceFrame::Timestamp);
+	Algo::StableSortBy(outRecording.EyeFrames, &FOculusXRMovementRecording::FEyeFrame::Timestamp);
+	return true;
+}
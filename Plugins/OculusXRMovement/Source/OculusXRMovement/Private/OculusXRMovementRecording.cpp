@@ -0,0 +1,887 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRMovementRecording.h"
+#include "OculusXRRetargeting.h"
+#include "Algo/BinarySearch.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/Archive.h"
+
+namespace
+{
+	constexpr int32 kNumBones = static_cast<int32>(EOculusXRBoneID::COUNT);
+	constexpr int32 kNumExpressions = static_cast<int32>(EOculusXRFaceExpression::COUNT);
+	constexpr int32 kNumEyes = 2;
+
+	// Bools are stored as a single byte, FArchive would use 4
+	void SerializeFlag(FArchive& Ar, bool& bValue)
+	{
+		uint8 value = bValue ? 1 : 0;
+		Ar << value;
+		bValue = value != 0;
+	}
+
+	void SerializeRotator(FArchive& Ar, FRotator& Rotator)
+	{
+		FRotator3f compactRotator(Rotator);
+		Ar << compactRotator;
+		Rotator = FRotator(compactRotator);
+	}
+
+	void SerializeVector(FArchive& Ar, FVector& Vector)
+	{
+		FVector3f compactVector(Vector);
+		Ar << compactVector;
+		Vector = FVector(compactVector);
+	}
+
+	// Index of the last frame at or before Time, INDEX_NONE if there is none.
+	// Works on the recorded frames as well as on the frame index of a mapped recording.
+	template <typename RangeType>
+	int32 FindFrameIndex(const RangeType& Frames, const double Time)
+	{
+		if (Frames.IsEmpty())
+		{
+			return INDEX_NONE;
+		}
+		const int32 upperBound = Algo::UpperBoundBy(Frames, Time, [](const auto& frame) { return frame.Timestamp; });
+		return upperBound - 1;
+	}
+
+	// Playback holds the first frame until its time is reached
+	int32 GetPlaybackFrameIndex(const int32 FrameIndex, const int32 NumFrames)
+	{
+		return NumFrames > 0 ? FMath::Max(FrameIndex, 0) : INDEX_NONE;
+	}
+
+	// Frame counts come from the file, a corrupted one must not allocate more frames than the remaining bytes can hold.
+	// Every frame starts with its timestamp.
+	bool CheckFrameCount(FArchive& Ar, const int32 NumFrames)
+	{
+		const int64 totalSize = Ar.TotalSize();
+		if (Ar.IsError() || NumFrames < 0 || (totalSize >= 0 && NumFrames > (totalSize - Ar.Tell()) / static_cast<int64>(sizeof(double))))
+		{
+			UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Movement recording has a corrupted frame count (%d)."), NumFrames);
+			Ar.SetError();
+			return false;
+		}
+		return true;
+	}
+
+	// Per frame counts come from the file as well, and are read on anim worker threads through the mapped recordings
+	bool CheckElementCount(FArchive& Ar, const int32 NumElements, const int32 MaxElements)
+	{
+		if (Ar.IsError())
+		{
+			return false;
+		}
+		if (NumElements < 0 || NumElements > MaxElements)
+		{
+			UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Movement recording has a corrupted element count (%d, at most %d)."), NumElements, MaxElements);
+			Ar.SetError();
+			return false;
+		}
+		return true;
+	}
+
+	// Same layout as serializing the array directly, with a bounded count
+	void SerializeWeights(FArchive& Ar, TArray<float>& Weights, const int32 MaxWeights)
+	{
+		int32 numWeights = Weights.Num();
+		Ar << numWeights;
+		if (Ar.IsLoading())
+		{
+			if (!CheckElementCount(Ar, numWeights, MaxWeights))
+			{
+				Weights.Reset();
+				return;
+			}
+			Weights.SetNum(numWeights);
+		}
+		for (float& weight : Weights)
+		{
+			Ar << weight;
+		}
+	}
+
+	void SerializeFrameIndex(FArchive& Ar, TArray<FOculusXRMovementRecording::FFrameIndexEntry>& Index)
+	{
+		for (auto& entry : Index)
+		{
+			Ar << entry.Timestamp;
+			Ar << entry.Offset;
+		}
+	}
+
+	void RescalePositions(FOculusXRBodyState& State, const float FromWorldToMeters, const float ToWorldToMeters)
+	{
+		if (FromWorldToMeters != ToWorldToMeters)
+		{
+			const float scale = ToWorldToMeters / FromWorldToMeters;
+			for (auto& joint : State.Joints)
+			{
+				joint.Position *= scale;
+			}
+		}
+	}
+
+	void RescalePositions(FOculusXRBodySkeleton& State, const float FromWorldToMeters, const float ToWorldToMeters)
+	{
+		if (FromWorldToMeters != ToWorldToMeters)
+		{
+			const float scale = ToWorldToMeters / FromWorldToMeters;
+			for (auto& bone : State.Bones)
+			{
+				bone.Position *= scale;
+			}
+		}
+	}
+
+	void RescalePositions(FOculusXREyeGazesState& State, const float FromWorldToMeters, const float ToWorldToMeters)
+	{
+		if (FromWorldToMeters != ToWorldToMeters)
+		{
+			const float scale = ToWorldToMeters / FromWorldToMeters;
+			for (auto& eyeGaze : State.EyeGazes)
+			{
+				eyeGaze.Position *= scale;
+			}
+		}
+	}
+} // namespace
+
+double FOculusXRMovementRecording::GetDuration() const
+{
+	double duration = 0.0;
+	duration = BodyFrames.IsEmpty() ? duration : FMath::Max(duration, BodyFrames.Last().Timestamp);
+	duration = FaceFrames.IsEmpty() ? duration : FMath::Max(duration, FaceFrames.Last().Timestamp);
+	duration = EyeFrames.IsEmpty() ? duration : FMath::Max(duration, EyeFrames.Last().Timestamp);
+	return duration;
+}
+
+void FOculusXRMovementRecording::Reset()
+{
+	WorldToMeters = 100.0f;
+	bHasBodySkeleton = false;
+	BodySkeleton = FOculusXRBodySkeleton();
+	BodyFrames.Empty();
+	FaceFrames.Empty();
+	EyeFrames.Empty();
+}
+
+bool FOculusXRMovementRecording::Serialize(FArchive& Ar)
+{
+	const int64 startOffset = Ar.Tell();
+	TArray<FFrameIndexEntry> bodyIndex, faceIndex, eyeIndex;
+
+	uint32 magic = kMagic;
+	uint32 version = kCurrentVersion;
+	Ar << magic;
+	Ar << version;
+	if (Ar.IsLoading() && (magic != kMagic || version == 0 || version > kCurrentVersion))
+	{
+		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Unsupported movement recording (magic 0x%08x, version %u)."), magic, version);
+		Ar.SetError();
+		return false;
+	}
+
+	Ar << WorldToMeters;
+	SerializeFlag(Ar, bHasBodySkeleton);
+	if (bHasBodySkeleton)
+	{
+		SerializeBodySkeleton(Ar, BodySkeleton);
+	}
+
+	int32 numBodyFrames = BodyFrames.Num();
+	Ar << numBodyFrames;
+	if (Ar.IsLoading())
+	{
+		if (!CheckFrameCount(Ar, numBodyFrames))
+		{
+			return false;
+		}
+		BodyFrames.SetNum(numBodyFrames);
+	}
+	for (FBodyFrame& frame : BodyFrames)
+	{
+		bodyIndex.Add({ frame.Timestamp, Ar.Tell() - startOffset });
+		Ar << frame.Timestamp;
+		SerializeBodyState(Ar, frame.State);
+	}
+
+	int32 numFaceFrames = FaceFrames.Num();
+	Ar << numFaceFrames;
+	if (Ar.IsLoading())
+	{
+		if (!CheckFrameCount(Ar, numFaceFrames))
+		{
+			return false;
+		}
+		FaceFrames.SetNum(numFaceFrames);
+	}
+	for (FFaceFrame& frame : FaceFrames)
+	{
+		faceIndex.Add({ frame.Timestamp, Ar.Tell() - startOffset });
+		Ar << frame.Timestamp;
+		SerializeFaceState(Ar, frame.State);
+	}
+
+	int32 numEyeFrames = EyeFrames.Num();
+	Ar << numEyeFrames;
+	if (Ar.IsLoading())
+	{
+		if (!CheckFrameCount(Ar, numEyeFrames))
+		{
+			return false;
+		}
+		EyeFrames.SetNum(numEyeFrames);
+	}
+	for (FEyeFrame& frame : EyeFrames)
+	{
+		eyeIndex.Add({ frame.Timestamp, Ar.Tell() - startOffset });
+		Ar << frame.Timestamp;
+		SerializeEyeGazesState(Ar, frame.State);
+	}
+
+	if (version >= 2)
+	{
+		// The index is only needed by mapped readers, loading skips over it
+		const int64 indexOffset = Align(Ar.Tell() - startOffset, alignof(FFrameIndexEntry));
+		const int64 indexSize = (numBodyFrames + numFaceFrames + numEyeFrames) * static_cast<int64>(sizeof(FFrameIndexEntry));
+		if (Ar.IsLoading())
+		{
+			Ar.Seek(startOffset + indexOffset + indexSize + kIndexFooterSize);
+		}
+		else
+		{
+			for (uint8 padding = 0; Ar.Tell() - startOffset < indexOffset;)
+			{
+				Ar << padding;
+			}
+			SerializeFrameIndex(Ar, bodyIndex);
+			SerializeFrameIndex(Ar, faceIndex);
+			SerializeFrameIndex(Ar, eyeIndex);
+
+			FIndexFooter footer{ indexOffset, numBodyFrames, numFaceFrames, numEyeFrames, kIndexMagic };
+			SerializeIndexFooter(Ar, footer);
+		}
+	}
+
+	return !Ar.IsError();
+}
+
+bool FOculusXRMovementRecording::SaveToFile(const FString& Filename)
+{
+	TUniquePtr<FArchive> FileWriter(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!FileWriter)
+	{
+		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Cannot open %s to write the movement recording."), *Filename);
+		return false;
+	}
+	const bool bSuccess = Serialize(*FileWriter);
+	return FileWriter->Close() && bSuccess;
+}
+
+bool FOculusXRMovementRecording::LoadFromFile(const FString& Filename)
+{
+	TUniquePtr<FArchive> FileReader(IFileManager::Get().CreateFileReader(*Filename));
+	if (!FileReader)
+	{
+		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Cannot open movement recording %s."), *Filename);
+		return false;
+	}
+	Reset();
+	if (!Serialize(*FileReader))
+	{
+		Reset();
+		return false;
+	}
+	return true;
+}
+
+void FOculusXRMovementRecording::SerializeBodySkeleton(FArchive& Ar, FOculusXRBodySkeleton& BodySkeleton)
+{
+	int32 numBones = BodySkeleton.NumBones;
+	Ar << numBones;
+	if (Ar.IsLoading())
+	{
+		if (!CheckElementCount(Ar, numBones, kNumBones))
+		{
+			BodySkeleton.NumBones = 0;
+			BodySkeleton.Bones.Reset();
+			return;
+		}
+		BodySkeleton.NumBones = numBones;
+		BodySkeleton.Bones.SetNum(numBones);
+	}
+	else if (!ensureMsgf(numBones >= 0 && BodySkeleton.Bones.Num() >= numBones, TEXT("Body skeleton has %d bones, %d expected."), BodySkeleton.Bones.Num(), numBones))
+	{
+		Ar.SetError();
+		return;
+	}
+	for (int32 i = 0; i < numBones; ++i)
+	{
+		auto& bone = BodySkeleton.Bones[i];
+		int32 boneId = static_cast<int32>(bone.BoneId);
+		int32 parentBoneId = static_cast<int32>(bone.ParentBoneIndex);
+		Ar << boneId;
+		Ar << parentBoneId;
+		bone.BoneId = static_cast<EOculusXRBoneID>(boneId);
+		bone.ParentBoneIndex = static_cast<EOculusXRBoneID>(parentBoneId);
+		SerializeRotator(Ar, bone.Orientation);
+		SerializeVector(Ar, bone.Position);
+	}
+}
+
+void FOculusXRMovementRecording::SerializeBodyState(FArchive& Ar, FOculusXRBodyState& BodyState)
+{
+	SerializeFlag(Ar, BodyState.IsActive);
+	Ar << BodyState.Confidence;
+	Ar << BodyState.SkeletonChangedCount;
+	Ar << BodyState.Time;
+
+	int32 numJoints = BodyState.Joints.Num();
+	Ar << numJoints;
+	if (Ar.IsLoading())
+	{
+		if (!CheckElementCount(Ar, numJoints, kNumBones))
+		{
+			BodyState.Joints.Reset();
+			return;
+		}
+		BodyState.Joints.SetNum(numJoints);
+	}
+	for (auto& joint : BodyState.Joints)
+	{
+		SerializeFlag(Ar, joint.bIsValid);
+		SerializeRotator(Ar, joint.Orientation);
+		SerializeVector(Ar, joint.Position);
+	}
+}
+
+void FOculusXRMovementRecording::SerializeFaceState(FArchive& Ar, FOculusXRFaceState& FaceState)
+{
+	SerializeWeights(Ar, FaceState.ExpressionWeights, kNumExpressions);
+	SerializeWeights(Ar, FaceState.ExpressionWeightConfidences, kNumExpressions);
+	SerializeFlag(Ar, FaceState.bIsValid);
+	SerializeFlag(Ar, FaceState.bIsEyeFollowingBlendshapesValid);
+	Ar << FaceState.Time;
+}
+
+void FOculusXRMovementRecording::SerializeIndexFooter(FArchive& Ar, FIndexFooter& Footer)
+{
+	Ar << Footer.IndexOffset;
+	Ar << Footer.NumBodyFrames;
+	Ar << Footer.NumFaceFrames;
+	Ar << Footer.NumEyeFrames;
+	Ar << Footer.Magic;
+}
+
+void FOculusXRMovementRecording::SerializeEyeGazesState(FArchive& Ar, FOculusXREyeGazesState& EyeGazesState)
+{
+	int32 numEyeGazes = EyeGazesState.EyeGazes.Num();
+	Ar << numEyeGazes;
+	if (Ar.IsLoading())
+	{
+		if (!CheckElementCount(Ar, numEyeGazes, kNumEyes))
+		{
+			EyeGazesState.EyeGazes.Reset();
+			return;
+		}
+		EyeGazesState.EyeGazes.SetNum(numEyeGazes);
+	}
+	for (auto& eyeGaze : EyeGazesState.EyeGazes)
+	{
+		SerializeRotator(Ar, eyeGaze.Orientation);
+		SerializeVector(Ar, eyeGaze.Position);
+		Ar << eyeGaze.Confidence;
+		SerializeFlag(Ar, eyeGaze.bIsValid);
+	}
+	Ar << EyeGazesState.Time;
+}
+
+FOculusXRPlaybackMovementDataProvider::FOculusXRPlaybackMovementDataProvider(const TSharedRef<const FOculusXRMovementRecording>& InRecording, const bool bInLoop)
+	: Recording(InRecording)
+	, bLoop(bInLoop)
+{
+}
+
+void FOculusXRPlaybackMovementDataProvider::SetPlaybackTime(const double Time)
+{
+	const double duration = Recording->GetDuration();
+	double playbackTime = FMath::Max(Time, 0.0);
+	if (bLoop && duration > 0.0)
+	{
+		playbackTime = FMath::Fmod(playbackTime, duration);
+	}
+	PlaybackTime.store(playbackTime, std::memory_order_relaxed);
+}
+
+void FOculusXRPlaybackMovementDataProvider::Advance(const double DeltaSeconds)
+{
+	SetPlaybackTime(GetPlaybackTime() + DeltaSeconds);
+}
+
+bool FOculusXRPlaybackMovementDataProvider::IsAvailable() const
+{
+	return !Recording->IsEmpty();
+}
+
+bool FOculusXRPlaybackMovementDataProvider::GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters)
+{
+	const int32 frameIndex = GetPlaybackFrameIndex(FindFrameIndex(Recording->BodyFrames, GetPlaybackTime()), Recording->BodyFrames.Num());
+	if (frameIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	outBodyState = Recording->BodyFrames[frameIndex].State;
+	RescalePositions(outBodyState, Recording->WorldToMeters, WorldToMeters);
+	return true;
+}
+
+bool FOculusXRPlaybackMovementDataProvider::GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters)
+{
+	if (!Recording->bHasBodySkeleton)
+	{
+		return false;
+	}
+
+	outBodySkeleton = Recording->BodySkeleton;
+	RescalePositions(outBodySkeleton, Recording->WorldToMeters, WorldToMeters);
+	return true;
+}
+
+bool FOculusXRPlaybackMovementDataProvider::GetFaceState(FOculusXRFaceState& outFaceState)
+{
+	const int32 frameIndex = GetPlaybackFrameIndex(FindFrameIndex(Recording->FaceFrames, GetPlaybackTime()), Recording->FaceFrames.Num());
+	if (frameIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	outFaceState = Recording->FaceFrames[frameIndex].State;
+	return true;
+}
+
+bool FOculusXRPlaybackMovementDataProvider::GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters)
+{
+	const int32 frameIndex = GetPlaybackFrameIndex(FindFrameIndex(Recording->EyeFrames, GetPlaybackTime()), Recording->EyeFrames.Num());
+	if (frameIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	outEyeGazesState = Recording->EyeFrames[frameIndex].State;
+	RescalePositions(outEyeGazesState, Recording->WorldToMeters, WorldToMeters);
+	return true;
+}
+
+FCriticalSection FOculusXRMappedMovementRecording::OpenRecordingsLock;
+TMap<FString, TWeakPtr<const FOculusXRMappedMovementRecording>> FOculusXRMappedMovementRecording::OpenRecordings;
+
+TSharedPtr<const FOculusXRMappedMovementRecording> FOculusXRMappedMovementRecording::Open(const FString& InFilename)
+{
+	const FString fullFilename = FPaths::ConvertRelativePathToFull(InFilename);
+
+	FScopeLock scopeLock(&OpenRecordingsLock);
+	if (TSharedPtr<const FOculusXRMappedMovementRecording> openRecording = OpenRecordings.FindRef(fullFilename).Pin())
+	{
+		return openRecording;
+	}
+
+	TSharedRef<FOculusXRMappedMovementRecording> recording = MakeShareable(new FOculusXRMappedMovementRecording());
+	if (!recording->Initialize(fullFilename))
+	{
+		return nullptr;
+	}
+	OpenRecordings.Add(fullFilename, recording);
+	return recording;
+}
+
+FOculusXRMappedMovementRecording::~FOculusXRMappedMovementRecording()
+{
+	{
+		FScopeLock scopeLock(&OpenRecordingsLock);
+		// The file may have been opened again since the last reference to this recording was released
+		const TWeakPtr<const FOculusXRMappedMovementRecording>* openRecording = OpenRecordings.Find(Filename);
+		if (openRecording && !openRecording->IsValid())
+		{
+			OpenRecordings.Remove(Filename);
+		}
+	}
+
+	// Unmap before closing the file
+	MappedRegion.Reset();
+	MappedHandle.Reset();
+}
+
+bool FOculusXRMappedMovementRecording::Initialize(const FString& InFilename)
+{
+	Filename = InFilename;
+
+	MappedHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (MappedHandle)
+	{
+		MappedRegion.Reset(MappedHandle->MapRegion());
+	}
+	if (MappedRegion)
+	{
+		Data = TArrayView64<const uint8>(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize());
+	}
+	else
+	{
+		MappedHandle.Reset();
+		UE_LOG(LogOculusXRRetargeting, Log, TEXT("Cannot memory map movement recording %s, loading it instead."), *Filename);
+		if (!FFileHelper::LoadFileToArray(FallbackData, *Filename))
+		{
+			UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Cannot open movement recording %s."), *Filename);
+			return false;
+		}
+		Data = FallbackData;
+	}
+
+	FMemoryReaderView reader(Data);
+	uint32 magic = 0;
+	uint32 version = 0;
+	reader << magic;
+	reader << version;
+	if (magic != FOculusXRMovementRecording::kMagic || version == 0 || version > FOculusXRMovementRecording::kCurrentVersion)
+	{
+		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Unsupported movement recording %s (magic 0x%08x, version %u)."), *Filename, magic, version);
+		return false;
+	}
+
+	reader << WorldToMeters;
+	SerializeFlag(reader, bHasBodySkeleton);
+	if (bHasBodySkeleton)
+	{
+		FOculusXRMovementRecording::SerializeBodySkeleton(reader, BodySkeleton);
+		if (reader.IsError())
+		{
+			UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Movement recording %s has a corrupted body skeleton."), *Filename);
+			return false;
+		}
+	}
+
+	if (version < 2)
+	{
+		return BuildIndex(reader);
+	}
+
+	FOculusXRMovementRecording::FIndexFooter footer;
+	if (Data.Num() >= FOculusXRMovementRecording::kIndexFooterSize)
+	{
+		reader.Seek(Data.Num() - FOculusXRMovementRecording::kIndexFooterSize);
+		FOculusXRMovementRecording::SerializeIndexFooter(reader, footer);
+	}
+	const int64 numEntries = static_cast<int64>(footer.NumBodyFrames) + footer.NumFaceFrames + footer.NumEyeFrames;
+	const int64 indexEnd = footer.IndexOffset + numEntries * static_cast<int64>(sizeof(FFrameIndexEntry));
+	if (reader.IsError() || footer.Magic != FOculusXRMovementRecording::kIndexMagic || footer.NumBodyFrames < 0 || footer.NumFaceFrames < 0
+		|| footer.NumEyeFrames < 0 || footer.IndexOffset < 0 || !IsAligned(footer.IndexOffset, alignof(FFrameIndexEntry))
+		|| indexEnd > Data.Num() - FOculusXRMovementRecording::kIndexFooterSize)
+	{
+		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Movement recording %s has a corrupted frame index."), *Filename);
+		return false;
+	}
+
+	// The index is read in place, it was written little endian like every platform we run on
+	const FFrameIndexEntry* entries = reinterpret_cast<const FFrameIndexEntry*>(Data.GetData() + footer.IndexOffset);
+	BodyIndex = MakeArrayView(entries, footer.NumBodyFrames);
+	FaceIndex = MakeArrayView(entries + footer.NumBodyFrames, footer.NumFaceFrames);
+	EyeIndex = MakeArrayView(entries + footer.NumBodyFrames + footer.NumFaceFrames, footer.NumEyeFrames);
+	return true;
+}
+
+bool FOculusXRMappedMovementRecording::BuildIndex(FArchive& Ar)
+{
+	int32 numFrames[3] = {};
+	FOculusXRBodyState bodyState;
+	FOculusXRFaceState faceState;
+	FOculusXREyeGazesState eyeGazesState;
+	for (int32 stream = 0; stream < UE_ARRAY_COUNT(numFrames) && !Ar.IsError(); ++stream)
+	{
+		Ar << numFrames[stream];
+		if (!CheckFrameCount(Ar, numFrames[stream]))
+		{
+			return false;
+		}
+		for (int32 i = 0; i < numFrames[stream] && !Ar.IsError(); ++i)
+		{
+			FFrameIndexEntry& entry = OwnedIndex.AddDefaulted_GetRef();
+			entry.Offset = Ar.Tell();
+			Ar << entry.Timestamp;
+			switch (stream)
+			{
+				case 0:
+					FOculusXRMovementRecording::SerializeBodyState(Ar, bodyState);
+					break;
+				case 1:
+					FOculusXRMovementRecording::SerializeFaceState(Ar, faceState);
+					break;
+				default:
+					FOculusXRMovementRecording::SerializeEyeGazesState(Ar, eyeGazesState);
+					break;
+			}
+		}
+	}
+
+	if (Ar.IsError())
+	{
+		UE_LOG(LogOculusXRRetargeting, Warning, TEXT("Movement recording %s is truncated."), *Filename);
+		return false;
+	}
+
+	BodyIndex = MakeArrayView(OwnedIndex.GetData(), numFrames[0]);
+	FaceIndex = MakeArrayView(OwnedIndex.GetData() + numFrames[0], numFrames[1]);
+	EyeIndex = MakeArrayView(OwnedIndex.GetData() + numFrames[0] + numFrames[1], numFrames[2]);
+	return true;
+}
+
+double FOculusXRMappedMovementRecording::GetDuration() const
+{
+	double duration = 0.0;
+	duration = BodyIndex.IsEmpty() ? duration : FMath::Max(duration, BodyIndex.Last().Timestamp);
+	duration = FaceIndex.IsEmpty() ? duration : FMath::Max(duration, FaceIndex.Last().Timestamp);
+	duration = EyeIndex.IsEmpty() ? duration : FMath::Max(duration, EyeIndex.Last().Timestamp);
+	return duration;
+}
+
+int32 FOculusXRMappedMovementRecording::FindBodyFrame(const double Time) const
+{
+	return FindFrameIndex(BodyIndex, Time);
+}
+
+int32 FOculusXRMappedMovementRecording::FindFaceFrame(const double Time) const
+{
+	return FindFrameIndex(FaceIndex, Time);
+}
+
+int32 FOculusXRMappedMovementRecording::FindEyeFrame(const double Time) const
+{
+	return FindFrameIndex(EyeIndex, Time);
+}
+
+TArrayView64<const uint8> FOculusXRMappedMovementRecording::GetFrameData(const TArrayView<const FFrameIndexEntry>& Index, const int32 FrameIndex) const
+{
+	if (!Index.IsValidIndex(FrameIndex) || Index[FrameIndex].Offset < 0 || Index[FrameIndex].Offset >= Data.Num())
+	{
+		return {};
+	}
+	// Frames are not size prefixed, decoding stops where the frame ends
+	return Data.RightChop(Index[FrameIndex].Offset);
+}
+
+bool FOculusXRMappedMovementRecording::DecodeBodyFrame(const int32 FrameIndex, FOculusXRBodyState& outBodyState) const
+{
+	const TArrayView64<const uint8> frameData = GetFrameData(BodyIndex, FrameIndex);
+	if (frameData.IsEmpty())
+	{
+		return false;
+	}
+
+	FMemoryReaderView reader(frameData);
+	double timestamp = 0.0;
+	reader << timestamp;
+	FOculusXRMovementRecording::SerializeBodyState(reader, outBodyState);
+	return !reader.IsError();
+}
+
+bool FOculusXRMappedMovementRecording::DecodeFaceFrame(const int32 FrameIndex, FOculusXRFaceState& outFaceState) const
+{
+	const TArrayView64<const uint8> frameData = GetFrameData(FaceIndex, FrameIndex);
+	if (frameData.IsEmpty())
+	{
+		return false;
+	}
+
+	FMemoryReaderView reader(frameData);
+	double timestamp = 0.0;
+	reader << timestamp;
+	FOculusXRMovementRecording::SerializeFaceState(reader, outFaceState);
+	return !reader.IsError();
+}
+
+bool FOculusXRMappedMovementRecording::DecodeEyeFrame(const int32 FrameIndex, FOculusXREyeGazesState& outEyeGazesState) const
+{
+	const TArrayView64<const uint8> frameData = GetFrameData(EyeIndex, FrameIndex);
+	if (frameData.IsEmpty())
+	{
+		return false;
+	}
+
+	FMemoryReaderView reader(frameData);
+	double timestamp = 0.0;
+	reader << timestamp;
+	FOculusXRMovementRecording::SerializeEyeGazesState(reader, outEyeGazesState);
+	return !reader.IsError();
+}
+
+FOculusXRMappedPlaybackMovementDataProvider::FOculusXRMappedPlaybackMovementDataProvider(const TSharedRef<const FOculusXRMappedMovementRecording>& InRecording, const bool bInLoop)
+	: Recording(InRecording)
+	, bLoop(bInLoop)
+{
+}
+
+void FOculusXRMappedPlaybackMovementDataProvider::SetPlaybackTime(const double Time)
+{
+	const double duration = Recording->GetDuration();
+	double playbackTime = FMath::Max(Time, 0.0);
+	if (bLoop && duration > 0.0)
+	{
+		playbackTime = FMath::Fmod(playbackTime, duration);
+	}
+	PlaybackTime.store(playbackTime, std::memory_order_relaxed);
+}
+
+void FOculusXRMappedPlaybackMovementDataProvider::Advance(const double DeltaSeconds)
+{
+	SetPlaybackTime(GetPlaybackTime() + DeltaSeconds);
+}
+
+bool FOculusXRMappedPlaybackMovementDataProvider::IsAvailable() const
+{
+	return !Recording->IsEmpty();
+}
+
+bool FOculusXRMappedPlaybackMovementDataProvider::GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters)
+{
+	const int32 frameIndex = GetPlaybackFrameIndex(Recording->FindBodyFrame(GetPlaybackTime()), Recording->GetNumBodyFrames());
+	if (!Recording->DecodeBodyFrame(frameIndex, outBodyState))
+	{
+		return false;
+	}
+	RescalePositions(outBodyState, Recording->GetWorldToMeters(), WorldToMeters);
+	return true;
+}
+
+bool FOculusXRMappedPlaybackMovementDataProvider::GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters)
+{
+	if (!Recording->HasBodySkeleton())
+	{
+		return false;
+	}
+	outBodySkeleton = Recording->GetBodySkeleton();
+	RescalePositions(outBodySkeleton, Recording->GetWorldToMeters(), WorldToMeters);
+	return true;
+}
+
+bool FOculusXRMappedPlaybackMovementDataProvider::GetFaceState(FOculusXRFaceState& outFaceState)
+{
+	const int32 frameIndex = GetPlaybackFrameIndex(Recording->FindFaceFrame(GetPlaybackTime()), Recording->GetNumFaceFrames());
+	return Recording->DecodeFaceFrame(frameIndex, outFaceState);
+}
+
+bool FOculusXRMappedPlaybackMovementDataProvider::GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters)
+{
+	const int32 frameIndex = GetPlaybackFrameIndex(Recording->FindEyeFrame(GetPlaybackTime()), Recording->GetNumEyeFrames());
+	if (!Recording->DecodeEyeFrame(frameIndex, outEyeGazesState))
+	{
+		return false;
+	}
+	RescalePositions(outEyeGazesState, Recording->GetWorldToMeters(), WorldToMeters);
+	return true;
+}
+
+FOculusXRRecordingMovementDataProvider::FOculusXRRecordingMovementDataProvider(const TSharedRef<IOculusXRMovementDataProvider>& InSource)
+	: Source(InSource)
+	, Recording(MakeShared<FOculusXRMovementRecording>())
+{
+}
+
+TSharedRef<FOculusXRMovementRecording> FOculusXRRecordingMovementDataProvider::TakeRecording()
+{
+	FScopeLock scopeLock(&RecordingLock);
+	TSharedRef<FOculusXRMovementRecording> TakenRecording = Recording;
+	Recording = MakeShared<FOculusXRMovementRecording>();
+	FirstStateTime.Reset();
+	LastBodyTime = LastFaceTime = LastEyeTime = -1.0f;
+	return TakenRecording;
+}
+
+double FOculusXRRecordingMovementDataProvider::GetTimestamp(const float StateTime)
+{
+	if (!FirstStateTime.IsSet())
+	{
+		FirstStateTime = StateTime;
+	}
+	return FMath::Max(static_cast<double>(StateTime) - FirstStateTime.GetValue(), 0.0);
+}
+
+bool FOculusXRRecordingMovementDataProvider::IsAvailable() const
+{
+	return Source->IsAvailable();
+}
+
+bool FOculusXRRecordingMovementDataProvider::GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters)
+{
+	if (!Source->GetBodyState(outBodyState, WorldToMeters))
+	{
+		return false;
+	}
+
+	FScopeLock scopeLock(&RecordingLock);
+	if (outBodyState.Time != LastBodyTime)
+	{
+		LastBodyTime = outBodyState.Time;
+		Recording->WorldToMeters = WorldToMeters;
+		Recording->BodyFrames.Add({ GetTimestamp(outBodyState.Time), outBodyState });
+	}
+	return true;
+}
+
+bool FOculusXRRecordingMovementDataProvider::GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters)
+{
+	if (!Source->GetBodySkeleton(outBodySkeleton, WorldToMeters))
+	{
+		return false;
+	}
+
+	FScopeLock scopeLock(&RecordingLock);
+	Recording->WorldToMeters = WorldToMeters;
+	Recording->BodySkeleton = outBodySkeleton;
+	Recording->bHasBodySkeleton = true;
+	return true;
+}
+
+bool FOculusXRRecordingMovementDataProvider::GetFaceState(FOculusXRFaceState& outFaceState)
+{
+	if (!Source->GetFaceState(outFaceState))
+	{
+		return false;
+	}
+
+	FScopeLock scopeLock(&RecordingLock);
+	if (outFaceState.Time != LastFaceTime)
+	{
+		LastFaceTime = outFaceState.Time;
+		Recording->FaceFrames.Add({ GetTimestamp(outFaceState.Time), outFaceState });
+	}
+	return true;
+}
+
+bool FOculusXRRecordingMovementDataProvider::GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters)
+{
+	if (!Source->GetEyeGazesState(outEyeGazesState, WorldToMeters))
+	{
+		return false;
+	}
+
+	FScopeLock scopeLock(&RecordingLock);
+	if (outEyeGazesState.Time != LastEyeTime)
+	{
+		LastEyeTime = outEyeGazesState.Time;
+		Recording->WorldToMeters = WorldToMeters;
+		Recording->EyeFrames.Add({ GetTimestamp(outEyeGazesState.Time), outEyeGazesState });
+	}
+	return true;
+}
@@ -0,0 +1,168 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRMovementSendScheduler.h"
+#include "OculusXRRetargetBudgetManager.h"
+
+FOculusXRMovementSendScheduler::FOculusXRMovementSendScheduler(const TSharedRef<const FOculusXRTieredBodyStateCodec>& InCodec, const FOculusXRMovementSendSchedulerSettings& InSettings)
+	: Codec(InCodec)
+	, Settings(InSettings)
+{
+	Settings.MinSendRate = FMath::Max(Settings.MinSendRate, 0.1f);
+	Settings.MaxSendRate = FMath::Max(Settings.MaxSendRate, Settings.MinSendRate);
+	Settings.RelevanceDistance = FMath::Max(Settings.RelevanceDistance, 1.0f);
+}
+
+float FOculusXRMovementSendScheduler::ComputeRelevance(const FOculusXRMovementSendRelevance& Relevance, const FOculusXRMovementSendSchedulerSettings& Settings)
+{
+	float relevance = 1.0f - FMath::Clamp(Relevance.Distance / FMath::Max(Settings.RelevanceDistance, 1.0f), 0.0f, 1.0f);
+	if (!Relevance.bIsInView)
+	{
+		relevance *= FMath::Clamp(Settings.OutOfViewScale, 0.0f, 1.0f);
+	}
+	if (Relevance.bIsSpeaking)
+	{
+		relevance += Settings.SpeakingBonus;
+	}
+	return FMath::Clamp(relevance, 0.0f, 1.0f);
+}
+
+int32 FOculusXRMovementSendScheduler::GetPacketBytes(const EOculusXRBodyFidelityTier Tier) const
+{
+	return static_cast<int32>((Codec->GetMaxEncodedBits(Tier) + 7) / 8) + Settings.PacketOverheadBytes;
+}
+
+double FOculusXRMovementSendScheduler::GetBytesPerSecond(const FAvatarSchedule& Avatar) const
+{
+	const FOculusXRMovementSendDecision& decision = Avatar.Decision;
+	if (decision.Tier == EOculusXRBodyFidelityTier::Frozen)
+	{
+		return 0.0;
+	}
+	// The face update rides in the same packet as the body
+	const int32 packetBytes = GetPacketBytes(decision.Tier) + (decision.bSendFace ? Avatar.FaceBytes : 0);
+	return packetBytes * static_cast<double>(decision.SendRate);
+}
+
+bool FOculusXRMovementSendScheduler::Demote(FAvatarSchedule& Avatar) const
+{
+	FOculusXRMovementSendDecision& decision = Avatar.Decision;
+	if (decision.Tier == EOculusXRBodyFidelityTier::Full)
+	{
+		decision.Tier = EOculusXRBodyFidelityTier::NoFingers;
+	}
+	else if (decision.Tier != EOculusXRBodyFidelityTier::Frozen && decision.SendRate > Settings.MinSendRate)
+	{
+		decision.SendRate = FMath::Max(decision.SendRate * 0.5f, Settings.MinSendRate);
+	}
+	else if (decision.bSendFace)
+	{
+		decision.bSendFace = false;
+	}
+	else if (decision.Tier == EOculusXRBodyFidelityTier::NoFingers)
+	{
+		decision.Tier = EOculusXRBodyFidelityTier::CoreOnly;
+	}
+	else if (decision.Tier == EOculusXRBodyFidelityTier::CoreOnly)
+	{
+		decision.Tier = EOculusXRBodyFidelityTier::Frozen;
+		decision.SendRate = 0.0f;
+	}
+	else
+	{
+		return false;
+	}
+	++decision.NumDemotions;
+	return true;
+}
+
+void FOculusXRMovementSendScheduler::Schedule(const TMap<uint32, FOculusXRMovementSendRelevance>& InAvatars)
+{
+	TMap<uint32, FAvatarSchedule> scheduled;
+	scheduled.Reserve(InAvatars.Num());
+	double totalBytesPerSecond = 0.0;
+	for (const auto& avatarPair : InAvatars)
+	{
+		FAvatarSchedule& avatar = scheduled.Add(avatarPair.Key);
+		if (const FAvatarSchedule* previous = Avatars.Find(avatarPair.Key))
+		{
+			avatar.NextSendTime = previous->NextSendTime;
+		}
+		avatar.FaceBytes = FMath::Max(avatarPair.Value.FaceBytes, 0);
+
+		FOculusXRMovementSendDecision& decision = avatar.Decision;
+		decision.Relevance = ComputeRelevance(avatarPair.Value, Settings);
+		decision.Tier = FOculusXRRetargetBudgetManager::GetTierForSignificance(decision.Relevance);
+		decision.SendRate = decision.Tier == EOculusXRBodyFidelityTier::Frozen ? 0.0f : FMath::Lerp(Settings.MinSendRate, Settings.MaxSendRate, decision.Relevance);
+		decision.bSendFace = avatar.FaceBytes > 0 && decision.Tier <= EOculusXRBodyFidelityTier::NoFingers;
+		totalBytesPerSecond += GetBytesPerSecond(avatar);
+	}
+
+	// Demote the least relevant avatar one step at a time, each demotion halves its priority so the cuts spread out
+	while (totalBytesPerSecond > Settings.BytesPerSecond)
+	{
+		FAvatarSchedule* demoted = nullptr;
+		float lowestPriority = TNumericLimits<float>::Max();
+		for (auto& avatarPair : scheduled)
+		{
+			const FOculusXRMovementSendDecision& decision = avatarPair.Value.Decision;
+			const float priority = decision.Relevance * FMath::Pow(0.5f, static_cast<float>(decision.NumDemotions));
+			if (decision.Tier != EOculusXRBodyFidelityTier::Frozen && priority < lowestPriority)
+			{
+				lowestPriority = priority;
+				demoted = &avatarPair.Value;
+			}
+		}
+		if (!demoted)
+		{
+			break;
+		}
+
+		totalBytesPerSecond -= GetBytesPerSecond(*demoted);
+		Demote(*demoted);
+		totalBytesPerSecond += GetBytesPerSecond(*demoted);
+	}
+
+	Avatars = MoveTemp(scheduled);
+	ScheduledBytesPerSecond = totalBytesPerSecond;
+}
+
+bool FOculusXRMovementSendScheduler::ShouldSend(const uint32 AvatarId, const double Time)
+{
+	FAvatarSchedule* avatar = Avatars.Find(AvatarId);
+	if (!avatar || avatar->Decision.Tier == EOculusXRBodyFidelityTier::Frozen || Time < avatar->NextSendTime)
+	{
+		return false;
+	}
+
+	// Keep the rate steady, but don't burst to catch up after a rate change or a stall
+	const double interval = 1.0 / avatar->Decision.SendRate;
+	avatar->NextSendTime += interval;
+	if (avatar->NextSendTime <= Time)
+	{
+		avatar->NextSendTime = Time + interval;
+	}
+	return true;
+}
+
+bool FOculusXRMovementSendScheduler::WriteBodyState(const uint32 AvatarId, const FOculusXRBodyState& BodyState, FBitWriter& Writer) const
+{
+	const FAvatarSchedule* avatar = Avatars.Find(AvatarId);
+	if (!avatar || avatar->Decision.Tier == EOculusXRBodyFidelityTier::Frozen)
+	{
+		return false;
+	}
+	Codec->Encode(avatar->Decision.Tier, BodyState, Writer);
+	return true;
+}
+
+const FOculusXRMovementSendDecision* FOculusXRMovementSendScheduler::FindDecision(const uint32 AvatarId) const
+{
+	const FAvatarSchedule* avatar = Avatars.Find(AvatarId);
+	return avatar ? &avatar->Decision : nullptr;
+}
@@ -0,0 +1,102 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXROneEuroFilter.h"
+
+namespace
+{
+	constexpr int32 kLanes = 4;
+	constexpr float kMinCutoff = 0.01f;
+
+	// Smoothing factor of a low pass filter with the given cutoff, TwoPiDeltaTime = 2 * pi * DeltaTime
+	float SmoothingFactor(const float TwoPiDeltaTime, const float Cutoff)
+	{
+		const float scaledCutoff = TwoPiDeltaTime * Cutoff;
+		return scaledCutoff / (scaledCutoff + 1.0f);
+	}
+
+	VectorRegister4Float VectorSmoothingFactor(const VectorRegister4Float& TwoPiDeltaTime, const VectorRegister4Float& Cutoff)
+	{
+		const VectorRegister4Float scaledCutoff = VectorMultiply(TwoPiDeltaTime, Cutoff);
+		return VectorDivide(scaledCutoff, VectorAdd(scaledCutoff, GlobalVectorConstants::FloatOne));
+	}
+} // namespace
+
+FOculusXROneEuroFilter::FOculusXROneEuroFilter(const int32 InNumChannels, const FOculusXROneEuroFilterSettings& InSettings)
+{
+	Reset(InNumChannels, InSettings);
+}
+
+void FOculusXROneEuroFilter::Reset(const int32 InNumChannels, const FOculusXROneEuroFilterSettings& InSettings)
+{
+	NumChannels = FMath::Max(InNumChannels, 0);
+	bHasState = false;
+	const int32 numPadded = Align(NumChannels, kLanes);
+	MinCutoffs.Init(FMath::Max(InSettings.MinCutoff, kMinCutoff), numPadded);
+	Betas.Init(FMath::Max(InSettings.Beta, 0.0f), numPadded);
+	DerivativeCutoffs.Init(FMath::Max(InSettings.DerivativeCutoff, kMinCutoff), numPadded);
+	Values.Init(0.0f, numPadded);
+	Derivatives.Init(0.0f, numPadded);
+}
+
+void FOculusXROneEuroFilter::Set(const int32 Channel, const FOculusXROneEuroFilterSettings& InSettings)
+{
+	check(Channel >= 0 && Channel < NumChannels);
+	MinCutoffs[Channel] = FMath::Max(InSettings.MinCutoff, kMinCutoff);
+	Betas[Channel] = FMath::Max(InSettings.Beta, 0.0f);
+	DerivativeCutoffs[Channel] = FMath::Max(InSettings.DerivativeCutoff, kMinCutoff);
+}
+
+void FOculusXROneEuroFilter::Apply(const float* InValues, float* OutValues, const float DeltaTime)
+{
+	if (!bHasState || DeltaTime <= 0.0f)
+	{
+		// Nothing to filter against yet, or no time went by since the previous values
+		if (!bHasState)
+		{
+			FMemory::Memcpy(Values.GetData(), InValues, NumChannels * sizeof(float));
+			FMemory::Memzero(Derivatives.GetData(), Derivatives.Num() * sizeof(float));
+			bHasState = true;
+		}
+		FMemory::Memmove(OutValues, Values.GetData(), NumChannels * sizeof(float));
+		return;
+	}
+
+	const float twoPiDeltaTime = UE_TWO_PI * DeltaTime;
+	const float rate = 1.0f / DeltaTime;
+	const VectorRegister4Float twoPiDeltaTimes = VectorSetFloat1(twoPiDeltaTime);
+	const VectorRegister4Float rates = VectorSetFloat1(rate);
+	const int32 numVectorized = NumChannels - NumChannels % kLanes;
+	for (int32 i = 0; i < numVectorized; i += kLanes)
+	{
+		const VectorRegister4Float previous = VectorLoadAligned(Values.GetData() + i);
+		const VectorRegister4Float delta = VectorSubtract(VectorLoad(InValues + i), previous);
+
+		// Speed, low pass filtered at the derivative cutoff
+		const VectorRegister4Float previousDerivative = VectorLoadAligned(Derivatives.GetData() + i);
+		const VectorRegister4Float derivativeFactor = VectorSmoothingFactor(twoPiDeltaTimes, VectorLoadAligned(DerivativeCutoffs.GetData() + i));
+		const VectorRegister4Float derivative = VectorMultiplyAdd(derivativeFactor, VectorSubtract(VectorMultiply(delta, rates), previousDerivative), previousDerivative);
+
+		// Value, low pass filtered at a cutoff rising with the speed
+		const VectorRegister4Float cutoff = VectorMultiplyAdd(VectorLoadAligned(Betas.GetData() + i), VectorAbs(derivative), VectorLoadAligned(MinCutoffs.GetData() + i));
+		const VectorRegister4Float value = VectorMultiplyAdd(VectorSmoothingFactor(twoPiDeltaTimes, cutoff), delta, previous);
+
+		VectorStoreAligned(derivative, Derivatives.GetData() + i);
+		VectorStoreAligned(value, Values.GetData() + i);
+		VectorStore(value, OutValues + i);
+	}
+
+	for (int32 i = numVectorized; i < NumChannels; ++i)
+	{
+		const float delta = InValues[i] - Values[i];
+		Derivatives[i] += SmoothingFactor(twoPiDeltaTime, DerivativeCutoffs[i]) * (delta * rate - Derivatives[i]);
+		const float cutoff = MinCutoffs[i] + Betas[i] * FMath::Abs(Derivatives[i]);
+		Values[i] += SmoothingFactor(twoPiDeltaTime, cutoff) * delta;
+		OutValues[i] = Values[i];
+	}
+}
@@ -0,0 +1,248 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRRetargetBudgetManager.h"
+#include "OculusXRRetargeting.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Body Avatars - Full"), STAT_OculusXRBodyTierFull, STATGROUP_OculusXRMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Body Avatars - No Fingers"), STAT_OculusXRBodyTierNoFingers, STATGROUP_OculusXRMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Body Avatars - Core Only"), STAT_OculusXRBodyTierCoreOnly, STATGROUP_OculusXRMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Body Avatars - Frozen"), STAT_OculusXRBodyTierFrozen, STATGROUP_OculusXRMovement);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Body Retarget Estimated Cost (ms)"), STAT_OculusXRBodyRetargetEstimatedCost, STATGROUP_OculusXRMovement);
+
+static TAutoConsoleVariable<float> CVarRetargetBudgetMs(
+	TEXT("oculusxr.Movement.RetargetBudgetMs"),
+	2.0f,
+	TEXT("Time budget in milliseconds for body retargeting across all avatars that use the retarget budget. 0 disables cost based demotion."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSignificanceDistance(
+	TEXT("oculusxr.Movement.SignificanceDistance"),
+	3000.0f,
+	TEXT("Distance in world units from the closest player camera at which an avatar reaches zero significance."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarHiddenSignificanceScale(
+	TEXT("oculusxr.Movement.HiddenSignificanceScale"),
+	0.25f,
+	TEXT("Significance multiplier applied to avatars that were not rendered recently."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarMaxEvaluationRateDivisor(
+	TEXT("oculusxr.Movement.MaxEvaluationRateDivisor"),
+	4,
+	TEXT("Largest evaluation rate divisor assigned to the least significant avatars that use the retarget budget. 1 retargets every avatar every frame."),
+	ECVF_Default);
+
+namespace
+{
+	// Used until the first cost of a tier is reported
+	const double kDefaultTierCostSeconds[] = { 100.0e-6, 70.0e-6, 40.0e-6, 5.0e-6 };
+	// Weight of a new sample in the running cost average
+	const double kCostSmoothing = 0.05;
+	const float kRecentlyRenderedTolerance = 0.2f;
+} // namespace
+
+FOculusXRRetargetBudgetManager& FOculusXRRetargetBudgetManager::Get()
+{
+	static FOculusXRRetargetBudgetManager Instance;
+	return Instance;
+}
+
+FOculusXRRetargetBudgetManager::FOculusXRRetargetBudgetManager()
+{
+	static_assert(UE_ARRAY_COUNT(kDefaultTierCostSeconds) == kNumTiers, "Every tier needs a default cost");
+	for (int32 i = 0; i < kNumTiers; ++i)
+	{
+		EstimatedCost[i] = kDefaultTierCostSeconds[i];
+	}
+}
+
+uint32 FOculusXRRetargetBudgetManager::AllocateAvatarId()
+{
+	static FThreadSafeCounter NextAvatarId;
+	return static_cast<uint32>(NextAvatarId.Increment());
+}
+
+float FOculusXRRetargetBudgetManager::ComputeSignificance(const USceneComponent* Component, bool& bOutIsLocallyControlled)
+{
+	check(IsInGameThread());
+	bOutIsLocallyControlled = false;
+	if (!Component)
+	{
+		return 1.0f;
+	}
+
+	const APawn* Pawn = Cast<APawn>(Component->GetOwner());
+	if (Pawn && Pawn->IsLocallyControlled())
+	{
+		bOutIsLocallyControlled = true;
+		return 1.0f;
+	}
+
+	float distanceSquared = TNumericLimits<float>::Max();
+	if (const UWorld* World = Component->GetWorld())
+	{
+		const FVector componentLocation = Component->GetComponentLocation();
+		for (FConstPlayerControllerIterator it = World->GetPlayerControllerIterator(); it; ++it)
+		{
+			const APlayerController* PlayerController = it->Get();
+			if (PlayerController && PlayerController->IsLocalController() && PlayerController->PlayerCameraManager)
+			{
+				distanceSquared = FMath::Min(distanceSquared, static_cast<float>(FVector::DistSquared(componentLocation, PlayerController->PlayerCameraManager->GetCameraLocation())));
+			}
+		}
+	}
+
+	// Without a local viewer there is nothing to compare against
+	if (distanceSquared == TNumericLimits<float>::Max())
+	{
+		return 1.0f;
+	}
+
+	const float maxDistance = FMath::Max(CVarSignificanceDistance.GetValueOnGameThread(), 1.0f);
+	float significance = 1.0f - FMath::Clamp(FMath::Sqrt(distanceSquared) / maxDistance, 0.0f, 1.0f);
+
+	const UPrimitiveComponent* PrimitiveComponent = Cast<UPrimitiveComponent>(Component);
+	if (PrimitiveComponent && !PrimitiveComponent->WasRecentlyRendered(kRecentlyRenderedTolerance))
+	{
+		significance *= FMath::Clamp(CVarHiddenSignificanceScale.GetValueOnGameThread(), 0.0f, 1.0f);
+	}
+	return significance;
+}
+
+EOculusXRBodyFidelityTier FOculusXRRetargetBudgetManager::GetTierForSignificance(const float Significance)
+{
+	if (Significance >= 0.5f)
+	{
+		return EOculusXRBodyFidelityTier::Full;
+	}
+	if (Significance >= 0.25f)
+	{
+		return EOculusXRBodyFidelityTier::NoFingers;
+	}
+	if (Significance >= 0.05f)
+	{
+		return EOculusXRBodyFidelityTier::CoreOnly;
+	}
+	return EOculusXRBodyFidelityTier::Frozen;
+}
+
+int32 FOculusXRRetargetBudgetManager::GetEvaluationRateDivisorForSignificance(const float Significance)
+{
+	const int32 maxDivisor = FMath::Max(CVarMaxEvaluationRateDivisor.GetValueOnAnyThread(), 1);
+	return 1 + FMath::FloorToInt((1.0f - FMath::Clamp(Significance, 0.0f, 1.0f)) * (maxDivisor - 1) + 0.5f);
+}
+
+EOculusXRBodyFidelityTier FOculusXRRetargetBudgetManager::RequestTier(const uint32 AvatarId, const float Significance, const bool bIsLocallyControlled, const EOculusXRBodyFidelityTier HighestTier)
+{
+	FScopeLock scopeLock(&Lock);
+
+	if (LastResolvedFrame != GFrameCounter)
+	{
+		ResolveTiers();
+		LastResolvedFrame = GFrameCounter;
+	}
+
+	FAvatarRequest* Request = Avatars.Find(AvatarId);
+	if (!Request)
+	{
+		// New avatars don't have a budget assignment yet, start them at the tier their significance allows
+		Request = &Avatars.Add(AvatarId);
+		Request->AssignedTier = bIsLocallyControlled ? HighestTier : FMath::Max(HighestTier, GetTierForSignificance(Significance));
+	}
+
+	Request->Significance = Significance;
+	Request->bIsLocallyControlled = bIsLocallyControlled;
+	Request->HighestTier = HighestTier;
+	Request->LastRequestFrame = GFrameCounter;
+
+	// A lower highest tier set on the node since the last resolve applies immediately
+	return FMath::Max(Request->AssignedTier, HighestTier);
+}
+
+void FOculusXRRetargetBudgetManager::ReportCost(const EOculusXRBodyFidelityTier Tier, const double Seconds)
+{
+	FScopeLock scopeLock(&Lock);
+	double& cost = EstimatedCost[static_cast<int32>(Tier)];
+	cost = FMath::Lerp(cost, Seconds, kCostSmoothing);
+}
+
+double FOculusXRRetargetBudgetManager::GetEstimatedCost(const EOculusXRBodyFidelityTier Tier) const
+{
+	FScopeLock scopeLock(&Lock);
+	return EstimatedCost[static_cast<int32>(Tier)];
+}
+
+void FOculusXRRetargetBudgetManager::ResolveTiers()
+{
+	TArray<FAvatarRequest*> sortedRequests;
+	sortedRequests.Reserve(Avatars.Num());
+	for (auto it = Avatars.CreateIterator(); it; ++it)
+	{
+		if (it.Value().LastRequestFrame + kStaleFrameCount < GFrameCounter)
+		{
+			it.RemoveCurrent();
+			continue;
+		}
+		sortedRequests.Add(&it.Value());
+	}
+
+	// Most significant first, locally controlled avatars ahead of everything else
+	sortedRequests.Sort([](const FAvatarRequest& A, const FAvatarRequest& B) {
+		if (A.bIsLocallyControlled != B.bIsLocallyControlled)
+		{
+			return A.bIsLocallyControlled;
+		}
+		return A.Significance > B.Significance;
+	});
+
+	double totalCost = 0.0;
+	for (FAvatarRequest* Request : sortedRequests)
+	{
+		Request->AssignedTier = Request->bIsLocallyControlled ? Request->HighestTier : FMath::Max(Request->HighestTier, GetTierForSignificance(Request->Significance));
+		totalCost += EstimatedCost[static_cast<int32>(Request->AssignedTier)];
+	}
+
+	// Demote the least significant avatars one tier at a time until the frame fits
+	const double budget = CVarRetargetBudgetMs.GetValueOnGameThread() / 1000.0;
+	if (budget > 0.0)
+	{
+		for (int32 i = sortedRequests.Num() - 1; i >= 0 && totalCost > budget; --i)
+		{
+			FAvatarRequest* Request = sortedRequests[i];
+			if (Request->bIsLocallyControlled)
+			{
+				break;
+			}
+			while (Request->AssignedTier != EOculusXRBodyFidelityTier::Frozen && totalCost > budget)
+			{
+				const EOculusXRBodyFidelityTier demotedTier = static_cast<EOculusXRBodyFidelityTier>(static_cast<int32>(Request->AssignedTier) + 1);
+				totalCost += EstimatedCost[static_cast<int32>(demotedTier)] - EstimatedCost[static_cast<int32>(Request->AssignedTier)];
+				Request->AssignedTier = demotedTier;
+			}
+		}
+	}
+
+	int32 tierCounts[kNumTiers] = {};
+	for (const FAvatarRequest* Request : sortedRequests)
+	{
+		++tierCounts[static_cast<int32>(Request->AssignedTier)];
+	}
+	SET_DWORD_STAT(STAT_OculusXRBodyTierFull, tierCounts[static_cast<int32>(EOculusXRBodyFidelityTier::Full)]);
+	SET_DWORD_STAT(STAT_OculusXRBodyTierNoFingers, tierCounts[static_cast<int32>(EOculusXRBodyFidelityTier::NoFingers)]);
+	SET_DWORD_STAT(STAT_OculusXRBodyTierCoreOnly, tierCounts[static_cast<int32>(EOculusXRBodyFidelityTier::CoreOnly)]);
+	SET_DWORD_STAT(STAT_OculusXRBodyTierFrozen, tierCounts[static_cast<int32>(EOculusXRBodyFidelityTier::Frozen)]);
+	SET_FLOAT_STAT(STAT_OculusXRBodyRetargetEstimatedCost, totalCost * 1000.0);
+}
@@ -20,3 +20,184 @@ bool FOculusXRRetargetingUtils::GetUnitScaleFactorFromSettings(UWorld* World, fl
 	}
 	return false;
 }
+
+namespace
+{
+	// Cyclic Jacobi eigen decomposition of a symmetric matrix, eigenvectors end up in the columns of OutVectors
+	void SymmetricEigen(TArray<double>& Matrix, const int32 Size, TArray<double>& OutValues, TArray<double>& OutVectors)
+	{
+		OutVectors.SetNumZeroed(Size * Size);
+		for (int32 i = 0; i < Size; ++i)
+		{
+			OutVectors[i * Size + i] = 1.0;
+		}
+
+		auto at = [Size](TArray<double>& M, const int32 Row, const int32 Col) -> double& { return M[Row * Size + Col]; };
+		for (int32 sweep = 0; sweep < 64; ++sweep)
+		{
+			double offDiagonal = 0.0;
+			for (int32 p = 0; p < Size; ++p)
+			{
+				for (int32 q = p + 1; q < Size; ++q)
+				{
+					offDiagonal += FMath::Square(at(Matrix, p, q));
+				}
+			}
+			if (offDiagonal < 1.e-20)
+			{
+				break;
+			}
+
+			for (int32 p = 0; p < Size; ++p)
+			{
+				for (int32 q = p + 1; q < Size; ++q)
+				{
+					const double apq = at(Matrix, p, q);
+					if (FMath::Abs(apq) < 1.e-30)
+					{
+						continue;
+					}
+					const double theta = (at(Matrix, q, q) - at(Matrix, p, p)) / (2.0 * apq);
+					const double t = (theta >= 0.0 ? 1.0 : -1.0) / (FMath::Abs(theta) + FMath::Sqrt(theta * theta + 1.0));
+					const double c = 1.0 / FMath::Sqrt(t * t + 1.0);
+					const double s = t * c;
+					for (int32 k = 0; k < Size; ++k)
+					{
+						const double akp = at(Matrix, k, p);
+						const double akq = at(Matrix, k, q);
+						at(Matrix, k, p) = c * akp - s * akq;
+						at(Matrix, k, q) = s * akp + c * akq;
+					}
+					for (int32 k = 0; k < Size; ++k)
+					{
+						const double apk = at(Matrix, p, k);
+						const double aqk = at(Matrix, q, k);
+						at(Matrix, p, k) = c * apk - s * aqk;
+						at(Matrix, q, k) = s * apk + c * aqk;
+					}
+					for (int32 k = 0; k < Size; ++k)
+					{
+						const double vkp = at(OutVectors, k, p);
+						const double vkq = at(OutVectors, k, q);
+						at(OutVectors, k, p) = c * vkp - s * vkq;
+						at(OutVectors, k, q) = s * vkp + c * vkq;
+					}
+				}
+			}
+		}
+
+		OutValues.SetNumUninitialized(Size);
+		for (int32 i = 0; i < Size; ++i)
+		{
+			OutValues[i] = at(Matrix, i, i);
+		}
+	}
+} // namespace
+
+bool FOculusXRRetargetingUtils::FitPrincipalComponents(TConstArrayView<float> Samples, const int32 NumFeatures, const int32 MaxComponents, const float MinExplainedVariance,
+	TArray<float>& OutMean, TArray<float>& OutComponents, TArray<float>& OutVariances, float& OutExplainedVariance)
+{
+	const int32 numSamples = NumFeatures > 0 ? Samples.Num() / NumFeatures : 0;
+	if (numSamples < 2)
+	{
+		return false;
+	}
+
+	TArray<double> mean;
+	mean.SetNumZeroed(NumFeatures);
+	for (int32 s = 0; s < numSamples; ++s)
+	{
+		for (int32 f = 0; f < NumFeatures; ++f)
+		{
+			mean[f] += Samples[s * NumFeatures + f];
+		}
+	}
+	for (double& value : mean)
+	{
+		value /= numSamples;
+	}
+
+	TArray<double> covariance;
+	covariance.SetNumZeroed(NumFeatures * NumFeatures);
+	TArray<double> centered;
+	centered.SetNumUninitialized(NumFeatures);
+	for (int32 s = 0; s < numSamples; ++s)
+	{
+		for (int32 f = 0; f < NumFeatures; ++f)
+		{
+			centered[f] = Samples[s * NumFeatures + f] - mean[f];
+		}
+		for (int32 row = 0; row < NumFeatures; ++row)
+		{
+			for (int32 col = row; col < NumFeatures; ++col)
+			{
+				covariance[row * NumFeatures + col] += centered[row] * centered[col];
+			}
+		}
+	}
+	for (int32 row = 0; row < NumFeatures; ++row)
+	{
+		for (int32 col = row; col < NumFeatures; ++col)
+		{
+			const double value = covariance[row * NumFeatures + col] / (numSamples - 1);
+			covariance[row * NumFeatures + col] = value;
+			covariance[col * NumFeatures + row] = value;
+		}
+	}
+
+	TArray<double> eigenValues, eigenVectors;
+	SymmetricEigen(covariance, NumFeatures, eigenValues, eigenVectors);
+
+	TArray<int32> order;
+	order.SetNumUninitialized(NumFeatures);
+	double totalVariance = 0.0;
+	for (int32 i = 0; i < NumFeatures; ++i)
+	{
+		order[i] = i;
+		totalVariance += FMath::Max(eigenValues[i], 0.0);
+	}
+	order.Sort([&eigenValues](const int32 A, const int32 B) { return eigenValues[A] > eigenValues[B]; });
+
+	OutMean.SetNumUninitialized(NumFeatures);
+	for (int32 f = 0; f < NumFeatures; ++f)
+	{
+		OutMean[f] = static_cast<float>(mean[f]);
+	}
+
+	OutComponents.Reset();
+	OutVariances.Reset();
+	double explainedVariance = 0.0;
+	const int32 maxComponents = FMath::Clamp(MaxComponents, 1, NumFeatures);
+	for (int32 k = 0; k < maxComponents; ++k)
+	{
+		const int32 component = order[k];
+		for (int32 f = 0; f < NumFeatures; ++f)
+		{
+			OutComponents.Add(static_cast<float>(eigenVectors[f * NumFeatures + component]));
+		}
+		const double variance = FMath::Max(eigenValues[component], 0.0);
+		OutVariances.Add(static_cast<float>(variance));
+		explainedVariance += variance;
+		if (totalVariance <= 0.0 || explainedVariance >= MinExplainedVariance * totalVariance)
+		{
+			break;
+		}
+	}
+	OutExplainedVariance = totalVariance > 0.0 ? static_cast<float>(explainedVariance / totalVariance) : 1.0f;
+	return true;
+}
+
+int32 FOculusXRRetargetingUtils::UpdateChangedValues(TConstArrayView<float> Values, TArrayView<float> InOutEmittedValues, const float Threshold)
+{
+	check(Values.Num() == InOutEmittedValues.Num());
+	int32 NumChanged = 0;
+	for (int32 i = 0; i < Values.Num(); ++i)
+	{
+		if (FMath::Abs(Values[i] - InOutEmittedValues[i]) > Threshold)
+		{
+			InOutEmittedValues[i] = Values[i];
+			++NumChanged;
+		}
+	}
+	return NumChanged;
+}
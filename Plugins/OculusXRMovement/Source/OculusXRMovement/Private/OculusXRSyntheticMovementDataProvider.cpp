@@ -0,0 +1,379 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRSyntheticMovementDataProvider.h"
+#include "Math/RandomStream.h"
+#include "Algo/StableSort.h"
+
+namespace
+{
+	constexpr int32 kNumBones = static_cast<int32>(EOculusXRBoneID::COUNT);
+	constexpr int32 kNumExpressions = static_cast<int32>(EOculusXRFaceExpression::COUNT);
+
+	// Seconds between blinks, the blink itself lasts kBlinkDuration
+	constexpr double kBlinkInterval = 3.7;
+	constexpr double kBlinkDuration = 0.15;
+
+	float Cycle(const double Time, const float Frequency, const float Phase)
+	{
+		return FMath::Sin(static_cast<float>(UE_TWO_PI * Frequency * Time) + Phase);
+	}
+
+	// 0 -> 1 -> 0 over a cycle
+	float Pulse(const double Time, const float Frequency, const float Phase)
+	{
+		return 0.5f - 0.5f * FMath::Cos(static_cast<float>(UE_TWO_PI * Frequency * Time) + Phase);
+	}
+
+	FQuat MakeRotation(const float RollDegrees, const float PitchDegrees, const float YawDegrees)
+	{
+		return FQuat(FRotator(PitchDegrees, YawDegrees, RollDegrees));
+	}
+
+	bool IsLeftSideJoint(const EOculusXRBoneID BoneId)
+	{
+		return (BoneId >= EOculusXRBoneID::BodyLeftShoulder && BoneId <= EOculusXRBoneID::BodyLeftHandWristTwist)
+			|| (BoneId >= EOculusXRBoneID::BodyLeftHandPalm && BoneId <= EOculusXRBoneID::BodyLeftHandLittleTip)
+			|| (BoneId >= EOculusXRBoneID::BodyLeftUpperLeg && BoneId <= EOculusXRBoneID::BodyLeftFootBall);
+	}
+} // namespace
+
+FOculusXRSyntheticMovementDataProvider::FOculusXRSyntheticMovementDataProvider(const FOculusXRSyntheticMovementSettings& InSettings)
+	: Settings(InSettings)
+{
+	FRandomStream random(Settings.Seed);
+	HeightScale = random.FRandRange(0.9f, 1.1f);
+	RateScale = random.FRandRange(0.85f, 1.15f);
+	WalkPhase = random.FRandRange(0.0f, UE_TWO_PI);
+	ReachPhase = random.FRandRange(0.0f, UE_TWO_PI);
+	FingerPhase = random.FRandRange(0.0f, UE_TWO_PI);
+
+	ExpressionPhases.SetNumUninitialized(kNumExpressions);
+	ExpressionAmplitudes.SetNumUninitialized(kNumExpressions);
+	for (int32 i = 0; i < kNumExpressions; ++i)
+	{
+		ExpressionPhases[i] = random.FRandRange(0.0f, UE_TWO_PI);
+		// Most expressions stay subtle, a few are fully driven
+		ExpressionAmplitudes[i] = FMath::Square(random.FRand());
+	}
+
+	BuildRestSkeleton();
+}
+
+void FOculusXRSyntheticMovementDataProvider::BuildRestSkeleton()
+{
+	RestJoints.SetNum(kNumBones);
+	auto addJoint = [this](EOculusXRBoneID boneId, EOculusXRBoneID parentBoneId, const FVector& position) {
+		RestJoints[static_cast<int32>(boneId)] = { boneId, parentBoneId, position };
+	};
+
+	// T-Pose, X forward, Y right, Z up.  Left side joints are mirrored from the right side below.
+	addJoint(EOculusXRBoneID::BodyRoot, EOculusXRBoneID::None, FVector(0.0, 0.0, 0.0));
+	addJoint(EOculusXRBoneID::BodyHips, EOculusXRBoneID::BodyRoot, FVector(0.0, 0.0, 0.95));
+	addJoint(EOculusXRBoneID::BodySpineLower, EOculusXRBoneID::BodyHips, FVector(-0.01, 0.0, 1.02));
+	addJoint(EOculusXRBoneID::BodySpineMiddle, EOculusXRBoneID::BodySpineLower, FVector(-0.02, 0.0, 1.12));
+	addJoint(EOculusXRBoneID::BodySpineUpper, EOculusXRBoneID::BodySpineMiddle, FVector(-0.02, 0.0, 1.22));
+	addJoint(EOculusXRBoneID::BodyChest, EOculusXRBoneID::BodySpineUpper, FVector(-0.01, 0.0, 1.32));
+	addJoint(EOculusXRBoneID::BodyNeck, EOculusXRBoneID::BodyChest, FVector(0.0, 0.0, 1.5));
+	addJoint(EOculusXRBoneID::BodyHead, EOculusXRBoneID::BodyNeck, FVector(0.02, 0.0, 1.6));
+
+	addJoint(EOculusXRBoneID::BodyRightShoulder, EOculusXRBoneID::BodyChest, FVector(0.0, 0.03, 1.45));
+	addJoint(EOculusXRBoneID::BodyRightScapula, EOculusXRBoneID::BodyRightShoulder, FVector(-0.04, 0.1, 1.42));
+	addJoint(EOculusXRBoneID::BodyRightArmUpper, EOculusXRBoneID::BodyRightScapula, FVector(0.0, 0.18, 1.42));
+	addJoint(EOculusXRBoneID::BodyRightArmLower, EOculusXRBoneID::BodyRightArmUpper, FVector(0.0, 0.46, 1.42));
+	addJoint(EOculusXRBoneID::BodyRightHandWristTwist, EOculusXRBoneID::BodyRightArmLower, FVector(0.0, 0.6, 1.42));
+	addJoint(EOculusXRBoneID::BodyRightHandWrist, EOculusXRBoneID::BodyRightArmLower, FVector(0.0, 0.72, 1.42));
+	addJoint(EOculusXRBoneID::BodyRightHandPalm, EOculusXRBoneID::BodyRightHandWrist, FVector(0.0, 0.78, 1.42));
+
+	addJoint(EOculusXRBoneID::BodyRightHandThumbMetacarpal, EOculusXRBoneID::BodyRightHandWrist, FVector(0.02, 0.74, 1.41));
+	addJoint(EOculusXRBoneID::BodyRightHandThumbProximal, EOculusXRBoneID::BodyRightHandThumbMetacarpal, FVector(0.04, 0.77, 1.4));
+	addJoint(EOculusXRBoneID::BodyRightHandThumbDistal, EOculusXRBoneID::BodyRightHandThumbProximal, FVector(0.05, 0.8, 1.4));
+	addJoint(EOculusXRBoneID::BodyRightHandThumbTip, EOculusXRBoneID::BodyRightHandThumbDistal, FVector(0.055, 0.82, 1.4));
+
+	// Metacarpal, Proximal, Intermediate, Distal, Tip for the four fingers
+	const EOculusXRBoneID fingerRoots[] = {
+		EOculusXRBoneID::BodyRightHandIndexMetacarpal,
+		EOculusXRBoneID::BodyRightHandMiddleMetacarpal,
+		EOculusXRBoneID::BodyRightHandRingMetacarpal,
+		EOculusXRBoneID::BodyRightHandLittleMetacarpal,
+	};
+	const float fingerOffsets[] = { 0.025f, 0.0f, -0.02f, -0.04f };
+	const float fingerJointY[] = { 0.74f, 0.81f, 0.855f, 0.885f, 0.905f };
+	for (int32 finger = 0; finger < UE_ARRAY_COUNT(fingerRoots); ++finger)
+	{
+		EOculusXRBoneID parentBoneId = EOculusXRBoneID::BodyRightHandWrist;
+		for (int32 joint = 0; joint < UE_ARRAY_COUNT(fingerJointY); ++joint)
+		{
+			const EOculusXRBoneID boneId = static_cast<EOculusXRBoneID>(static_cast<int32>(fingerRoots[finger]) + joint);
+			addJoint(boneId, parentBoneId, FVector(fingerOffsets[finger], fingerJointY[joint], 1.42));
+			parentBoneId = boneId;
+		}
+	}
+
+	addJoint(EOculusXRBoneID::BodyRightUpperLeg, EOculusXRBoneID::BodyHips, FVector(0.0, 0.1, 0.92));
+	addJoint(EOculusXRBoneID::BodyRightLowerLeg, EOculusXRBoneID::BodyRightUpperLeg, FVector(0.0, 0.1, 0.5));
+	addJoint(EOculusXRBoneID::BodyRightFootAnkleTwist, EOculusXRBoneID::BodyRightLowerLeg, FVector(0.0, 0.1, 0.3));
+	addJoint(EOculusXRBoneID::BodyRightFootAnkle, EOculusXRBoneID::BodyRightLowerLeg, FVector(0.0, 0.1, 0.08));
+	addJoint(EOculusXRBoneID::BodyRightFootSubtalar, EOculusXRBoneID::BodyRightFootAnkle, FVector(-0.02, 0.1, 0.04));
+	addJoint(EOculusXRBoneID::BodyRightFootTransverse, EOculusXRBoneID::BodyRightFootSubtalar, FVector(0.06, 0.1, 0.03));
+	addJoint(EOculusXRBoneID::BodyRightFootBall, EOculusXRBoneID::BodyRightFootTransverse, FVector(0.14, 0.1, 0.02));
+
+	// Mirror the right side, the left side joints use the same layout in the bone id enumeration
+	auto mirrorRange = [this](EOculusXRBoneID firstRight, EOculusXRBoneID lastRight, EOculusXRBoneID firstLeft) {
+		const int32 offset = static_cast<int32>(firstLeft) - static_cast<int32>(firstRight);
+		for (int32 i = static_cast<int32>(firstRight); i <= static_cast<int32>(lastRight); ++i)
+		{
+			const FRestJoint& rightJoint = RestJoints[i];
+			FRestJoint& leftJoint = RestJoints[i + offset];
+			leftJoint.BoneId = static_cast<EOculusXRBoneID>(i + offset);
+			leftJoint.ParentBoneId = rightJoint.ParentBoneId >= firstRight
+				? static_cast<EOculusXRBoneID>(static_cast<int32>(rightJoint.ParentBoneId) + offset)
+				: rightJoint.ParentBoneId;
+			leftJoint.Position = FVector(rightJoint.Position.X, -rightJoint.Position.Y, rightJoint.Position.Z);
+		}
+	};
+	mirrorRange(EOculusXRBoneID::BodyRightShoulder, EOculusXRBoneID::BodyRightHandWristTwist, EOculusXRBoneID::BodyLeftShoulder);
+	mirrorRange(EOculusXRBoneID::BodyRightHandPalm, EOculusXRBoneID::BodyRightHandLittleTip, EOculusXRBoneID::BodyLeftHandPalm);
+	mirrorRange(EOculusXRBoneID::BodyRightUpperLeg, EOculusXRBoneID::BodyRightFootBall, EOculusXRBoneID::BodyLeftUpperLeg);
+	// The wrist is listed with the hand but parented to the arm
+	RestJoints[static_cast<int32>(EOculusXRBoneID::BodyLeftHandWrist)].ParentBoneId = EOculusXRBoneID::BodyLeftArmLower;
+
+	// Parents are not always listed before their children (palm before wrist), sort by depth once
+	TArray<int32> depths;
+	depths.SetNumZeroed(kNumBones);
+	for (int32 i = 0; i < kNumBones; ++i)
+	{
+		for (EOculusXRBoneID parent = RestJoints[i].ParentBoneId; parent != EOculusXRBoneID::None; parent = RestJoints[static_cast<int32>(parent)].ParentBoneId)
+		{
+			++depths[i];
+		}
+	}
+	EvaluationOrder.SetNumUninitialized(kNumBones);
+	for (int32 i = 0; i < kNumBones; ++i)
+	{
+		EvaluationOrder[i] = i;
+	}
+	Algo::StableSortBy(EvaluationOrder, [&depths](int32 boneIdx) { return depths[boneIdx]; });
+}
+
+int32 FOculusXRSyntheticMovementDataProvider::GetSkeletonChangedCount(const double InTime) const
+{
+	return Settings.SkeletonChangeInterval > 0.0f ? 1 + FMath::FloorToInt32(InTime / Settings.SkeletonChangeInterval) : 1;
+}
+
+float FOculusXRSyntheticMovementDataProvider::GetBodyScale(const int32 SkeletonChangedCount) const
+{
+	// Every recalibration reports slightly different proportions
+	return HeightScale * (1.0f + 0.02f * ((SkeletonChangedCount % 3) - 1));
+}
+
+int32 FOculusXRSyntheticMovementDataProvider::GetFrameIndex(const double InTime) const
+{
+	return FMath::FloorToInt32(InTime * FMath::Max(Settings.FrameRate, 1.0f));
+}
+
+FQuat FOculusXRSyntheticMovementDataProvider::GetJointAnimation(const EOculusXRBoneID BoneId, const double InTime) const
+{
+	const bool bIsLeft = IsLeftSideJoint(BoneId);
+	const float side = bIsLeft ? 1.0f : -1.0f;
+	const float walk = Cycle(InTime, Settings.WalkCycleFrequency * RateScale, WalkPhase + (bIsLeft ? 0.0f : UE_PI));
+	const float walkAmount = Settings.WalkCycleFrequency > 0.0f ? 1.0f : 0.0f;
+	// Only the right arm reaches
+	const float reach = Settings.ReachCycleFrequency > 0.0f && !bIsLeft ? Pulse(InTime, Settings.ReachCycleFrequency * RateScale, ReachPhase) : 0.0f;
+	const float curl = Settings.FingerCurlFrequency > 0.0f ? Pulse(InTime, Settings.FingerCurlFrequency * RateScale, FingerPhase + (bIsLeft ? 0.5f : 0.0f)) : 0.0f;
+
+	switch (BoneId)
+	{
+		case EOculusXRBoneID::BodyHips:
+			return MakeRotation(0.0f, 0.0f, 5.0f * walkAmount * Cycle(InTime, Settings.WalkCycleFrequency * RateScale, WalkPhase));
+		case EOculusXRBoneID::BodySpineMiddle:
+			return MakeRotation(0.0f, 0.0f, -4.0f * walkAmount * Cycle(InTime, Settings.WalkCycleFrequency * RateScale, WalkPhase));
+		case EOculusXRBoneID::BodyHead:
+			return MakeRotation(0.0f, 5.0f * Cycle(InTime, 0.13f, WalkPhase), 25.0f * Cycle(InTime, 0.07f, ReachPhase));
+		case EOculusXRBoneID::BodyLeftArmUpper:
+		case EOculusXRBoneID::BodyRightArmUpper:
+			// Arms down from the T-Pose, swinging against the legs, the right arm reaches forward
+			return MakeRotation(side * FMath::Lerp(70.0f, 10.0f, reach), 0.0f, side * 20.0f * walkAmount * walk - 80.0f * reach);
+		case EOculusXRBoneID::BodyLeftArmLower:
+		case EOculusXRBoneID::BodyRightArmLower:
+			return MakeRotation(0.0f, 0.0f, -side * FMath::Lerp(20.0f + 10.0f * walkAmount * walk, 5.0f, reach));
+		case EOculusXRBoneID::BodyLeftUpperLeg:
+		case EOculusXRBoneID::BodyRightUpperLeg:
+			return MakeRotation(0.0f, 25.0f * walkAmount * walk, 0.0f);
+		case EOculusXRBoneID::BodyLeftLowerLeg:
+		case EOculusXRBoneID::BodyRightLowerLeg:
+			return MakeRotation(0.0f, -35.0f * walkAmount * FMath::Max(0.0f, -walk), 0.0f);
+		case EOculusXRBoneID::BodyLeftFootAnkle:
+		case EOculusXRBoneID::BodyRightFootAnkle:
+			return MakeRotation(0.0f, 10.0f * walkAmount * walk, 0.0f);
+		default:
+			break;
+	}
+
+	if (IsFingerJoint(BoneId))
+	{
+		const int32 firstJoint = static_cast<int32>(bIsLeft ? EOculusXRBoneID::BodyLeftHandThumbMetacarpal : EOculusXRBoneID::BodyRightHandThumbMetacarpal);
+		const int32 jointInHand = static_cast<int32>(BoneId) - firstJoint;
+		const bool bIsThumb = jointInHand < 4;
+		// Metacarpals barely move, tips follow their distal joint
+		const int32 jointInFinger = bIsThumb ? jointInHand : (jointInHand - 4) % 5;
+		const float curlDegrees[] = { 5.0f, 70.0f, 80.0f, 50.0f, 0.0f };
+		const float degrees = (bIsThumb ? 0.4f : 1.0f) * curlDegrees[jointInFinger] * curl;
+		return MakeRotation(side * degrees, 0.0f, 0.0f);
+	}
+	return FQuat::Identity;
+}
+
+bool FOculusXRSyntheticMovementDataProvider::IsFingerJoint(const EOculusXRBoneID BoneId)
+{
+	return (BoneId >= EOculusXRBoneID::BodyLeftHandThumbMetacarpal && BoneId <= EOculusXRBoneID::BodyLeftHandLittleTip)
+		|| (BoneId >= EOculusXRBoneID::BodyRightHandThumbMetacarpal && BoneId <= EOculusXRBoneID::BodyRightHandLittleTip);
+}
+
+void FOculusXRSyntheticMovementDataProvider::EvaluateBody(const double InTime, TArrayView<FTransform> outTransforms) const
+{
+	check(outTransforms.Num() == kNumBones);
+	const float bodyScale = GetBodyScale(GetSkeletonChangedCount(InTime));
+	const int32 frameIndex = GetFrameIndex(InTime);
+	FRandomStream noise(HashCombine(GetTypeHash(Settings.Seed), GetTypeHash(frameIndex)));
+
+	for (const int32 boneIdx : EvaluationOrder)
+	{
+		const FRestJoint& restJoint = RestJoints[boneIdx];
+		FQuat localRotation = GetJointAnimation(restJoint.BoneId, InTime);
+		if (Settings.JointNoiseDegrees > 0.0f)
+		{
+			const float noiseDegrees = Settings.JointNoiseDegrees;
+			localRotation = localRotation * MakeRotation(noise.FRandRange(-noiseDegrees, noiseDegrees), noise.FRandRange(-noiseDegrees, noiseDegrees), noise.FRandRange(-noiseDegrees, noiseDegrees));
+		}
+
+		if (restJoint.ParentBoneId == EOculusXRBoneID::None)
+		{
+			outTransforms[boneIdx] = FTransform(localRotation, restJoint.Position * bodyScale);
+			continue;
+		}
+
+		// Rest orientations are identity, so the rest offset is expressed in the parent's frame as well
+		const int32 parentIdx = static_cast<int32>(restJoint.ParentBoneId);
+		const FTransform& parentTransform = outTransforms[parentIdx];
+		const FVector restOffset = (restJoint.Position - RestJoints[parentIdx].Position) * bodyScale;
+		FVector position = parentTransform.GetLocation() + parentTransform.GetRotation().RotateVector(restOffset);
+		if (restJoint.BoneId == EOculusXRBoneID::BodyHips)
+		{
+			// Vertical bob, twice per walk cycle
+			position.Z += 0.02f * Cycle(InTime, 2.0f * Settings.WalkCycleFrequency * RateScale, 2.0f * WalkPhase);
+		}
+		outTransforms[boneIdx] = FTransform(parentTransform.GetRotation() * localRotation, position);
+	}
+}
+
+bool FOculusXRSyntheticMovementDataProvider::GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters)
+{
+	const double time = GetTime();
+	// On the stack, getters can be called from any thread
+	FTransform transforms[kNumBones];
+	EvaluateBody(time, transforms);
+
+	outBodyState.IsActive = true;
+	outBodyState.Confidence = 1.0f;
+	outBodyState.SkeletonChangedCount = GetSkeletonChangedCount(time);
+	outBodyState.Time = static_cast<float>(time);
+	outBodyState.Joints.SetNum(kNumBones);
+
+	FRandomStream validity(HashCombine(GetTypeHash(~Settings.Seed), GetTypeHash(GetFrameIndex(time))));
+	for (int32 i = 0; i < kNumBones; ++i)
+	{
+		auto& joint = outBodyState.Joints[i];
+		joint.bIsValid = Settings.InvalidJointProbability <= 0.0f || validity.FRand() >= Settings.InvalidJointProbability;
+		joint.Orientation = transforms[i].Rotator();
+		joint.Position = transforms[i].GetLocation() * WorldToMeters;
+	}
+	return true;
+}
+
+bool FOculusXRSyntheticMovementDataProvider::GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters)
+{
+	const float bodyScale = GetBodyScale(GetSkeletonChangedCount(GetTime()));
+
+	outBodySkeleton.NumBones = kNumBones;
+	outBodySkeleton.Bones.SetNum(kNumBones);
+	for (int32 i = 0; i < kNumBones; ++i)
+	{
+		auto& bone = outBodySkeleton.Bones[i];
+		bone.BoneId = RestJoints[i].BoneId;
+		bone.ParentBoneIndex = RestJoints[i].ParentBoneId;
+		bone.Orientation = FRotator::ZeroRotator;
+		bone.Position = RestJoints[i].Position * bodyScale * WorldToMeters;
+	}
+	return true;
+}
+
+bool FOculusXRSyntheticMovementDataProvider::GetFaceState(FOculusXRFaceState& outFaceState)
+{
+	const double time = GetTime();
+	FRandomStream noise(HashCombine(GetTypeHash(Settings.Seed + 1), GetTypeHash(GetFrameIndex(time))));
+
+	outFaceState.ExpressionWeights.SetNumUninitialized(kNumExpressions);
+	outFaceState.ExpressionWeightConfidences.Init(1.0f, 2);
+	for (int32 i = 0; i < kNumExpressions; ++i)
+	{
+		float weight = 0.0f;
+		if (Settings.ExpressionCycleFrequency > 0.0f)
+		{
+			weight = ExpressionAmplitudes[i] * Pulse(time, Settings.ExpressionCycleFrequency * RateScale, ExpressionPhases[i]);
+		}
+		if (Settings.ExpressionNoise > 0.0f)
+		{
+			weight += noise.FRandRange(-Settings.ExpressionNoise, Settings.ExpressionNoise);
+		}
+		outFaceState.ExpressionWeights[i] = FMath::Clamp(weight, 0.0f, 1.0f);
+	}
+
+	// Periodic blinks on top of the cycles
+	const double blinkTime = FMath::Fmod(time + WalkPhase, kBlinkInterval);
+	if (blinkTime < kBlinkDuration)
+	{
+		const float blink = FMath::Sin(static_cast<float>(UE_PI * blinkTime / kBlinkDuration));
+		for (EOculusXRFaceExpression expression : { EOculusXRFaceExpression::EyesClosedL, EOculusXRFaceExpression::EyesClosedR })
+		{
+			float& weight = outFaceState.ExpressionWeights[static_cast<int32>(expression)];
+			weight = FMath::Max(weight, blink);
+		}
+	}
+
+	outFaceState.bIsValid = true;
+	outFaceState.bIsEyeFollowingBlendshapesValid = true;
+	outFaceState.Time = static_cast<float>(time);
+	return true;
+}
+
+bool FOculusXRSyntheticMovementDataProvider::GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters)
+{
+	const double time = GetTime();
+	FTransform transforms[kNumBones];
+	EvaluateBody(time, transforms);
+	const FTransform& headTransform = transforms[static_cast<int32>(EOculusXRBoneID::BodyHead)];
+
+	// Saccade-like gaze targets held for a short while
+	FRandomStream gaze(HashCombine(GetTypeHash(Settings.Seed + 2), GetTypeHash(FMath::FloorToInt32(time * 2.0))));
+	const FRotator gazeRotation(gaze.FRandRange(-10.0f, 10.0f), gaze.FRandRange(-20.0f, 20.0f), 0.0f);
+	const FQuat eyeRotation = headTransform.GetRotation() * FQuat(gazeRotation);
+
+	outEyeGazesState.EyeGazes.SetNum(2);
+	for (int32 eye = 0; eye < 2; ++eye)
+	{
+		auto& eyeGaze = outEyeGazesState.EyeGazes[eye];
+		const FVector eyeOffset(0.09, eye == 0 ? -0.032 : 0.032, 0.07);
+		eyeGaze.Orientation = eyeRotation.Rotator();
+		eyeGaze.Position = headTransform.TransformPosition(eyeOffset) * WorldToMeters;
+		eyeGaze.Confidence = 1.0f;
+		eyeGaze.bIsValid = true;
+	}
+	outEyeGazesState.Time = static_cast<float>(time);
+	return true;
+}
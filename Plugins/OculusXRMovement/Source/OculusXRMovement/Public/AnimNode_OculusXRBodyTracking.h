@@ -10,7 +10,9 @@ LICENSE file in the root directory of this source tree.
 
 #include "CoreMinimal.h"
 #include "OculusXRLiveLinkRetargetBodyAsset.h"
+#include "OculusXRBodyRemapAsset.h"
 #include "OculusXRBodyRetargeter.h"
+#include "OculusXRMovementDataProvider.h"
 #include "OculusXRRetargetSkeleton.h"
 #include "Animation/AnimNodeBase.h"
 #include "AnimNode_OculusXRBodyTracking.generated.h"
@@ -29,100 +31,16 @@ struct OCULUSXRRETARGETING_API FAnimNode_OculusXRBodyTracking : public FAnimNode
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Debug, meta = (PinShownByDefault))
 	EOculusXRBodyDebugDrawMode DebugDrawMode;
 	/**
-	 * Remapping from bone ID to target skeleton's bone name.
+	 * Remapping from bone ID to target skeleton's bone name. When empty, the remap asset or the UE5 mannequin remapping is used.
 	 */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OculusXR|BodyTracking")
-	TMap<EOculusXRBoneID, FName> BoneRemapping = {
-		{ EOculusXRBoneID::BodyRoot, "root" },
-		{ EOculusXRBoneID::BodyHips, "pelvis" },
-		{ EOculusXRBoneID::BodySpineLower, "spine_01" },
-		{ EOculusXRBoneID::BodySpineMiddle, "spine_02" },
-		{ EOculusXRBoneID::BodySpineUpper, "spine_04" },
-		{ EOculusXRBoneID::BodyChest, "spine_05" },
-		{ EOculusXRBoneID::BodyNeck, "neck_02" },
-		{ EOculusXRBoneID::BodyHead, "head" },
-
-		{ EOculusXRBoneID::BodyLeftShoulder, "clavicle_l" },
-		{ EOculusXRBoneID::BodyLeftScapula, NAME_None },
-		{ EOculusXRBoneID::BodyLeftArmUpper, "upperarm_l" },
-		{ EOculusXRBoneID::BodyLeftArmLower, "lowerarm_l" },
-		{ EOculusXRBoneID::BodyLeftHandWristTwist, NAME_None },
-
-		{ EOculusXRBoneID::BodyRightShoulder, "clavicle_r" },
-		{ EOculusXRBoneID::BodyRightScapula, NAME_None },
-		{ EOculusXRBoneID::BodyRightArmUpper, "upperarm_r" },
-		{ EOculusXRBoneID::BodyRightArmLower, "lowerarm_r" },
-		{ EOculusXRBoneID::BodyRightHandWristTwist, NAME_None },
-
-		{ EOculusXRBoneID::BodyLeftHandPalm, NAME_None },
-		{ EOculusXRBoneID::BodyLeftHandWrist, "hand_l" },
-		{ EOculusXRBoneID::BodyLeftHandThumbMetacarpal, "thumb_01_l" },
-		{ EOculusXRBoneID::BodyLeftHandThumbProximal, "thumb_02_l" },
-		{ EOculusXRBoneID::BodyLeftHandThumbDistal, "thumb_03_l" },
-		{ EOculusXRBoneID::BodyLeftHandThumbTip, NAME_None },
-		{ EOculusXRBoneID::BodyLeftHandIndexMetacarpal, "index_metacarpal_l" },
-		{ EOculusXRBoneID::BodyLeftHandIndexProximal, "index_01_l" },
-		{ EOculusXRBoneID::BodyLeftHandIndexIntermediate, "index_02_l" },
-		{ EOculusXRBoneID::BodyLeftHandIndexDistal, "index_03_l" },
-		{ EOculusXRBoneID::BodyLeftHandIndexTip, NAME_None },
-		{ EOculusXRBoneID::BodyLeftHandMiddleMetacarpal, "middle_metacarpal_l" },
-		{ EOculusXRBoneID::BodyLeftHandMiddleProximal, "middle_01_l" },
-		{ EOculusXRBoneID::BodyLeftHandMiddleIntermediate, "middle_02_l" },
-		{ EOculusXRBoneID::BodyLeftHandMiddleDistal, "middle_03_l" },
-		{ EOculusXRBoneID::BodyLeftHandMiddleTip, NAME_None },
-		{ EOculusXRBoneID::BodyLeftHandRingMetacarpal, "ring_metacarpal_l" },
-		{ EOculusXRBoneID::BodyLeftHandRingProximal, "ring_01_l" },
-		{ EOculusXRBoneID::BodyLeftHandRingIntermediate, "ring_02_l" },
-		{ EOculusXRBoneID::BodyLeftHandRingDistal, "ring_03_l" },
-		{ EOculusXRBoneID::BodyLeftHandRingTip, NAME_None },
-		{ EOculusXRBoneID::BodyLeftHandLittleMetacarpal, "pinky_metacarpal_l" },
-		{ EOculusXRBoneID::BodyLeftHandLittleProximal, "pinky_01_l" },
-		{ EOculusXRBoneID::BodyLeftHandLittleIntermediate, "pinky_02_l" },
-		{ EOculusXRBoneID::BodyLeftHandLittleDistal, "pinky_03_l" },
-		{ EOculusXRBoneID::BodyLeftHandLittleTip, NAME_None },
-
-		{ EOculusXRBoneID::BodyRightHandPalm, NAME_None },
-		{ EOculusXRBoneID::BodyRightHandWrist, "hand_r" },
-		{ EOculusXRBoneID::BodyRightHandThumbMetacarpal, "thumb_01_r" },
-		{ EOculusXRBoneID::BodyRightHandThumbProximal, "thumb_02_r" },
-		{ EOculusXRBoneID::BodyRightHandThumbDistal, "thumb_03_r" },
-		{ EOculusXRBoneID::BodyRightHandThumbTip, NAME_None },
-		{ EOculusXRBoneID::BodyRightHandIndexMetacarpal, "index_metacarpal_r" },
-		{ EOculusXRBoneID::BodyRightHandIndexProximal, "index_01_r" },
-		{ EOculusXRBoneID::BodyRightHandIndexIntermediate, "index_02_r" },
-		{ EOculusXRBoneID::BodyRightHandIndexDistal, "index_03_r" },
-		{ EOculusXRBoneID::BodyRightHandIndexTip, NAME_None },
-		{ EOculusXRBoneID::BodyRightHandMiddleMetacarpal, "middle_metacarpal_r" },
-		{ EOculusXRBoneID::BodyRightHandMiddleProximal, "middle_01_r" },
-		{ EOculusXRBoneID::BodyRightHandMiddleIntermediate, "middle_02_r" },
-		{ EOculusXRBoneID::BodyRightHandMiddleDistal, "middle_03_r" },
-		{ EOculusXRBoneID::BodyRightHandMiddleTip, NAME_None },
-		{ EOculusXRBoneID::BodyRightHandRingMetacarpal, "ring_metacarpal_r" },
-		{ EOculusXRBoneID::BodyRightHandRingProximal, "ring_01_r" },
-		{ EOculusXRBoneID::BodyRightHandRingIntermediate, "ring_02_r" },
-		{ EOculusXRBoneID::BodyRightHandRingDistal, "ring_03_r" },
-		{ EOculusXRBoneID::BodyRightHandRingTip, NAME_None },
-		{ EOculusXRBoneID::BodyRightHandLittleMetacarpal, "pinky_metacarpal_r" },
-		{ EOculusXRBoneID::BodyRightHandLittleProximal, "pinky_01_r" },
-		{ EOculusXRBoneID::BodyRightHandLittleIntermediate, "pinky_02_r" },
-		{ EOculusXRBoneID::BodyRightHandLittleDistal, "pinky_03_r" },
-		{ EOculusXRBoneID::BodyRightHandLittleTip, NAME_None },
-
-		{ EOculusXRBoneID::BodyLeftUpperLeg, "thigh_l" },
-		{ EOculusXRBoneID::BodyLeftLowerLeg, "calf_l" },
-		{ EOculusXRBoneID::BodyLeftFootAnkleTwist, NAME_None },
-		{ EOculusXRBoneID::BodyLeftFootAnkle, "foot_l" },
-		{ EOculusXRBoneID::BodyLeftFootSubtalar, NAME_None },
-		{ EOculusXRBoneID::BodyLeftFootTransverse, NAME_None },
-		{ EOculusXRBoneID::BodyLeftFootBall, "ball_l" },
-		{ EOculusXRBoneID::BodyRightUpperLeg, "thigh_r" },
-		{ EOculusXRBoneID::BodyRightLowerLeg, "calf_r" },
-		{ EOculusXRBoneID::BodyRightFootAnkleTwist, NAME_None },
-		{ EOculusXRBoneID::BodyRightFootAnkle, "foot_r" },
-		{ EOculusXRBoneID::BodyRightFootSubtalar, NAME_None },
-		{ EOculusXRBoneID::BodyRightFootTransverse, NAME_None },
-		{ EOculusXRBoneID::BodyRightFootBall, "ball_r" },
-	};
+	TMap<EOculusXRBoneID, FName> BoneRemapping;
+
+	/**
+	 * Remapping shared by every node retargeting to the same skeleton, used instead of BoneRemapping when set.
+	 */
+	UPROPERTY(EditAnywhere, Category = "OculusXR|BodyTracking")
+	TObjectPtr<UOculusXRBodyRemapAsset> RemapAsset;
 
 	/**
 	 * Switch between retargeting modes.
@@ -142,17 +60,131 @@ struct OCULUSXRRETARGETING_API FAnimNode_OculusXRBodyTracking : public FAnimNode
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OculusXR|BodyTracking", meta = (PinShownByDefault))
 	EOculusXRBodyRetargetingRootMotionBehavior RootMotionBehavior = EOculusXRBodyRetargetingRootMotionBehavior::CombineToRoot;
 
+	/**
+	 * How bones that hang off mapped joints without any mapped descendants (facial bones, helpers, accessories) are handled.
+	 * Freezing them skips their per-frame retargeting and writes their local transforms in one block.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OculusXR|BodyTracking")
+	EOculusXRBodyUnmappedSubtreeMode UnmappedSubtreeMode = EOculusXRBodyUnmappedSubtreeMode::RestPose;
+
+	/**
+	 * Body regions driven by tracking. Bones outside these regions are copied from the input pose.
+	 * A region whose parent bone is copied from the input pose keeps its tracked rotations relative to that bone, so with
+	 * only the hands selected, the tracked hands follow the arms of the input pose.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OculusXR|BodyTracking", meta = (Bitmask, BitmaskEnum = "/Script/OculusXRRetargeting.EOculusXRBodyRegion"))
+	int32 RetargetedRegions = static_cast<int32>(EOculusXRBodyRegion::All);
+
+	/**
+	 * Skip evaluating the input pose when tracking overwrites every bone (every region retargeted, unmapped subtrees not
+	 * copied from the input pose). This saves the cost of the upstream graph, but drops the curves and attributes it
+	 * produces, such as face tracking curves from a node placed before this one.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OculusXR|BodyTracking|Performance")
+	bool bSkipOverriddenInputPose = false;
+
+	/**
+	 * Highest fidelity tier this node retargets at. Lower tiers skip fingers, twist joint interpolation and hand scaling,
+	 * or hold the last retargeted pose. Switching tiers does not rebuild the retargeter.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OculusXR|BodyTracking|Performance")
+	EOculusXRBodyFidelityTier FidelityTier = EOculusXRBodyFidelityTier::Full;
+
+	/**
+	 * Let the global retarget budget lower the fidelity tier based on the avatar significance (distance, visibility, local or remote)
+	 * and the measured retargeting cost. See oculusxr.Movement.RetargetBudgetMs.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OculusXR|BodyTracking|Performance")
+	bool bUseRetargetBudget = false;
+
+	/**
+	 * Retarget only once every N evaluations. Frames in between blend the last two retargeted poses, which delays the
+	 * tracked pose by N evaluations. The retarget budget can raise the divisor further based on the avatar significance.
+	 * Update rate optimizations are not folded into the divisor: they already skip the evaluations they throttle, so the
+	 * divisor counts the evaluations they let through and stacks with their rate. Deriving it from URO as well would
+	 * throttle those meshes twice.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OculusXR|BodyTracking|Performance", meta = (ClampMin = "1", UIMin = "1", UIMax = "8"))
+	int32 EvaluationRateDivisor = 1;
+
 	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override;
+	virtual bool HasPreUpdate() const override { return true; }
 	virtual void PreUpdate(const UAnimInstance* InAnimInstance) override;
 	virtual void Update_AnyThread(const FAnimationUpdateContext& Context) override;
 	virtual void Evaluate_AnyThread(FPoseContext& Output) override;
 
+	// The remap asset's remapping, else BoneRemapping, else the shared UE5 mannequin remapping, never empty
+	const TMap<EOculusXRBoneID, FName>& GetBoneRemapping() const;
+
 private:
+	/**
+	 * Snapshot of everything the retargeter needs from the game thread.
+	 * Gathered in PreUpdate so that evaluation never has to touch a UObject.
+	 */
+	struct FNodeConfig
+	{
+		EOculusXRBodyRetargetingMode RetargetingMode = EOculusXRBodyRetargetingMode::RotationAndPositions;
+		EOculusXRBodyRetargetingRootMotionBehavior RootMotionBehavior = EOculusXRBodyRetargetingRootMotionBehavior::CombineToRoot;
+		EOculusXRAxis ForwardMesh = EOculusXRAxis::Y;
+		EOculusXRBodyUnmappedSubtreeMode UnmappedSubtreeMode = EOculusXRBodyUnmappedSubtreeMode::RestPose;
+		EOculusXRBodyRegion RetargetedRegions = EOculusXRBodyRegion::All;
+		EOculusXRBodyDebugPoseMode DebugPoseMode = EOculusXRBodyDebugPoseMode::None;
+		EOculusXRBodyDebugDrawMode DebugDrawMode = EOculusXRBodyDebugDrawMode::None;
+		EOculusXRBodyFidelityTier FidelityTier = EOculusXRBodyFidelityTier::Full;
+		bool bUseRetargetBudget = false;
+		bool bSkipOverriddenInputPose = false;
+		int32 EvaluationRateDivisor = 1;
+		// Copy of GetBoneRemapping, taken again only when the remapping used or the remap asset's contents change.
+		// Null until the first PreUpdate.
+		TSharedPtr<const TMap<EOculusXRBoneID, FName>> BoneRemapping;
+		const TMap<EOculusXRBoneID, FName>* BoneRemappingSource = nullptr;
+		uint32 BoneRemappingChangeCount = 0;
+
+		TSharedPtr<IOculusXRMovementDataProvider> DataProvider;
+		FTransform ComponentTransform = FTransform::Identity;
+		float WorldScale = 100.f;
+		bool bIsTrackingAvailable = false;
+		bool bIsGameWorld = false;
+
+		// Bumped every time a value that requires the retargeter to be re-initialized changes
+		int32 Generation = 0;
+
+		// The retargeter overwrites every bone and the node was allowed to drop the input pose's curves and attributes
+		bool SkipsInputPose() const
+		{
+			return bSkipOverriddenInputPose && RetargetedRegions == EOculusXRBodyRegion::All && UnmappedSubtreeMode != EOculusXRBodyUnmappedSubtreeMode::InputPose;
+		}
+
+		bool RequiresReinitialization(const FNodeConfig& Other) const
+		{
+			return RetargetingMode != Other.RetargetingMode
+				|| RootMotionBehavior != Other.RootMotionBehavior
+				|| ForwardMesh != Other.ForwardMesh
+				|| UnmappedSubtreeMode != Other.UnmappedSubtreeMode
+				|| RetargetedRegions != Other.RetargetedRegions
+				|| DebugPoseMode != Other.DebugPoseMode
+				|| DebugDrawMode != Other.DebugDrawMode
+				|| BoneRemapping != Other.BoneRemapping;
+		}
+	};
+
+	const FNodeConfig& GetActiveConfig() const { return Configs[FPlatformAtomics::AtomicRead(&ActiveConfigIndex)]; }
+	void ApplyConfig(const FNodeConfig& Config);
+
 	TSharedPtr<FOculusXRBodyRetargeter> RetargeterInstance;
+	// The retargeter points to the remapping it was initialized with, kept alive here whatever PreUpdate publishes next
+	TSharedPtr<const TMap<EOculusXRBoneID, FName>> AppliedBoneRemapping;
+
+	// Double buffered - PreUpdate writes the inactive entry and then flips ActiveConfigIndex
+	FNodeConfig Configs[2];
+	int32 ActiveConfigIndex = 0;
+	int32 AppliedConfigGeneration = INDEX_NONE;
+	const IOculusXRMovementDataProvider* AppliedDataProvider = nullptr;
 
-	// U Type Data - cached from other location
-	USkeletalMeshComponent* SkeletalMeshComponent = nullptr;
-	USkeleton* Skeleton = nullptr;
+	// Identifies this node with the retarget budget manager, assigned on first use
+	uint32 BudgetAvatarId = 0;
 
-	float Scale = 100.f;
+	// Evaluations since the last retargeted frame, INDEX_NONE until a frame was retargeted
+	int32 FramesSinceRetarget = INDEX_NONE;
 };
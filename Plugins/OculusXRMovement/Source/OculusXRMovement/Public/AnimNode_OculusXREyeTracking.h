@@ -13,6 +13,8 @@ LICENSE file in the root directory of this source tree.
 #include "OculusXRRetargetSkeleton.h"
 #include "Animation/AnimNodeBase.h"
 #include "OculusXRMorphTargetsController.h"
+#include "OculusXRMovementDataProvider.h"
+#include "OculusXROneEuroFilter.h"
 #include "AnimNode_OculusXREyeTracking.generated.h"
 
 USTRUCT(Blueprintable)
@@ -24,6 +26,7 @@ struct OCULUSXRRETARGETING_API FAnimNode_OculusXREyeTracking : public FAnimNode_
 	FPoseLink InputPose;
 
 	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual bool HasPreUpdate() const override { return true; }
 	virtual void PreUpdate(const UAnimInstance* InAnimInstance) override;
 	virtual void Update_AnyThread(const FAnimationUpdateContext& Context) override;
 	virtual void Evaluate_AnyThread(FPoseContext& Output) override;
@@ -34,10 +37,34 @@ struct OCULUSXRRETARGETING_API FAnimNode_OculusXREyeTracking : public FAnimNode_
 	UPROPERTY(EditDefaultsOnly, Category = "OculusXR|EyeTracking")
 	FName RightEyeBone = "RightEye";
 
+	/**
+	 * Smooths the tracked gaze orientations with a One Euro filter.
+	 */
+	UPROPERTY(EditAnywhere, Category = "OculusXR|EyeTracking")
+	bool bFilterGaze = false;
+
+	// Eyes move fast, the default cutoffs are higher than for face expressions
+	UPROPERTY(EditAnywhere, Category = "OculusXR|EyeTracking", meta = (EditCondition = "bFilterGaze"))
+	FOculusXROneEuroFilterSettings GazeFilter = FOculusXROneEuroFilterSettings(3.0f, 2.0f, 1.0f);
+
 private:
+	// Resolved on the game thread in PreUpdate
+	TSharedPtr<IOculusXRMovementDataProvider> DataProvider;
+
 	FQuat InitialLeftRotation;
 	FQuat InitialRightRotation;
 
+	// Both gaze quaternions, four channels each
+	FOculusXROneEuroFilter CompiledGazeFilter;
+	FQuat4f FilteredGazes[2] = { FQuat4f::Identity, FQuat4f::Identity };
+	bool bHasFilteredGazes = false;
+	// Filter steps use the sample times, or the frame time when the provider does not time its samples
+	float LastGazeTime = 0.0f;
+	float PendingDeltaTime = 0.0f;
+
+	// Returns the orientations of both eyes, filtered when bFilterGaze is set
+	void FilterGazes(const FOculusXREyeGazesState& GazesState, FQuat OutGazes[2]);
+
 	bool HasSetInitialRotations = false;
 	void RecalculateInitialRotations(FBoneContainer);
 };
@@ -13,6 +13,10 @@ LICENSE file in the root directory of this source tree.
 #include "OculusXRRetargetSkeleton.h"
 #include "Animation/AnimNodeBase.h"
 #include "OculusXRMorphTargetsController.h"
+#include "OculusXRMovementDataProvider.h"
+#include "OculusXRFaceExpressionModifiers.h"
+#include "OculusXRFaceRetargetAsset.h"
+#include "OculusXROneEuroFilter.h"
 #include "AnimNode_OculusXRFaceTracking.generated.h"
 
 USTRUCT(BlueprintType)
@@ -24,6 +28,7 @@ public:
 		: MinValue(0.f)
 		, MaxValue(1.f)
 		, Multiplier(1.f)
+		, ResponseExponent(1.f)
 	{
 	}
 
@@ -35,6 +40,13 @@ public:
 
 	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement")
 	float Multiplier;
+
+	/**
+	 * Response curve applied to the weight before the multiplier, weight ^ ResponseExponent.
+	 * Above 1 keeps small weights down, below 1 brings them up.
+	 */
+	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement", meta = (ClampMin = "0.01"))
+	float ResponseExponent;
 };
 
 USTRUCT(BlueprintType)
@@ -44,6 +56,8 @@ struct OCULUSXRRETARGETING_API FOculusXRExpressionCurves
 
 	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement")
 	TArray<FName> CurveNames;
+
+	bool operator==(const FOculusXRExpressionCurves& Other) const { return CurveNames == Other.CurveNames; }
 };
 
 USTRUCT(Blueprintable)
@@ -55,89 +69,88 @@ struct OCULUSXRRETARGETING_API FAnimNode_OculusXRFaceTracking : public FAnimNode
 	FPoseLink InputPose;
 
 	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override;
+	virtual bool HasPreUpdate() const override { return true; }
 	virtual void PreUpdate(const UAnimInstance* InAnimInstance) override;
 	virtual void Update_AnyThread(const FAnimationUpdateContext& Context) override;
 	virtual void Evaluate_AnyThread(FPoseContext& Output) override;
 
 	/**
-	 * Remapping from bone ID to target skeleton's bone name.
+	 * Curves driven by each expression. When empty, the shared mapping to the ARKit-named blendshapes is used.
 	 */
 	UPROPERTY(EditDefaultsOnly, Category = "OculusXR|FaceTracking")
-	TMap<EOculusXRFaceExpression, FOculusXRExpressionCurves> ExpressionNames = {
-		{ EOculusXRFaceExpression::BrowLowererL, FOculusXRExpressionCurves{ { FName("browLowerer_L") } } },
-		{ EOculusXRFaceExpression::BrowLowererR, FOculusXRExpressionCurves{ { FName("browLowerer_R") } } },
-		{ EOculusXRFaceExpression::CheekPuffL, FOculusXRExpressionCurves{ { FName("cheekPuff_L") } } },
-		{ EOculusXRFaceExpression::CheekPuffR, FOculusXRExpressionCurves{ { FName("cheekPuff_R") } } },
-		{ EOculusXRFaceExpression::CheekRaiserL, FOculusXRExpressionCurves{ { FName("cheekRaiser_L") } } },
-		{ EOculusXRFaceExpression::CheekRaiserR, FOculusXRExpressionCurves{ { FName("cheekRaiser_R") } } },
-		{ EOculusXRFaceExpression::CheekSuckL, FOculusXRExpressionCurves{ { FName("cheekSuck_L") } } },
-		{ EOculusXRFaceExpression::CheekSuckR, FOculusXRExpressionCurves{ { FName("cheekSuck_R") } } },
-		{ EOculusXRFaceExpression::ChinRaiserB, FOculusXRExpressionCurves{ { FName("chinRaiser_B") } } },
-		{ EOculusXRFaceExpression::ChinRaiserT, FOculusXRExpressionCurves{ { FName("chinRaiser_T") } } },
-		{ EOculusXRFaceExpression::DimplerL, FOculusXRExpressionCurves{ { FName("dimpler_L") } } },
-		{ EOculusXRFaceExpression::DimplerR, FOculusXRExpressionCurves{ { FName("dimpler_R") } } },
-		{ EOculusXRFaceExpression::EyesClosedL, FOculusXRExpressionCurves{ { FName("eyesClosed_L") } } },
-		{ EOculusXRFaceExpression::EyesClosedR, FOculusXRExpressionCurves{ { FName("eyesClosed_R") } } },
-		{ EOculusXRFaceExpression::EyesLookDownL, FOculusXRExpressionCurves{ { FName("eyesLookDown_L") } } },
-		{ EOculusXRFaceExpression::EyesLookDownR, FOculusXRExpressionCurves{ { FName("eyesLookDown_R") } } },
-		{ EOculusXRFaceExpression::EyesLookLeftL, FOculusXRExpressionCurves{ { FName("eyesLookLeft_L") } } },
-		{ EOculusXRFaceExpression::EyesLookLeftR, FOculusXRExpressionCurves{ { FName("eyesLookLeft_R") } } },
-		{ EOculusXRFaceExpression::EyesLookRightL, FOculusXRExpressionCurves{ { FName("eyesLookRight_L") } } },
-		{ EOculusXRFaceExpression::EyesLookRightR, FOculusXRExpressionCurves{ { FName("eyesLookRight_R") } } },
-		{ EOculusXRFaceExpression::EyesLookUpL, FOculusXRExpressionCurves{ { FName("eyesLookUp_L") } } },
-		{ EOculusXRFaceExpression::EyesLookUpR, FOculusXRExpressionCurves{ { FName("eyesLookUp_R") } } },
-		{ EOculusXRFaceExpression::InnerBrowRaiserL, FOculusXRExpressionCurves{ { FName("innerBrowRaiser_L") } } },
-		{ EOculusXRFaceExpression::InnerBrowRaiserR, FOculusXRExpressionCurves{ { FName("innerBrowRaiser_R") } } },
-		{ EOculusXRFaceExpression::JawDrop, FOculusXRExpressionCurves{ { FName("jawDrop") } } },
-		{ EOculusXRFaceExpression::JawSidewaysLeft, FOculusXRExpressionCurves{ { FName("jawSidewaysLeft") } } },
-		{ EOculusXRFaceExpression::JawSidewaysRight, FOculusXRExpressionCurves{ { FName("jawSidewaysRight") } } },
-		{ EOculusXRFaceExpression::JawThrust, FOculusXRExpressionCurves{ { FName("jawThrust") } } },
-		{ EOculusXRFaceExpression::LidTightenerL, FOculusXRExpressionCurves{ { FName("lidTightener_L") } } },
-		{ EOculusXRFaceExpression::LidTightenerR, FOculusXRExpressionCurves{ { FName("lidTightener_R") } } },
-		{ EOculusXRFaceExpression::LipCornerDepressorL, FOculusXRExpressionCurves{ { FName("lipCornerDepressor_L") } } },
-		{ EOculusXRFaceExpression::LipCornerDepressorR, FOculusXRExpressionCurves{ { FName("lipCornerDepressor_R") } } },
-		{ EOculusXRFaceExpression::LipCornerPullerL, FOculusXRExpressionCurves{ { FName("lipCornerPuller_L") } } },
-		{ EOculusXRFaceExpression::LipCornerPullerR, FOculusXRExpressionCurves{ { FName("lipCornerPuller_R") } } },
-		{ EOculusXRFaceExpression::LipFunnelerLB, FOculusXRExpressionCurves{ { FName("lipFunneler_LB") } } },
-		{ EOculusXRFaceExpression::LipFunnelerLT, FOculusXRExpressionCurves{ { FName("lipFunneler_LT") } } },
-		{ EOculusXRFaceExpression::LipFunnelerRB, FOculusXRExpressionCurves{ { FName("lipFunneler_RB") } } },
-		{ EOculusXRFaceExpression::LipFunnelerRT, FOculusXRExpressionCurves{ { FName("lipFunneler_RT") } } },
-		{ EOculusXRFaceExpression::LipPressorL, FOculusXRExpressionCurves{ { FName("lipPressor_L") } } },
-		{ EOculusXRFaceExpression::LipPressorR, FOculusXRExpressionCurves{ { FName("lipPressor_R") } } },
-		{ EOculusXRFaceExpression::LipPuckerL, FOculusXRExpressionCurves{ { FName("lipPucker_L") } } },
-		{ EOculusXRFaceExpression::LipPuckerR, FOculusXRExpressionCurves{ { FName("lipPucker_R") } } },
-		{ EOculusXRFaceExpression::LipStretcherL, FOculusXRExpressionCurves{ { FName("lipStretcher_L") } } },
-		{ EOculusXRFaceExpression::LipStretcherR, FOculusXRExpressionCurves{ { FName("lipStretcher_R") } } },
-		{ EOculusXRFaceExpression::LipSuckLB, FOculusXRExpressionCurves{ { FName("lipSuck_LB") } } },
-		{ EOculusXRFaceExpression::LipSuckLT, FOculusXRExpressionCurves{ { FName("lipSuck_LT") } } },
-		{ EOculusXRFaceExpression::LipSuckRB, FOculusXRExpressionCurves{ { FName("lipSuck_RB") } } },
-		{ EOculusXRFaceExpression::LipSuckRT, FOculusXRExpressionCurves{ { FName("lipSuck_RT") } } },
-		{ EOculusXRFaceExpression::LipTightenerL, FOculusXRExpressionCurves{ { FName("lipTightener_L") } } },
-		{ EOculusXRFaceExpression::LipTightenerR, FOculusXRExpressionCurves{ { FName("lipTightener_R") } } },
-		{ EOculusXRFaceExpression::LipsToward, FOculusXRExpressionCurves{ { FName("lipsToward") } } },
-		{ EOculusXRFaceExpression::LowerLipDepressorL, FOculusXRExpressionCurves{ { FName("lowerLipDepressor_L") } } },
-		{ EOculusXRFaceExpression::LowerLipDepressorR, FOculusXRExpressionCurves{ { FName("lowerLipDepressor_R") } } },
-		{ EOculusXRFaceExpression::MouthLeft, FOculusXRExpressionCurves{ { FName("mouthLeft") } } },
-		{ EOculusXRFaceExpression::MouthRight, FOculusXRExpressionCurves{ { FName("mouthRight") } } },
-		{ EOculusXRFaceExpression::NoseWrinklerL, FOculusXRExpressionCurves{ { FName("noseWrinkler_L") } } },
-		{ EOculusXRFaceExpression::NoseWrinklerR, FOculusXRExpressionCurves{ { FName("noseWrinkler_R") } } },
-		{ EOculusXRFaceExpression::OuterBrowRaiserL, FOculusXRExpressionCurves{ { FName("outerBrowRaiser_L") } } },
-		{ EOculusXRFaceExpression::OuterBrowRaiserR, FOculusXRExpressionCurves{ { FName("outerBrowRaiser_R") } } },
-		{ EOculusXRFaceExpression::UpperLidRaiserL, FOculusXRExpressionCurves{ { FName("upperLidRaiser_L") } } },
-		{ EOculusXRFaceExpression::UpperLidRaiserR, FOculusXRExpressionCurves{ { FName("upperLidRaiser_R") } } },
-		{ EOculusXRFaceExpression::UpperLipRaiserL, FOculusXRExpressionCurves{ { FName("upperLipRaiser_L") } } },
-		{ EOculusXRFaceExpression::UpperLipRaiserR, FOculusXRExpressionCurves{ { FName("upperLipRaiser_R") } } },
-		{ EOculusXRFaceExpression::TongueTipInterdental, FOculusXRExpressionCurves{ { FName("tongueTipInterdental") } } },
-		{ EOculusXRFaceExpression::TongueTipAlveolar, FOculusXRExpressionCurves{ { FName("tongueTipAlveolar") } } },
-		{ EOculusXRFaceExpression::TongueFrontDorsalPalate, FOculusXRExpressionCurves{ { FName("tongueFrontDorsalPalate") } } },
-		{ EOculusXRFaceExpression::TongueMidDorsalPalate, FOculusXRExpressionCurves{ { FName("tongueMidDorsalPalate") } } },
-		{ EOculusXRFaceExpression::TongueBackDorsalVelar, FOculusXRExpressionCurves{ { FName("tongueBackDorsalVelar") } } },
-		{ EOculusXRFaceExpression::TongueOut, FOculusXRExpressionCurves{ { FName("tongueOut") } } }
-	};
+	TMap<EOculusXRFaceExpression, FOculusXRExpressionCurves> ExpressionNames;
 
 	UPROPERTY(EditDefaultsOnly, Category = "OculusXR|FaceTracking")
 	TMap<EOculusXRFaceExpression, FOculusXRFaceExpressionModifierNew> ExpressionModifiers;
 
+	/**
+	 * Weighted mapping from expressions to curves, used instead of ExpressionNames when set.
+	 */
+	UPROPERTY(EditAnywhere, Category = "OculusXR|FaceTracking")
+	TObjectPtr<UOculusXRFaceRetargetAsset> RetargetAsset;
+
+	/**
+	 * Curves keep their last value until they move more than this, so small tracking jitter does not update morph targets.
+	 */
+	UPROPERTY(EditAnywhere, Category = "OculusXR|FaceTracking", meta = (ClampMin = "0.0", ClampMax = "0.1"))
+	float CurveChangeThreshold = 0.0f;
+
+	/**
+	 * Smooths the tracked expression weights with a One Euro filter, before the modifiers.
+	 */
+	UPROPERTY(EditAnywhere, Category = "OculusXR|FaceTracking")
+	bool bFilterExpressions = false;
+
+	UPROPERTY(EditAnywhere, Category = "OculusXR|FaceTracking", meta = (EditCondition = "bFilterExpressions"))
+	FOculusXROneEuroFilterSettings ExpressionFilter;
+
+	/**
+	 * Filter settings of expressions that need their own, e.g. faster eyelids.
+	 */
+	UPROPERTY(EditAnywhere, Category = "OculusXR|FaceTracking", meta = (EditCondition = "bFilterExpressions"))
+	TMap<EOculusXRFaceExpression, FOculusXROneEuroFilterSettings> ExpressionFilterOverrides;
+
+	/**
+	 * Skips curves without any effect at the current LOD: morph targets stripped from the LOD, and curves past the
+	 * MaxLOD of their metadata. Curves that are neither morph targets nor limited by their metadata are always written.
+	 */
+	UPROPERTY(EditAnywhere, Category = "OculusXR|FaceTracking")
+	bool bCullCurvesByLOD = true;
+
 private:
+	// Rebuilds the compiled curves from the retarget asset, ExpressionNames or the default mapping, and ExpressionModifiers
+	void CompileExpressionCurves();
+	// Picks the curves written at the LOD of the bone container, trimmed tables are built once per matrix and mesh LOD
+	void SelectLODCurves(const FBoneContainer& RequiredBones);
+
+	// Expression to curve weights, rows sorted like the curves of a pose so evaluation builds them without any lookup.
+	// Shared with the retarget asset, or with every node using the default mapping
+	TSharedPtr<const FOculusXRFaceRetargetMatrix> CompiledMatrix;
+	bool bIsCompiled = false;
+	// CompiledMatrix without the curves culled at the current LOD, shared by the nodes using the same mesh LOD
+	TSharedPtr<const FOculusXRFaceRetargetMatrix> LODMatrix;
+	TArray<float> CurveValues;
+
+	// What the last evaluation emitted, reused as is while the face state and the curves do not change
+	TArray<float> LastExpressionWeights;
+	TArray<float> EmittedCurveValues;
+	FBlendedHeapCurve EmittedCurves;
+	bool bHasEmittedCurves = false;
+
+	// Expressions without a modifier keep an identity one
+	FOculusXRFaceExpressionModifiers CompiledModifiers;
+	// Expression weights after the filter and the modifiers, the curves read from here
+	TArray<float> ModifiedWeights;
+
+	// One channel per expression when bFilterExpressions is set
+	FOculusXROneEuroFilter CompiledFilter;
+	// Filter steps use the sample times, or the frame time when the provider does not time its samples
+	float LastFaceTime = 0.0f;
+	float PendingDeltaTime = 0.0f;
+
 	USkeletalMeshComponent* SkeletalMeshComponent;
+
+	// Resolved on the game thread in PreUpdate
+	TSharedPtr<IOculusXRMovementDataProvider> DataProvider;
 };
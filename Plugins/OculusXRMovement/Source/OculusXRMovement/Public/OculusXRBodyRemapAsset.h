@@ -0,0 +1,43 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "OculusXRMovementTypes.h"
+#include "OculusXRBodyRemapAsset.generated.h"
+
+/**
+ * Remapping from bone ID to a target skeleton's bone names, shared by every body tracking node retargeting to that
+ * skeleton instead of each anim instance carrying its own copy.
+ */
+UCLASS(BlueprintType)
+class OCULUSXRRETARGETING_API UOculusXRBodyRemapAsset : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UOculusXRBodyRemapAsset();
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement")
+	TMap<EOculusXRBoneID, FName> BoneRemapping;
+
+	// Bumped every time BoneRemapping is edited, nodes compare it to know when to take a new copy of the remapping
+	uint32 GetChangeCount() const { return ChangeCount; }
+
+	// Remapping to the UE5 mannequin, built once and used by every node without a remapping of its own
+	static const TMap<EOculusXRBoneID, FName>& GetDefaultBoneRemapping();
+
+private:
+	uint32 ChangeCount = 0;
+};
@@ -11,6 +11,7 @@ LICENSE file in the root directory of this source tree.
 #include "Animation/AnimNodeBase.h"
 #include "OculusXRLiveLinkRetargetBodyAsset.h"
 #include "OculusXRMovementTypes.h"
+#include "OculusXRMovementDataProvider.h"
 
 UENUM(BlueprintType, meta = (DisplayName = "Retargeting mode"))
 enum class EOculusXRBodyRetargetingMode : uint8
@@ -29,6 +30,35 @@ enum class EOculusXRBodyRetargetingRootMotionBehavior : uint8
 	ZeroOutRootTranslationHipYaw UMETA(DisplayName = "Zero Root Translation with Zero Hip Yaw"),
 };
 
+UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true", DisplayName = "Body Region"))
+enum class EOculusXRBodyRegion : uint8
+{
+	None = 0 UMETA(Hidden),
+	Head = 1 << 0 UMETA(DisplayName = "Head"),
+	UpperBody = 1 << 1 UMETA(DisplayName = "Upper Body"),
+	Hands = 1 << 2 UMETA(DisplayName = "Hands"),
+	Legs = 1 << 3 UMETA(DisplayName = "Legs"),
+	All = Head | UpperBody | Hands | Legs UMETA(Hidden),
+};
+ENUM_CLASS_FLAGS(EOculusXRBodyRegion);
+
+UENUM(BlueprintType, meta = (DisplayName = "Unmapped Subtree mode"))
+enum class EOculusXRBodyUnmappedSubtreeMode : uint8
+{
+	Retarget UMETA(DisplayName = "Retarget Every Bone"),
+	RestPose UMETA(DisplayName = "Freeze To Rest Pose"),
+	InputPose UMETA(DisplayName = "Keep Input Pose"),
+};
+
+UENUM(BlueprintType, meta = (DisplayName = "Fidelity Tier"))
+enum class EOculusXRBodyFidelityTier : uint8
+{
+	Full UMETA(DisplayName = "Full"),
+	NoFingers UMETA(DisplayName = "No Fingers"),
+	CoreOnly UMETA(DisplayName = "Core Only"),
+	Frozen UMETA(DisplayName = "Frozen"),
+};
+
 UENUM(BlueprintType, meta = (DisplayName = "DebugDraw mode"))
 enum class EOculusXRBodyDebugDrawMode : uint8
 {
@@ -50,19 +80,35 @@ class OCULUSXRRETARGETING_API FOculusXRBodyRetargeter
 {
 public:
 	virtual ~FOculusXRBodyRetargeter() = default;
+
+	// Creates the retargeter used by the body tracking node. It only needs a compact pose, so it can also run
+	// without an anim instance (offline conversion on worker threads).
+	static TSharedRef<FOculusXRBodyRetargeter> Create();
+
 	virtual void Initialize(const EOculusXRBodyRetargetingMode RetargetingMode,
 		const EOculusXRBodyRetargetingRootMotionBehavior RootMotionBehavior,
 		const EOculusXRAxis MeshForwardFacingDir,
 		const TMap<EOculusXRBoneID, FName>* SourceToTargetNameMap) = 0;
 
 	virtual bool RetargetFromBodyState(const FOculusXRBodyState& BodyState,
-		const USkeletalMeshComponent* SkeletalMeshComponent,
+		const FTransform& ComponentTransform,
 		const float WorldScale,
-		FPoseContext& Output) = 0;
+		FCompactPose& OutPose) = 0;
 
 	virtual EOculusXRBodyRetargetingMode GetRetargetingMode() = 0;
 	virtual EOculusXRBodyRetargetingRootMotionBehavior GetRootMotionBehavior() = 0;
 
+	virtual void SetUnmappedSubtreeMode(const EOculusXRBodyUnmappedSubtreeMode mode) = 0;
+	virtual void SetRetargetedRegions(const EOculusXRBodyRegion regions) = 0;
+	virtual void SetFidelityTier(const EOculusXRBodyFidelityTier tier) = 0;
+
+	// Source of the body skeleton, the live platform data is used when not set
+	virtual void SetDataProvider(const TSharedPtr<IOculusXRMovementDataProvider>& provider) = 0;
+
+	// Writes a blend of the last two retargeted local poses into the retargeted bones of OutPose, without retargeting.
+	// Returns false if no pose matching the current bone container is cached.
+	virtual bool BlendCachedFrames(const float Alpha, FCompactPose& OutPose) const = 0;
+
 	virtual void SetDebugPoseMode(const EOculusXRBodyDebugPoseMode mode) = 0;
 	virtual void SetDebugDrawMode(const EOculusXRBodyDebugDrawMode mode) = 0;
 
@@ -85,4 +131,81 @@ public:
 	{
 		return boneID == EOculusXRBoneID::BodyRoot || boneID == EOculusXRBoneID::BodyHips;
 	}
+
+	static bool IsFingerSourceJoint(EOculusXRBoneID boneID)
+	{
+		return (boneID > EOculusXRBoneID::BodyLeftHandWrist && boneID <= EOculusXRBoneID::BodyLeftHandLittleTip)
+			|| (boneID > EOculusXRBoneID::BodyRightHandWrist && boneID <= EOculusXRBoneID::BodyRightHandLittleTip);
+	}
+
+	static EOculusXRBodyRegion GetBodyRegion(EOculusXRBoneID boneID)
+	{
+		switch (boneID)
+		{
+			case EOculusXRBoneID::BodyNeck:
+			case EOculusXRBoneID::BodyHead:
+				return EOculusXRBodyRegion::Head;
+			case EOculusXRBoneID::BodyLeftUpperLeg:
+			case EOculusXRBoneID::BodyLeftLowerLeg:
+			case EOculusXRBoneID::BodyLeftFootAnkleTwist:
+			case EOculusXRBoneID::BodyLeftFootAnkle:
+			case EOculusXRBoneID::BodyLeftFootSubtalar:
+			case EOculusXRBoneID::BodyLeftFootTransverse:
+			case EOculusXRBoneID::BodyLeftFootBall:
+			case EOculusXRBoneID::BodyRightUpperLeg:
+			case EOculusXRBoneID::BodyRightLowerLeg:
+			case EOculusXRBoneID::BodyRightFootAnkleTwist:
+			case EOculusXRBoneID::BodyRightFootAnkle:
+			case EOculusXRBoneID::BodyRightFootSubtalar:
+			case EOculusXRBoneID::BodyRightFootTransverse:
+			case EOculusXRBoneID::BodyRightFootBall:
+				return EOculusXRBodyRegion::Legs;
+			default:
+				break;
+		}
+		// Palm, Wrist and every finger joint sit in one contiguous block for both hands
+		if (boneID >= EOculusXRBoneID::BodyLeftHandPalm && boneID <= EOculusXRBoneID::BodyRightHandLittleTip)
+		{
+			return EOculusXRBodyRegion::Hands;
+		}
+		return EOculusXRBodyRegion::UpperBody;
+	}
+
+	// Region of every target joint: mapped joints use the region of their source joint, unmapped joints inherit the
+	// region of their parent. Parents come before their children.
+	static void GetJointRegions(const TArray<EOculusXRBoneID>& SourceJoints, const TArray<int32>& ParentIndices, TArray<EOculusXRBodyRegion>& outRegions)
+	{
+		check(SourceJoints.Num() == ParentIndices.Num());
+		outRegions.SetNumUninitialized(SourceJoints.Num());
+		for (int32 i = 0; i < SourceJoints.Num(); ++i)
+		{
+			if (SourceJoints[i] != EOculusXRBoneID::None)
+			{
+				outRegions[i] = GetBodyRegion(SourceJoints[i]);
+			}
+			else
+			{
+				outRegions[i] = ParentIndices[i] != INDEX_NONE ? outRegions[ParentIndices[i]] : EOculusXRBodyRegion::UpperBody;
+			}
+		}
+	}
+
+	// Joints driven by a finger, the No Fingers tier holds them: mapped finger joints and the unmapped joints that
+	// belong to the finger of their closest mapped ancestor. Parents come before their children.
+	static void GetFingerJoints(const TArray<EOculusXRBoneID>& SourceJoints, const TArray<int32>& ParentIndices, TBitArray<>& outFingerJoints)
+	{
+		check(SourceJoints.Num() == ParentIndices.Num());
+		outFingerJoints.Init(false, SourceJoints.Num());
+		for (int32 i = 0; i < SourceJoints.Num(); ++i)
+		{
+			if (SourceJoints[i] != EOculusXRBoneID::None)
+			{
+				outFingerJoints[i] = IsFingerSourceJoint(SourceJoints[i]);
+			}
+			else if (ParentIndices[i] != INDEX_NONE)
+			{
+				outFingerJoints[i] = outFingerJoints[ParentIndices[i]];
+			}
+		}
+	}
 };
@@ -0,0 +1,164 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OculusXRBodyRetargeter.h"
+#include "OculusXRMovementTypes.h"
+
+class FBitReader;
+class FBitWriter;
+class FOculusXRHandPoseCodec;
+
+struct OCULUSXRRETARGETING_API FOculusXRBodyStateCodecSettings
+{
+	FOculusXRBodyStateCodecSettings();
+
+	// Bits for each of the three smallest quaternion components, per bone id
+	uint8 RotationBits[static_cast<int32>(EOculusXRBoneID::COUNT)];
+
+	// Joint positions are sent relative to the hips, in world units, clamped to +/- PositionRange
+	bool bEncodePositions = true;
+	float PositionPrecision = 0.1f;
+	float PositionRange = 200.0f;
+
+	// Joints the retargeter skips at this tier are not sent, see FOculusXRBodyStateCodec::IsJointSentAtTier
+	EOculusXRBodyFidelityTier FidelityTier = EOculusXRBodyFidelityTier::Full;
+
+	// At the Full tier, finger joints are sent as hand pose coefficients instead of one by one
+	TSharedPtr<const FOculusXRHandPoseCodec> HandPoseCodec;
+	// Scales the hand pose offsets, which are fitted in meters
+	float WorldToMeters = 100.0f;
+
+	void SetRotationBits(const EOculusXRBoneID BoneId, const uint8 Bits) { RotationBits[static_cast<int32>(BoneId)] = Bits; }
+	uint8 GetRotationBits(const EOculusXRBoneID BoneId) const { return RotationBits[static_cast<int32>(BoneId)]; }
+};
+
+struct FOculusXRQuantizedBodyJoint
+{
+	bool bIsValid = false;
+	uint8 LargestComponent = 0;
+	uint32 Rotation[3] = {};
+	uint32 Position[3] = {};
+
+	bool operator==(const FOculusXRQuantizedBodyJoint& Other) const
+	{
+		return bIsValid == Other.bIsValid && LargestComponent == Other.LargestComponent
+			&& Rotation[0] == Other.Rotation[0] && Rotation[1] == Other.Rotation[1] && Rotation[2] == Other.Rotation[2]
+			&& Position[0] == Other.Position[0] && Position[1] == Other.Position[1] && Position[2] == Other.Position[2];
+	}
+};
+
+// Body state as it goes on the wire, joints in the codec's encoded joint order
+struct FOculusXRQuantizedBodyState
+{
+	bool IsActive = false;
+	uint8 Confidence = 0;
+	uint32 SkeletonChangedCount = 0;
+	float Time = 0.0f;
+	FVector3f HipsPosition = FVector3f::ZeroVector;
+	TArray<FOculusXRQuantizedBodyJoint> Joints;
+	// Left then right hand, only with a hand pose codec
+	bool bIsHandValid[2] = {};
+	TArray<uint32> HandCoefficients[2];
+};
+
+/**
+ * Compact wire format for FOculusXRBodyState, for replicating tracked avatars.
+ * Rotations use smallest-three quantization with a bit budget per joint, positions are quantized relative to the hips
+ * with a fixed precision, and joints the receiving skeleton does not map are not sent at all. With a hand pose codec,
+ * the finger joints are sent as a few coefficients per hand in the header.
+ * Sender and receiver must build the codec with the same settings and bone remapping; a layout hash in every packet
+ * rejects packets from a mismatched codec.
+ */
+class OCULUSXRRETARGETING_API FOculusXRBodyStateCodec
+{
+public:
+	// Only joints mapped to a bone in BoneRemapping are encoded (hips and root always are), every joint without a remapping
+	explicit FOculusXRBodyStateCodec(const FOculusXRBodyStateCodecSettings& InSettings, const TMap<EOculusXRBoneID, FName>* BoneRemapping = nullptr);
+
+	void Encode(const FOculusXRBodyState& BodyState, FBitWriter& Writer) const;
+	// Joints that are not encoded are returned invalid
+	bool Decode(FBitReader& Reader, FOculusXRBodyState& outBodyState) const;
+
+	void Quantize(const FOculusXRBodyState& BodyState, FOculusXRQuantizedBodyState& outQuantized) const;
+	void Dequantize(const FOculusXRQuantizedBodyState& Quantized, FOculusXRBodyState& outBodyState) const;
+	// Rebuilds the finger joints from the hand coefficients, after the wrists are dequantized
+	void DequantizeHands(const FOculusXRQuantizedBodyState& Quantized, FOculusXRBodyState& outBodyState) const;
+	void DequantizeJoint(const int32 EncodedJointIndex, const FOculusXRQuantizedBodyJoint& Joint, const FVector& HipsPosition, FQuat& outRotation, FVector& outPosition) const;
+	void Write(const FOculusXRQuantizedBodyState& Quantized, FBitWriter& Writer) const;
+	bool Read(FBitReader& Reader, FOculusXRQuantizedBodyState& outQuantized) const;
+
+	// Header and per joint payloads, used by the delta mode
+	void WriteHeader(const FOculusXRQuantizedBodyState& Quantized, FBitWriter& Writer) const;
+	bool ReadHeader(FBitReader& Reader, FOculusXRQuantizedBodyState& outQuantized) const;
+	void WriteJoint(const int32 EncodedJointIndex, const FOculusXRQuantizedBodyJoint& Joint, FBitWriter& Writer) const;
+	void ReadJoint(const int32 EncodedJointIndex, FBitReader& Reader, FOculusXRQuantizedBodyJoint& outJoint) const;
+
+	// No fingers below Full, only the main chain joints at CoreOnly, only hips and root when Frozen
+	static bool IsJointSentAtTier(const EOculusXRBoneID BoneId, const EOculusXRBodyFidelityTier Tier);
+
+	const FOculusXRBodyStateCodecSettings& GetSettings() const { return Settings; }
+	const TArray<EOculusXRBoneID>& GetEncodedJoints() const { return EncodedJoints; }
+	uint16 GetLayoutHash() const { return LayoutHash; }
+	bool UsesHandPoses() const { return Settings.HandPoseCodec.IsValid() && Settings.FidelityTier == EOculusXRBodyFidelityTier::Full; }
+	// Size of a packet with every encoded joint valid
+	int64 GetMaxEncodedBits() const;
+
+	// Largest quantization error of a valid joint
+	float GetMaxRotationErrorDegrees(const int32 EncodedJointIndex) const;
+	float GetMaxPositionError() const { return Settings.bEncodePositions ? Settings.PositionPrecision * 0.5f * UE_SQRT_3 : 0.0f; }
+
+private:
+	FOculusXRBodyStateCodecSettings Settings;
+	TArray<EOculusXRBoneID> EncodedJoints;
+	// Per encoded joint
+	TArray<uint8> JointRotationBits;
+	int32 HipsJointIndex = INDEX_NONE;
+	int32 PositionBits = 0;
+	uint32 MaxPositionValue = 0;
+	uint16 LayoutHash = 0;
+};
+
+/**
+ * One codec per fidelity tier, so a sender can drop joints for avatars it has little bandwidth for.
+ * Each packet starts with its tier, and the receiver decodes it with the matching reduced joint set.
+ */
+class OCULUSXRRETARGETING_API FOculusXRTieredBodyStateCodec
+{
+public:
+	explicit FOculusXRTieredBodyStateCodec(const FOculusXRBodyStateCodecSettings& InSettings, const TMap<EOculusXRBoneID, FName>* BoneRemapping = nullptr);
+
+	void Encode(const EOculusXRBodyFidelityTier Tier, const FOculusXRBodyState& BodyState, FBitWriter& Writer) const;
+	// Joints not sent at the packet's tier are returned invalid
+	bool Decode(FBitReader& Reader, FOculusXRBodyState& outBodyState, EOculusXRBodyFidelityTier& outTier) const;
+
+	const FOculusXRBodyStateCodec& GetCodec(const EOculusXRBodyFidelityTier Tier) const { return Codecs[static_cast<int32>(Tier)]; }
+	int64 GetMaxEncodedBits(const EOculusXRBodyFidelityTier Tier) const;
+
+private:
+	TArray<FOculusXRBodyStateCodec> Codecs;
+};
+
+// Error of a decoded body state against the original, accumulated over frames
+struct OCULUSXRRETARGETING_API FOculusXRBodyStateCodecErrorStats
+{
+	int32 NumJoints = 0;
+	double SumRotationErrorDegrees = 0.0;
+	double MaxRotationErrorDegrees = 0.0;
+	double SumPositionError = 0.0;
+	double MaxPositionError = 0.0;
+
+	// Only joints valid in both states are compared
+	void Add(const FOculusXRBodyState& Original, const FOculusXRBodyState& Decoded);
+
+	double GetMeanRotationErrorDegrees() const { return NumJoints > 0 ? SumRotationErrorDegrees / NumJoints : 0.0; }
+	double GetMeanPositionError() const { return NumJoints > 0 ? SumPositionError / NumJoints : 0.0; }
+	FString ToString() const;
+};
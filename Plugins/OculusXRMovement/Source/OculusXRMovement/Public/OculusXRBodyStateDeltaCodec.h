@@ -0,0 +1,90 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OculusXRBodyStateCodec.h"
+#include "OculusXRDeltaBaselines.h"
+
+struct OCULUSXRRETARGETING_API FOculusXRBodyStateDeltaSettings
+{
+	FOculusXRBodyStateDeltaSettings();
+
+	// A joint is only sent when it moved more than its error bound away from the baseline, per bone id
+	float RotationErrorDegrees[static_cast<int32>(EOculusXRBoneID::COUNT)];
+	float PositionError[static_cast<int32>(EOculusXRBoneID::COUNT)];
+
+	// Packets between two keyframes, so receivers recover without a request
+	int32 KeyframeInterval = 72;
+	// Sent states kept as possible baselines until acked, a keyframe is sent when the acked baseline got dropped
+	int32 MaxPendingBaselines = 32;
+};
+
+/**
+ * Sender side of the delta mode: every update only carries the joints that moved beyond their error bound since the
+ * last baseline the receiver acknowledged, plus periodic keyframes carrying every joint.
+ * One encoder per receiver, the caller forwards the receiver's acks with Ack.
+ */
+class OCULUSXRRETARGETING_API FOculusXRBodyStateDeltaEncoder
+{
+public:
+	FOculusXRBodyStateDeltaEncoder(const TSharedRef<const FOculusXRBodyStateCodec>& InCodec, const FOculusXRBodyStateDeltaSettings& InSettings = FOculusXRBodyStateDeltaSettings());
+
+	// Returns the sequence number of the packet
+	uint16 Encode(const FOculusXRBodyState& BodyState, FBitWriter& Writer);
+	void Ack(const uint16 Sequence);
+	// Forces the next packet to be a keyframe
+	void Reset();
+
+	bool WasLastPacketKeyframe() const { return bLastPacketKeyframe; }
+	int32 GetLastNumChangedJoints() const { return LastNumChangedJoints; }
+
+private:
+	bool IsJointChanged(const int32 EncodedJointIndex, const FOculusXRQuantizedBodyJoint& Joint, const FVector& HipsPosition, const FOculusXRQuantizedBodyJoint& BaselineJoint, const FVector& BaselineHipsPosition) const;
+
+	TSharedRef<const FOculusXRBodyStateCodec> Codec;
+	FOculusXRBodyStateDeltaSettings Settings;
+	// Per encoded joint
+	TArray<float> JointRotationErrorRadians;
+	TArray<float> JointPositionError;
+
+	TOculusXRDeltaEncoderBaselines<FOculusXRQuantizedBodyState> Baselines;
+	FOculusXRQuantizedBodyState Current;
+
+	bool bLastPacketKeyframe = false;
+	int32 LastNumChangedJoints = 0;
+};
+
+/**
+ * Receiver side of the delta mode. Keeps the states reconstructed from recent packets as baselines, and the converted
+ * joint transforms of the last decoded state so joints a packet does not touch are not dequantized again.
+ * This only saves decode work: the retargeter still converts every joint of the states it reads, which the jitter
+ * buffer interpolates between packets, so unchanged joints cannot be told apart by then.
+ */
+class OCULUSXRRETARGETING_API FOculusXRBodyStateDeltaDecoder
+{
+public:
+	explicit FOculusXRBodyStateDeltaDecoder(const TSharedRef<const FOculusXRBodyStateCodec>& InCodec, const int32 InMaxBaselines = 32);
+
+	// Returns false if the packet is invalid or its baseline is not known (lost or too old), nothing is acked then
+	bool Decode(FBitReader& Reader, FOculusXRBodyState& outBodyState, uint16& outSequence);
+
+	// Number of joints that had to be converted by the last decode
+	int32 GetLastNumConvertedJoints() const { return LastNumConvertedJoints; }
+
+private:
+	TSharedRef<const FOculusXRBodyStateCodec> Codec;
+	TOculusXRDeltaDecoderBaselines<FOculusXRQuantizedBodyState> Baselines;
+
+	// Last decoded state, with the converted orientation and hips relative offset of every joint
+	FOculusXRQuantizedBodyState LastDecoded;
+	TArray<FRotator> CachedOrientations;
+	TArray<FVector> CachedOffsets;
+	int32 LastNumConvertedJoints = 0;
+};
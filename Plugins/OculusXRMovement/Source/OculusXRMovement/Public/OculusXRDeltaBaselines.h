@@ -0,0 +1,158 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+/**
+ * Sequence, ack and baseline bookkeeping shared by the delta codecs. A delta packet starts with its sequence number
+ * and a keyframe bit, followed by the sequence of its baseline when it is not a keyframe.
+ */
+namespace OculusXRDeltaBaselines
+{
+	constexpr int32 kSequenceBits = 16;
+
+	inline void WriteSequence(FBitWriter& Writer, uint16 Sequence)
+	{
+		Writer.SerializeBits(&Sequence, kSequenceBits);
+	}
+
+	inline uint16 ReadSequence(FBitReader& Reader)
+	{
+		uint16 sequence = 0;
+		Reader.SerializeBits(&sequence, kSequenceBits);
+		return sequence;
+	}
+
+	// Sequence numbers wrap around
+	inline bool IsNewerSequence(const uint16 A, const uint16 B)
+	{
+		return static_cast<int16>(A - B) > 0;
+	}
+} // namespace OculusXRDeltaBaselines
+
+// Sender side: numbers the packets, picks keyframes and keeps the sent states until the receiver acks one of them
+template <typename StateType>
+class TOculusXRDeltaEncoderBaselines
+{
+public:
+	TOculusXRDeltaEncoderBaselines(const int32 InKeyframeInterval, const int32 InMaxPendingBaselines)
+		: KeyframeInterval(FMath::Max(InKeyframeInterval, 1))
+		, MaxPendingBaselines(FMath::Max(InMaxPendingBaselines, 1))
+	{
+	}
+
+	// Writes the packet header, returns the baseline the packet is relative to or null for a keyframe
+	const StateType* BeginPacket(FBitWriter& Writer, uint16& outSequence)
+	{
+		outSequence = NextSequence++;
+		const bool bKeyframe = !AckedSequence.IsSet() || PacketsSinceKeyframe + 1 >= KeyframeInterval;
+		OculusXRDeltaBaselines::WriteSequence(Writer, outSequence);
+		Writer.WriteBit(bKeyframe ? 1 : 0);
+		if (bKeyframe)
+		{
+			PacketsSinceKeyframe = 0;
+			return nullptr;
+		}
+		OculusXRDeltaBaselines::WriteSequence(Writer, AckedSequence.GetValue());
+		++PacketsSinceKeyframe;
+		return &AckedBaseline;
+	}
+
+	// Keeps what the receiver reconstructs from the packet, until it is acked
+	void EndPacket(const uint16 Sequence, const StateType& Reconstructed)
+	{
+		if (PendingBaselines.Num() >= MaxPendingBaselines)
+		{
+			// Nothing got acked for a while, the receiver may have lost the baseline, start over from a keyframe
+			PendingBaselines.RemoveAt(0, 1, EAllowShrinking::No);
+			AckedSequence.Reset();
+		}
+		PendingBaselines.Emplace(Sequence, Reconstructed);
+	}
+
+	void Ack(const uint16 Sequence)
+	{
+		// Late acks for packets older than the current baseline are of no use
+		if (AckedSequence.IsSet() && !OculusXRDeltaBaselines::IsNewerSequence(Sequence, AckedSequence.GetValue()))
+		{
+			return;
+		}
+
+		const int32 pendingIdx = PendingBaselines.IndexOfByPredicate([Sequence](const auto& entry) { return entry.Key == Sequence; });
+		if (pendingIdx != INDEX_NONE)
+		{
+			AckedSequence = Sequence;
+			AckedBaseline = MoveTemp(PendingBaselines[pendingIdx].Value);
+			PendingBaselines.RemoveAt(0, pendingIdx + 1, EAllowShrinking::No);
+		}
+	}
+
+	// Forces the next packet to be a keyframe
+	void Reset()
+	{
+		AckedSequence.Reset();
+		PendingBaselines.Reset();
+	}
+
+private:
+	int32 KeyframeInterval = 72;
+	int32 MaxPendingBaselines = 32;
+
+	uint16 NextSequence = 0;
+	int32 PacketsSinceKeyframe = 0;
+	TOptional<uint16> AckedSequence;
+	StateType AckedBaseline;
+	// What the receiver reconstructs from every packet not acked yet
+	TArray<TPair<uint16, StateType>> PendingBaselines;
+};
+
+// Receiver side: keeps the states reconstructed from recent packets as baselines of the next ones
+template <typename StateType>
+class TOculusXRDeltaDecoderBaselines
+{
+public:
+	explicit TOculusXRDeltaDecoderBaselines(const int32 InMaxBaselines)
+		: MaxBaselines(FMath::Max(InMaxBaselines, 1))
+	{
+	}
+
+	// Reads the packet header, returns false if the baseline of a delta packet is not known (lost or too old).
+	// outBaseline is null for a keyframe
+	bool BeginPacket(FBitReader& Reader, uint16& outSequence, const StateType*& outBaseline) const
+	{
+		outSequence = OculusXRDeltaBaselines::ReadSequence(Reader);
+		outBaseline = nullptr;
+		const bool bKeyframe = Reader.ReadBit() != 0;
+		if (bKeyframe)
+		{
+			return true;
+		}
+		const uint16 baselineSequence = OculusXRDeltaBaselines::ReadSequence(Reader);
+		const TPair<uint16, StateType>* baseline = Baselines.FindByPredicate([baselineSequence](const auto& entry) { return entry.Key == baselineSequence; });
+		outBaseline = baseline ? &baseline->Value : nullptr;
+		return outBaseline != nullptr;
+	}
+
+	// Keeps the state decoded from a packet as a baseline, the oldest one is dropped when full
+	void EndPacket(const uint16 Sequence, StateType Decoded)
+	{
+		if (Baselines.Num() >= MaxBaselines)
+		{
+			Baselines.RemoveAt(0, 1, EAllowShrinking::No);
+		}
+		Baselines.Emplace(Sequence, MoveTemp(Decoded));
+	}
+
+private:
+	int32 MaxBaselines = 32;
+	TArray<TPair<uint16, StateType>> Baselines;
+};
@@ -0,0 +1,48 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OculusXRMovementTypes.h"
+
+struct FOculusXRFaceExpressionModifierNew;
+
+/**
+ * Expression modifiers of every expression as aligned structure of arrays, padded to whole SIMD registers.
+ * Expressions without a modifier keep an identity one, so the whole weight vector goes through the same kernel:
+ * the optional response exponent, the multiplier and the clamp, four weights at a time.
+ */
+class OCULUSXRRETARGETING_API FOculusXRFaceExpressionModifiers
+{
+public:
+	explicit FOculusXRFaceExpressionModifiers(const int32 InNumExpressions = static_cast<int32>(EOculusXRFaceExpression::COUNT));
+
+	// Resets every expression to the identity modifier
+	void Reset(const int32 InNumExpressions);
+	void Set(const int32 ExpressionIndex, const FOculusXRFaceExpressionModifierNew& Modifier);
+
+	// Writes the modified weights of the first GetNumExpressions() weights, InWeights and OutWeights may be the same array
+	void Apply(const float* InWeights, float* OutWeights) const;
+	// Reference for a single weight
+	static float Apply(const FOculusXRFaceExpressionModifierNew& Modifier, const float Weight);
+
+	int32 GetNumExpressions() const { return NumExpressions; }
+	bool HasResponse() const { return bHasResponse; }
+
+private:
+	using FAlignedFloats = TArray<float, TAlignedHeapAllocator<16>>;
+
+	int32 NumExpressions = 0;
+	// Skips the response exponent when every expression has a linear response
+	bool bHasResponse = false;
+	FAlignedFloats Exponents;
+	FAlignedFloats Multipliers;
+	FAlignedFloats MinValues;
+	FAlignedFloats MaxValues;
+};
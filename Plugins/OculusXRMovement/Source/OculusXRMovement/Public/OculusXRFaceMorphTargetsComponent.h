@@ -0,0 +1,92 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "AnimNode_OculusXRFaceTracking.h"
+#include "OculusXRFaceExpressionModifiers.h"
+#include "OculusXRFaceRetargetAsset.h"
+#include "OculusXRFaceMorphTargetsComponent.generated.h"
+
+class UMorphTarget;
+class USkeletalMesh;
+class USkinnedMeshComponent;
+
+/**
+ * Writes the rows of a retarget matrix straight into morph target weights, by morph target index.
+ * Indices are resolved once per mesh, rows without a morph target of the same name are not evaluated.
+ */
+class OCULUSXRRETARGETING_API FOculusXRFaceMorphTargetWriter
+{
+public:
+	void Initialize(const FOculusXRFaceRetargetMatrix& InMatrix, const USkeletalMesh* InMesh);
+	// FindMorphTargetIndex returns INDEX_NONE for curves without a morph target
+	void Initialize(const FOculusXRFaceRetargetMatrix& InMatrix, TFunctionRef<int32(FName)> FindMorphTargetIndex);
+
+	// Mixes the expression weights into the weight of every resolved morph target
+	void Write(const float* ExpressionWeights, TArrayView<float> InOutMorphTargetWeights) const;
+	// Also activates the morph targets on the component, which must use the mesh of Initialize
+	void Write(const float* ExpressionWeights, USkinnedMeshComponent& Component) const;
+
+	int32 GetNumMorphTargets() const { return Matrix.GetNumCurves(); }
+	int32 GetMorphTargetIndex(const int32 Row) const { return MorphTargetIndices[Row]; }
+
+private:
+	// Only the rows with a morph target
+	FOculusXRFaceRetargetMatrix Matrix;
+	TArray<int32> MorphTargetIndices;
+	TArray<TObjectPtr<UMorphTarget>> MorphTargets;
+	TWeakObjectPtr<const USkeletalMesh> Mesh;
+	mutable TArray<float> Values;
+};
+
+/**
+ * Drives the morph targets of a skeletal mesh from face tracking without going through animation curves, for meshes
+ * whose expressions map directly onto morph targets. Ticks after the mesh, so its weights replace the ones the
+ * animation wrote for the same morph targets. The mesh needs no face tracking node.
+ */
+UCLASS(ClassGroup = (OculusXR), meta = (BlueprintSpawnableComponent))
+class OCULUSXRRETARGETING_API UOculusXRFaceMorphTargetsComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UOculusXRFaceMorphTargetsComponent();
+
+	/**
+	 * Weighted mapping from expressions to morph targets. Without one, the face tracking node's default names are used.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OculusXR|FaceTracking")
+	TObjectPtr<UOculusXRFaceRetargetAsset> RetargetAsset;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OculusXR|FaceTracking")
+	TMap<EOculusXRFaceExpression, FOculusXRFaceExpressionModifierNew> ExpressionModifiers;
+
+	// Defaults to the first skeletal mesh of the owner
+	UFUNCTION(BlueprintCallable, Category = "OculusXR|FaceTracking")
+	void SetTargetMesh(USkeletalMeshComponent* InTargetMesh);
+
+	// Resolves the morph targets again, after changing the retarget asset, the modifiers or the mesh asset
+	UFUNCTION(BlueprintCallable, Category = "OculusXR|FaceTracking")
+	void Recompile();
+
+	virtual void BeginPlay() override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+	UPROPERTY(Transient)
+	TObjectPtr<USkeletalMeshComponent> TargetMesh;
+
+	TWeakObjectPtr<const USkeletalMesh> CompiledMesh;
+	FOculusXRFaceExpressionModifiers CompiledModifiers;
+	FOculusXRFaceMorphTargetWriter Writer;
+	FOculusXRFaceState FaceState;
+	TArray<float> ModifiedWeights;
+};
@@ -0,0 +1,136 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "OculusXRMovementTypes.h"
+#include "OculusXRFaceRetargetAsset.generated.h"
+
+struct FOculusXRExpressionCurves;
+class USkeleton;
+
+USTRUCT(BlueprintType)
+struct OCULUSXRRETARGETING_API FOculusXRFaceRetargetWeight
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement")
+	EOculusXRFaceExpression Expression = EOculusXRFaceExpression::JawDrop;
+
+	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement")
+	float Weight = 1.0f;
+};
+
+USTRUCT(BlueprintType)
+struct OCULUSXRRETARGETING_API FOculusXRFaceRetargetCurve
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement")
+	FName CurveName;
+
+	// The curve is the weighted sum of these expressions
+	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement")
+	TArray<FOculusXRFaceRetargetWeight> Expressions;
+};
+
+/**
+ * Expression to curve weights in compressed sparse row form, one row per curve.
+ * Rows are sorted like the curves of a pose, so the evaluated values can be turned into curves in a single pass.
+ * Binary layout: versioned header, curve names, then the row offsets, columns and values as bulk arrays.
+ */
+struct OCULUSXRRETARGETING_API FOculusXRFaceRetargetMatrix
+{
+	static constexpr uint32 kMagic = 0x52465846; // "FXFR"
+	static constexpr uint32 kCurrentVersion = 1;
+
+	TArray<FName> CurveNames;
+	// Row r spans [RowOffsets[r], RowOffsets[r + 1]) of Columns and Values
+	TArray<int32> RowOffsets;
+	TArray<int32> Columns;
+	TArray<float> Values;
+	bool bClampOutput = true;
+
+	// Rows with the same curve name are summed, as are repeated expressions within a row
+	static FOculusXRFaceRetargetMatrix Build(TArrayView<const FOculusXRFaceRetargetCurve> Curves, const bool bClampOutput);
+	// One row per curve name with a weight of 1, a curve listed by several expressions takes the last one
+	static FOculusXRFaceRetargetMatrix Build(const TMap<EOculusXRFaceExpression, FOculusXRExpressionCurves>& ExpressionNames);
+
+	// Writes one value per curve, Weights has one weight per expression
+	void Multiply(const float* Weights, float* OutCurveValues) const;
+	// The rows of the curves to keep, still sorted
+	FOculusXRFaceRetargetMatrix Trim(TFunctionRef<bool(FName)> KeepCurve) const;
+
+	// Returns false, with an empty matrix, if the data is not a matrix of a supported version. The archive is left
+	// without an error, loaded rows are sorted again for this process.
+	bool Serialize(FArchive& Ar);
+	// Whether the rows are in the order pose curves are built in
+	bool AreRowsSorted() const;
+
+	// Target curves no row writes, and rows whose curve is not a target curve
+	void FindCoverage(TConstArrayView<FName> TargetCurveNames, TArray<FName>& OutUncoveredCurves, TArray<FName>& OutUnknownCurves) const;
+
+	int32 GetNumCurves() const { return CurveNames.Num(); }
+	int32 GetNumNonZeros() const { return Values.Num(); }
+	// Number of expressions the weight vector must hold
+	int32 GetNumExpressions() const { return NumExpressions; }
+
+private:
+	int32 NumExpressions = 0;
+};
+
+/**
+ * Weighted many to many mapping from the tracked expressions to the curves of a face rig, such as ARKit blendshapes or
+ * MetaHuman controls. Replaces ExpressionNames on the face tracking node, evaluated as a sparse matrix-vector product.
+ */
+UCLASS(BlueprintType)
+class OCULUSXRRETARGETING_API UOculusXRFaceRetargetAsset : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement")
+	TArray<FOculusXRFaceRetargetCurve> Curves;
+
+	// Clamps every curve to [0, 1] after mixing
+	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement")
+	bool bClampOutput = true;
+
+#if WITH_EDITORONLY_DATA
+	/**
+	 * Skeleton whose curves the mapping should cover, checked by data validation.
+	 */
+	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement")
+	TObjectPtr<USkeleton> TargetSkeleton;
+#endif
+
+	// The compiled matrix is saved with the asset, loading it needs no compile
+	virtual void Serialize(FArchive& Ar) override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual EDataValidationResult IsDataValid(FDataValidationContext& Context) const override;
+#endif
+
+	// Compiled when edited, call CompileMatrix after changing Curves at runtime
+	const FOculusXRFaceRetargetMatrix& GetMatrix() const { return *Matrix; }
+	// Nodes keep the matrix they compiled with, a recompile leaves it untouched
+	TSharedRef<const FOculusXRFaceRetargetMatrix> GetSharedMatrix() const { return Matrix; }
+	void CompileMatrix();
+
+	// Mapping to the ARKit-named blendshapes, used by every face tracking node without a mapping of its own
+	static const TMap<EOculusXRFaceExpression, FOculusXRExpressionCurves>& GetDefaultExpressionNames();
+	// GetDefaultExpressionNames compiled once, shared by all those nodes
+	static TSharedRef<const FOculusXRFaceRetargetMatrix> GetDefaultMatrix();
+
+private:
+	TSharedRef<const FOculusXRFaceRetargetMatrix> Matrix = MakeShared<FOculusXRFaceRetargetMatrix>();
+	bool bIsMatrixLoaded = false;
+};
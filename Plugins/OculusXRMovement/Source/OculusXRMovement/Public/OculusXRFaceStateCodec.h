@@ -0,0 +1,185 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OculusXRDeltaBaselines.h"
+#include "OculusXRMovementTypes.h"
+
+class FBitReader;
+class FBitWriter;
+struct FOculusXRMovementRecording;
+
+// Principal components of the expression weights
+struct OCULUSXRRETARGETING_API FOculusXRFaceExpressionBasis
+{
+	// One float per expression
+	TArray<float> Mean;
+	// NumComponents rows of one float per expression, by decreasing variance
+	TArray<float> Components;
+	// Coefficients are quantized within +/- this range, per component
+	TArray<float> Ranges;
+	// Share of the fitted variance the components explain
+	float ExplainedVariance = 0.0f;
+
+	int32 GetNumComponents() const { return Ranges.Num(); }
+	bool IsValid() const;
+	void Serialize(FArchive& Ar);
+};
+
+// Accumulates expression weights from tracked sessions, then fits a basis
+class OCULUSXRRETARGETING_API FOculusXRFaceExpressionBasisFitter
+{
+public:
+	void AddFaceState(const FOculusXRFaceState& FaceState);
+	void AddRecording(const FOculusXRMovementRecording& Recording);
+
+	int32 GetNumSamples() const;
+	// Keeps the fewest components explaining MinExplainedVariance, at most MaxComponents
+	bool Fit(const int32 MaxComponents, const float MinExplainedVariance, FOculusXRFaceExpressionBasis& outBasis) const;
+
+private:
+	TArray<float> Samples;
+};
+
+struct OCULUSXRRETARGETING_API FOculusXRFaceStateCodecSettings
+{
+	// Bits of a weight, or of a coefficient with a basis
+	int32 WeightBits = 8;
+	// Weights below this are sent as zero, with a single bit
+	float ZeroThreshold = 0.01f;
+	// Sends the weights as coefficients of this basis instead of one by one
+	TSharedPtr<const FOculusXRFaceExpressionBasis> Basis;
+};
+
+// Face state as it goes on the wire
+struct FOculusXRQuantizedFaceState
+{
+	bool bIsValid = false;
+	bool bIsEyeFollowingBlendshapesValid = false;
+	float Time = 0.0f;
+	TArray<uint8> Confidences;
+	// One per expression, or one per basis component
+	TArray<uint32> Values;
+};
+
+/**
+ * Compact wire format for FOculusXRFaceState, for replicating tracked avatars.
+ * Most expression weights sit near zero most of the time: every weight starts with a zero bit, and only non zero weights
+ * are followed by their quantized value. With a basis, the weights are sent as a few quantized PCA coefficients instead.
+ * Sender and receiver must build the codec with the same settings; a layout hash in every packet rejects packets from a
+ * mismatched codec.
+ */
+class OCULUSXRRETARGETING_API FOculusXRFaceStateCodec
+{
+public:
+	explicit FOculusXRFaceStateCodec(const FOculusXRFaceStateCodecSettings& InSettings = FOculusXRFaceStateCodecSettings());
+
+	void Encode(const FOculusXRFaceState& FaceState, FBitWriter& Writer) const;
+	bool Decode(FBitReader& Reader, FOculusXRFaceState& outFaceState) const;
+
+	void Quantize(const FOculusXRFaceState& FaceState, FOculusXRQuantizedFaceState& outQuantized) const;
+	// Writes the weights in place, the array the face node reads is only reallocated when its size changes
+	void Dequantize(const FOculusXRQuantizedFaceState& Quantized, FOculusXRFaceState& outFaceState) const;
+	void Write(const FOculusXRQuantizedFaceState& Quantized, FBitWriter& Writer) const;
+	bool Read(FBitReader& Reader, FOculusXRQuantizedFaceState& outQuantized) const;
+
+	// Header and per value payloads, used by the delta mode
+	void WriteHeader(const FOculusXRQuantizedFaceState& Quantized, FBitWriter& Writer) const;
+	bool ReadHeader(FBitReader& Reader, FOculusXRQuantizedFaceState& outQuantized) const;
+	void WriteValue(const uint32 Value, FBitWriter& Writer) const;
+	uint32 ReadValue(FBitReader& Reader) const;
+
+	const FOculusXRFaceStateCodecSettings& GetSettings() const { return Settings; }
+	bool UsesBasis() const { return Settings.Basis.IsValid(); }
+	int32 GetNumValues() const { return NumValues; }
+	uint16 GetLayoutHash() const { return LayoutHash; }
+	// Size of a packet with every weight non zero
+	int64 GetMaxEncodedBits() const;
+	// Largest error of a decoded weight, without a basis
+	float GetMaxWeightError() const;
+	// Size of one quantization step of a weight
+	float GetWeightStep() const { return 1.0f / MaxValue; }
+
+private:
+	FOculusXRFaceStateCodecSettings Settings;
+	int32 NumValues = 0;
+	uint32 MaxValue = 0;
+	uint16 LayoutHash = 0;
+};
+
+struct OCULUSXRRETARGETING_API FOculusXRFaceStateDeltaSettings
+{
+	// A value is only sent when it moved more than this many quantization steps away from the baseline
+	int32 DeadbandSteps = 1;
+	// Packets between two keyframes, so receivers recover without a request
+	int32 KeyframeInterval = 72;
+	// Sent states kept as possible baselines until acked, a keyframe is sent when the acked baseline got dropped
+	int32 MaxPendingBaselines = 32;
+};
+
+/**
+ * Sender side of the face delta mode: every update only carries the values that moved beyond the dead band since the
+ * last baseline the receiver acknowledged, plus periodic keyframes carrying every value.
+ * One encoder per receiver, the caller forwards the receiver's acks with Ack.
+ */
+class OCULUSXRRETARGETING_API FOculusXRFaceStateDeltaEncoder
+{
+public:
+	FOculusXRFaceStateDeltaEncoder(const TSharedRef<const FOculusXRFaceStateCodec>& InCodec, const FOculusXRFaceStateDeltaSettings& InSettings = FOculusXRFaceStateDeltaSettings());
+
+	// Returns the sequence number of the packet
+	uint16 Encode(const FOculusXRFaceState& FaceState, FBitWriter& Writer);
+	void Ack(const uint16 Sequence);
+	// Forces the next packet to be a keyframe
+	void Reset();
+
+	bool WasLastPacketKeyframe() const { return bLastPacketKeyframe; }
+	int32 GetLastNumChangedValues() const { return LastNumChangedValues; }
+	// Largest error of a decoded weight, without a basis
+	float GetMaxWeightError() const { return Codec->GetMaxWeightError() + Settings.DeadbandSteps * Codec->GetWeightStep(); }
+
+private:
+	TSharedRef<const FOculusXRFaceStateCodec> Codec;
+	FOculusXRFaceStateDeltaSettings Settings;
+
+	TOculusXRDeltaEncoderBaselines<FOculusXRQuantizedFaceState> Baselines;
+	FOculusXRQuantizedFaceState Current;
+
+	bool bLastPacketKeyframe = false;
+	int32 LastNumChangedValues = 0;
+};
+
+// Receiver side of the face delta mode, keeps the states reconstructed from recent packets as baselines
+class OCULUSXRRETARGETING_API FOculusXRFaceStateDeltaDecoder
+{
+public:
+	explicit FOculusXRFaceStateDeltaDecoder(const TSharedRef<const FOculusXRFaceStateCodec>& InCodec, const int32 InMaxBaselines = 32);
+
+	// Returns false if the packet is invalid or its baseline is not known (lost or too old), nothing is acked then
+	bool Decode(FBitReader& Reader, FOculusXRFaceState& outFaceState, uint16& outSequence);
+
+private:
+	TSharedRef<const FOculusXRFaceStateCodec> Codec;
+	TOculusXRDeltaDecoderBaselines<FOculusXRQuantizedFaceState> Baselines;
+};
+
+// Error of decoded expression weights against the original, accumulated over frames
+struct OCULUSXRRETARGETING_API FOculusXRFaceStateCodecErrorStats
+{
+	int32 NumWeights = 0;
+	double SumWeightError = 0.0;
+	double MaxWeightError = 0.0;
+
+	// Only frames valid in both states are compared
+	void Add(const FOculusXRFaceState& Original, const FOculusXRFaceState& Decoded);
+
+	double GetMeanWeightError() const { return NumWeights > 0 ? SumWeightError / NumWeights : 0.0; }
+	FString ToString() const;
+};
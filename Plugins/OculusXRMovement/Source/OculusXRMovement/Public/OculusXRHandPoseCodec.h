@@ -0,0 +1,93 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OculusXRMovementTypes.h"
+
+class FBitReader;
+class FBitWriter;
+struct FOculusXRMovementRecording;
+
+// Principal components of the finger poses of one hand
+struct OCULUSXRRETARGETING_API FOculusXRHandPoseBasis
+{
+	// Mean rotation vector of every finger joint relative to its parent, 3 floats per joint
+	TArray<float> Mean;
+	// NumComponents rows of NumFeatures floats, by decreasing variance
+	TArray<float> Components;
+	// Coefficients are quantized within +/- this range, per component
+	TArray<float> Ranges;
+	// Mean offset of every finger joint from its parent, in the parent's frame, in meters
+	TArray<FVector3f> Offsets;
+	// Share of the fitted variance the components explain
+	float ExplainedVariance = 0.0f;
+
+	int32 GetNumComponents() const { return Ranges.Num(); }
+	bool IsValid() const;
+	void Serialize(FArchive& Ar);
+};
+
+// Accumulates finger poses from tracked sessions, then fits a basis for each hand
+class OCULUSXRRETARGETING_API FOculusXRHandPoseBasisFitter
+{
+public:
+	void AddBodyState(const FOculusXRBodyState& BodyState, const float WorldToMeters);
+	void AddRecording(const FOculusXRMovementRecording& Recording);
+
+	int32 GetNumSamples(const int32 Hand) const;
+	// Keeps the fewest components explaining MinExplainedVariance, at most MaxComponents
+	bool Fit(const int32 Hand, const int32 MaxComponents, const float MinExplainedVariance, FOculusXRHandPoseBasis& outBasis) const;
+
+private:
+	TArray<float> Samples[2];
+	TArray<FVector3f> OffsetSums[2];
+};
+
+/**
+ * Low dimensional codec for the finger joints of kALIGNABLE_HAND_JOINTS.
+ * Finger rotations relative to their parent are highly correlated, so a hand pose is sent as a few PCA coefficients
+ * instead of 24 joints, and decoded with a single matrix-vector product followed by forward kinematics from the wrist.
+ * Bases are fitted offline with FOculusXRHandPoseBasisFitter and saved with the content.
+ */
+class OCULUSXRRETARGETING_API FOculusXRHandPoseCodec
+{
+public:
+	static constexpr int32 kNumHandJoints = 24;
+	static constexpr int32 kNumFeatures = kNumHandJoints * 3;
+
+	// Hand 0 is the left hand, 1 the right hand
+	FOculusXRHandPoseCodec(const FOculusXRHandPoseBasis& InLeftBasis, const FOculusXRHandPoseBasis& InRightBasis, const int32 InCoefficientBits = 10);
+
+	static TConstArrayView<EOculusXRBoneID> GetHandJoints(const int32 Hand);
+	static EOculusXRBoneID GetWristJoint(const int32 Hand);
+	// Index of the parent within the hand joints, INDEX_NONE for joints parented to the wrist
+	static int32 GetParentIndex(const int32 HandJointIndex);
+	// Rotation vectors of the hand joints relative to their parent, false if a joint of the hand is invalid
+	static bool ComputeFeatures(const FOculusXRBodyState& BodyState, const int32 Hand, float* outFeatures);
+
+	// Returns false if the hand is not tracked
+	bool Encode(const FOculusXRBodyState& BodyState, const int32 Hand, TArray<uint32>& outCoefficients) const;
+	// Rebuilds the hand joints from the wrist of the body state, positions use the basis offsets
+	bool Decode(const TArray<uint32>& Coefficients, const int32 Hand, const float WorldToMeters, FOculusXRBodyState& inOutBodyState) const;
+
+	void WriteCoefficients(const TArray<uint32>& Coefficients, FBitWriter& Writer) const;
+	void ReadCoefficients(FBitReader& Reader, TArray<uint32>& outCoefficients, const int32 Hand) const;
+
+	const FOculusXRHandPoseBasis& GetBasis(const int32 Hand) const { return Bases[Hand]; }
+	int32 GetCoefficientBits() const { return CoefficientBits; }
+	int64 GetEncodedBits(const int32 Hand) const { return static_cast<int64>(Bases[Hand].GetNumComponents()) * CoefficientBits; }
+	// Identifies the bases and bit count, part of the body codec layout hash
+	uint32 GetHash() const { return Hash; }
+
+private:
+	FOculusXRHandPoseBasis Bases[2];
+	int32 CoefficientBits = 10;
+	uint32 Hash = 0;
+};
@@ -0,0 +1,72 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OculusXRMovementTypes.h"
+#include "UObject/ObjectKey.h"
+
+class USkeletalMeshComponent;
+
+/**
+ * Source of body, face and eye tracking data for the movement anim nodes.
+ * The live provider forwards to the OculusXRMovement platform calls, other providers replay or synthesize data
+ * so the nodes can run without an XR system (headless benchmarks, automation tests).
+ * Getters are called from animation worker threads.
+ */
+class OCULUSXRRETARGETING_API IOculusXRMovementDataProvider
+{
+public:
+	virtual ~IOculusXRMovementDataProvider() = default;
+
+	virtual bool IsAvailable() const = 0;
+
+	virtual bool GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters) = 0;
+	virtual bool GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters) = 0;
+	virtual bool GetFaceState(FOculusXRFaceState& outFaceState) = 0;
+	virtual bool GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters) = 0;
+};
+
+// Forwards to the OculusXRMovement platform functions
+class OCULUSXRRETARGETING_API FOculusXRLiveMovementDataProvider : public IOculusXRMovementDataProvider
+{
+public:
+	// This animation node is executed during the packaging step.
+	// During that time, the MetaXR plugin is not available and any calls to it will crash the editor,
+	// so it is only considered available once the XR system is loaded.
+	virtual bool IsAvailable() const override;
+
+	virtual bool GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters) override;
+	virtual bool GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters) override;
+	virtual bool GetFaceState(FOculusXRFaceState& outFaceState) override;
+	virtual bool GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters) override;
+};
+
+/**
+ * Chooses the provider each movement anim node reads from.
+ * A provider registered for a skeletal mesh component wins over the default provider, which wins over the live provider.
+ * Resolved on the game thread in PreUpdate.
+ */
+class OCULUSXRRETARGETING_API FOculusXRMovementDataProviderRegistry
+{
+public:
+	static TSharedRef<IOculusXRMovementDataProvider> GetLiveProvider();
+
+	// Pass nullptr to go back to the live provider
+	static void SetDefaultProvider(const TSharedPtr<IOculusXRMovementDataProvider>& Provider);
+	// Pass nullptr to remove the component override
+	static void SetProviderForComponent(const USkeletalMeshComponent* Component, const TSharedPtr<IOculusXRMovementDataProvider>& Provider);
+
+	static TSharedRef<IOculusXRMovementDataProvider> FindProvider(const USkeletalMeshComponent* Component);
+
+private:
+	static FCriticalSection ProvidersLock;
+	static TSharedPtr<IOculusXRMovementDataProvider> DefaultProvider;
+	static TMap<TObjectKey<USkeletalMeshComponent>, TSharedPtr<IOculusXRMovementDataProvider>> ComponentProviders;
+};
@@ -0,0 +1,106 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OculusXRMovementDataProvider.h"
+
+struct OCULUSXRRETARGETING_API FOculusXRMovementJitterBufferSettings
+{
+	// Playout delay on top of the average transit time, adapted to the measured jitter within these bounds (seconds)
+	float MinDelay = 0.03f;
+	float MaxDelay = 0.25f;
+	float JitterMultiplier = 2.5f;
+
+	// How far past the newest sample the stream is extrapolated before it holds (seconds), at most one sample interval
+	float MaxExtrapolation = 0.1f;
+	// Playout clock drift allowed to catch up with a changed delay, as a fraction of real time
+	float MaxTimeScaleCorrection = 0.1f;
+	// Samples kept per stream
+	int32 MaxSamples = 64;
+};
+
+/**
+ * Per avatar buffer for tracking streams received over the network.
+ * Samples are pushed as they arrive, in any order, and are played out behind the sender with a delay adapted to the
+ * measured jitter. Update advances the playout clock once per rendered frame on the game thread; the nodes then read
+ * one state interpolated at that time through the provider interface, whatever the packet arrivals were.
+ * Register it for the remote avatar's mesh with FOculusXRMovementDataProviderRegistry::SetProviderForComponent.
+ */
+class OCULUSXRRETARGETING_API FOculusXRMovementJitterBuffer : public IOculusXRMovementDataProvider
+{
+public:
+	explicit FOculusXRMovementJitterBuffer(const FOculusXRMovementJitterBufferSettings& InSettings = FOculusXRMovementJitterBufferSettings());
+
+	// SendTime is the sender's clock, ArrivalTime the local clock Update is called with
+	void PushBodyState(const FOculusXRBodyState& BodyState, const double SendTime, const double ArrivalTime, const float WorldToMeters);
+	void PushFaceState(const FOculusXRFaceState& FaceState, const double SendTime, const double ArrivalTime);
+	void PushEyeGazesState(const FOculusXREyeGazesState& EyeGazesState, const double SendTime, const double ArrivalTime, const float WorldToMeters);
+	// Skeletons only change on calibration, they are expected on a reliable channel and apply immediately
+	void SetBodySkeleton(const FOculusXRBodySkeleton& BodySkeleton, const float WorldToMeters);
+
+	void Update(const double LocalTime);
+	void Reset();
+
+	// Sender time the streams are currently played at
+	double GetPlaybackTime() const;
+	float GetDelay() const;
+	// Samples that arrived after their time was played, or duplicates
+	int32 GetNumLateSamples() const;
+	int32 GetNumExtrapolatedUpdates() const;
+
+	virtual bool IsAvailable() const override { return true; }
+	virtual bool GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters) override;
+	virtual bool GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters) override;
+	virtual bool GetFaceState(FOculusXRFaceState& outFaceState) override;
+	virtual bool GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters) override;
+
+private:
+	template <typename StateType>
+	struct TStream
+	{
+		// Sorted by send time
+		TArray<TPair<double, StateType>> Samples;
+		float WorldToMeters = 100.0f;
+
+		// Evaluated once per update
+		StateType Evaluated;
+		bool bEvaluated = false;
+		bool bEvaluatedValid = false;
+	};
+
+	template <typename StateType>
+	void PushSample(TStream<StateType>& Stream, const StateType& State, const double SendTime, const double ArrivalTime);
+	template <typename StateType>
+	void Evaluate(TStream<StateType>& Stream);
+	template <typename StateType>
+	void Prune(TStream<StateType>& Stream);
+
+	FOculusXRMovementJitterBufferSettings Settings;
+	mutable FCriticalSection Lock;
+
+	TStream<FOculusXRBodyState> Body;
+	TStream<FOculusXRFaceState> Face;
+	TStream<FOculusXREyeGazesState> EyeGazes;
+	FOculusXRBodySkeleton BodySkeleton;
+	float BodySkeletonWorldToMeters = 100.0f;
+	bool bHasBodySkeleton = false;
+
+	// Transit time (arrival minus send time, including the clock offset) and its jitter, as in RFC 3550
+	bool bHasTransit = false;
+	double Transit = 0.0;
+	double LastTransit = 0.0;
+	double Jitter = 0.0;
+
+	bool bIsPlaying = false;
+	double LastLocalTime = 0.0;
+	double PlaybackTime = 0.0;
+	int32 NumLateSamples = 0;
+	int32 NumExtrapolatedUpdates = 0;
+};
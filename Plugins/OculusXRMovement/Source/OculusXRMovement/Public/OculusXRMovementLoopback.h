@@ -0,0 +1,70 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "OculusXRMovementDataProvider.h"
+
+class FOculusXRMovementJitterBuffer;
+
+struct OCULUSXRRETARGETING_API FOculusXRMovementLoopbackSettings
+{
+	int32 Seed = 0;
+	// One way latency, each packet gets up to Jitter more (seconds)
+	float Latency = 0.08f;
+	float Jitter = 0.03f;
+	// Probability for a packet to be lost
+	float LossProbability = 0.0f;
+	// Probability for a packet to be held back by ReorderDelay, so later packets overtake it
+	float ReorderProbability = 0.0f;
+	float ReorderDelay = 0.05f;
+};
+
+/**
+ * Simulated network between a local provider and a remote avatar's jitter buffer, to test and tune remote playback
+ * without a network. Send samples the source as the sending client would, Deliver pushes the packets that arrived
+ * by the given time to the jitter buffer. Both use the same clock, the jitter buffer does not rely on it.
+ */
+class OCULUSXRRETARGETING_API FOculusXRMovementLoopback
+{
+public:
+	FOculusXRMovementLoopback(const TSharedRef<IOculusXRMovementDataProvider>& InSource, const TSharedRef<FOculusXRMovementJitterBuffer>& InReceiver, const FOculusXRMovementLoopbackSettings& InSettings = FOculusXRMovementLoopbackSettings());
+
+	void Send(const double SendTime, const float WorldToMeters);
+	void Deliver(const double LocalTime);
+
+	int32 GetNumSent() const { return NumSent; }
+	int32 GetNumLost() const { return NumLost; }
+	// Packets delivered after a packet sent later
+	int32 GetNumReordered() const { return NumReordered; }
+
+private:
+	struct FPacket
+	{
+		double SendTime = 0.0;
+		double ArrivalTime = 0.0;
+		float WorldToMeters = 100.0f;
+		TOptional<FOculusXRBodyState> BodyState;
+		TOptional<FOculusXRFaceState> FaceState;
+		TOptional<FOculusXREyeGazesState> EyeGazesState;
+	};
+
+	TSharedRef<IOculusXRMovementDataProvider> Source;
+	TSharedRef<FOculusXRMovementJitterBuffer> Receiver;
+	FOculusXRMovementLoopbackSettings Settings;
+	FRandomStream Random;
+
+	TArray<FPacket> InFlight;
+	int32 LastSkeletonChangedCount = INDEX_NONE;
+	double LastDeliveredSendTime = -UE_DOUBLE_BIG_NUMBER;
+	int32 NumSent = 0;
+	int32 NumLost = 0;
+	int32 NumReordered = 0;
+};
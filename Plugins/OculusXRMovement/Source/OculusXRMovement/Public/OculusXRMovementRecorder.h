@@ -0,0 +1,106 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OculusXRMovementDataProvider.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+struct FOculusXRMovementRecording;
+
+struct FOculusXRMovementRecorderSettings
+{
+	// Size of every capture chunk in bytes, a frame never spans two chunks
+	int32 ChunkSize = 256 * 1024;
+	// Capture memory is bounded to NumChunks * ChunkSize, frames are dropped while every chunk waits for the disk
+	int32 NumChunks = 16;
+	// Compress chunks on the writer thread before they are written
+	bool bCompress = true;
+};
+
+/**
+ * Forwards to another provider and streams every new frame it returns to disk.
+ * Capturing only encodes the frame and copies it into a preallocated chunk, full chunks are compressed and written
+ * by a background thread. When the disk falls behind and no chunk is free, frames are dropped and counted instead of
+ * stalling the calling thread.
+ * The stream is read back with LoadStream, and can be saved as an indexed recording for mapped playback.
+ */
+class OCULUSXRRETARGETING_API FOculusXRAsyncMovementRecorder : public IOculusXRMovementDataProvider
+{
+public:
+	static constexpr uint32 kStreamMagic = 0x534D584F; // "OXMS"
+	static constexpr uint32 kStreamVersion = 1;
+
+	FOculusXRAsyncMovementRecorder(const TSharedRef<IOculusXRMovementDataProvider>& InSource, const FString& InFilename, const FOculusXRMovementRecorderSettings& InSettings = FOculusXRMovementRecorderSettings());
+	virtual ~FOculusXRAsyncMovementRecorder();
+
+	bool IsRecording() const { return bIsRecording.load(std::memory_order_relaxed); }
+	// Writes the captured frames and closes the file, blocks until the writer thread is done
+	void Stop();
+
+	uint32 GetNumDroppedFrames() const { return NumDroppedFrames.load(std::memory_order_relaxed); }
+	// Captured bytes not written to disk yet
+	int64 GetBacklogBytes() const { return BacklogBytes.load(std::memory_order_relaxed); }
+
+	static bool LoadStream(const FString& Filename, FOculusXRMovementRecording& outRecording);
+
+	virtual bool IsAvailable() const override;
+	virtual bool GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters) override;
+	virtual bool GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters) override;
+	virtual bool GetFaceState(FOculusXRFaceState& outFaceState) override;
+	virtual bool GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters) override;
+
+private:
+	enum class ERecordType : uint8
+	{
+		BodySkeleton,
+		Body,
+		Face,
+		Eye,
+	};
+
+	struct FChunk
+	{
+		TArray<uint8> Data;
+		int32 Size = 0;
+	};
+
+	class FWriter;
+
+	// Returns false if the frame was already captured
+	bool BeginCapture(const ERecordType Type, const float StateTime, double& outTimestamp);
+	void Capture(const TArray<uint8>& Record);
+	// Hands the current chunk over to the writer, the caller holds CaptureLock
+	void SubmitCurrentChunk();
+	void ReleaseChunk(FChunk* Chunk);
+	void UpdateStats() const;
+
+	TSharedRef<IOculusXRMovementDataProvider> Source;
+	FOculusXRMovementRecorderSettings Settings;
+	std::atomic<bool> bIsRecording = false;
+
+	FCriticalSection CaptureLock;
+	TArray<TUniquePtr<FChunk>> Chunks;
+	TArray<FChunk*> FreeChunks;
+	FChunk* CurrentChunk = nullptr;
+	TOptional<float> FirstStateTime;
+	float LastBodyTime = -1.0f;
+	float LastFaceTime = -1.0f;
+	float LastEyeTime = -1.0f;
+	// Skeletons have no time, one is captured whenever the body states report a new SkeletonChangedCount
+	std::atomic<int32> BodySkeletonChangedCount = INDEX_NONE;
+	TOptional<int32> CapturedSkeletonChangedCount;
+
+	TQueue<FChunk*, EQueueMode::Mpsc> PendingChunks;
+	std::atomic<uint32> NumDroppedFrames = 0;
+	std::atomic<int64> BacklogBytes = 0;
+
+	TUniquePtr<FWriter> Writer;
+};
@@ -0,0 +1,234 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/MappedFileHandle.h"
+#include "OculusXRMovementDataProvider.h"
+#include <atomic>
+
+/**
+ * A recorded body/face/eye tracking session.
+ * Binary layout: versioned header, source body skeleton, then the timestamped body, face and eye frames.
+ * Since version 2 the frames are followed by a frame index and a fixed size footer, so a reader can seek
+ * without parsing the file (see FOculusXRMappedMovementRecording).
+ * Positions are stored in the world scale they were captured with and rescaled on playback.
+ */
+struct OCULUSXRRETARGETING_API FOculusXRMovementRecording
+{
+	static constexpr uint32 kMagic = 0x524D584F;	  // "OXMR"
+	static constexpr uint32 kIndexMagic = 0x584D584F; // "OXMX"
+	static constexpr uint32 kCurrentVersion = 2;
+
+	// Stored for every frame of every stream after the frames, 8 byte aligned
+	struct FFrameIndexEntry
+	{
+		double Timestamp = 0.0;
+		// From the start of the recording to the frame's timestamp
+		int64 Offset = 0;
+	};
+	static_assert(sizeof(FFrameIndexEntry) == 16, "Frame index entries are read in place from the file");
+
+	// Last bytes of the recording
+	struct FIndexFooter
+	{
+		int64 IndexOffset = 0;
+		int32 NumBodyFrames = 0;
+		int32 NumFaceFrames = 0;
+		int32 NumEyeFrames = 0;
+		uint32 Magic = kIndexMagic;
+	};
+	static constexpr int64 kIndexFooterSize = 24;
+
+	struct FBodyFrame
+	{
+		double Timestamp = 0.0;
+		FOculusXRBodyState State;
+	};
+
+	struct FFaceFrame
+	{
+		double Timestamp = 0.0;
+		FOculusXRFaceState State;
+	};
+
+	struct FEyeFrame
+	{
+		double Timestamp = 0.0;
+		FOculusXREyeGazesState State;
+	};
+
+	float WorldToMeters = 100.0f;
+	bool bHasBodySkeleton = false;
+	FOculusXRBodySkeleton BodySkeleton;
+
+	// Sorted by timestamp, in seconds from the start of the session
+	TArray<FBodyFrame> BodyFrames;
+	TArray<FFaceFrame> FaceFrames;
+	TArray<FEyeFrame> EyeFrames;
+
+	bool IsEmpty() const { return BodyFrames.IsEmpty() && FaceFrames.IsEmpty() && EyeFrames.IsEmpty(); }
+	double GetDuration() const;
+	void Reset();
+
+	// Returns false if the archive does not hold a recording this version can read
+	bool Serialize(FArchive& Ar);
+
+	bool SaveToFile(const FString& Filename);
+	bool LoadFromFile(const FString& Filename);
+
+	static void SerializeBodySkeleton(FArchive& Ar, FOculusXRBodySkeleton& BodySkeleton);
+	static void SerializeBodyState(FArchive& Ar, FOculusXRBodyState& BodyState);
+	static void SerializeFaceState(FArchive& Ar, FOculusXRFaceState& FaceState);
+	static void SerializeEyeGazesState(FArchive& Ar, FOculusXREyeGazesState& EyeGazesState);
+	static void SerializeIndexFooter(FArchive& Ar, FIndexFooter& Footer);
+};
+
+/**
+ * Read-only view of a recording file that stays on disk: the file is memory mapped, the frame index is
+ * used in place to seek in O(log n), and frames are only decoded when requested, straight into the caller's state.
+ * Immutable once opened, so any number of playback providers on any thread can share one instance.
+ */
+class OCULUSXRRETARGETING_API FOculusXRMappedMovementRecording
+{
+public:
+	// Returns the already open recording if another provider still uses the same file
+	static TSharedPtr<const FOculusXRMappedMovementRecording> Open(const FString& InFilename);
+
+	~FOculusXRMappedMovementRecording();
+
+	float GetWorldToMeters() const { return WorldToMeters; }
+	bool HasBodySkeleton() const { return bHasBodySkeleton; }
+	const FOculusXRBodySkeleton& GetBodySkeleton() const { return BodySkeleton; }
+
+	bool IsEmpty() const { return BodyIndex.IsEmpty() && FaceIndex.IsEmpty() && EyeIndex.IsEmpty(); }
+	double GetDuration() const;
+	int32 GetNumBodyFrames() const { return BodyIndex.Num(); }
+	int32 GetNumFaceFrames() const { return FaceIndex.Num(); }
+	int32 GetNumEyeFrames() const { return EyeIndex.Num(); }
+
+	// Index of the last frame at or before Time, INDEX_NONE if there is none
+	int32 FindBodyFrame(const double Time) const;
+	int32 FindFaceFrame(const double Time) const;
+	int32 FindEyeFrame(const double Time) const;
+
+	// Decode in place, reusing the allocations of the out states
+	bool DecodeBodyFrame(const int32 FrameIndex, FOculusXRBodyState& outBodyState) const;
+	bool DecodeFaceFrame(const int32 FrameIndex, FOculusXRFaceState& outFaceState) const;
+	bool DecodeEyeFrame(const int32 FrameIndex, FOculusXREyeGazesState& outEyeGazesState) const;
+
+private:
+	using FFrameIndexEntry = FOculusXRMovementRecording::FFrameIndexEntry;
+
+	FOculusXRMappedMovementRecording() = default;
+	bool Initialize(const FString& InFilename);
+	// Version 1 recordings have no index, it is built with a single pass over the frames
+	bool BuildIndex(FArchive& Ar);
+	TArrayView64<const uint8> GetFrameData(const TArrayView<const FFrameIndexEntry>& Index, const int32 FrameIndex) const;
+
+	FString Filename;
+	TUniquePtr<IMappedFileHandle> MappedHandle;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	// Used when the platform cannot map the file
+	TArray64<uint8> FallbackData;
+	TArrayView64<const uint8> Data;
+
+	float WorldToMeters = 100.0f;
+	bool bHasBodySkeleton = false;
+	FOculusXRBodySkeleton BodySkeleton;
+
+	// Point into the mapped file, or into OwnedIndex for version 1 recordings
+	TArrayView<const FFrameIndexEntry> BodyIndex;
+	TArrayView<const FFrameIndexEntry> FaceIndex;
+	TArrayView<const FFrameIndexEntry> EyeIndex;
+	TArray<FFrameIndexEntry> OwnedIndex;
+
+	static FCriticalSection OpenRecordingsLock;
+	static TMap<FString, TWeakPtr<const FOculusXRMappedMovementRecording>> OpenRecordings;
+};
+
+/**
+ * Replays a recording instead of the platform calls, for deterministic headless runs.
+ * Every getter returns the last frame at or before the playback time.
+ */
+class OCULUSXRRETARGETING_API FOculusXRPlaybackMovementDataProvider : public IOculusXRMovementDataProvider
+{
+public:
+	explicit FOculusXRPlaybackMovementDataProvider(const TSharedRef<const FOculusXRMovementRecording>& InRecording, const bool bInLoop = true);
+
+	void SetPlaybackTime(const double Time);
+	double GetPlaybackTime() const { return PlaybackTime.load(std::memory_order_relaxed); }
+	void Advance(const double DeltaSeconds);
+
+	virtual bool IsAvailable() const override;
+	virtual bool GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters) override;
+	virtual bool GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters) override;
+	virtual bool GetFaceState(FOculusXRFaceState& outFaceState) override;
+	virtual bool GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters) override;
+
+private:
+	TSharedRef<const FOculusXRMovementRecording> Recording;
+	std::atomic<double> PlaybackTime = 0.0;
+	bool bLoop = true;
+};
+
+/**
+ * Streams a memory mapped recording, several providers can replay the same file with their own playback time.
+ * Every getter returns the last frame at or before the playback time.
+ */
+class OCULUSXRRETARGETING_API FOculusXRMappedPlaybackMovementDataProvider : public IOculusXRMovementDataProvider
+{
+public:
+	explicit FOculusXRMappedPlaybackMovementDataProvider(const TSharedRef<const FOculusXRMappedMovementRecording>& InRecording, const bool bInLoop = true);
+
+	void SetPlaybackTime(const double Time);
+	double GetPlaybackTime() const { return PlaybackTime.load(std::memory_order_relaxed); }
+	void Advance(const double DeltaSeconds);
+
+	virtual bool IsAvailable() const override;
+	virtual bool GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters) override;
+	virtual bool GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters) override;
+	virtual bool GetFaceState(FOculusXRFaceState& outFaceState) override;
+	virtual bool GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters) override;
+
+private:
+	TSharedRef<const FOculusXRMappedMovementRecording> Recording;
+	std::atomic<double> PlaybackTime = 0.0;
+	bool bLoop = true;
+};
+
+/**
+ * Forwards to another provider and records every new frame it returns.
+ * Frames are deduplicated by their tracking time, so several nodes reading the same provider record each frame once.
+ */
+class OCULUSXRRETARGETING_API FOculusXRRecordingMovementDataProvider : public IOculusXRMovementDataProvider
+{
+public:
+	explicit FOculusXRRecordingMovementDataProvider(const TSharedRef<IOculusXRMovementDataProvider>& InSource);
+
+	// Hands over the frames recorded so far and starts a new recording
+	TSharedRef<FOculusXRMovementRecording> TakeRecording();
+
+	virtual bool IsAvailable() const override;
+	virtual bool GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters) override;
+	virtual bool GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters) override;
+	virtual bool GetFaceState(FOculusXRFaceState& outFaceState) override;
+	virtual bool GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters) override;
+
+private:
+	double GetTimestamp(const float StateTime);
+
+	TSharedRef<IOculusXRMovementDataProvider> Source;
+	FCriticalSection RecordingLock;
+	TSharedRef<FOculusXRMovementRecording> Recording;
+	TOptional<float> FirstStateTime;
+	float LastBodyTime = -1.0f;
+	float LastFaceTime = -1.0f;
+	float LastEyeTime = -1.0f;
+};
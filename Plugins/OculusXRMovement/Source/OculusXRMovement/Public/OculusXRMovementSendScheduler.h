@@ -0,0 +1,95 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OculusXRBodyStateCodec.h"
+
+struct OCULUSXRRETARGETING_API FOculusXRMovementSendSchedulerSettings
+{
+	// Budget of one connection for all the tracking streams it receives
+	int32 BytesPerSecond = 128 * 1024;
+	// Transport headers added to every packet
+	int32 PacketOverheadBytes = 28;
+
+	// Send rates from the least to the most relevant avatar (packets per second)
+	float MinSendRate = 6.0f;
+	float MaxSendRate = 72.0f;
+
+	// Relevance falls off to 0 at this distance (world units)
+	float RelevanceDistance = 2000.0f;
+	// Relevance scale of avatars outside the receiver's view
+	float OutOfViewScale = 0.4f;
+	// Relevance added to avatars that are speaking, their face matters most
+	float SpeakingBonus = 0.3f;
+};
+
+// What the receiver of a connection knows about an avatar, refreshed by the caller a few times per second
+struct FOculusXRMovementSendRelevance
+{
+	float Distance = 0.0f;
+	bool bIsInView = true;
+	bool bIsSpeaking = false;
+	// Size of the avatar's face update, 0 if it has no face stream
+	int32 FaceBytes = 0;
+};
+
+struct FOculusXRMovementSendDecision
+{
+	float Relevance = 1.0f;
+	// Frozen avatars are not sent
+	EOculusXRBodyFidelityTier Tier = EOculusXRBodyFidelityTier::Full;
+	float SendRate = 0.0f;
+	bool bSendFace = false;
+	int32 NumDemotions = 0;
+};
+
+/**
+ * Sender side scheduler spending one connection's byte budget on the tracked avatars it replicates.
+ * Avatars start at the tier and rate their relevance (distance, view, speaking) allows, then the least relevant
+ * ones are demoted step by step (fingers dropped, rate halved, face dropped, core joints only, not sent) until the
+ * estimated bytes per second fit the budget. Body packets are written with a tiered codec, so the receiver decodes
+ * them with the same reduced joint set and can retarget at the matching fidelity tier.
+ */
+class OCULUSXRRETARGETING_API FOculusXRMovementSendScheduler
+{
+public:
+	FOculusXRMovementSendScheduler(const TSharedRef<const FOculusXRTieredBodyStateCodec>& InCodec, const FOculusXRMovementSendSchedulerSettings& InSettings = FOculusXRMovementSendSchedulerSettings());
+
+	static float ComputeRelevance(const FOculusXRMovementSendRelevance& Relevance, const FOculusXRMovementSendSchedulerSettings& Settings);
+
+	// Assigns a tier and a rate to every avatar, avatars missing from the map are not sent anymore
+	void Schedule(const TMap<uint32, FOculusXRMovementSendRelevance>& Avatars);
+
+	// Whether the avatar is due for an update at Time, at its scheduled rate
+	bool ShouldSend(const uint32 AvatarId, const double Time);
+	// Returns false if the avatar is not scheduled or frozen
+	bool WriteBodyState(const uint32 AvatarId, const FOculusXRBodyState& BodyState, FBitWriter& Writer) const;
+
+	const FOculusXRMovementSendDecision* FindDecision(const uint32 AvatarId) const;
+	// Estimated bytes per second of the current schedule
+	double GetScheduledBytesPerSecond() const { return ScheduledBytesPerSecond; }
+	int32 GetPacketBytes(const EOculusXRBodyFidelityTier Tier) const;
+
+private:
+	struct FAvatarSchedule
+	{
+		FOculusXRMovementSendDecision Decision;
+		int32 FaceBytes = 0;
+		double NextSendTime = 0.0;
+	};
+
+	double GetBytesPerSecond(const FAvatarSchedule& Avatar) const;
+	bool Demote(FAvatarSchedule& Avatar) const;
+
+	TSharedRef<const FOculusXRTieredBodyStateCodec> Codec;
+	FOculusXRMovementSendSchedulerSettings Settings;
+	TMap<uint32, FAvatarSchedule> Avatars;
+	double ScheduledBytesPerSecond = 0.0;
+};
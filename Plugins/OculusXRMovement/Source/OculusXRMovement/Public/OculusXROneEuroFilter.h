@@ -0,0 +1,85 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OculusXROneEuroFilter.generated.h"
+
+USTRUCT(BlueprintType)
+struct OCULUSXRRETARGETING_API FOculusXROneEuroFilterSettings
+{
+	GENERATED_BODY()
+public:
+	FOculusXROneEuroFilterSettings()
+		: MinCutoff(1.5f)
+		, Beta(0.5f)
+		, DerivativeCutoff(1.0f)
+	{
+	}
+
+	FOculusXROneEuroFilterSettings(const float InMinCutoff, const float InBeta, const float InDerivativeCutoff)
+		: MinCutoff(InMinCutoff)
+		, Beta(InBeta)
+		, DerivativeCutoff(InDerivativeCutoff)
+	{
+	}
+
+	/**
+	 * Cutoff frequency at rest, in Hz. Lower removes more jitter but lags more on slow motion.
+	 */
+	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement", meta = (ClampMin = "0.01"))
+	float MinCutoff;
+
+	/**
+	 * How fast the cutoff frequency rises with speed. Higher lags less on fast motion.
+	 */
+	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement", meta = (ClampMin = "0.0"))
+	float Beta;
+
+	/**
+	 * Cutoff frequency of the speed estimate, in Hz.
+	 */
+	UPROPERTY(EditAnywhere, Category = "OculusXR|Movement", meta = (ClampMin = "0.01"))
+	float DerivativeCutoff;
+};
+
+/**
+ * One Euro filter (Casiez et al. 2012) over a vector of channels: a low pass filter whose cutoff frequency rises with
+ * the filtered speed, so jitter at rest is removed without lagging fast motion.
+ * Parameters and state are aligned structure of arrays padded to whole SIMD registers, four channels are filtered at a
+ * time. Nothing is allocated after Reset.
+ */
+class OCULUSXRRETARGETING_API FOculusXROneEuroFilter
+{
+public:
+	explicit FOculusXROneEuroFilter(const int32 InNumChannels = 0, const FOculusXROneEuroFilterSettings& InSettings = FOculusXROneEuroFilterSettings());
+
+	// Gives every channel the same settings and restarts the filter
+	void Reset(const int32 InNumChannels, const FOculusXROneEuroFilterSettings& InSettings);
+	void Set(const int32 Channel, const FOculusXROneEuroFilterSettings& InSettings);
+	// Restarts the filter from the next values, keeping the settings
+	void ResetState() { bHasState = false; }
+
+	// Filters the first GetNumChannels() values sampled DeltaTime seconds after the previous ones.
+	// The first values after a reset go through as is, InValues and OutValues may be the same array.
+	void Apply(const float* InValues, float* OutValues, const float DeltaTime);
+
+	int32 GetNumChannels() const { return NumChannels; }
+
+private:
+	using FAlignedFloats = TArray<float, TAlignedHeapAllocator<16>>;
+
+	int32 NumChannels = 0;
+	bool bHasState = false;
+	FAlignedFloats MinCutoffs;
+	FAlignedFloats Betas;
+	FAlignedFloats DerivativeCutoffs;
+	FAlignedFloats Values;
+	FAlignedFloats Derivatives;
+};
@@ -0,0 +1,71 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OculusXRBodyRetargeter.h"
+
+class USceneComponent;
+
+/**
+ * Assigns body retargeting fidelity tiers to every avatar in the frame.
+ * Each avatar starts at the tier matching its significance, then the least significant avatars are
+ * demoted until the measured cost of the frame fits in oculusxr.Movement.RetargetBudgetMs.
+ * Locally controlled avatars are never demoted.
+ */
+class OCULUSXRRETARGETING_API FOculusXRRetargetBudgetManager
+{
+public:
+	static FOculusXRRetargetBudgetManager& Get();
+
+	// Unique id used to track an avatar across frames
+	static uint32 AllocateAvatarId();
+
+	// Significance in [0, 1] from the distance to the closest local player camera and whether the component was recently rendered.
+	// Must be called from the game thread.
+	static float ComputeSignificance(const USceneComponent* Component, bool& bOutIsLocallyControlled);
+
+	static EOculusXRBodyFidelityTier GetTierForSignificance(const float Significance);
+
+	// Retarget once every N frames, scaled from 1 at full significance to oculusxr.Movement.MaxEvaluationRateDivisor
+	static int32 GetEvaluationRateDivisorForSignificance(const float Significance);
+
+	// Game thread - registers the request for this frame and returns the tier the avatar should be retargeted at.
+	// Tiers are resolved once per frame from the requests of the previous frame.
+	EOculusXRBodyFidelityTier RequestTier(const uint32 AvatarId, const float Significance, const bool bIsLocallyControlled, const EOculusXRBodyFidelityTier HighestTier);
+
+	// Any thread - reports the time spent retargeting one avatar at the given tier, per frame.
+	// Avatars retargeted every N frames report their cost divided by N.
+	void ReportCost(const EOculusXRBodyFidelityTier Tier, const double Seconds);
+
+	double GetEstimatedCost(const EOculusXRBodyFidelityTier Tier) const;
+
+private:
+	FOculusXRRetargetBudgetManager();
+
+	struct FAvatarRequest
+	{
+		float Significance = 1.0f;
+		bool bIsLocallyControlled = false;
+		EOculusXRBodyFidelityTier HighestTier = EOculusXRBodyFidelityTier::Full;
+		EOculusXRBodyFidelityTier AssignedTier = EOculusXRBodyFidelityTier::Full;
+		uint64 LastRequestFrame = 0;
+	};
+
+	void ResolveTiers();
+
+	static constexpr int32 kNumTiers = static_cast<int32>(EOculusXRBodyFidelityTier::Frozen) + 1;
+	// Avatars that didn't request a tier for this many frames are dropped
+	static constexpr uint64 kStaleFrameCount = 30;
+
+	mutable FCriticalSection Lock;
+	TMap<uint32, FAvatarRequest> Avatars;
+	double EstimatedCost[kNumTiers];
+	uint64 LastResolvedFrame = 0;
+};
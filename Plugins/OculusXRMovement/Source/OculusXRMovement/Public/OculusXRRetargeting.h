@@ -12,6 +12,7 @@ LICENSE file in the root directory of this source tree.
 #include "Modules/ModuleManager.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogOculusXRRetargeting, Log, All);
+DECLARE_STATS_GROUP(TEXT("OculusXRMovement"), STATGROUP_OculusXRMovement, STATCAT_Advanced);
 
 class FOculusXRRetargetingModule : public IModuleInterface
 {
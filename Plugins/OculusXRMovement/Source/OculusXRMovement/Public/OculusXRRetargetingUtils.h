@@ -73,6 +73,21 @@ struct OCULUSXRRETARGETING_API FOculusXRRetargetingUtils
 	 */
 	static bool GetUnitScaleFactorFromSettings(UWorld* World, float& OutWorldToMeters);
 
+	/**
+	 * Principal components of samples of NumFeatures floats each, by decreasing variance.
+	 * Keeps the fewest components explaining MinExplainedVariance of the total variance, at most MaxComponents.
+	 * @param OutComponents One row of NumFeatures floats per component
+	 * @param OutVariances Variance along each component
+	 */
+	static bool FitPrincipalComponents(TConstArrayView<float> Samples, const int32 NumFeatures, const int32 MaxComponents, const float MinExplainedVariance,
+		TArray<float>& OutMean, TArray<float>& OutComponents, TArray<float>& OutVariances, float& OutExplainedVariance);
+
+	/**
+	 * Copies the values that moved more than Threshold away from the emitted ones, the others keep their emitted value.
+	 * Returns the number of values copied.
+	 */
+	static int32 UpdateChangedValues(TConstArrayView<float> Values, TArrayView<float> InOutEmittedValues, const float Threshold);
+
 private:
 	/**
 	 * Oculus tracking space is using +X as its forward direction.
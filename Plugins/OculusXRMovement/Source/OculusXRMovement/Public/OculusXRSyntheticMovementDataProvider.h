@@ -0,0 +1,97 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OculusXRMovementDataProvider.h"
+#include <atomic>
+
+struct FOculusXRSyntheticMovementSettings
+{
+	// Every seed produces a different body size, cycle rates and phases
+	int32 Seed = 0;
+
+	// Cycles per second of the generated motions, 0 disables the motion
+	float WalkCycleFrequency = 0.9f;
+	float ReachCycleFrequency = 0.25f;
+	float FingerCurlFrequency = 0.5f;
+	float ExpressionCycleFrequency = 0.3f;
+
+	// Random rotation added to every joint, in degrees
+	float JointNoiseDegrees = 1.0f;
+	// Random offset added to every expression weight
+	float ExpressionNoise = 0.02f;
+
+	// Chance for every joint of a frame to be reported with bIsValid = false
+	float InvalidJointProbability = 0.0f;
+	// Seconds between SkeletonChangedCount bumps (with slightly different body proportions), 0 keeps a single skeleton
+	float SkeletonChangeInterval = 0.0f;
+
+	// Noise and joint invalidation change at this rate
+	float FrameRate = 72.0f;
+};
+
+/**
+ * Generates deterministic body, face and eye tracking data from a seed: walking, reaching, finger curls,
+ * blinks and expression cycles. Lets many unique avatars run without a headset or recordings, for load testing.
+ * The generated frame only depends on the settings and the current time, so getters are safe from any thread.
+ */
+class OCULUSXRRETARGETING_API FOculusXRSyntheticMovementDataProvider : public IOculusXRMovementDataProvider
+{
+public:
+	explicit FOculusXRSyntheticMovementDataProvider(const FOculusXRSyntheticMovementSettings& InSettings);
+
+	void SetTime(const double InTime) { Time.store(InTime, std::memory_order_relaxed); }
+	double GetTime() const { return Time.load(std::memory_order_relaxed); }
+	void Advance(const double DeltaSeconds) { SetTime(GetTime() + DeltaSeconds); }
+
+	const FOculusXRSyntheticMovementSettings& GetSettings() const { return Settings; }
+
+	virtual bool IsAvailable() const override { return true; }
+	virtual bool GetBodyState(FOculusXRBodyState& outBodyState, const float WorldToMeters) override;
+	virtual bool GetBodySkeleton(FOculusXRBodySkeleton& outBodySkeleton, const float WorldToMeters) override;
+	virtual bool GetFaceState(FOculusXRFaceState& outFaceState) override;
+	virtual bool GetEyeGazesState(FOculusXREyeGazesState& outEyeGazesState, const float WorldToMeters) override;
+
+private:
+	struct FRestJoint
+	{
+		EOculusXRBoneID BoneId = EOculusXRBoneID::None;
+		EOculusXRBoneID ParentBoneId = EOculusXRBoneID::None;
+		FVector Position = FVector::ZeroVector; // Meters, tracking space
+	};
+
+	static bool IsFingerJoint(const EOculusXRBoneID BoneId);
+
+	void BuildRestSkeleton();
+	int32 GetSkeletonChangedCount(const double InTime) const;
+	float GetBodyScale(const int32 SkeletonChangedCount) const;
+	int32 GetFrameIndex(const double InTime) const;
+	FQuat GetJointAnimation(const EOculusXRBoneID BoneId, const double InTime) const;
+	// Component space transforms of every joint, indexed by bone id, in meters.
+	// Written to a caller provided buffer so that load tests do not measure per avatar allocations.
+	void EvaluateBody(const double InTime, TArrayView<FTransform> outTransforms) const;
+
+	FOculusXRSyntheticMovementSettings Settings;
+	std::atomic<double> Time = 0.0;
+
+	// Derived from the seed
+	float HeightScale = 1.0f;
+	float RateScale = 1.0f;
+	float WalkPhase = 0.0f;
+	float ReachPhase = 0.0f;
+	float FingerPhase = 0.0f;
+	TArray<float> ExpressionPhases;
+	TArray<float> ExpressionAmplitudes;
+
+	// Indexed by bone id
+	TArray<FRestJoint> RestJoints;
+	// Bone ids sorted from parent to child
+	TArray<int32> EvaluationOrder;
+};
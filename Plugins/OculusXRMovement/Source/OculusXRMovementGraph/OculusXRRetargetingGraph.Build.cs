@@ -31,6 +31,7 @@ public class OculusXRRetargetingGraph : ModuleRules
                 "AnimGraph",
                 "AnimGraphRuntime",
                 "BlueprintGraph",
+                "AssetRegistry",
             }
         );
     }
@@ -0,0 +1,337 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "OculusXRRetargetRecordingsCommandlet.h"
+#include "AnimNode_OculusXRBodyTracking.h"
+#include "AnimNode_OculusXRFaceTracking.h"
+#include "OculusXRBodyRetargeter.h"
+#include "OculusXRFaceRetargetAsset.h"
+#include "OculusXRMovementRecorder.h"
+#include "OculusXRMovementRecording.h"
+#include "Animation/AnimData/IAnimationDataController.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/Skeleton.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Async/ParallelFor.h"
+#include "BonePose.h"
+#include "Engine/SkeletalMesh.h"
+#include "HAL/FileManager.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogOculusXRRetargetRecordings, Log, All);
+
+namespace
+{
+	constexpr float kWorldToMeters = 100.0f;
+
+	struct FSession
+	{
+		FString Filename;
+		// Unique within the output path
+		FString AssetName;
+		TSharedPtr<IOculusXRMovementDataProvider> Provider;
+		TFunction<void(double)> SetPlaybackTime;
+		double Duration = 0.0;
+		TSharedPtr<FOculusXRBodyRetargeter> Retargeter;
+
+		// Output, indexed by mesh bone index and by curve index
+		int32 NumFrames = 0;
+		int32 NumRetargetedFrames = 0;
+		TArray<FRawAnimSequenceTrack> BoneTracks;
+		TArray<TArray<FRichCurveKey>> CurveKeys;
+		double RetargetSeconds = 0.0;
+	};
+
+	bool OpenSession(const FString& Filename, FSession& Session)
+	{
+		Session.Filename = Filename;
+		if (FPaths::GetExtension(Filename) == TEXT("oxms"))
+		{
+			TSharedRef<FOculusXRMovementRecording> recording = MakeShared<FOculusXRMovementRecording>();
+			if (!FOculusXRAsyncMovementRecorder::LoadStream(Filename, *recording))
+			{
+				return false;
+			}
+			TSharedRef<FOculusXRPlaybackMovementDataProvider> playback = MakeShared<FOculusXRPlaybackMovementDataProvider>(recording, false);
+			Session.Provider = playback;
+			Session.SetPlaybackTime = [playback](double time) { playback->SetPlaybackTime(time); };
+			Session.Duration = recording->GetDuration();
+			return recording->bHasBodySkeleton;
+		}
+
+		const TSharedPtr<const FOculusXRMappedMovementRecording> recording = FOculusXRMappedMovementRecording::Open(Filename);
+		if (!recording)
+		{
+			return false;
+		}
+		TSharedRef<FOculusXRMappedPlaybackMovementDataProvider> playback = MakeShared<FOculusXRMappedPlaybackMovementDataProvider>(recording.ToSharedRef(), false);
+		Session.Provider = playback;
+		Session.SetPlaybackTime = [playback](double time) { playback->SetPlaybackTime(time); };
+		Session.Duration = recording->GetDuration();
+		return recording->HasBodySkeleton();
+	}
+
+	void RetargetSession(FSession& Session, const FBoneContainer& BoneContainer, const FOculusXRFaceExpressionModifiers& Modifiers, const FOculusXRFaceRetargetMatrix& FaceMatrix, const int32 FrameRate)
+	{
+		const int32 numCurves = FaceMatrix.GetNumCurves();
+		const double startTime = FPlatformTime::Seconds();
+
+		Session.NumFrames = FMath::FloorToInt32(Session.Duration * FrameRate) + 1;
+		const int32 numMeshBones = BoneContainer.GetReferenceSkeleton().GetNum();
+		Session.BoneTracks.SetNum(numMeshBones);
+		for (FRawAnimSequenceTrack& track : Session.BoneTracks)
+		{
+			track.PosKeys.Reserve(Session.NumFrames);
+			track.RotKeys.Reserve(Session.NumFrames);
+			track.ScaleKeys.Reserve(Session.NumFrames);
+		}
+		Session.CurveKeys.SetNum(numCurves);
+
+		FCompactPose pose;
+		pose.SetBoneContainer(&BoneContainer);
+		FOculusXRBodyState bodyState;
+		FOculusXRFaceState faceState;
+		TArray<float> modifiedWeights;
+		modifiedWeights.SetNumUninitialized(Modifiers.GetNumExpressions());
+		TArray<float> curveValues;
+
+		for (int32 frame = 0; frame < Session.NumFrames; ++frame)
+		{
+			const float frameTime = static_cast<float>(frame) / FrameRate;
+			Session.SetPlaybackTime(frameTime);
+
+			pose.ResetToRefPose();
+			if (Session.Provider->GetBodyState(bodyState, kWorldToMeters)
+				&& Session.Retargeter->RetargetFromBodyState(bodyState, FTransform::Identity, kWorldToMeters, pose))
+			{
+				++Session.NumRetargetedFrames;
+			}
+
+			for (const FCompactPoseBoneIndex boneIndex : pose.ForEachBoneIndex())
+			{
+				const FTransform& localTransform = pose[boneIndex];
+				FRawAnimSequenceTrack& track = Session.BoneTracks[BoneContainer.MakeMeshPoseIndex(boneIndex).GetInt()];
+				track.PosKeys.Add(FVector3f(localTransform.GetLocation()));
+				track.RotKeys.Add(FQuat4f(localTransform.GetRotation()));
+				track.ScaleKeys.Add(FVector3f(localTransform.GetScale3D()));
+			}
+
+			if (numCurves > 0)
+			{
+				curveValues.Init(0.0f, numCurves);
+				if (Session.Provider->GetFaceState(faceState) && faceState.bIsValid && faceState.ExpressionWeights.Num() >= Modifiers.GetNumExpressions())
+				{
+					Modifiers.Apply(faceState.ExpressionWeights.GetData(), modifiedWeights.GetData());
+					FaceMatrix.Multiply(modifiedWeights.GetData(), curveValues.GetData());
+				}
+				for (int32 curveIndex = 0; curveIndex < numCurves; ++curveIndex)
+				{
+					Session.CurveKeys[curveIndex].Add(FRichCurveKey(frameTime, curveValues[curveIndex]));
+				}
+			}
+		}
+
+		Session.RetargetSeconds = FPlatformTime::Seconds() - startTime;
+	}
+
+	bool SaveAnimSequence(const FSession& Session, USkeletalMesh* Mesh, const FString& OutputPath, const TArray<FName>& CurveNames, const int32 FrameRate)
+	{
+		const FString packageName = OutputPath / Session.AssetName;
+		UPackage* package = CreatePackage(*packageName);
+		UAnimSequence* animSequence = NewObject<UAnimSequence>(package, *Session.AssetName, RF_Public | RF_Standalone);
+		animSequence->SetSkeleton(Mesh->GetSkeleton());
+		animSequence->SetPreviewMesh(Mesh);
+
+		const FReferenceSkeleton& refSkeleton = Mesh->GetRefSkeleton();
+		IAnimationDataController& controller = animSequence->GetController();
+		controller.InitializeModel();
+		controller.OpenBracket(FText::FromString(TEXT("Retarget movement recording")), false);
+		controller.SetFrameRate(FFrameRate(FrameRate, 1), false);
+		controller.SetNumberOfFrames(FFrameNumber(FMath::Max(Session.NumFrames - 1, 1)), false);
+		for (int32 boneIndex = 0; boneIndex < Session.BoneTracks.Num(); ++boneIndex)
+		{
+			const FRawAnimSequenceTrack& track = Session.BoneTracks[boneIndex];
+			if (track.PosKeys.IsEmpty())
+			{
+				continue;
+			}
+			const FName boneName = refSkeleton.GetBoneName(boneIndex);
+			controller.AddBoneCurve(boneName, false);
+			controller.SetBoneTrackKeys(boneName, track.PosKeys, track.RotKeys, track.ScaleKeys, false);
+		}
+		for (int32 curveIndex = 0; curveIndex < CurveNames.Num(); ++curveIndex)
+		{
+			const FAnimationCurveIdentifier curveId(CurveNames[curveIndex], ERawCurveTrackTypes::RCT_Float);
+			controller.AddCurve(curveId, AACF_Editable, false);
+			controller.SetCurveKeys(curveId, Session.CurveKeys[curveIndex], false);
+		}
+		controller.NotifyPopulated();
+		controller.CloseBracket(false);
+
+		FAssetRegistryModule::AssetCreated(animSequence);
+		package->MarkPackageDirty();
+
+		FSavePackageArgs saveArgs;
+		saveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+		const FString packageFilename = FPackageName::LongPackageNameToFilename(packageName, FPackageName::GetAssetPackageExtension());
+		if (!UPackage::SavePackage(package, animSequence, *packageFilename, saveArgs))
+		{
+			UE_LOG(LogOculusXRRetargetRecordings, Error, TEXT("Cannot save %s."), *packageFilename);
+			return false;
+		}
+		return true;
+	}
+} // namespace
+
+UOculusXRRetargetRecordingsCommandlet::UOculusXRRetargetRecordingsCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UOculusXRRetargetRecordingsCommandlet::Main(const FString& Params)
+{
+	FString recordingsPath;
+	FString meshPath;
+	FString outputPath;
+	FString faceRetargetPath;
+	int32 frameRate = 30;
+	FParse::Value(*Params, TEXT("Recordings="), recordingsPath);
+	FParse::Value(*Params, TEXT("Mesh="), meshPath);
+	FParse::Value(*Params, TEXT("Output="), outputPath);
+	FParse::Value(*Params, TEXT("FrameRate="), frameRate);
+	FParse::Value(*Params, TEXT("FaceRetarget="), faceRetargetPath);
+	const bool bWriteFace = !FParse::Param(*Params, TEXT("NoFace"));
+
+	if (recordingsPath.IsEmpty() || meshPath.IsEmpty() || !FPackageName::IsValidLongPackageName(outputPath) || frameRate <= 0)
+	{
+		UE_LOG(LogOculusXRRetargetRecordings, Error, TEXT("Usage: -run=OculusXRRetargetRecordings -Recordings=<file or directory> -Mesh=<skeletal mesh path> -Output=<package path> [-FrameRate=30] [-FaceRetarget=<face retarget asset path>] [-NoFace]"));
+		return 1;
+	}
+
+	USkeletalMesh* mesh = LoadObject<USkeletalMesh>(nullptr, *meshPath);
+	if (!mesh || !mesh->GetSkeleton())
+	{
+		UE_LOG(LogOculusXRRetargetRecordings, Error, TEXT("Cannot load skeletal mesh %s."), *meshPath);
+		return 1;
+	}
+
+	const UOculusXRFaceRetargetAsset* faceRetargetAsset = nullptr;
+	if (!faceRetargetPath.IsEmpty())
+	{
+		faceRetargetAsset = LoadObject<UOculusXRFaceRetargetAsset>(nullptr, *faceRetargetPath);
+		if (!faceRetargetAsset)
+		{
+			UE_LOG(LogOculusXRRetargetRecordings, Error, TEXT("Cannot load face retarget asset %s."), *faceRetargetPath);
+			return 1;
+		}
+	}
+
+	TArray<FString> filenames;
+	if (IFileManager::Get().DirectoryExists(*recordingsPath))
+	{
+		TArray<FString> found;
+		IFileManager::Get().FindFiles(found, *(recordingsPath / TEXT("*.oxmr")), true, false);
+		IFileManager::Get().FindFiles(found, *(recordingsPath / TEXT("*.oxms")), true, false);
+		for (const FString& filename : found)
+		{
+			filenames.Add(recordingsPath / filename);
+		}
+	}
+	else
+	{
+		filenames.Add(recordingsPath);
+	}
+	// Asset names must not depend on the order the file system lists the recordings in
+	filenames.Sort();
+
+	// Same settings as a body and face tracking node added to an anim graph
+	const FAnimNode_OculusXRBodyTracking defaultBodyNode;
+	const FAnimNode_OculusXRFaceTracking defaultFaceNode;
+
+	// Every bone of the mesh is keyed
+	TArray<FBoneIndexType> requiredBones;
+	for (int32 boneIndex = 0; boneIndex < mesh->GetRefSkeleton().GetNum(); ++boneIndex)
+	{
+		requiredBones.Add(static_cast<FBoneIndexType>(boneIndex));
+	}
+	const FBoneContainer boneContainer(requiredBones, UE::Anim::FCurveFilterSettings(), *mesh);
+
+	FOculusXRFaceExpressionModifiers faceModifiers;
+	faceModifiers.Reset(static_cast<int32>(EOculusXRFaceExpression::COUNT));
+	FOculusXRFaceRetargetMatrix faceMatrix;
+	if (bWriteFace)
+	{
+		for (const auto& expressionModifier : defaultFaceNode.ExpressionModifiers)
+		{
+			faceModifiers.Set(static_cast<int32>(expressionModifier.Key), expressionModifier.Value);
+		}
+		faceMatrix = faceRetargetAsset ? faceRetargetAsset->GetMatrix() : *UOculusXRFaceRetargetAsset::GetDefaultMatrix();
+	}
+
+	// Loading and retargeter creation stay on the game thread, only the conversion runs in parallel
+	TArray<FSession> sessions;
+	sessions.Reserve(filenames.Num());
+	TSet<FString> assetNames;
+	for (const FString& filename : filenames)
+	{
+		FSession& session = sessions.AddDefaulted_GetRef();
+		if (!OpenSession(filename, session))
+		{
+			UE_LOG(LogOculusXRRetargetRecordings, Warning, TEXT("Skipping %s, it cannot be read or has no body skeleton."), *filename);
+			sessions.Pop();
+			continue;
+		}
+		// Recordings sharing a base name, like a stream and the recording saved from it, get a numeric suffix
+		const FString baseName = FPaths::GetBaseFilename(filename);
+		session.AssetName = baseName;
+		for (int32 suffix = 1; assetNames.Contains(session.AssetName); ++suffix)
+		{
+			session.AssetName = FString::Printf(TEXT("%s_%d"), *baseName, suffix);
+		}
+		assetNames.Add(session.AssetName);
+		if (session.AssetName != baseName)
+		{
+			UE_LOG(LogOculusXRRetargetRecordings, Display, TEXT("%s is saved as %s, another recording uses its name."), *filename, *session.AssetName);
+		}
+		session.Retargeter = FOculusXRBodyRetargeter::Create();
+		session.Retargeter->Initialize(defaultBodyNode.RetargetingMode, defaultBodyNode.RootMotionBehavior, defaultBodyNode.ForwardMesh, &defaultBodyNode.GetBoneRemapping());
+		session.Retargeter->SetUnmappedSubtreeMode(defaultBodyNode.UnmappedSubtreeMode);
+		session.Retargeter->SetDataProvider(session.Provider);
+	}
+
+	const double startTime = FPlatformTime::Seconds();
+	ParallelFor(sessions.Num(), [&](int32 sessionIndex) {
+		RetargetSession(sessions[sessionIndex], boneContainer, faceModifiers, faceMatrix, frameRate);
+	});
+	const double retargetSeconds = FPlatformTime::Seconds() - startTime;
+
+	int32 numFailed = 0;
+	double recordedSeconds = 0.0;
+	for (const FSession& session : sessions)
+	{
+		recordedSeconds += session.Duration;
+		if (session.NumRetargetedFrames == 0)
+		{
+			UE_LOG(LogOculusXRRetargetRecordings, Warning, TEXT("No frame of %s could be retargeted to %s."), *session.Filename, *meshPath);
+			++numFailed;
+			continue;
+		}
+		UE_LOG(LogOculusXRRetargetRecordings, Display, TEXT("%s: %d frames (%d retargeted) in %.2fs."), *session.Filename, session.NumFrames, session.NumRetargetedFrames, session.RetargetSeconds);
+		numFailed += SaveAnimSequence(session, mesh, outputPath, faceMatrix.CurveNames, frameRate) ? 0 : 1;
+	}
+
+	UE_LOG(LogOculusXRRetargetRecordings, Display, TEXT("Retargeted %d recordings (%.1fs of tracking) in %.2fs, %.1fx real time."),
+		sessions.Num(), recordedSeconds, retargetSeconds, retargetSeconds > 0.0 ? recordedSeconds / retargetSeconds : 0.0);
+	return numFailed + (filenames.Num() - sessions.Num()) > 0 ? 1 : 0;
+}
@@ -8,11 +8,46 @@ LICENSE file in the root directory of this source tree.
 
 #include "OculusXR_TrackingGraphNodes.h"
 #include "OculusXRMovementTypes.h"
+#include "IAnimBlueprintCopyTermDefaultsContext.h"
 #include "Misc/EnumRange.h"
 #include <cctype>
 
 ENUM_RANGE_BY_COUNT(EOculusXRBoneID, EOculusXRBoneID::COUNT);
 
+// Graph nodes start from the default mappings, so the editable values and the saved deltas are the same as before the
+// runtime nodes shared them. Compiled nodes only keep a mapping of their own when it differs from the shared one.
+UOculusXR_BodyTracking::UOculusXR_BodyTracking()
+{
+	Node.BoneRemapping = UOculusXRBodyRemapAsset::GetDefaultBoneRemapping();
+}
+
+void UOculusXR_BodyTracking::OnCopyTermDefaultsToDefaultObject(IAnimBlueprintCopyTermDefaultsContext& InCompilationContext, IAnimBlueprintNodeCopyTermDefaultsContext& InPerNodeContext, IAnimBlueprintGeneratedClassCompiledData& OutCompiledData)
+{
+	Super::OnCopyTermDefaultsToDefaultObject(InCompilationContext, InPerNodeContext, OutCompiledData);
+
+	FAnimNode_OculusXRBodyTracking* DestinationNode = reinterpret_cast<FAnimNode_OculusXRBodyTracking*>(InPerNodeContext.GetDestinationPtr());
+	if (Node.RemapAsset || Node.BoneRemapping.OrderIndependentCompareEqual(UOculusXRBodyRemapAsset::GetDefaultBoneRemapping()))
+	{
+		DestinationNode->BoneRemapping.Empty();
+	}
+}
+
+UOculusXR_FaceTracking::UOculusXR_FaceTracking()
+{
+	Node.ExpressionNames = UOculusXRFaceRetargetAsset::GetDefaultExpressionNames();
+}
+
+void UOculusXR_FaceTracking::OnCopyTermDefaultsToDefaultObject(IAnimBlueprintCopyTermDefaultsContext& InCompilationContext, IAnimBlueprintNodeCopyTermDefaultsContext& InPerNodeContext, IAnimBlueprintGeneratedClassCompiledData& OutCompiledData)
+{
+	Super::OnCopyTermDefaultsToDefaultObject(InCompilationContext, InPerNodeContext, OutCompiledData);
+
+	FAnimNode_OculusXRFaceTracking* DestinationNode = reinterpret_cast<FAnimNode_OculusXRFaceTracking*>(InPerNodeContext.GetDestinationPtr());
+	if (Node.RetargetAsset || Node.ExpressionNames.OrderIndependentCompareEqual(UOculusXRFaceRetargetAsset::GetDefaultExpressionNames()))
+	{
+		DestinationNode->ExpressionNames.Empty();
+	}
+}
+
 void UOculusXR_BodyTracking::GenerateBoneMapping()
 {
 	FString SourceName;
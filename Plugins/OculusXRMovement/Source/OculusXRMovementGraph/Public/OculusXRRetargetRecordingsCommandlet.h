@@ -0,0 +1,35 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "OculusXRRetargetRecordingsCommandlet.generated.h"
+
+/**
+ * Converts movement recordings into animation sequences for a target skeletal mesh, without playing them in a world.
+ * Every recording is retargeted on its own worker thread with the body tracking node's retargeter and default
+ * settings, face weights are written as curves using the face tracking node's default expression mapping, or the
+ * given face retarget asset.
+ *
+ * UnrealEditor-Cmd <Project> -run=OculusXRRetargetRecordings -Recordings=<file or directory> -Mesh=<skeletal mesh path>
+ *     -Output=<package path> [-FrameRate=30] [-FaceRetarget=<face retarget asset path>] [-NoFace]
+ *
+ * Recordings are .oxmr files (FOculusXRMovementRecording) or .oxms streams (FOculusXRAsyncMovementRecorder).
+ */
+UCLASS()
+class OCULUSXRRETARGETINGGRAPH_API UOculusXRRetargetRecordingsCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UOculusXRRetargetRecordingsCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -23,6 +23,8 @@ class OCULUSXRRETARGETINGGRAPH_API UOculusXR_BodyTracking : public UAnimGraphNod
 {
 	GENERATED_BODY()
 
+	UOculusXR_BodyTracking();
+
 	// TODO: Hide the input pose data as that is not being used or valid
 
 	UPROPERTY(EditAnywhere, Category = Settings)
@@ -45,6 +47,8 @@ class OCULUSXRRETARGETINGGRAPH_API UOculusXR_BodyTracking : public UAnimGraphNod
 
 	virtual void ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog) override;
 
+	virtual void OnCopyTermDefaultsToDefaultObject(IAnimBlueprintCopyTermDefaultsContext& InCompilationContext, IAnimBlueprintNodeCopyTermDefaultsContext& InPerNodeContext, IAnimBlueprintGeneratedClassCompiledData& OutCompiledData) override;
+
 	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
 
 	virtual FText GetTooltipText() const override;
@@ -60,6 +64,8 @@ class OCULUSXRRETARGETINGGRAPH_API UOculusXR_FaceTracking : public UAnimGraphNod
 {
 	GENERATED_BODY()
 
+	UOculusXR_FaceTracking();
+
 	// TODO: Hide the input pose data as that is not being used or valid
 
 	UPROPERTY(EditAnywhere, Category = Settings)
@@ -67,6 +73,8 @@ class OCULUSXRRETARGETINGGRAPH_API UOculusXR_FaceTracking : public UAnimGraphNod
 
 	virtual void ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog) override;
 
+	virtual void OnCopyTermDefaultsToDefaultObject(IAnimBlueprintCopyTermDefaultsContext& InCompilationContext, IAnimBlueprintNodeCopyTermDefaultsContext& InPerNodeContext, IAnimBlueprintGeneratedClassCompiledData& OutCompiledData) override;
+
 	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
 
 	virtual FText GetTooltipText() const override;
@@ -0,0 +1,176 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/IConsoleManager.h"
+#include "OculusXRBodyRemapAsset.h"
+#include "OculusXRBodyRetargeter.h"
+#include "OculusXRRetargetBudgetManager.h"
+
+#if UE_VERSION_OLDER_THAN(5, 5, 0)
+#define BodyRetargetingTestFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#else
+#define BodyRetargetingTestFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#endif // UE_VERSION_OLDER_THAN(5, 5, 0)
+
+// These tests check the joint sets the body retargeter derives from the UE5 mannequin mapping, and how the retarget budget scales avatars down.
+
+// Part of the UE5 mannequin hierarchy, with unmapped twist, helper and leaf bones, parents before their children
+struct FMannequinHierarchy
+{
+	TArray<FName> Names;
+	TArray<EOculusXRBoneID> SourceJoints;
+	TArray<int32> ParentIndices;
+
+	FMannequinHierarchy()
+	{
+		const TPair<const TCHAR*, const TCHAR*> Bones[] = {
+			{ TEXT("root"), nullptr },
+			{ TEXT("pelvis"), TEXT("root") },
+			{ TEXT("spine_01"), TEXT("pelvis") },
+			{ TEXT("spine_02"), TEXT("spine_01") },
+			{ TEXT("spine_03"), TEXT("spine_02") },
+			{ TEXT("spine_04"), TEXT("spine_03") },
+			{ TEXT("spine_05"), TEXT("spine_04") },
+			{ TEXT("neck_01"), TEXT("spine_05") },
+			{ TEXT("neck_02"), TEXT("neck_01") },
+			{ TEXT("head"), TEXT("neck_02") },
+			{ TEXT("clavicle_l"), TEXT("spine_05") },
+			{ TEXT("upperarm_l"), TEXT("clavicle_l") },
+			{ TEXT("lowerarm_l"), TEXT("upperarm_l") },
+			{ TEXT("lowerarm_twist_01_l"), TEXT("lowerarm_l") },
+			{ TEXT("hand_l"), TEXT("lowerarm_l") },
+			{ TEXT("index_metacarpal_l"), TEXT("hand_l") },
+			{ TEXT("index_01_l"), TEXT("index_metacarpal_l") },
+			{ TEXT("index_02_l"), TEXT("index_01_l") },
+			{ TEXT("index_03_l"), TEXT("index_02_l") },
+			{ TEXT("index_end_l"), TEXT("index_03_l") },
+			{ TEXT("thumb_01_l"), TEXT("hand_l") },
+			{ TEXT("weapon_l"), TEXT("hand_l") },
+			{ TEXT("thigh_l"), TEXT("pelvis") },
+			{ TEXT("calf_l"), TEXT("thigh_l") },
+			{ TEXT("foot_l"), TEXT("calf_l") },
+			{ TEXT("ball_l"), TEXT("foot_l") },
+			{ TEXT("ik_foot_root"), TEXT("root") },
+		};
+
+		TMap<FName, EOculusXRBoneID> NameToSourceJoint;
+		for (const auto& Mapping : UOculusXRBodyRemapAsset::GetDefaultBoneRemapping())
+		{
+			if (!Mapping.Value.IsNone())
+			{
+				NameToSourceJoint.Add(Mapping.Value, Mapping.Key);
+			}
+		}
+
+		for (const auto& Bone : Bones)
+		{
+			Names.Add(Bone.Key);
+			const EOculusXRBoneID* SourceJoint = NameToSourceJoint.Find(Bone.Key);
+			SourceJoints.Add(SourceJoint ? *SourceJoint : EOculusXRBoneID::None);
+			ParentIndices.Add(Bone.Value ? Names.IndexOfByKey(FName(Bone.Value)) : INDEX_NONE);
+		}
+	}
+
+	int32 Find(const TCHAR* Name) const { return Names.IndexOfByKey(FName(Name)); }
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyRetargetedRegionsMannequin, "OculusXRRetargetingTests.FBodyRetargetedRegionsMannequin", BodyRetargetingTestFilters)
+inline bool FBodyRetargetedRegionsMannequin::RunTest(const FString& Parameters)
+{
+	const FMannequinHierarchy Mannequin;
+	TestTrue("Mapped mannequin bones should be found", Mannequin.SourceJoints[Mannequin.Find(TEXT("hand_l"))] == EOculusXRBoneID::BodyLeftHandWrist);
+
+	TArray<EOculusXRBodyRegion> Regions;
+	FOculusXRBodyRetargeter::GetJointRegions(Mannequin.SourceJoints, Mannequin.ParentIndices, Regions);
+	TestEqual("Every joint should get a region", Regions.Num(), Mannequin.Names.Num());
+
+	const auto IsRetargeted = [&](const EOculusXRBodyRegion Mask, const TCHAR* Name) {
+		return EnumHasAnyFlags(Mask, Regions[Mannequin.Find(Name)]);
+	};
+
+	const EOculusXRBodyRegion HandsOnly = EOculusXRBodyRegion::Hands;
+	TestTrue("Wrists should be in the hands region", IsRetargeted(HandsOnly, TEXT("hand_l")));
+	TestTrue("Fingers should be in the hands region", IsRetargeted(HandsOnly, TEXT("index_03_l")));
+	TestTrue("Unmapped finger leaves should follow their finger", IsRetargeted(HandsOnly, TEXT("index_end_l")));
+	TestTrue("Bones attached to the hand should follow the hand", IsRetargeted(HandsOnly, TEXT("weapon_l")));
+	TestFalse("Arms should keep the input pose with only the hands", IsRetargeted(HandsOnly, TEXT("lowerarm_l")));
+	TestFalse("Arm twist bones should follow the arm", IsRetargeted(HandsOnly, TEXT("lowerarm_twist_01_l")));
+
+	const EOculusXRBodyRegion UpperBodyAndHead = EOculusXRBodyRegion::UpperBody | EOculusXRBodyRegion::Head;
+	TestTrue("Head should be retargeted with the head region", IsRetargeted(UpperBodyAndHead, TEXT("head")));
+	TestTrue("Mapped neck should be in the head region", IsRetargeted(EOculusXRBodyRegion::Head, TEXT("neck_02")));
+	TestTrue("Unmapped spine bones should follow their parent", IsRetargeted(UpperBodyAndHead, TEXT("spine_03")));
+	TestTrue("Root should be in the upper body region", IsRetargeted(UpperBodyAndHead, TEXT("root")));
+	TestTrue("Bones under the root should follow the root", IsRetargeted(UpperBodyAndHead, TEXT("ik_foot_root")));
+	TestFalse("Legs should keep the input pose without the legs region", IsRetargeted(UpperBodyAndHead, TEXT("thigh_l")));
+	TestFalse("Feet should keep the input pose without the legs region", IsRetargeted(UpperBodyAndHead, TEXT("ball_l")));
+	TestFalse("Hands should keep the input pose without the hands region", IsRetargeted(UpperBodyAndHead, TEXT("hand_l")));
+
+	for (int32 i = 0; i < Mannequin.Names.Num(); ++i)
+	{
+		TestTrue(FString::Printf(TEXT("%s should be retargeted with every region"), *Mannequin.Names[i].ToString()), EnumHasAnyFlags(EOculusXRBodyRegion::All, Regions[i]));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyFidelityTierFingersMannequin, "OculusXRRetargetingTests.FBodyFidelityTierFingersMannequin", BodyRetargetingTestFilters)
+inline bool FBodyFidelityTierFingersMannequin::RunTest(const FString& Parameters)
+{
+	const FMannequinHierarchy Mannequin;
+
+	TBitArray<> FingerJoints;
+	FOculusXRBodyRetargeter::GetFingerJoints(Mannequin.SourceJoints, Mannequin.ParentIndices, FingerJoints);
+	TestEqual("Every joint should be classified", FingerJoints.Num(), Mannequin.Names.Num());
+
+	// The No Fingers tier holds these joints
+	for (const TCHAR* Name : { TEXT("index_metacarpal_l"), TEXT("index_01_l"), TEXT("index_03_l"), TEXT("index_end_l"), TEXT("thumb_01_l") })
+	{
+		TestTrue(FString::Printf(TEXT("%s should be a finger joint"), Name), FingerJoints[Mannequin.Find(Name)]);
+	}
+	// The wrist, and what hangs off it, keeps following the tracked hand
+	for (const TCHAR* Name : { TEXT("hand_l"), TEXT("weapon_l"), TEXT("lowerarm_l"), TEXT("lowerarm_twist_01_l"), TEXT("head"), TEXT("ball_l"), TEXT("root") })
+	{
+		TestFalse(FString::Printf(TEXT("%s should not be a finger joint"), Name), FingerJoints[Mannequin.Find(Name)]);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRetargetBudgetSignificance, "OculusXRRetargetingTests.FRetargetBudgetSignificance", BodyRetargetingTestFilters)
+inline bool FRetargetBudgetSignificance::RunTest(const FString& Parameters)
+{
+	TestTrue("Fully significant avatars should get the full tier", FOculusXRRetargetBudgetManager::GetTierForSignificance(1.0f) == EOculusXRBodyFidelityTier::Full);
+	TestTrue("Insignificant avatars should be frozen", FOculusXRRetargetBudgetManager::GetTierForSignificance(0.0f) == EOculusXRBodyFidelityTier::Frozen);
+	TestEqual("Fully significant avatars should be retargeted every frame", FOculusXRRetargetBudgetManager::GetEvaluationRateDivisorForSignificance(1.0f), 1);
+
+	const IConsoleVariable* MaxDivisorVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("oculusxr.Movement.MaxEvaluationRateDivisor"));
+	TestNotNull("The largest divisor should be configurable", MaxDivisorVariable);
+	if (MaxDivisorVariable)
+	{
+		TestEqual("Insignificant avatars should get the largest divisor", FOculusXRRetargetBudgetManager::GetEvaluationRateDivisorForSignificance(0.0f), FMath::Max(MaxDivisorVariable->GetInt(), 1));
+	}
+
+	bool bTiersMonotonic = true;
+	bool bDivisorsMonotonic = true;
+	for (int32 i = 1; i <= 100; ++i)
+	{
+		const float Significance = i / 100.0f;
+		const float LowerSignificance = (i - 1) / 100.0f;
+		bTiersMonotonic &= FOculusXRRetargetBudgetManager::GetTierForSignificance(Significance) <= FOculusXRRetargetBudgetManager::GetTierForSignificance(LowerSignificance);
+		bDivisorsMonotonic &= FOculusXRRetargetBudgetManager::GetEvaluationRateDivisorForSignificance(Significance) <= FOculusXRRetargetBudgetManager::GetEvaluationRateDivisorForSignificance(LowerSignificance);
+	}
+	TestTrue("Less significant avatars should never get a higher tier", bTiersMonotonic);
+	TestTrue("Less significant avatars should never be retargeted more often", bDivisorsMonotonic);
+
+	return true;
+}
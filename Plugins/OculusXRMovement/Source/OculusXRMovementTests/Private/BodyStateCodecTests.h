@@ -0,0 +1,363 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/AutomationTest.h"
+#include "AnimNode_OculusXRBodyTracking.h"
+#include "OculusXRBodyStateCodec.h"
+#include "OculusXRBodyStateDeltaCodec.h"
+#include "OculusXRMovementRecording.h"
+#include "OculusXRSyntheticMovementDataProvider.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+#if UE_VERSION_OLDER_THAN(5, 5, 0)
+#define BodyStateCodecTestFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#define BodyStateCodecPerfFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter
+#else
+#define BodyStateCodecTestFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#define BodyStateCodecPerfFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter
+#endif // UE_VERSION_OLDER_THAN(5, 5, 0)
+
+// These tests check that the body state codec and its delta mode are bit exact, stay within their error bounds and report
+// their throughput.
+
+// A recorded session of synthetic tracking, stands in for a capture from a headset
+inline TSharedRef<FOculusXRMovementRecording> RecordSyntheticSession(const int32 NumFrames, const int32 Seed = 0)
+{
+	FOculusXRSyntheticMovementSettings Settings;
+	Settings.Seed = Seed;
+	const TSharedRef<FOculusXRSyntheticMovementDataProvider> Source = MakeShared<FOculusXRSyntheticMovementDataProvider>(Settings);
+	FOculusXRRecordingMovementDataProvider Recorder(Source);
+	FOculusXRBodyState BodyState;
+	for (int32 i = 0; i < NumFrames; ++i)
+	{
+		Source->SetTime(i / 72.0);
+		Recorder.GetBodyState(BodyState, 100.0f);
+	}
+	return Recorder.TakeRecording();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateCodecBitExact, "OculusXRRetargetingTests.FBodyStateCodecBitExact", BodyStateCodecTestFilters)
+inline bool FBodyStateCodecBitExact::RunTest(const FString& Parameters)
+{
+	const FOculusXRBodyStateCodec Codec{ FOculusXRBodyStateCodecSettings() };
+	const TSharedRef<FOculusXRMovementRecording> Recording = RecordSyntheticSession(20);
+
+	for (const FOculusXRMovementRecording::FBodyFrame& Frame : Recording->BodyFrames)
+	{
+		FOculusXRQuantizedBodyState Quantized;
+		Codec.Quantize(Frame.State, Quantized);
+		FBitWriter Writer(Codec.GetMaxEncodedBits(), false);
+		Codec.Write(Quantized, Writer);
+		TestFalse("Packet should fit the maximum size", Writer.IsError());
+
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		FOculusXRQuantizedBodyState Read;
+		TestTrue("Packet should be read", Codec.Read(Reader, Read));
+		TestEqual("Whole packet should be consumed", Reader.GetBitsLeft(), 0ll);
+		TestTrue("Header should match", Read.IsActive == Quantized.IsActive && Read.Confidence == Quantized.Confidence && Read.SkeletonChangedCount == Quantized.SkeletonChangedCount && Read.Time == Quantized.Time && Read.HipsPosition == Quantized.HipsPosition);
+		TestTrue("Joints should match bit for bit", Read.Joints == Quantized.Joints);
+
+		// Decoding and encoding again does not drift
+		FOculusXRBodyState Decoded;
+		Codec.Dequantize(Read, Decoded);
+		FOculusXRQuantizedBodyState Requantized;
+		Codec.Quantize(Decoded, Requantized);
+		FBitWriter Rewriter(Codec.GetMaxEncodedBits(), false);
+		Codec.Write(Requantized, Rewriter);
+		TestTrue("Encoding a decoded state should give the same packet",
+			Rewriter.GetNumBits() == Writer.GetNumBits() && FMemory::Memcmp(Rewriter.GetData(), Writer.GetData(), Writer.GetNumBytes()) == 0);
+	}
+
+	// Known values: identity rotation and a joint one precision step away from the hips
+	FOculusXRBodyState BodyState;
+	BodyState.IsActive = true;
+	BodyState.Confidence = 1.0f;
+	BodyState.Joints.SetNum(static_cast<int32>(EOculusXRBoneID::COUNT));
+	auto& Hips = BodyState.Joints[static_cast<int32>(EOculusXRBoneID::BodyHips)];
+	Hips.bIsValid = true;
+	Hips.Position = FVector(10.0, 20.0, 90.0);
+	auto& Spine = BodyState.Joints[static_cast<int32>(EOculusXRBoneID::BodySpineLower)];
+	Spine.bIsValid = true;
+	Spine.Position = Hips.Position + FVector(0.0, 0.0, Codec.GetSettings().PositionPrecision);
+
+	FOculusXRQuantizedBodyState Quantized;
+	Codec.Quantize(BodyState, Quantized);
+	const int32 SpineIdx = Codec.GetEncodedJoints().IndexOfByKey(EOculusXRBoneID::BodySpineLower);
+	const FOculusXRQuantizedBodyJoint& SpineJoint = Quantized.Joints[SpineIdx];
+	TestEqual("Identity should use W as the largest component", static_cast<int32>(SpineJoint.LargestComponent), 3);
+	TestEqual("Zero offsets should quantize to the same value", SpineJoint.Position[0], SpineJoint.Position[1]);
+
+	FOculusXRBodyState Decoded;
+	Codec.Dequantize(Quantized, Decoded);
+	TestTrue("Hips position should be exact", Decoded.Joints[static_cast<int32>(EOculusXRBoneID::BodyHips)].Position.Equals(Hips.Position, 1.e-3));
+	TestTrue("Offset should decode within the precision", Decoded.Joints[static_cast<int32>(EOculusXRBoneID::BodySpineLower)].Position.Equals(Spine.Position, Codec.GetMaxPositionError()));
+	TestTrue("Identity should decode to identity", Decoded.Joints[static_cast<int32>(EOculusXRBoneID::BodySpineLower)].Orientation.Equals(FRotator::ZeroRotator, 1.e-3f));
+	TestFalse("Invalid joints should stay invalid", Decoded.Joints[static_cast<int32>(EOculusXRBoneID::BodyHead)].bIsValid);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateCodecOmitsUnmappedJoints, "OculusXRRetargetingTests.FBodyStateCodecOmitsUnmappedJoints", BodyStateCodecTestFilters)
+inline bool FBodyStateCodecOmitsUnmappedJoints::RunTest(const FString& Parameters)
+{
+	const FAnimNode_OculusXRBodyTracking DefaultNode;
+	const FOculusXRBodyStateCodec FullCodec{ FOculusXRBodyStateCodecSettings() };
+	const FOculusXRBodyStateCodec MappedCodec(FOculusXRBodyStateCodecSettings(), &DefaultNode.GetBoneRemapping());
+	TestTrue("Joints mapped to no bone should not be encoded", MappedCodec.GetEncodedJoints().Num() < FullCodec.GetEncodedJoints().Num());
+	TestTrue("Omitting joints should make packets smaller", MappedCodec.GetMaxEncodedBits() < FullCodec.GetMaxEncodedBits());
+	TestTrue("Hips should always be encoded", MappedCodec.GetEncodedJoints().Contains(EOculusXRBoneID::BodyHips));
+
+	const TSharedRef<FOculusXRMovementRecording> Recording = RecordSyntheticSession(1);
+	FBitWriter Writer(MappedCodec.GetMaxEncodedBits(), false);
+	MappedCodec.Encode(Recording->BodyFrames[0].State, Writer);
+
+	FOculusXRBodyState Decoded;
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+	TestTrue("Packet should decode", MappedCodec.Decode(Reader, Decoded));
+	for (int32 i = 0; i < static_cast<int32>(EOculusXRBoneID::COUNT); ++i)
+	{
+		const bool bEncoded = MappedCodec.GetEncodedJoints().Contains(static_cast<EOculusXRBoneID>(i));
+		TestEqual(FString::Printf(TEXT("Joint %d should only be valid when encoded"), i), Decoded.Joints[i].bIsValid, bEncoded);
+	}
+
+	FBitReader MismatchedReader(Writer.GetData(), Writer.GetNumBits());
+	TestFalse("A codec with another layout should reject the packet", FullCodec.Decode(MismatchedReader, Decoded));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateCodecErrors, "OculusXRRetargetingTests.FBodyStateCodecErrors", BodyStateCodecTestFilters)
+inline bool FBodyStateCodecErrors::RunTest(const FString& Parameters)
+{
+	const TSharedRef<FOculusXRMovementRecording> Recording = RecordSyntheticSession(720);
+
+	for (const int32 RotationBits : { 9, 12, 15 })
+	{
+		FOculusXRBodyStateCodecSettings Settings;
+		for (int32 i = 0; i < static_cast<int32>(EOculusXRBoneID::COUNT); ++i)
+		{
+			Settings.RotationBits[i] = static_cast<uint8>(RotationBits);
+		}
+		const FOculusXRBodyStateCodec Codec(Settings);
+
+		FOculusXRBodyStateCodecErrorStats Stats;
+		int64 NumBits = 0;
+		FOculusXRBodyState Decoded;
+		for (const FOculusXRMovementRecording::FBodyFrame& Frame : Recording->BodyFrames)
+		{
+			FBitWriter Writer(Codec.GetMaxEncodedBits(), false);
+			Codec.Encode(Frame.State, Writer);
+			NumBits += Writer.GetNumBits();
+			FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+			Codec.Decode(Reader, Decoded);
+			Stats.Add(Frame.State, Decoded);
+		}
+
+		TestTrue("Rotation error should stay within the quantization bound", Stats.MaxRotationErrorDegrees <= Codec.GetMaxRotationErrorDegrees(0) + 1.e-3);
+		TestTrue("Position error should stay within the quantization bound", Stats.MaxPositionError <= Codec.GetMaxPositionError() + 1.e-3);
+		AddInfo(FString::Printf(TEXT("%d rotation bits: %.1f bytes per frame, %s"), RotationBits, NumBits / 8.0 / Recording->BodyFrames.Num(), *Stats.ToString()));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateCodecThroughput, "OculusXRRetargetingTests.FBodyStateCodecThroughput", BodyStateCodecPerfFilters)
+inline bool FBodyStateCodecThroughput::RunTest(const FString& Parameters)
+{
+	const int32 NumFrames = 5000;
+	const TSharedRef<FOculusXRMovementRecording> Recording = RecordSyntheticSession(500);
+	const FOculusXRBodyStateCodec Codec{ FOculusXRBodyStateCodecSettings() };
+
+	TArray<TArray<uint8>> Packets;
+	TArray<int64> PacketBits;
+	Packets.SetNum(NumFrames);
+	PacketBits.SetNum(NumFrames);
+
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumFrames; ++i)
+	{
+		FBitWriter Writer(Codec.GetMaxEncodedBits(), false);
+		Codec.Encode(Recording->BodyFrames[i % Recording->BodyFrames.Num()].State, Writer);
+		PacketBits[i] = Writer.GetNumBits();
+		Packets[i] = MoveTemp(*Writer.GetBuffer());
+	}
+	const double EncodeSeconds = FPlatformTime::Seconds() - StartTime;
+
+	FOculusXRBodyState Decoded;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumFrames; ++i)
+	{
+		FBitReader Reader(Packets[i].GetData(), PacketBits[i]);
+		Codec.Decode(Reader, Decoded);
+	}
+	const double DecodeSeconds = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("Encode %.0f frames/s, decode %.0f frames/s"), NumFrames / FMath::Max(EncodeSeconds, UE_SMALL_NUMBER), NumFrames / FMath::Max(DecodeSeconds, UE_SMALL_NUMBER)));
+	TestTrue("Encoding should run thousands of frames per second", NumFrames / FMath::Max(EncodeSeconds, UE_SMALL_NUMBER) > 1000.0);
+	TestTrue("Decoding should run thousands of frames per second", NumFrames / FMath::Max(DecodeSeconds, UE_SMALL_NUMBER) > 1000.0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateDeltaCodecIdle, "OculusXRRetargetingTests.FBodyStateDeltaCodecIdle", BodyStateCodecTestFilters)
+inline bool FBodyStateDeltaCodecIdle::RunTest(const FString& Parameters)
+{
+	const TSharedRef<const FOculusXRBodyStateCodec> Codec = MakeShared<FOculusXRBodyStateCodec>(FOculusXRBodyStateCodecSettings());
+	FOculusXRBodyStateDeltaEncoder Encoder(Codec);
+	FOculusXRBodyStateDeltaDecoder Decoder(Codec);
+	const TSharedRef<FOculusXRMovementRecording> Recording = RecordSyntheticSession(1);
+	const FOculusXRBodyState& BodyState = Recording->BodyFrames[0].State;
+
+	int64 KeyframeBits = 0;
+	FOculusXRBodyState Decoded;
+	for (int32 i = 0; i < 10; ++i)
+	{
+		FBitWriter Writer(Codec->GetMaxEncodedBits() + 64, false);
+		Encoder.Encode(BodyState, Writer);
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		uint16 Sequence = 0;
+		TestTrue("Packet should decode", Decoder.Decode(Reader, Decoded, Sequence));
+		Encoder.Ack(Sequence);
+
+		if (i == 0)
+		{
+			TestTrue("First packet should be a keyframe", Encoder.WasLastPacketKeyframe());
+			KeyframeBits = Writer.GetNumBits();
+		}
+		else
+		{
+			TestFalse("Later packets should be deltas", Encoder.WasLastPacketKeyframe());
+			TestEqual("An idle avatar should not send joints", Encoder.GetLastNumChangedJoints(), 0);
+			TestEqual("An idle avatar should not convert joints", Decoder.GetLastNumConvertedJoints(), 0);
+			TestTrue("An idle avatar should send a fraction of a keyframe", Writer.GetNumBits() * 4 < KeyframeBits);
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateDeltaCodecErrors, "OculusXRRetargetingTests.FBodyStateDeltaCodecErrors", BodyStateCodecTestFilters)
+inline bool FBodyStateDeltaCodecErrors::RunTest(const FString& Parameters)
+{
+	const TSharedRef<FOculusXRMovementRecording> Recording = RecordSyntheticSession(720);
+	const TSharedRef<const FOculusXRBodyStateCodec> Codec = MakeShared<FOculusXRBodyStateCodec>(FOculusXRBodyStateCodecSettings());
+	const FOculusXRBodyStateDeltaSettings Settings;
+	FOculusXRBodyStateDeltaEncoder Encoder(Codec, Settings);
+	FOculusXRBodyStateDeltaDecoder Decoder(Codec);
+
+	double MaxRotationBound = 0.0;
+	double MaxPositionBound = 0.0;
+	for (int32 i = 0; i < Codec->GetEncodedJoints().Num(); ++i)
+	{
+		const int32 BoneIdx = static_cast<int32>(Codec->GetEncodedJoints()[i]);
+		MaxRotationBound = FMath::Max(MaxRotationBound, Settings.RotationErrorDegrees[BoneIdx] + Codec->GetMaxRotationErrorDegrees(i));
+		MaxPositionBound = FMath::Max(MaxPositionBound, Settings.PositionError[BoneIdx] + 2.0 * Codec->GetMaxPositionError());
+	}
+
+	// Acks arrive with a few packets of delay, like they would over a network
+	const int32 AckDelay = 3;
+	TArray<uint16> InFlightAcks;
+	FOculusXRBodyStateCodecErrorStats Stats;
+	int64 NumBits = 0;
+	int32 NumKeyframes = 0;
+	FOculusXRBodyState Decoded;
+	for (const FOculusXRMovementRecording::FBodyFrame& Frame : Recording->BodyFrames)
+	{
+		FBitWriter Writer(Codec->GetMaxEncodedBits() + 64, false);
+		Encoder.Encode(Frame.State, Writer);
+		NumBits += Writer.GetNumBits();
+		NumKeyframes += Encoder.WasLastPacketKeyframe() ? 1 : 0;
+
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		uint16 Sequence = 0;
+		TestTrue("Packet should decode", Decoder.Decode(Reader, Decoded, Sequence));
+		Stats.Add(Frame.State, Decoded);
+
+		InFlightAcks.Add(Sequence);
+		if (InFlightAcks.Num() > AckDelay)
+		{
+			Encoder.Ack(InFlightAcks[0]);
+			InFlightAcks.RemoveAt(0);
+		}
+	}
+
+	const double FullBytes = Codec->GetMaxEncodedBits() / 8.0;
+	const double DeltaBytes = NumBits / 8.0 / Recording->BodyFrames.Num();
+	AddInfo(FString::Printf(TEXT("Delta %.1f bytes per frame vs %.1f for full packets, %d keyframes, %s"), DeltaBytes, FullBytes, NumKeyframes, *Stats.ToString()));
+	TestTrue("Rotation error should stay within the delta bound", Stats.MaxRotationErrorDegrees <= MaxRotationBound + 1.e-3);
+	TestTrue("Position error should stay within the delta bound", Stats.MaxPositionError <= MaxPositionBound + 1.e-3);
+	TestTrue("Deltas should be smaller than full packets", DeltaBytes < FullBytes);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBodyStateDeltaCodecKeyframes, "OculusXRRetargetingTests.FBodyStateDeltaCodecKeyframes", BodyStateCodecTestFilters)
+inline bool FBodyStateDeltaCodecKeyframes::RunTest(const FString& Parameters)
+{
+	const TSharedRef<FOculusXRMovementRecording> Recording = RecordSyntheticSession(40);
+	const TSharedRef<const FOculusXRBodyStateCodec> Codec = MakeShared<FOculusXRBodyStateCodec>(FOculusXRBodyStateCodecSettings());
+	FOculusXRBodyStateDeltaSettings Settings;
+	Settings.KeyframeInterval = 8;
+
+	auto EncodePacket = [&Codec](FOculusXRBodyStateDeltaEncoder& Encoder, const FOculusXRBodyState& BodyState) {
+		FBitWriter Writer(Codec->GetMaxEncodedBits() + 64, false);
+		Encoder.Encode(BodyState, Writer);
+		return TPair<TArray<uint8>, int64>(*Writer.GetBuffer(), Writer.GetNumBits());
+	};
+
+	// Without acks every packet is a keyframe
+	FOculusXRBodyStateDeltaEncoder UnackedEncoder(Codec, Settings);
+	for (int32 i = 0; i < 5; ++i)
+	{
+		EncodePacket(UnackedEncoder, Recording->BodyFrames[i].State);
+		TestTrue("Packets should be keyframes until acked", UnackedEncoder.WasLastPacketKeyframe());
+	}
+
+	// With acks keyframes come at the interval
+	FOculusXRBodyStateDeltaEncoder Encoder(Codec, Settings);
+	FOculusXRBodyStateDeltaDecoder Decoder(Codec);
+	FOculusXRBodyState Decoded;
+	int32 LastKeyframe = INDEX_NONE;
+	for (int32 i = 0; i < 25; ++i)
+	{
+		const TPair<TArray<uint8>, int64> Packet = EncodePacket(Encoder, Recording->BodyFrames[i].State);
+		if (Encoder.WasLastPacketKeyframe())
+		{
+			TestTrue("Keyframes should come at the interval", LastKeyframe == INDEX_NONE || i - LastKeyframe == Settings.KeyframeInterval);
+			LastKeyframe = i;
+		}
+		FBitReader Reader(Packet.Key.GetData(), Packet.Value);
+		uint16 Sequence = 0;
+		Decoder.Decode(Reader, Decoded, Sequence);
+		Encoder.Ack(Sequence);
+	}
+	TestTrue("Keyframes should have been sent", LastKeyframe > 0);
+
+	// A receiver that missed the baseline rejects deltas and recovers on the next keyframe
+	FOculusXRBodyStateDeltaDecoder LateDecoder(Codec);
+	bool bRecovered = false;
+	for (int32 i = 25; i < 40; ++i)
+	{
+		const TPair<TArray<uint8>, int64> Packet = EncodePacket(Encoder, Recording->BodyFrames[i].State);
+		FBitReader Reader(Packet.Key.GetData(), Packet.Value);
+		uint16 Sequence = 0;
+		const bool bDecoded = LateDecoder.Decode(Reader, Decoded, Sequence);
+		bRecovered |= Encoder.WasLastPacketKeyframe() && bDecoded;
+		if (!bRecovered)
+		{
+			TestFalse("Deltas against an unknown baseline should be rejected", bDecoded);
+		}
+	}
+	TestTrue("A keyframe should let the receiver recover", bRecovered);
+
+	return true;
+}
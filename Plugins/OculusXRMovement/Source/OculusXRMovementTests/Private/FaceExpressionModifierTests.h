@@ -0,0 +1,151 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/AutomationTest.h"
+#include "AnimNode_OculusXRFaceTracking.h"
+#include "OculusXRFaceExpressionModifiers.h"
+
+#if UE_VERSION_OLDER_THAN(5, 5, 0)
+#define FaceExpressionModifierTestFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#define FaceExpressionModifierPerfFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter
+#else
+#define FaceExpressionModifierTestFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#define FaceExpressionModifierPerfFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter
+#endif // UE_VERSION_OLDER_THAN(5, 5, 0)
+
+// These tests check that the vectorized expression modifiers match the per expression ones, and how much faster they are.
+
+inline FOculusXRFaceExpressionModifierNew MakeRandomExpressionModifier(FRandomStream& Random, const bool bWithResponse)
+{
+	FOculusXRFaceExpressionModifierNew Modifier;
+	Modifier.Multiplier = Random.FRandRange(0.5f, 2.0f);
+	Modifier.MinValue = Random.FRandRange(0.0f, 0.2f);
+	Modifier.MaxValue = Random.FRandRange(0.6f, 1.0f);
+	Modifier.ResponseExponent = bWithResponse ? Random.FRandRange(0.5f, 2.0f) : 1.0f;
+	return Modifier;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFaceExpressionModifiersMatchScalar, "OculusXRRetargetingTests.FFaceExpressionModifiersMatchScalar", FaceExpressionModifierTestFilters)
+inline bool FFaceExpressionModifiersMatchScalar::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(7);
+	for (const int32 NumExpressions : { 3, 70, 250 })
+	{
+		// Trackers can report slightly negative weights, they must not depend on the lane they land in
+		TArray<float> Weights;
+		for (int32 i = 0; i < NumExpressions; ++i)
+		{
+			Weights.Add(Random.FRandRange(-0.25f, 1.0f));
+		}
+
+		// Identity by default
+		FOculusXRFaceExpressionModifiers Modifiers(NumExpressions);
+		TArray<float> Modified;
+		Modified.SetNumUninitialized(NumExpressions);
+		Modifiers.Apply(Weights.GetData(), Modified.GetData());
+		TestTrue("Weights without modifiers should be left as is", Modified == Weights);
+
+		for (const bool bWithResponse : { false, true })
+		{
+			TArray<FOculusXRFaceExpressionModifierNew> Reference;
+			Modifiers.Reset(NumExpressions);
+			for (int32 i = 0; i < NumExpressions; i += 2)
+			{
+				Reference.Add(MakeRandomExpressionModifier(Random, bWithResponse));
+				Modifiers.Set(i, Reference.Last());
+			}
+			TestEqual("Response should only be evaluated when used", Modifiers.HasResponse(), bWithResponse);
+
+			Modifiers.Apply(Weights.GetData(), Modified.GetData());
+			float MaxError = 0.0f;
+			for (int32 i = 0; i < NumExpressions; ++i)
+			{
+				const float Expected = i % 2 == 0 ? FOculusXRFaceExpressionModifiers::Apply(Reference[i / 2], Weights[i]) : Weights[i];
+				MaxError = FMath::Max(MaxError, FMath::Abs(Modified[i] - Expected));
+			}
+			TestTrue(FString::Printf(TEXT("%d expressions should match the scalar modifiers"), NumExpressions), MaxError < 1.e-4f);
+			bool bKeepsNegativeWeights = true;
+			for (int32 i = 1; i < NumExpressions; i += 2)
+			{
+				bKeepsNegativeWeights &= Modified[i] == Weights[i];
+			}
+			TestTrue("Expressions without a modifier should keep their weight, negative ones included", bKeepsNegativeWeights);
+
+			// In place
+			TArray<float> InPlace = Weights;
+			Modifiers.Apply(InPlace.GetData(), InPlace.GetData());
+			TestTrue("Modifying in place should give the same weights", InPlace == Modified);
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFaceExpressionModifiersThroughput, "OculusXRRetargetingTests.FFaceExpressionModifiersThroughput", FaceExpressionModifierPerfFilters)
+inline bool FFaceExpressionModifiersThroughput::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumIterations = 20000;
+	FRandomStream Random(3);
+	for (const int32 NumExpressions : { 70, 250 })
+	{
+		TArray<float> Weights;
+		for (int32 i = 0; i < NumExpressions; ++i)
+		{
+			Weights.Add(Random.FRand());
+		}
+
+		for (const bool bWithResponse : { false, true })
+		{
+			// What the node did before: a map of modifiers looked up and copied for every expression
+			TMap<int32, FOculusXRFaceExpressionModifierNew> ModifierMap;
+			FOculusXRFaceExpressionModifiers Modifiers(NumExpressions);
+			for (int32 i = 0; i < NumExpressions; ++i)
+			{
+				const FOculusXRFaceExpressionModifierNew& Modifier = ModifierMap.Add(i, MakeRandomExpressionModifier(Random, bWithResponse));
+				Modifiers.Set(i, Modifier);
+			}
+
+			TArray<float> Modified;
+			Modified.SetNumUninitialized(NumExpressions);
+			double Checksum = 0.0;
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				for (int32 i = 0; i < NumExpressions; ++i)
+				{
+					if (ModifierMap.Contains(i))
+					{
+						const FOculusXRFaceExpressionModifierNew Modifier = ModifierMap[i];
+						Modified[i] = FOculusXRFaceExpressionModifiers::Apply(Modifier, Weights[i]);
+					}
+				}
+				Checksum += Modified[Iteration % NumExpressions];
+			}
+			const double ScalarSeconds = FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				Modifiers.Apply(Weights.GetData(), Modified.GetData());
+				Checksum += Modified[Iteration % NumExpressions];
+			}
+			const double VectorSeconds = FPlatformTime::Seconds() - StartTime;
+
+			const double NumWeights = static_cast<double>(NumIterations) * NumExpressions;
+			AddInfo(FString::Printf(TEXT("%d expressions%s: map lookups %.2f ns/weight, vectorized %.2f ns/weight (%.1fx), checksum %.1f"),
+				NumExpressions, bWithResponse ? TEXT(" with response") : TEXT(""), ScalarSeconds * 1.e9 / NumWeights, VectorSeconds * 1.e9 / NumWeights,
+				ScalarSeconds / FMath::Max(VectorSeconds, UE_SMALL_NUMBER), Checksum));
+			TestTrue("Vectorized modifiers should be faster than map lookups", VectorSeconds < ScalarSeconds);
+		}
+	}
+
+	return true;
+}
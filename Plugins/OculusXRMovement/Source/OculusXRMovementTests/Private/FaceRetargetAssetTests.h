@@ -0,0 +1,406 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/AutomationTest.h"
+#include "Algo/AllOf.h"
+#include "AnimNode_OculusXRFaceTracking.h"
+#include "Animation/AnimCurveUtils.h"
+#include "OculusXRFaceMorphTargetsComponent.h"
+#include "OculusXRFaceRetargetAsset.h"
+#include "OculusXRRetargetingUtils.h"
+#include "OculusXRSyntheticMovementDataProvider.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#if UE_VERSION_OLDER_THAN(5, 5, 0)
+#define FaceRetargetAssetTestFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#define FaceRetargetAssetPerfFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter
+#else
+#define FaceRetargetAssetTestFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#define FaceRetargetAssetPerfFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter
+#endif // UE_VERSION_OLDER_THAN(5, 5, 0)
+
+// These tests check that face retarget assets mix expressions into curves like the dense weighted sums they stand for,
+// also once trimmed for a LOD or saved, and that curves held by a change threshold stay within it.
+
+// A rig of NumCurves curves, each mixing a few random expressions
+inline TArray<FOculusXRFaceRetargetCurve> MakeRandomFaceRig(const int32 NumCurves, const int32 ExpressionsPerCurve, const int32 Seed)
+{
+	FRandomStream Random(Seed);
+	TArray<FOculusXRFaceRetargetCurve> Curves;
+	for (int32 i = 0; i < NumCurves; ++i)
+	{
+		FOculusXRFaceRetargetCurve& Curve = Curves.AddDefaulted_GetRef();
+		Curve.CurveName = FName(*FString::Printf(TEXT("ctrl_expressions_%d"), i));
+		for (int32 j = 0; j < ExpressionsPerCurve; ++j)
+		{
+			FOculusXRFaceRetargetWeight& Weight = Curve.Expressions.AddDefaulted_GetRef();
+			Weight.Expression = static_cast<EOculusXRFaceExpression>(Random.RandHelper(static_cast<int32>(EOculusXRFaceExpression::COUNT)));
+			Weight.Weight = Random.FRandRange(-0.5f, 1.0f);
+		}
+	}
+	return Curves;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFaceRetargetMatrixMatchesDense, "OculusXRRetargetingTests.FFaceRetargetMatrixMatchesDense", FaceRetargetAssetTestFilters)
+inline bool FFaceRetargetMatrixMatchesDense::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumExpressions = static_cast<int32>(EOculusXRFaceExpression::COUNT);
+	FRandomStream Random(11);
+	TArray<float> Weights;
+	for (int32 i = 0; i < NumExpressions; ++i)
+	{
+		Weights.Add(Random.FRand());
+	}
+
+	// A curve listed twice, and an expression repeated within a curve
+	TArray<FOculusXRFaceRetargetCurve> Curves = MakeRandomFaceRig(40, 4, 5);
+	const FOculusXRFaceRetargetCurve DuplicateCurve = Curves[3];
+	const FOculusXRFaceRetargetWeight DuplicateWeight = Curves[7].Expressions[0];
+	Curves.Add(DuplicateCurve);
+	Curves[7].Expressions.Add(DuplicateWeight);
+
+	UOculusXRFaceRetargetAsset* Asset = NewObject<UOculusXRFaceRetargetAsset>();
+	Asset->Curves = Curves;
+	Asset->bClampOutput = false;
+	Asset->CompileMatrix();
+	const FOculusXRFaceRetargetMatrix& Matrix = Asset->GetMatrix();
+	TestEqual("Curves listed twice should share a row", Matrix.GetNumCurves(), 40);
+	TestEqual("Rows should be delimited", Matrix.RowOffsets.Num(), Matrix.GetNumCurves() + 1);
+
+	bool bSorted = true;
+	for (int32 i = 1; i < Matrix.GetNumCurves(); ++i)
+	{
+		bSorted &= Matrix.CurveNames[i - 1].FastLess(Matrix.CurveNames[i]);
+	}
+	TestTrue("Rows should be sorted like pose curves", bSorted);
+
+	// Dense reference: every listed weight adds up
+	TMap<FName, float> Expected;
+	for (const FOculusXRFaceRetargetCurve& Curve : Curves)
+	{
+		float& Value = Expected.FindOrAdd(Curve.CurveName);
+		for (const FOculusXRFaceRetargetWeight& Weight : Curve.Expressions)
+		{
+			Value += Weight.Weight * Weights[static_cast<int32>(Weight.Expression)];
+		}
+	}
+
+	TArray<float> CurveValues;
+	CurveValues.SetNumUninitialized(Matrix.GetNumCurves());
+	Matrix.Multiply(Weights.GetData(), CurveValues.GetData());
+	float MaxError = 0.0f;
+	for (int32 i = 0; i < Matrix.GetNumCurves(); ++i)
+	{
+		MaxError = FMath::Max(MaxError, FMath::Abs(CurveValues[i] - Expected.FindRef(Matrix.CurveNames[i])));
+	}
+	TestTrue("Sparse product should match the dense sums", MaxError < 1.e-5f);
+
+	FOculusXRFaceRetargetMatrix Clamped = FOculusXRFaceRetargetMatrix::Build(Curves, true);
+	Clamped.Multiply(Weights.GetData(), CurveValues.GetData());
+	TestTrue("Clamped curves should stay within [0, 1]", Algo::AllOf(CurveValues, [](const float Value) { return Value >= 0.0f && Value <= 1.0f; }));
+
+	// The default names map every expression to its own curve with a weight of 1
+	const FOculusXRFaceRetargetMatrix NameMatrix = FOculusXRFaceRetargetMatrix::Build(UOculusXRFaceRetargetAsset::GetDefaultExpressionNames());
+	TestEqual("Every default curve should get a row", NameMatrix.GetNumCurves(), UOculusXRFaceRetargetAsset::GetDefaultExpressionNames().Num());
+	TestEqual("Every row should hold a single expression", NameMatrix.GetNumNonZeros(), NameMatrix.GetNumCurves());
+	CurveValues.SetNumUninitialized(NameMatrix.GetNumCurves());
+	NameMatrix.Multiply(Weights.GetData(), CurveValues.GetData());
+	const int32 JawDropRow = NameMatrix.CurveNames.IndexOfByKey(FName("jawDrop"));
+	TestTrue("A named curve should carry its expression's weight", JawDropRow != INDEX_NONE && CurveValues[JawDropRow] == Weights[static_cast<int32>(EOculusXRFaceExpression::JawDrop)]);
+
+	// LOD culling: trimmed rows keep their order and their values
+	const FOculusXRFaceRetargetMatrix Trimmed = Matrix.Trim([](const FName CurveName) { return CurveName.ToString().EndsWith(TEXT("0")) || CurveName.ToString().EndsWith(TEXT("5")); });
+	TestEqual("Culled curves should be dropped", Trimmed.GetNumCurves(), 8);
+	TestEqual("Trimmed rows should be delimited", Trimmed.RowOffsets.Num(), Trimmed.GetNumCurves() + 1);
+	TArray<float> FullValues;
+	FullValues.SetNumUninitialized(Matrix.GetNumCurves());
+	Matrix.Multiply(Weights.GetData(), FullValues.GetData());
+	CurveValues.SetNumUninitialized(Trimmed.GetNumCurves());
+	Trimmed.Multiply(Weights.GetData(), CurveValues.GetData());
+	bool bTrimmedMatches = true;
+	for (int32 i = 0; i < Trimmed.GetNumCurves(); ++i)
+	{
+		const int32 FullRow = Matrix.CurveNames.IndexOfByKey(Trimmed.CurveNames[i]);
+		bTrimmedMatches &= FullRow != INDEX_NONE && FullValues[FullRow] == CurveValues[i] && (i == 0 || Trimmed.CurveNames[i - 1].FastLess(Trimmed.CurveNames[i]));
+	}
+	TestTrue("Kept curves should evaluate as in the full table", bTrimmedMatches);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFaceRetargetMatrixSerialization, "OculusXRRetargetingTests.FFaceRetargetMatrixSerialization", FaceRetargetAssetTestFilters)
+inline bool FFaceRetargetMatrixSerialization::RunTest(const FString& Parameters)
+{
+	FOculusXRFaceRetargetMatrix Matrix = FOculusXRFaceRetargetMatrix::Build(MakeRandomFaceRig(60, 3, 9), false);
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	TestTrue("Saving should succeed", Matrix.Serialize(Writer));
+
+	FOculusXRFaceRetargetMatrix Loaded;
+	FMemoryReader Reader(Data);
+	TestTrue("Loading should succeed", Loaded.Serialize(Reader));
+	TestTrue("Loaded rows should match", Loaded.CurveNames == Matrix.CurveNames && Loaded.RowOffsets == Matrix.RowOffsets);
+	TestTrue("Loaded weights should match", Loaded.Columns == Matrix.Columns && Loaded.Values == Matrix.Values);
+	TestTrue("Loaded settings should match", Loaded.bClampOutput == Matrix.bClampOutput && Loaded.GetNumExpressions() == Matrix.GetNumExpressions());
+	TestTrue("Loaded rows should be sorted", Loaded.AreRowsSorted());
+
+	// Another process orders names differently: rows saved in any order are sorted again when loaded
+	FOculusXRFaceRetargetMatrix Reversed = Matrix;
+	Reversed.CurveNames.Reset();
+	Reversed.RowOffsets.Reset();
+	Reversed.Columns.Reset();
+	Reversed.Values.Reset();
+	Reversed.RowOffsets.Add(0);
+	for (int32 Row = Matrix.GetNumCurves() - 1; Row >= 0; --Row)
+	{
+		Reversed.CurveNames.Add(Matrix.CurveNames[Row]);
+		for (int32 i = Matrix.RowOffsets[Row]; i < Matrix.RowOffsets[Row + 1]; ++i)
+		{
+			Reversed.Columns.Add(Matrix.Columns[i]);
+			Reversed.Values.Add(Matrix.Values[i]);
+		}
+		Reversed.RowOffsets.Add(Reversed.Columns.Num());
+	}
+	TestFalse("Reversed rows should not be sorted", Reversed.AreRowsSorted());
+	Data.Reset();
+	FMemoryWriter ReversedWriter(Data);
+	Reversed.Serialize(ReversedWriter);
+	FMemoryReader ReversedReader(Data);
+	TestTrue("Loading unsorted rows should succeed", Loaded.Serialize(ReversedReader));
+	TestTrue("Unsorted rows should be sorted when loaded", Loaded.AreRowsSorted());
+	TestTrue("Sorted rows should keep their weights", Loaded.CurveNames == Matrix.CurveNames && Loaded.RowOffsets == Matrix.RowOffsets && Loaded.Columns == Matrix.Columns && Loaded.Values == Matrix.Values);
+
+	// A column out of range must not make it to evaluation
+	Matrix.Columns[3] = 1000;
+	Data.Reset();
+	FMemoryWriter CorruptWriter(Data);
+	Matrix.Serialize(CorruptWriter);
+	FMemoryReader CorruptReader(Data);
+	TestFalse("Corrupt matrices should be rejected", Loaded.Serialize(CorruptReader));
+	TestEqual("A rejected matrix should be empty", Loaded.GetNumCurves(), 0);
+	TestFalse("A rejected matrix should leave the archive usable", CorruptReader.IsError());
+
+	// More expressions than the weights callers pass in, edited after the magic and version
+	Matrix.Columns[3] = 0;
+	Data.Reset();
+	FMemoryWriter TooManyExpressionsWriter(Data);
+	Matrix.Serialize(TooManyExpressionsWriter);
+	const int32 TooManyExpressions = static_cast<int32>(EOculusXRFaceExpression::COUNT) + 1;
+	FMemory::Memcpy(Data.GetData() + 2 * sizeof(uint32), &TooManyExpressions, sizeof(int32));
+	FMemoryReader TooManyExpressionsReader(Data);
+	TestFalse("Matrices with more expressions than the face state should be rejected", Loaded.Serialize(TooManyExpressionsReader));
+	TestEqual("A matrix rejected for its expressions should be empty", Loaded.GetNumCurves(), 0);
+	TestEqual("A matrix rejected for its expressions should have no expressions", Loaded.GetNumExpressions(), 0);
+
+	// Coverage of a target skeleton's curves
+	const TArray<FName> TargetCurves = { Matrix.CurveNames[0], Matrix.CurveNames[1], FName("jawOpen") };
+	TArray<FName> UncoveredCurves, UnknownCurves;
+	Matrix.FindCoverage(TargetCurves, UncoveredCurves, UnknownCurves);
+	TestTrue("Target curves without a row should be reported", UncoveredCurves == TArray<FName>({ FName("jawOpen") }));
+	TestEqual("Rows without a target curve should be reported", UnknownCurves.Num(), Matrix.GetNumCurves() - 2);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFaceCurveChangeThreshold, "OculusXRRetargetingTests.FFaceCurveChangeThreshold", FaceRetargetAssetTestFilters)
+inline bool FFaceCurveChangeThreshold::RunTest(const FString& Parameters)
+{
+	const FOculusXRFaceRetargetMatrix& Matrix = *UOculusXRFaceRetargetAsset::GetDefaultMatrix();
+	const int32 NumCurves = Matrix.GetNumCurves();
+	constexpr int32 NumFrames = 600;
+
+	// Curve writes per frame and largest lag of the emitted curves, for growing thresholds
+	TArray<int32> NumWritten;
+	for (const float Threshold : { 0.0f, 0.01f, 0.03f })
+	{
+		const TSharedRef<FOculusXRSyntheticMovementDataProvider> Source = MakeShared<FOculusXRSyntheticMovementDataProvider>(FOculusXRSyntheticMovementSettings());
+		FOculusXRFaceState FaceState;
+		TArray<float> CurveValues, EmittedValues;
+		CurveValues.SetNumZeroed(NumCurves);
+		EmittedValues.SetNumZeroed(NumCurves);
+		int32 Written = 0;
+		float MaxLag = 0.0f;
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			Source->SetTime(Frame / 72.0);
+			Source->GetFaceState(FaceState);
+			Matrix.Multiply(FaceState.ExpressionWeights.GetData(), CurveValues.GetData());
+			Written += FOculusXRRetargetingUtils::UpdateChangedValues(CurveValues, EmittedValues, Threshold);
+			for (int32 i = 0; i < NumCurves; ++i)
+			{
+				MaxLag = FMath::Max(MaxLag, FMath::Abs(CurveValues[i] - EmittedValues[i]));
+			}
+		}
+		AddInfo(FString::Printf(TEXT("Threshold %.2f: %.1f of %d curves written per frame, largest lag %.4f"), Threshold, static_cast<float>(Written) / NumFrames, NumCurves, MaxLag));
+		TestTrue("Emitted curves should stay within the threshold", MaxLag <= Threshold);
+		NumWritten.Add(Written);
+	}
+	TestTrue("A threshold should cut curve writes", NumWritten[1] < NumWritten[0] && NumWritten[2] < NumWritten[1]);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFaceRetargetMatrixThroughput, "OculusXRRetargetingTests.FFaceRetargetMatrixThroughput", FaceRetargetAssetPerfFilters)
+inline bool FFaceRetargetMatrixThroughput::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumExpressions = static_cast<int32>(EOculusXRFaceExpression::COUNT);
+	constexpr int32 NumIterations = 2000;
+	FRandomStream Random(2);
+	TArray<float> Weights;
+	for (int32 i = 0; i < NumExpressions; ++i)
+	{
+		Weights.Add(Random.FRand());
+	}
+
+	// ARKit sized and MetaHuman sized rigs
+	for (const int32 NumCurves : { 52, 800 })
+	{
+		const TArray<FOculusXRFaceRetargetCurve> Curves = MakeRandomFaceRig(NumCurves, 4, NumCurves);
+		const FOculusXRFaceRetargetMatrix Matrix = FOculusXRFaceRetargetMatrix::Build(Curves, true);
+
+		// What the blueprint math after the node amounts to: read every source curve by name, then mix
+		TMap<FName, float> ExpressionCurves;
+		TArray<FName> ExpressionCurveNames;
+		ExpressionCurveNames.SetNum(NumExpressions);
+		for (const auto& ExpressionNames : UOculusXRFaceRetargetAsset::GetDefaultExpressionNames())
+		{
+			ExpressionCurveNames[static_cast<int32>(ExpressionNames.Key)] = ExpressionNames.Value.CurveNames[0];
+		}
+
+		TArray<float> CurveValues;
+		CurveValues.SetNumUninitialized(Matrix.GetNumCurves());
+		double Checksum = 0.0;
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			for (int32 i = 0; i < NumExpressions; ++i)
+			{
+				ExpressionCurves.Add(ExpressionCurveNames[i], Weights[i]);
+			}
+			for (int32 i = 0; i < Curves.Num(); ++i)
+			{
+				float Value = 0.0f;
+				for (const FOculusXRFaceRetargetWeight& Weight : Curves[i].Expressions)
+				{
+					Value += Weight.Weight * ExpressionCurves.FindRef(ExpressionCurveNames[static_cast<int32>(Weight.Expression)]);
+				}
+				CurveValues[i] = FMath::Clamp(Value, 0.0f, 1.0f);
+			}
+			Checksum += CurveValues[Iteration % Curves.Num()];
+		}
+		const double LookupSeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			Matrix.Multiply(Weights.GetData(), CurveValues.GetData());
+			Checksum += CurveValues[Iteration % Matrix.GetNumCurves()];
+		}
+		const double MatrixSeconds = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(TEXT("%d curves, %d non zeros: lookups %.2f us/frame, sparse product %.2f us/frame (%.1fx), checksum %.1f"),
+			Matrix.GetNumCurves(), Matrix.GetNumNonZeros(), LookupSeconds * 1.e6 / NumIterations, MatrixSeconds * 1.e6 / NumIterations,
+			LookupSeconds / FMath::Max(MatrixSeconds, UE_SMALL_NUMBER), Checksum));
+		TestTrue("The sparse product should be faster than mixing curves by name", MatrixSeconds < LookupSeconds);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFaceMorphTargetOutputThroughput, "OculusXRRetargetingTests.FFaceMorphTargetOutputThroughput", FaceRetargetAssetPerfFilters)
+inline bool FFaceMorphTargetOutputThroughput::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumExpressions = static_cast<int32>(EOculusXRFaceExpression::COUNT);
+	constexpr int32 NumIterations = 2000;
+	FRandomStream Random(4);
+	TArray<float> Weights;
+	for (int32 i = 0; i < NumExpressions; ++i)
+	{
+		Weights.Add(Random.FRand());
+	}
+
+	// One morph target per expression, and a MetaHuman sized rig
+	const TArray<FOculusXRFaceRetargetMatrix> Matrices = {
+		*UOculusXRFaceRetargetAsset::GetDefaultMatrix(),
+		FOculusXRFaceRetargetMatrix::Build(MakeRandomFaceRig(800, 4, 800), true)
+	};
+	for (const FOculusXRFaceRetargetMatrix& Matrix : Matrices)
+	{
+		// The mesh has a morph target for every curve, in another order
+		TMap<FName, int32> MorphTargetIndices;
+		for (int32 i = Matrix.GetNumCurves() - 1; i >= 0; --i)
+		{
+			MorphTargetIndices.Add(Matrix.CurveNames[i], MorphTargetIndices.Num());
+		}
+		TArray<float> MorphTargetWeights;
+		MorphTargetWeights.SetNumZeroed(MorphTargetIndices.Num());
+
+		FOculusXRFaceMorphTargetWriter Writer;
+		Writer.Initialize(Matrix, [&MorphTargetIndices](const FName CurveName) {
+			const int32* MorphTargetIndex = MorphTargetIndices.Find(CurveName);
+			return MorphTargetIndex ? *MorphTargetIndex : INDEX_NONE;
+		});
+		TestEqual("Every curve should resolve to a morph target", Writer.GetNumMorphTargets(), Matrix.GetNumCurves());
+
+		// Curve path: the node builds and merges curves, then the mesh resolves every curve to its morph target by name
+		FBlendedHeapCurve InputCurves;
+		UE::Anim::FCurveUtils::BuildSorted(InputCurves, 8, [](const int32 Index) { return FName(TEXT("body_curve"), Index + 1); }, [](const int32 Index) { return 1.0f; });
+		TArray<float> CurveValues;
+		CurveValues.SetNumUninitialized(Matrix.GetNumCurves());
+		double Checksum = 0.0;
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			Weights[Iteration % NumExpressions] = Random.FRand();
+			Matrix.Multiply(Weights.GetData(), CurveValues.GetData());
+			FBlendedHeapCurve FaceCurves;
+			UE::Anim::FCurveUtils::BuildSorted(FaceCurves, Matrix.GetNumCurves(),
+				[&Matrix](const int32 Index) { return Matrix.CurveNames[Index]; },
+				[&CurveValues](const int32 Index) { return CurveValues[Index]; });
+			FBlendedHeapCurve PoseCurves = InputCurves;
+			PoseCurves.Combine(FaceCurves);
+			PoseCurves.ForEachElement([&MorphTargetIndices, &MorphTargetWeights](const UE::Anim::FCurveElement& Element) {
+				if (const int32* MorphTargetIndex = MorphTargetIndices.Find(Element.Name))
+				{
+					MorphTargetWeights[*MorphTargetIndex] = Element.Value;
+				}
+			});
+			Checksum += MorphTargetWeights[Iteration % MorphTargetWeights.Num()];
+		}
+		const double CurveSeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			Weights[Iteration % NumExpressions] = Random.FRand();
+			Writer.Write(Weights.GetData(), MorphTargetWeights);
+			Checksum += MorphTargetWeights[Iteration % MorphTargetWeights.Num()];
+		}
+		const double DirectSeconds = FPlatformTime::Seconds() - StartTime;
+
+		// Both paths from the same weights should agree
+		Matrix.Multiply(Weights.GetData(), CurveValues.GetData());
+		bool bWeightsMatch = true;
+		for (int32 i = 0; i < Matrix.GetNumCurves(); ++i)
+		{
+			bWeightsMatch &= MorphTargetWeights[MorphTargetIndices[Matrix.CurveNames[i]]] == CurveValues[i];
+		}
+		TestTrue("Direct weights should match the curve values", bWeightsMatch);
+
+		AddInfo(FString::Printf(TEXT("%d morph targets: curves %.2f us/frame, direct %.2f us/frame (%.1fx), checksum %.1f"),
+			Matrix.GetNumCurves(), CurveSeconds * 1.e6 / NumIterations, DirectSeconds * 1.e6 / NumIterations,
+			CurveSeconds / FMath::Max(DirectSeconds, UE_SMALL_NUMBER), Checksum));
+		TestTrue("Writing morph targets directly should be faster than going through curves", DirectSeconds < CurveSeconds);
+	}
+
+	return true;
+}
@@ -0,0 +1,236 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/AutomationTest.h"
+#include "OculusXRFaceStateCodec.h"
+#include "OculusXRMovementRecording.h"
+#include "OculusXRSyntheticMovementDataProvider.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+#if UE_VERSION_OLDER_THAN(5, 5, 0)
+#define FaceStateCodecTestFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#define FaceStateCodecPerfFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter
+#else
+#define FaceStateCodecTestFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#define FaceStateCodecPerfFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter
+#endif // UE_VERSION_OLDER_THAN(5, 5, 0)
+
+// These tests check that the face state codec stays within its error bounds, with and without a basis and in delta mode,
+// and report its size and throughput.
+
+// A recorded session of synthetic face tracking, stands in for a capture from a headset
+inline TSharedRef<FOculusXRMovementRecording> RecordSyntheticFaceSession(const int32 NumFrames, const int32 Seed = 0, const float ExpressionNoise = 0.02f)
+{
+	FOculusXRSyntheticMovementSettings Settings;
+	Settings.Seed = Seed;
+	Settings.ExpressionNoise = ExpressionNoise;
+	const TSharedRef<FOculusXRSyntheticMovementDataProvider> Source = MakeShared<FOculusXRSyntheticMovementDataProvider>(Settings);
+	FOculusXRRecordingMovementDataProvider Recorder(Source);
+	FOculusXRFaceState FaceState;
+	for (int32 i = 0; i < NumFrames; ++i)
+	{
+		Source->SetTime(i / 72.0);
+		Recorder.GetFaceState(FaceState);
+	}
+	return Recorder.TakeRecording();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFaceStateCodecErrors, "OculusXRRetargetingTests.FFaceStateCodecErrors", FaceStateCodecTestFilters)
+inline bool FFaceStateCodecErrors::RunTest(const FString& Parameters)
+{
+	const TSharedRef<FOculusXRMovementRecording> Recording = RecordSyntheticFaceSession(600, 7);
+	const int64 RawBits = static_cast<int64>(EOculusXRFaceExpression::COUNT) * 32;
+
+	// Bit exact round trip and error bound of the zero mask mode, for a few weight sizes
+	for (const int32 WeightBits : { 6, 8, 10 })
+	{
+		FOculusXRFaceStateCodecSettings Settings;
+		Settings.WeightBits = WeightBits;
+		const FOculusXRFaceStateCodec Codec(Settings);
+		FOculusXRFaceStateCodecErrorStats Stats;
+		bool bBitExact = true;
+		int64 NumBits = 0;
+		FOculusXRFaceState Decoded;
+		for (const FOculusXRMovementRecording::FFaceFrame& Frame : Recording->FaceFrames)
+		{
+			FOculusXRQuantizedFaceState Quantized;
+			Codec.Quantize(Frame.State, Quantized);
+			FBitWriter Writer(Codec.GetMaxEncodedBits(), false);
+			Codec.Write(Quantized, Writer);
+			NumBits += Writer.GetNumBits();
+
+			FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+			FOculusXRQuantizedFaceState Read;
+			bBitExact &= Codec.Read(Reader, Read) && Reader.GetBitsLeft() == 0 && Read.Values == Quantized.Values && Read.Confidences == Quantized.Confidences;
+			Codec.Dequantize(Read, Decoded);
+			Stats.Add(Frame.State, Decoded);
+		}
+		const double MeanBits = static_cast<double>(NumBits) / Recording->FaceFrames.Num();
+		AddInfo(FString::Printf(TEXT("%d bit weights: %.0f bits per frame (%.1fx smaller than floats), %s"), WeightBits, MeanBits, RawBits / MeanBits, *Stats.ToString()));
+		TestTrue("Packets should be read back bit for bit", bBitExact);
+		TestTrue("Weights should be within the codec's error bound", Stats.MaxWeightError <= Codec.GetMaxWeightError() + UE_KINDA_SMALL_NUMBER);
+		TestTrue("Near zero weights should make packets smaller than their worst case", MeanBits < Codec.GetMaxEncodedBits());
+	}
+
+	// A basis fitted on other sessions
+	FOculusXRFaceExpressionBasisFitter Fitter;
+	for (int32 Seed = 0; Seed < 4; ++Seed)
+	{
+		Fitter.AddRecording(*RecordSyntheticFaceSession(600, Seed));
+	}
+	FOculusXRFaceStateCodecSettings BasisSettings;
+	FOculusXRFaceExpressionBasis Basis;
+	TestTrue("Basis should be fitted", Fitter.Fit(24, 0.98f, Basis));
+	BasisSettings.Basis = MakeShared<FOculusXRFaceExpressionBasis>(Basis);
+	const FOculusXRFaceStateCodec BasisCodec(BasisSettings);
+	TestTrue("Codec should use the basis", BasisCodec.UsesBasis() && BasisCodec.GetNumValues() == Basis.GetNumComponents());
+
+	FOculusXRFaceStateCodecErrorStats BasisStats;
+	FOculusXRFaceState Decoded;
+	for (const FOculusXRMovementRecording::FFaceFrame& Frame : Recording->FaceFrames)
+	{
+		FBitWriter Writer(BasisCodec.GetMaxEncodedBits(), false);
+		BasisCodec.Encode(Frame.State, Writer);
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		TestTrue("Packet should decode", BasisCodec.Decode(Reader, Decoded));
+		BasisStats.Add(Frame.State, Decoded);
+	}
+	AddInfo(FString::Printf(TEXT("Basis of %d components (%.1f%% of the variance): %lld bits per frame, %s"),
+		Basis.GetNumComponents(), Basis.ExplainedVariance * 100.0f, BasisCodec.GetMaxEncodedBits(), *BasisStats.ToString()));
+	TestTrue("Basis should keep weights close", BasisStats.GetMeanWeightError() < 0.03);
+
+	// Packets from another layout are rejected
+	const FOculusXRFaceStateCodec DefaultCodec;
+	FBitWriter Writer(BasisCodec.GetMaxEncodedBits(), false);
+	BasisCodec.Encode(Recording->FaceFrames[0].State, Writer);
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+	TestFalse("A packet from another layout should be rejected", DefaultCodec.Decode(Reader, Decoded));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFaceStateDeltaCodec, "OculusXRRetargetingTests.FFaceStateDeltaCodec", FaceStateCodecTestFilters)
+inline bool FFaceStateDeltaCodec::RunTest(const FString& Parameters)
+{
+	// Per frame noise defeats any delta, headsets filter their expression weights much more than the synthetic default
+	const TSharedRef<FOculusXRMovementRecording> Recording = RecordSyntheticFaceSession(600, 3, 0.001f);
+	const TSharedRef<const FOculusXRFaceStateCodec> Codec = MakeShared<FOculusXRFaceStateCodec>();
+	FOculusXRFaceStateDeltaEncoder Encoder(Codec);
+	FOculusXRFaceStateDeltaDecoder Decoder(Codec);
+
+	// Every other ack is lost, the encoder keeps using the last acked baseline
+	FOculusXRFaceStateCodecErrorStats Stats;
+	FOculusXRFaceState Decoded;
+	int64 NumBits = 0;
+	int64 NumStatelessBits = 0;
+	bool bAllDecoded = true;
+	for (int32 i = 0; i < Recording->FaceFrames.Num(); ++i)
+	{
+		const FOculusXRFaceState& FaceState = Recording->FaceFrames[i].State;
+		FBitWriter Writer(Codec->GetMaxEncodedBits() + 64, false);
+		Encoder.Encode(FaceState, Writer);
+		NumBits += Writer.GetNumBits();
+		FBitWriter StatelessWriter(Codec->GetMaxEncodedBits(), false);
+		Codec->Encode(FaceState, StatelessWriter);
+		NumStatelessBits += StatelessWriter.GetNumBits();
+
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		uint16 Sequence = 0;
+		const bool bDecoded = Decoder.Decode(Reader, Decoded, Sequence);
+		bAllDecoded &= bDecoded;
+		if (bDecoded && i % 2 == 0)
+		{
+			Encoder.Ack(Sequence);
+		}
+		Stats.Add(FaceState, Decoded);
+	}
+	AddInfo(FString::Printf(TEXT("Delta: %.0f bits per frame, stateless: %.0f bits per frame, %s"),
+		static_cast<double>(NumBits) / Recording->FaceFrames.Num(), static_cast<double>(NumStatelessBits) / Recording->FaceFrames.Num(), *Stats.ToString()));
+	TestTrue("Every packet should decode", bAllDecoded);
+	TestTrue("Weights should be within the delta error bound", Stats.MaxWeightError <= Encoder.GetMaxWeightError() + UE_KINDA_SMALL_NUMBER);
+	TestTrue("Delta packets should be smaller than stateless ones", NumBits < NumStatelessBits);
+
+	// A still face only costs a bit per weight
+	FOculusXRFaceStateDeltaEncoder IdleEncoder(Codec);
+	FOculusXRFaceStateDeltaDecoder IdleDecoder(Codec);
+	for (int32 i = 0; i < 4; ++i)
+	{
+		FBitWriter Writer(Codec->GetMaxEncodedBits() + 64, false);
+		IdleEncoder.Encode(Recording->FaceFrames[0].State, Writer);
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		uint16 Sequence = 0;
+		TestTrue("Packet should decode", IdleDecoder.Decode(Reader, Decoded, Sequence));
+		IdleEncoder.Ack(Sequence);
+		if (i > 0)
+		{
+			TestEqual("No weight should be sent for a still face", IdleEncoder.GetLastNumChangedValues(), 0);
+		}
+	}
+
+	// A receiver that missed the baseline rejects the packet
+	FOculusXRFaceStateDeltaDecoder LateDecoder(Codec);
+	FBitWriter Writer(Codec->GetMaxEncodedBits() + 64, false);
+	IdleEncoder.Encode(Recording->FaceFrames[1].State, Writer);
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+	uint16 Sequence = 0;
+	TestFalse("A delta against an unknown baseline should be rejected", LateDecoder.Decode(Reader, Decoded, Sequence));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFaceStateCodecThroughput, "OculusXRRetargetingTests.FFaceStateCodecThroughput", FaceStateCodecPerfFilters)
+inline bool FFaceStateCodecThroughput::RunTest(const FString& Parameters)
+{
+	const int32 NumFrames = 20000;
+	const TSharedRef<FOculusXRMovementRecording> Recording = RecordSyntheticFaceSession(500);
+	FOculusXRFaceExpressionBasisFitter Fitter;
+	Fitter.AddRecording(*Recording);
+	FOculusXRFaceExpressionBasis Basis;
+	Fitter.Fit(16, 0.98f, Basis);
+	FOculusXRFaceStateCodecSettings BasisSettings;
+	BasisSettings.Basis = MakeShared<FOculusXRFaceExpressionBasis>(Basis);
+
+	const FOculusXRFaceStateCodec Codecs[] = { FOculusXRFaceStateCodec(), FOculusXRFaceStateCodec(BasisSettings) };
+	for (const FOculusXRFaceStateCodec& Codec : Codecs)
+	{
+		TArray<TArray<uint8>> Packets;
+		TArray<int64> PacketBits;
+		Packets.SetNum(NumFrames);
+		PacketBits.SetNum(NumFrames);
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumFrames; ++i)
+		{
+			FBitWriter Writer(Codec.GetMaxEncodedBits(), false);
+			Codec.Encode(Recording->FaceFrames[i % Recording->FaceFrames.Num()].State, Writer);
+			PacketBits[i] = Writer.GetNumBits();
+			Packets[i] = MoveTemp(*Writer.GetBuffer());
+		}
+		const double EncodeSeconds = FPlatformTime::Seconds() - StartTime;
+
+		FOculusXRFaceState Decoded;
+		StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumFrames; ++i)
+		{
+			FBitReader Reader(Packets[i].GetData(), PacketBits[i]);
+			Codec.Decode(Reader, Decoded);
+		}
+		const double DecodeSeconds = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(TEXT("%s: encode %.0f frames/s, decode %.0f frames/s"), Codec.UsesBasis() ? TEXT("Basis") : TEXT("Weights"),
+			NumFrames / FMath::Max(EncodeSeconds, UE_SMALL_NUMBER), NumFrames / FMath::Max(DecodeSeconds, UE_SMALL_NUMBER)));
+		TestTrue("Encoding should run thousands of frames per second", NumFrames / FMath::Max(EncodeSeconds, UE_SMALL_NUMBER) > 1000.0);
+		TestTrue("Decoding should run thousands of frames per second", NumFrames / FMath::Max(DecodeSeconds, UE_SMALL_NUMBER) > 1000.0);
+	}
+
+	return true;
+}
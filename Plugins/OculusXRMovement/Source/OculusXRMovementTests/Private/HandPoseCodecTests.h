@@ -0,0 +1,125 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/AutomationTest.h"
+#include "OculusXRBodyStateCodec.h"
+#include "OculusXRHandPoseCodec.h"
+#include "OculusXRMovementRecording.h"
+#include "OculusXRSyntheticMovementDataProvider.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#if UE_VERSION_OLDER_THAN(5, 5, 0)
+#define HandPoseCodecTestFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#else
+#define HandPoseCodecTestFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#endif // UE_VERSION_OLDER_THAN(5, 5, 0)
+
+// These tests check that hand pose bases fitted on tracked sessions send finger poses in a fraction of the bits.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHandPoseCodecRoundTrip, "OculusXRRetargetingTests.FHandPoseCodecRoundTrip", HandPoseCodecTestFilters)
+inline bool FHandPoseCodecRoundTrip::RunTest(const FString& Parameters)
+{
+	// Fit on a recorded session and a few live ones, evaluate on a session the fitter has not seen
+	FOculusXRHandPoseBasisFitter Fitter;
+	FOculusXRBodyState BodyState;
+	{
+		const TSharedRef<FOculusXRSyntheticMovementDataProvider> Source = MakeShared<FOculusXRSyntheticMovementDataProvider>(FOculusXRSyntheticMovementSettings());
+		FOculusXRRecordingMovementDataProvider Recorder(Source);
+		for (int32 Frame = 0; Frame < 300; ++Frame)
+		{
+			Source->SetTime(Frame / 72.0);
+			Recorder.GetBodyState(BodyState, 100.0f);
+		}
+		Fitter.AddRecording(*Recorder.TakeRecording());
+	}
+	for (int32 Seed = 1; Seed < 4; ++Seed)
+	{
+		FOculusXRSyntheticMovementSettings SourceSettings;
+		SourceSettings.Seed = Seed;
+		FOculusXRSyntheticMovementDataProvider Source(SourceSettings);
+		for (int32 Frame = 0; Frame < 300; ++Frame)
+		{
+			Source.SetTime(Frame / 72.0);
+			Source.GetBodyState(BodyState, 100.0f);
+			Fitter.AddBodyState(BodyState, 100.0f);
+		}
+	}
+	TestEqual("Every frame should be a sample", Fitter.GetNumSamples(0), 1200);
+
+	FOculusXRHandPoseBasis Bases[2];
+	for (int32 Hand = 0; Hand < 2; ++Hand)
+	{
+		TestTrue("Basis should be fitted", Fitter.Fit(Hand, 12, 0.99f, Bases[Hand]));
+		TestTrue("Basis should be valid", Bases[Hand].IsValid());
+		TestTrue("Basis should explain the finger poses", Bases[Hand].ExplainedVariance >= 0.99f);
+		AddInfo(FString::Printf(TEXT("Hand %d: %d components explain %.2f%% of the variance"), Hand, Bases[Hand].GetNumComponents(), Bases[Hand].ExplainedVariance * 100.0f));
+	}
+
+	// The basis survives being saved with the content
+	TArray<uint8> Bytes;
+	FMemoryWriter BasisWriter(Bytes);
+	Bases[0].Serialize(BasisWriter);
+	FOculusXRHandPoseBasis Loaded;
+	FMemoryReader BasisReader(Bytes);
+	Loaded.Serialize(BasisReader);
+	const TSharedRef<const FOculusXRHandPoseCodec> HandCodec = MakeShared<FOculusXRHandPoseCodec>(Bases[0], Bases[1]);
+	TestEqual("A loaded basis should give the same codec", FOculusXRHandPoseCodec(Loaded, Bases[1]).GetHash(), HandCodec->GetHash());
+
+	// Finger bits of the body codec, with and without hand poses
+	FOculusXRBodyStateCodecSettings Settings;
+	const FOculusXRTieredBodyStateCodec JointCodec(Settings);
+	Settings.HandPoseCodec = HandCodec;
+	const FOculusXRTieredBodyStateCodec PoseCodec(Settings);
+	const int64 JointFingerBits = JointCodec.GetMaxEncodedBits(EOculusXRBodyFidelityTier::Full) - JointCodec.GetMaxEncodedBits(EOculusXRBodyFidelityTier::NoFingers);
+	const int64 PoseFingerBits = PoseCodec.GetMaxEncodedBits(EOculusXRBodyFidelityTier::Full) - PoseCodec.GetMaxEncodedBits(EOculusXRBodyFidelityTier::NoFingers);
+	AddInfo(FString::Printf(TEXT("Fingers take %lld bits as joints, %lld bits as hand poses"), JointFingerBits, PoseFingerBits));
+	TestTrue("Hand poses should take a tenth of the finger bits", PoseFingerBits * 10 <= JointFingerBits);
+
+	const FOculusXRBodyStateCodec& Codec = PoseCodec.GetCodec(EOculusXRBodyFidelityTier::Full);
+	FOculusXRSyntheticMovementSettings SourceSettings;
+	SourceSettings.Seed = 7;
+	FOculusXRSyntheticMovementDataProvider Source(SourceSettings);
+	FOculusXRBodyStateCodecErrorStats FingerStats;
+	bool bAllDecoded = true;
+	for (int32 Frame = 0; Frame < 300; ++Frame)
+	{
+		Source.SetTime(Frame / 72.0);
+		Source.GetBodyState(BodyState, 100.0f);
+		FBitWriter Writer(Codec.GetMaxEncodedBits(), false);
+		Codec.Encode(BodyState, Writer);
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		FOculusXRBodyState Decoded;
+		bAllDecoded &= Codec.Decode(Reader, Decoded) && Reader.GetBitsLeft() == 0;
+
+		// Compare the finger joints only
+		for (int32 i = 0; i < Decoded.Joints.Num(); ++i)
+		{
+			Decoded.Joints[i].bIsValid &= FOculusXRBodyRetargeter::IsFingerSourceJoint(static_cast<EOculusXRBoneID>(i));
+		}
+		FingerStats.Add(BodyState, Decoded);
+	}
+	AddInfo(FString::Printf(TEXT("Fingers: %s"), *FingerStats.ToString()));
+	TestTrue("Every packet should decode", bAllDecoded);
+	TestEqual("Every finger joint should be decoded", FingerStats.NumJoints, 300 * 2 * FOculusXRHandPoseCodec::kNumHandJoints);
+	TestTrue("Finger rotations should be close", FingerStats.MaxRotationErrorDegrees < 3.0);
+	TestTrue("Finger positions should be close", FingerStats.MaxPositionError < 0.5);
+
+	// Untracked hands are not sent
+	const int32 WristIdx = static_cast<int32>(FOculusXRHandPoseCodec::GetWristJoint(1));
+	BodyState.Joints[WristIdx].bIsValid = false;
+	TArray<uint32> Coefficients;
+	TestFalse("An untracked hand should not be encoded", HandCodec->Encode(BodyState, 1, Coefficients));
+
+	return true;
+}
@@ -0,0 +1,173 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/AutomationTest.h"
+#include "OculusXRBodyStateCodec.h"
+#include "OculusXRMovementJitterBuffer.h"
+#include "OculusXRMovementLoopback.h"
+#include "OculusXRSyntheticMovementDataProvider.h"
+
+#if UE_VERSION_OLDER_THAN(5, 5, 0)
+#define JitterBufferTestFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#else
+#define JitterBufferTestFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#endif // UE_VERSION_OLDER_THAN(5, 5, 0)
+
+// These tests check that the jitter buffer plays remote tracking streams smoothly over a simulated network.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementJitterBufferInterpolation, "OculusXRRetargetingTests.FMovementJitterBufferInterpolation", JitterBufferTestFilters)
+inline bool FMovementJitterBufferInterpolation::RunTest(const FString& Parameters)
+{
+	const int32 HipsIdx = static_cast<int32>(EOculusXRBoneID::BodyHips);
+	auto MakeBodyState = [HipsIdx](const float Yaw) {
+		FOculusXRBodyState BodyState;
+		BodyState.IsActive = true;
+		BodyState.Joints.SetNum(static_cast<int32>(EOculusXRBoneID::COUNT));
+		BodyState.Joints[HipsIdx].bIsValid = true;
+		BodyState.Joints[HipsIdx].Orientation = FRotator(0.0f, Yaw, 0.0f);
+		return BodyState;
+	};
+
+	FOculusXRMovementJitterBufferSettings Settings;
+	Settings.MinDelay = 0.03f;
+	Settings.MaxExtrapolation = 0.1f;
+	FOculusXRMovementJitterBuffer JitterBuffer(Settings);
+
+	// Out of order arrivals, both with 50ms transit
+	JitterBuffer.PushBodyState(MakeBodyState(10.0f), 0.1, 0.15, 100.0f);
+	JitterBuffer.PushBodyState(MakeBodyState(0.0f), 0.0, 0.05, 100.0f);
+	TestEqual("Reordered samples should be kept", JitterBuffer.GetNumLateSamples(), 0);
+
+	// Played 50ms transit + 30ms delay behind
+	FOculusXRBodyState BodyState;
+	JitterBuffer.Update(0.13);
+	TestTrue("Body state should be returned", JitterBuffer.GetBodyState(BodyState, 100.0f));
+	TestTrue("Samples should be interpolated", FMath::IsNearlyEqual(BodyState.Joints[HipsIdx].Orientation.Yaw, 5.0, 0.01));
+
+	JitterBuffer.Update(0.23);
+	JitterBuffer.GetBodyState(BodyState, 100.0f);
+	TestTrue("The stream should be extrapolated past the newest sample", FMath::IsNearlyEqual(BodyState.Joints[HipsIdx].Orientation.Yaw, 15.0, 0.01));
+
+	JitterBuffer.Update(0.38);
+	JitterBuffer.GetBodyState(BodyState, 100.0f);
+	TestTrue("Extrapolation should stop after MaxExtrapolation", FMath::IsNearlyEqual(BodyState.Joints[HipsIdx].Orientation.Yaw, 20.0, 0.01));
+	TestEqual("Extrapolated updates should be counted", JitterBuffer.GetNumExtrapolatedUpdates(), 2);
+
+	JitterBuffer.PushBodyState(MakeBodyState(-10.0f), -0.1, 0.4, 100.0f);
+	TestEqual("Samples older than the played time should be dropped", JitterBuffer.GetNumLateSamples(), 1);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementJitterBufferStall, "OculusXRRetargetingTests.FMovementJitterBufferStall", JitterBufferTestFilters)
+inline bool FMovementJitterBufferStall::RunTest(const FString& Parameters)
+{
+	const int32 HipsIdx = static_cast<int32>(EOculusXRBoneID::BodyHips);
+	auto MakeBodyState = [HipsIdx](const float Yaw) {
+		FOculusXRBodyState BodyState;
+		BodyState.IsActive = true;
+		BodyState.Joints.SetNum(static_cast<int32>(EOculusXRBoneID::COUNT));
+		BodyState.Joints[HipsIdx].bIsValid = true;
+		BodyState.Joints[HipsIdx].Orientation = FRotator(0.0f, Yaw, 0.0f);
+		BodyState.Joints[HipsIdx].Position = FVector(Yaw, 0.0, 0.0);
+		return BodyState;
+	};
+
+	FOculusXRMovementJitterBufferSettings Settings;
+	Settings.MinDelay = 0.03f;
+	Settings.MaxExtrapolation = 0.1f;
+	FOculusXRMovementJitterBuffer JitterBuffer(Settings);
+
+	// 72Hz samples, 50ms transit, then nothing arrives for a long while
+	const double SampleInterval = 1.0 / 72.0;
+	JitterBuffer.PushBodyState(MakeBodyState(0.0f), 0.0, 0.05, 100.0f);
+	JitterBuffer.PushBodyState(MakeBodyState(2.0f), SampleInterval, 0.05 + SampleInterval, 100.0f);
+
+	FOculusXRBodyState BodyState;
+	JitterBuffer.Update(0.08 + SampleInterval);
+	TestTrue("Body state should be returned", JitterBuffer.GetBodyState(BodyState, 100.0f));
+	TestTrue("The newest sample should be played", FMath::IsNearlyEqual(BodyState.Joints[HipsIdx].Orientation.Yaw, 2.0, 0.01));
+
+	JitterBuffer.Update(1.0);
+	JitterBuffer.GetBodyState(BodyState, 100.0f);
+	TestTrue("Rotations should be extrapolated by at most one sample interval", FMath::IsNearlyEqual(BodyState.Joints[HipsIdx].Orientation.Yaw, 4.0, 0.01));
+	TestTrue("Positions should be extrapolated by at most one sample interval", FMath::IsNearlyEqual(BodyState.Joints[HipsIdx].Position.X, 4.0, 0.01));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementJitterBufferLoopback, "OculusXRRetargetingTests.FMovementJitterBufferLoopback", JitterBufferTestFilters)
+inline bool FMovementJitterBufferLoopback::RunTest(const FString& Parameters)
+{
+	// Noise is not something interpolation can recover, leave it out to measure the playback error alone
+	FOculusXRSyntheticMovementSettings SourceSettings;
+	SourceSettings.JointNoiseDegrees = 0.0f;
+	SourceSettings.ExpressionNoise = 0.0f;
+	const TSharedRef<FOculusXRSyntheticMovementDataProvider> Source = MakeShared<FOculusXRSyntheticMovementDataProvider>(SourceSettings);
+	FOculusXRSyntheticMovementDataProvider Reference(SourceSettings);
+
+	FOculusXRMovementLoopbackSettings NetworkSettings;
+	NetworkSettings.Latency = 0.08f;
+	NetworkSettings.Jitter = 0.03f;
+	NetworkSettings.LossProbability = 0.05f;
+	NetworkSettings.ReorderProbability = 0.1f;
+	const TSharedRef<FOculusXRMovementJitterBuffer> JitterBuffer = MakeShared<FOculusXRMovementJitterBuffer>();
+	FOculusXRMovementLoopback Loopback(Source, JitterBuffer, NetworkSettings);
+
+	// The sender ticks at 30Hz, the receiver renders at 90Hz
+	const double SendInterval = 1.0 / 30.0;
+	const double FrameInterval = 1.0 / 90.0;
+	double NextSendTime = 0.0;
+	double LastPlaybackTime = 0.0;
+	bool bSmooth = true;
+	int32 NumFrames = 0;
+	FOculusXRBodyStateCodecErrorStats Stats;
+	FOculusXRBodyState BodyState, ReferenceBodyState;
+	FOculusXRFaceState FaceState;
+	for (int32 Frame = 0; Frame < 900; ++Frame)
+	{
+		const double LocalTime = Frame * FrameInterval;
+		for (; NextSendTime <= LocalTime; NextSendTime += SendInterval)
+		{
+			Source->SetTime(NextSendTime);
+			Loopback.Send(NextSendTime, 100.0f);
+		}
+		Loopback.Deliver(LocalTime);
+		JitterBuffer->Update(LocalTime);
+
+		// Past the warm up, the playout clock runs close to real time and the output follows the source
+		if (LocalTime < 1.0 || !JitterBuffer->GetBodyState(BodyState, 100.0f))
+		{
+			LastPlaybackTime = JitterBuffer->GetPlaybackTime();
+			continue;
+		}
+		const double PlaybackStep = JitterBuffer->GetPlaybackTime() - LastPlaybackTime;
+		bSmooth &= PlaybackStep >= FrameInterval * 0.89 && PlaybackStep <= FrameInterval * 1.11;
+		LastPlaybackTime = JitterBuffer->GetPlaybackTime();
+
+		Reference.SetTime(BodyState.Time);
+		Reference.GetBodyState(ReferenceBodyState, 100.0f);
+		Stats.Add(ReferenceBodyState, BodyState);
+		TestTrue("Face state should be returned", JitterBuffer->GetFaceState(FaceState));
+		++NumFrames;
+	}
+
+	AddInfo(FString::Printf(TEXT("%d sent, %d lost, %d reordered, %d late, %d extrapolated, delay %.0fms, %s"),
+		Loopback.GetNumSent(), Loopback.GetNumLost(), Loopback.GetNumReordered(), JitterBuffer->GetNumLateSamples(),
+		JitterBuffer->GetNumExtrapolatedUpdates(), JitterBuffer->GetDelay() * 1000.0f, *Stats.ToString()));
+	TestTrue("Frames should have been played", NumFrames > 600);
+	TestTrue("The network should have reordered packets", Loopback.GetNumReordered() > 0);
+	TestTrue("Playback time should advance smoothly", bSmooth);
+	TestTrue("Interpolated poses should stay close to the source", Stats.GetMeanRotationErrorDegrees() < 2.0);
+	TestTrue("Extrapolation should be rare", JitterBuffer->GetNumExtrapolatedUpdates() < NumFrames / 10);
+
+	return true;
+}
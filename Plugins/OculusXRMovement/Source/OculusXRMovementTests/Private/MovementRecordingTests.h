@@ -0,0 +1,332 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/AutomationTest.h"
+#include "OculusXRMovementRecorder.h"
+#include "OculusXRMovementRecording.h"
+#include "OculusXRSyntheticMovementDataProvider.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+#if UE_VERSION_OLDER_THAN(5, 5, 0)
+#define MovementRecordingTestFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#else
+#define MovementRecordingTestFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#endif // UE_VERSION_OLDER_THAN(5, 5, 0)
+
+// These tests check that recordings survive serialization and that playback returns the expected frames.
+
+inline TSharedRef<FOculusXRMovementRecording> CreateRecording()
+{
+	TSharedRef<FOculusXRMovementRecording> Recording = MakeShared<FOculusXRMovementRecording>();
+	Recording->WorldToMeters = 100.0f;
+	Recording->bHasBodySkeleton = true;
+	Recording->BodySkeleton.NumBones = 2;
+	Recording->BodySkeleton.Bones.AddDefaulted(2);
+	Recording->BodySkeleton.Bones[0].BoneId = EOculusXRBoneID::BodyRoot;
+	Recording->BodySkeleton.Bones[0].ParentBoneIndex = EOculusXRBoneID::None;
+	Recording->BodySkeleton.Bones[1].BoneId = EOculusXRBoneID::BodyHips;
+	Recording->BodySkeleton.Bones[1].ParentBoneIndex = EOculusXRBoneID::BodyRoot;
+	Recording->BodySkeleton.Bones[1].Position = FVector(0.0, 0.0, 90.0);
+	Recording->BodySkeleton.Bones[1].Orientation = FRotator(0.0, 90.0, 0.0);
+
+	for (int32 i = 0; i < 3; ++i)
+	{
+		FOculusXRMovementRecording::FBodyFrame& BodyFrame = Recording->BodyFrames.AddDefaulted_GetRef();
+		BodyFrame.Timestamp = i * 0.1;
+		BodyFrame.State.IsActive = true;
+		BodyFrame.State.Confidence = 1.0f;
+		BodyFrame.State.SkeletonChangedCount = 1;
+		BodyFrame.State.Time = 10.0f + i * 0.1f;
+		BodyFrame.State.Joints.AddDefaulted(2);
+		BodyFrame.State.Joints[1].bIsValid = true;
+		BodyFrame.State.Joints[1].Position = FVector(0.0, 0.0, 90.0 + i);
+		BodyFrame.State.Joints[1].Orientation = FRotator(0.0, 10.0 * i, 0.0);
+	}
+
+	FOculusXRMovementRecording::FFaceFrame& FaceFrame = Recording->FaceFrames.AddDefaulted_GetRef();
+	FaceFrame.Timestamp = 0.05;
+	FaceFrame.State.bIsValid = true;
+	FaceFrame.State.Time = 10.05f;
+	FaceFrame.State.ExpressionWeights = { 0.0f, 0.25f, 0.5f, 1.0f };
+	FaceFrame.State.ExpressionWeightConfidences = { 1.0f, 1.0f };
+
+	FOculusXRMovementRecording::FEyeFrame& EyeFrame = Recording->EyeFrames.AddDefaulted_GetRef();
+	EyeFrame.Timestamp = 0.0;
+	EyeFrame.State.Time = 10.0f;
+	EyeFrame.State.EyeGazes.AddDefaulted(2);
+	EyeFrame.State.EyeGazes[0].bIsValid = true;
+	EyeFrame.State.EyeGazes[0].Confidence = 0.5f;
+	EyeFrame.State.EyeGazes[0].Position = FVector(3.0, 4.0, 5.0);
+	EyeFrame.State.EyeGazes[0].Orientation = FRotator(5.0, 0.0, 0.0);
+
+	return Recording;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementRecordingRoundTrip, "OculusXRRetargetingTests.FMovementRecordingRoundTrip", MovementRecordingTestFilters)
+inline bool FMovementRecordingRoundTrip::RunTest(const FString& Parameters)
+{
+	const TSharedRef<FOculusXRMovementRecording> Recording = CreateRecording();
+
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	TestTrue("Recording should serialize", Recording->Serialize(Writer));
+
+	FOculusXRMovementRecording Loaded;
+	FMemoryReader Reader(Bytes);
+	TestTrue("Recording should deserialize", Loaded.Serialize(Reader));
+
+	TestTrue("Body skeleton should be present", Loaded.bHasBodySkeleton);
+	TestEqual("Number of skeleton bones should match", Loaded.BodySkeleton.NumBones, 2);
+	TestTrue("Skeleton parent should match", Loaded.BodySkeleton.Bones[1].ParentBoneIndex == EOculusXRBoneID::BodyRoot);
+	TestEqual("Skeleton position should match", Loaded.BodySkeleton.Bones[1].Position, FVector(0.0, 0.0, 90.0));
+	TestEqual("Number of body frames should match", Loaded.BodyFrames.Num(), 3);
+	TestEqual("Body timestamp should match", Loaded.BodyFrames[2].Timestamp, 0.2);
+	TestEqual("Body joint position should match", Loaded.BodyFrames[2].State.Joints[1].Position, FVector(0.0, 0.0, 92.0));
+	TestTrue("Body joint orientation should match", Loaded.BodyFrames[2].State.Joints[1].Orientation.Equals(FRotator(0.0, 20.0, 0.0), 1.e-4f));
+	TestTrue("Face weights should match", Loaded.FaceFrames[0].State.ExpressionWeights == Recording->FaceFrames[0].State.ExpressionWeights);
+	TestEqual("Eye gazes should match", Loaded.EyeFrames[0].State.EyeGazes.Num(), 2);
+	TestEqual("Eye confidence should match", Loaded.EyeFrames[0].State.EyeGazes[0].Confidence, 0.5f);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementRecordingRejectsUnknownData, "OculusXRRetargetingTests.FMovementRecordingRejectsUnknownData", MovementRecordingTestFilters)
+inline bool FMovementRecordingRejectsUnknownData::RunTest(const FString& Parameters)
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	uint32 Magic = 0x12345678;
+	uint32 Version = FOculusXRMovementRecording::kCurrentVersion;
+	Writer << Magic << Version;
+
+	AddExpectedError(TEXT("Unsupported movement recording"), EAutomationExpectedErrorFlags::Contains, 1);
+	FOculusXRMovementRecording Loaded;
+	FMemoryReader Reader(Bytes);
+	TestFalse("Data with a wrong magic number should be rejected", Loaded.Serialize(Reader));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementRecordingRejectsCorruptFrameCounts, "OculusXRRetargetingTests.FMovementRecordingRejectsCorruptFrameCounts", MovementRecordingTestFilters)
+inline bool FMovementRecordingRejectsCorruptFrameCounts::RunTest(const FString& Parameters)
+{
+	for (int32 NumBodyFrames : { -1, MAX_int32 })
+	{
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes);
+		uint32 Magic = FOculusXRMovementRecording::kMagic;
+		uint32 Version = FOculusXRMovementRecording::kCurrentVersion;
+		float WorldToMeters = 100.0f;
+		uint8 bHasBodySkeleton = 0;
+		Writer << Magic << Version << WorldToMeters << bHasBodySkeleton << NumBodyFrames;
+
+		AddExpectedError(TEXT("corrupted frame count"), EAutomationExpectedErrorFlags::Contains, 1);
+		FOculusXRMovementRecording Loaded;
+		FMemoryReader Reader(Bytes);
+		TestFalse(FString::Printf(TEXT("%d body frames should be rejected"), NumBodyFrames), Loaded.Serialize(Reader));
+		TestEqual("Nothing should be allocated for a corrupted count", Loaded.BodyFrames.Num(), 0);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementRecordingRejectsCorruptElementCounts, "OculusXRRetargetingTests.FMovementRecordingRejectsCorruptElementCounts", MovementRecordingTestFilters)
+inline bool FMovementRecordingRejectsCorruptElementCounts::RunTest(const FString& Parameters)
+{
+	for (int32 Count : { -1, MAX_int32 })
+	{
+		// Saves an empty state and overwrites its element count, which comes first in every state but the body state
+		const auto SaveWithCount = [Count](TFunctionRef<void(FArchive&)> SaveEmpty, const bool bCountLast) {
+			TArray<uint8> Bytes;
+			FMemoryWriter Writer(Bytes);
+			SaveEmpty(Writer);
+			const int32 CountOffset = bCountLast ? Bytes.Num() - sizeof(int32) : 0;
+			FMemory::Memcpy(Bytes.GetData() + CountOffset, &Count, sizeof(int32));
+			return Bytes;
+		};
+
+		AddExpectedError(TEXT("corrupted element count"), EAutomationExpectedErrorFlags::Contains, 4);
+
+		const TArray<uint8> SkeletonBytes = SaveWithCount([](FArchive& Ar) {
+			FOculusXRBodySkeleton Empty;
+			Empty.NumBones = 0;
+			Empty.Bones.Reset();
+			FOculusXRMovementRecording::SerializeBodySkeleton(Ar, Empty);
+		}, false);
+		FMemoryReader SkeletonReader(SkeletonBytes);
+		FOculusXRBodySkeleton BodySkeleton;
+		FOculusXRMovementRecording::SerializeBodySkeleton(SkeletonReader, BodySkeleton);
+		TestTrue(FString::Printf(TEXT("%d bones should be rejected"), Count), SkeletonReader.IsError());
+		TestEqual("No bones should be allocated for a corrupted count", BodySkeleton.Bones.Num(), 0);
+
+		const TArray<uint8> BodyBytes = SaveWithCount([](FArchive& Ar) {
+			FOculusXRBodyState Empty;
+			Empty.Joints.Reset();
+			FOculusXRMovementRecording::SerializeBodyState(Ar, Empty);
+		}, true);
+		FMemoryReader BodyReader(BodyBytes);
+		FOculusXRBodyState BodyState;
+		FOculusXRMovementRecording::SerializeBodyState(BodyReader, BodyState);
+		TestTrue(FString::Printf(TEXT("%d joints should be rejected"), Count), BodyReader.IsError());
+		TestEqual("No joints should be allocated for a corrupted count", BodyState.Joints.Num(), 0);
+
+		const TArray<uint8> FaceBytes = SaveWithCount([](FArchive& Ar) {
+			FOculusXRFaceState Empty;
+			FOculusXRMovementRecording::SerializeFaceState(Ar, Empty);
+		}, false);
+		FMemoryReader FaceReader(FaceBytes);
+		FOculusXRFaceState FaceState;
+		FOculusXRMovementRecording::SerializeFaceState(FaceReader, FaceState);
+		TestTrue(FString::Printf(TEXT("%d expression weights should be rejected"), Count), FaceReader.IsError());
+		TestEqual("No weights should be allocated for a corrupted count", FaceState.ExpressionWeights.Num(), 0);
+
+		const TArray<uint8> EyeBytes = SaveWithCount([](FArchive& Ar) {
+			FOculusXREyeGazesState Empty;
+			FOculusXRMovementRecording::SerializeEyeGazesState(Ar, Empty);
+		}, false);
+		FMemoryReader EyeReader(EyeBytes);
+		FOculusXREyeGazesState EyeGazesState;
+		FOculusXRMovementRecording::SerializeEyeGazesState(EyeReader, EyeGazesState);
+		TestTrue(FString::Printf(TEXT("%d eye gazes should be rejected"), Count), EyeReader.IsError());
+		TestEqual("No eye gazes should be allocated for a corrupted count", EyeGazesState.EyeGazes.Num(), 0);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementRecordingPlayback, "OculusXRRetargetingTests.FMovementRecordingPlayback", MovementRecordingTestFilters)
+inline bool FMovementRecordingPlayback::RunTest(const FString& Parameters)
+{
+	FOculusXRPlaybackMovementDataProvider Playback(CreateRecording(), false);
+	TestTrue("Playback of a recording should be available", Playback.IsAvailable());
+
+	FOculusXRBodyState BodyState;
+	Playback.SetPlaybackTime(0.15);
+	TestTrue("Body state should be returned", Playback.GetBodyState(BodyState, 100.0f));
+	TestEqual("Last frame before the playback time should be returned", BodyState.Joints[1].Position, FVector(0.0, 0.0, 91.0));
+
+	Playback.SetPlaybackTime(5.0);
+	Playback.GetBodyState(BodyState, 1.0f);
+	TestEqual("Positions should be rescaled to the requested world scale", BodyState.Joints[1].Position, FVector(0.0, 0.0, 0.92));
+
+	FOculusXRBodySkeleton BodySkeleton;
+	TestTrue("Body skeleton should be returned", Playback.GetBodySkeleton(BodySkeleton, 100.0f));
+	TestEqual("Body skeleton bone count should match", BodySkeleton.NumBones, 2);
+
+	FOculusXRFaceState FaceState;
+	Playback.SetPlaybackTime(0.0);
+	TestTrue("Face frames before the first timestamp should return the first frame", Playback.GetFaceState(FaceState));
+	TestEqual("Face weight should match", FaceState.ExpressionWeights[3], 1.0f);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementRecordingMappedPlayback, "OculusXRRetargetingTests.FMovementRecordingMappedPlayback", MovementRecordingTestFilters)
+inline bool FMovementRecordingMappedPlayback::RunTest(const FString& Parameters)
+{
+	const FString Filename = FPaths::CreateTempFilename(*FPaths::AutomationTransientDir(), TEXT("MovementRecording"), TEXT(".oxmr"));
+	TestTrue("Recording should be saved", CreateRecording()->SaveToFile(Filename));
+
+	{
+		const TSharedPtr<const FOculusXRMappedMovementRecording> Mapped = FOculusXRMappedMovementRecording::Open(Filename);
+		TestTrue("Recording should be mapped", Mapped.IsValid());
+		if (!Mapped)
+		{
+			return false;
+		}
+		TestTrue("Opening the same file again should share the mapping", Mapped == FOculusXRMappedMovementRecording::Open(Filename));
+		TestEqual("Number of body frames should match", Mapped->GetNumBodyFrames(), 3);
+		TestEqual("Duration should match", Mapped->GetDuration(), 0.2);
+		TestEqual("Seeking before a frame should find the previous one", Mapped->FindBodyFrame(0.15), 1);
+		TestEqual("Seeking past the end should find the last frame", Mapped->FindBodyFrame(10.0), 2);
+		TestEqual("Seeking before the first frame should find none", Mapped->FindFaceFrame(0.0), INDEX_NONE);
+
+		FOculusXRMappedPlaybackMovementDataProvider PlaybackA(Mapped.ToSharedRef(), false);
+		FOculusXRMappedPlaybackMovementDataProvider PlaybackB(Mapped.ToSharedRef(), false);
+		PlaybackA.SetPlaybackTime(0.15);
+		PlaybackB.SetPlaybackTime(0.2);
+
+		FOculusXRBodyState BodyState;
+		TestTrue("Body state should be decoded", PlaybackA.GetBodyState(BodyState, 100.0f));
+		TestEqual("Decoded joint position should match", BodyState.Joints[1].Position, FVector(0.0, 0.0, 91.0));
+		TestTrue("Body state should be decoded", PlaybackB.GetBodyState(BodyState, 1.0f));
+		TestEqual("Providers sharing a recording should keep their own time", BodyState.Joints[1].Position, FVector(0.0, 0.0, 0.92));
+
+		FOculusXRFaceState FaceState;
+		TestTrue("Face state should be decoded", PlaybackA.GetFaceState(FaceState));
+		TestEqual("Face weight should match", FaceState.ExpressionWeights[3], 1.0f);
+		FaceState = FOculusXRFaceState();
+		PlaybackB.SetPlaybackTime(0.0);
+		TestTrue("Face frames before the first timestamp should return the first frame", PlaybackB.GetFaceState(FaceState));
+		TestEqual("Face weight should match", FaceState.ExpressionWeights[3], 1.0f);
+
+		FOculusXREyeGazesState EyeGazesState;
+		TestTrue("Eye gazes should be decoded", PlaybackA.GetEyeGazesState(EyeGazesState, 100.0f));
+		TestEqual("Eye confidence should match", EyeGazesState.EyeGazes[0].Confidence, 0.5f);
+
+		FOculusXRBodySkeleton BodySkeleton;
+		TestTrue("Body skeleton should be returned", PlaybackA.GetBodySkeleton(BodySkeleton, 100.0f));
+		TestEqual("Body skeleton bone count should match", BodySkeleton.NumBones, 2);
+	}
+
+	IFileManager::Get().Delete(*Filename);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementRecorderStream, "OculusXRRetargetingTests.FMovementRecorderStream", MovementRecordingTestFilters)
+inline bool FMovementRecorderStream::RunTest(const FString& Parameters)
+{
+	const FString Filename = FPaths::CreateTempFilename(*FPaths::AutomationTransientDir(), TEXT("MovementStream"), TEXT(".oxms"));
+	const TSharedRef<FOculusXRSyntheticMovementDataProvider> Source = MakeShared<FOculusXRSyntheticMovementDataProvider>(FOculusXRSyntheticMovementSettings());
+
+	// Small chunks so the writer thread sees several of them
+	FOculusXRMovementRecorderSettings Settings;
+	Settings.ChunkSize = 16 * 1024;
+	Settings.NumChunks = 64;
+	FOculusXRAsyncMovementRecorder Recorder(Source, Filename, Settings);
+	TestTrue("Recorder should be recording", Recorder.IsRecording());
+
+	const int32 NumFrames = 100;
+	FOculusXRBodySkeleton BodySkeleton;
+	Recorder.GetBodySkeleton(BodySkeleton, 100.0f);
+	FOculusXRBodyState BodyState;
+	FOculusXRFaceState FaceState;
+	for (int32 i = 0; i < NumFrames; ++i)
+	{
+		// Capture starts half a second into the session, the skeleton read before must not start the clock at zero
+		Source->SetTime(0.5 + i / 72.0);
+		Recorder.GetBodyState(BodyState, 100.0f);
+		// Duplicate reads of the same frame are recorded once
+		Recorder.GetBodyState(BodyState, 100.0f);
+		// The skeleton is only recorded again when it changes
+		Recorder.GetBodySkeleton(BodySkeleton, 100.0f);
+		Recorder.GetFaceState(FaceState);
+	}
+	Recorder.Stop();
+	TestFalse("Recorder should be stopped", Recorder.IsRecording());
+	TestEqual("No frame should be dropped", Recorder.GetNumDroppedFrames(), 0u);
+	TestEqual("Backlog should be written", Recorder.GetBacklogBytes(), 0ll);
+
+	FOculusXRMovementRecording Recording;
+	TestTrue("Stream should load", FOculusXRAsyncMovementRecorder::LoadStream(Filename, Recording));
+	TestTrue("Body skeleton should be recorded", Recording.bHasBodySkeleton);
+	TestEqual("Every body frame should be recorded once", Recording.BodyFrames.Num(), NumFrames);
+	TestEqual("First body frame should start the recording", Recording.BodyFrames[0].Timestamp, 0.0);
+	TestEqual("Every face frame should be recorded once", Recording.FaceFrames.Num(), NumFrames);
+	TestEqual("Last body frame should match", Recording.BodyFrames.Last().State.Joints[1].Position, BodyState.Joints[1].Position);
+	TestTrue("Last face frame should match", Recording.FaceFrames.Last().State.ExpressionWeights == FaceState.ExpressionWeights);
+
+	IFileManager::Get().Delete(*Filename);
+	return true;
+}
@@ -0,0 +1,170 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/AutomationTest.h"
+#include "OculusXROneEuroFilter.h"
+
+#if UE_VERSION_OLDER_THAN(5, 5, 0)
+#define OneEuroFilterTestFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#define OneEuroFilterPerfFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter
+#else
+#define OneEuroFilterTestFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#define OneEuroFilterPerfFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter
+#endif // UE_VERSION_OLDER_THAN(5, 5, 0)
+
+// These tests check that the vectorized One Euro filter matches the textbook filter and removes jitter without lagging.
+
+// Textbook One Euro filter of a single channel
+struct FOneEuroFilterReference
+{
+	FOculusXROneEuroFilterSettings Settings;
+	bool bHasState = false;
+	float Value = 0.0f;
+	float Derivative = 0.0f;
+
+	static float Alpha(const float Cutoff, const float DeltaTime)
+	{
+		const float Tau = 1.0f / (UE_TWO_PI * Cutoff);
+		return 1.0f / (1.0f + Tau / DeltaTime);
+	}
+
+	float Filter(const float X, const float DeltaTime)
+	{
+		if (!bHasState)
+		{
+			bHasState = true;
+			Value = X;
+			return Value;
+		}
+		Derivative = FMath::Lerp(Derivative, (X - Value) / DeltaTime, Alpha(Settings.DerivativeCutoff, DeltaTime));
+		Value = FMath::Lerp(Value, X, Alpha(Settings.MinCutoff + Settings.Beta * FMath::Abs(Derivative), DeltaTime));
+		return Value;
+	}
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOneEuroFilterMatchesReference, "OculusXRRetargetingTests.FOneEuroFilterMatchesReference", OneEuroFilterTestFilters)
+inline bool FOneEuroFilterMatchesReference::RunTest(const FString& Parameters)
+{
+	// Whole registers and a scalar tail
+	for (const int32 NumChannels : { 8, 70 })
+	{
+		FRandomStream Random(NumChannels);
+		FOculusXROneEuroFilter Filter(NumChannels);
+		TArray<FOneEuroFilterReference> References;
+		References.SetNum(NumChannels);
+		for (int32 i = 0; i < NumChannels; ++i)
+		{
+			References[i].Settings = FOculusXROneEuroFilterSettings(Random.FRandRange(0.5f, 4.0f), Random.FRandRange(0.0f, 2.0f), Random.FRandRange(0.5f, 2.0f));
+			Filter.Set(i, References[i].Settings);
+		}
+
+		TArray<float> Values, Filtered;
+		Values.SetNum(NumChannels);
+		Filtered.SetNum(NumChannels);
+		float MaxError = 0.0f;
+		for (int32 Step = 0; Step < 300; ++Step)
+		{
+			// Uneven frame times
+			const float DeltaTime = Random.FRandRange(1.0f / 90.0f, 1.0f / 30.0f);
+			for (int32 i = 0; i < NumChannels; ++i)
+			{
+				Values[i] = 0.5f + 0.4f * FMath::Sin(Step * 0.05f + i) + Random.FRandRange(-0.05f, 0.05f);
+			}
+			Filter.Apply(Values.GetData(), Filtered.GetData(), DeltaTime);
+			for (int32 i = 0; i < NumChannels; ++i)
+			{
+				MaxError = FMath::Max(MaxError, FMath::Abs(Filtered[i] - References[i].Filter(Values[i], DeltaTime)));
+			}
+		}
+		TestTrue(FString::Printf(TEXT("%d channels should match the reference filter"), NumChannels), MaxError < 1.e-4f);
+	}
+
+	// A step buried in noise: jitter at rest goes down, the step still gets through quickly
+	FOculusXROneEuroFilter Filter(1, FOculusXROneEuroFilterSettings(1.0f, 2.0f, 1.0f));
+	FRandomStream Random(3);
+	double RawJitter = 0.0, FilteredJitter = 0.0;
+	int32 StepFrames = INDEX_NONE;
+	for (int32 Frame = 0; Frame < 144; ++Frame)
+	{
+		const float Target = Frame < 72 ? 0.0f : 1.0f;
+		const float Value = Target + Random.FRandRange(-0.02f, 0.02f);
+		float Filtered;
+		Filter.Apply(&Value, &Filtered, 1.0f / 72.0f);
+		if (Frame >= 36 && Frame < 72)
+		{
+			RawJitter += FMath::Square(Value - Target);
+			FilteredJitter += FMath::Square(Filtered - Target);
+		}
+		if (Frame >= 72 && StepFrames == INDEX_NONE && Filtered > 0.9f)
+		{
+			StepFrames = Frame - 72;
+		}
+	}
+	AddInfo(FString::Printf(TEXT("Jitter at rest %.4f -> %.4f, step reached 90%% after %d frames"), FMath::Sqrt(RawJitter / 36.0), FMath::Sqrt(FilteredJitter / 36.0), StepFrames));
+	TestTrue("Jitter at rest should be reduced", FilteredJitter < RawJitter * 0.3);
+	TestTrue("A fast step should get through within a few frames", StepFrames != INDEX_NONE && StepFrames <= 8);
+
+	// No time going by holds the output
+	const float Value = 0.3f;
+	float Held;
+	Filter.Apply(&Value, &Held, 0.0f);
+	float Next;
+	Filter.Apply(&Value, &Next, 0.0f);
+	TestEqual("A zero time step should hold the output", Held, Next);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOneEuroFilterThroughput, "OculusXRRetargetingTests.FOneEuroFilterThroughput", OneEuroFilterPerfFilters)
+inline bool FOneEuroFilterThroughput::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumChannels = 70;
+	constexpr int32 NumIterations = 20000;
+	FRandomStream Random(1);
+	TArray<float> Values, Filtered;
+	for (int32 i = 0; i < NumChannels; ++i)
+	{
+		Values.Add(Random.FRand());
+	}
+	Filtered.SetNum(NumChannels);
+
+	FOculusXROneEuroFilter Filter(NumChannels);
+	TArray<FOneEuroFilterReference> References;
+	References.SetNum(NumChannels);
+
+	double Checksum = 0.0;
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+	{
+		Values[Iteration % NumChannels] = Random.FRand();
+		for (int32 i = 0; i < NumChannels; ++i)
+		{
+			Filtered[i] = References[i].Filter(Values[i], 1.0f / 72.0f);
+		}
+		Checksum += Filtered[Iteration % NumChannels];
+	}
+	const double ScalarSeconds = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+	{
+		Values[Iteration % NumChannels] = Random.FRand();
+		Filter.Apply(Values.GetData(), Filtered.GetData(), 1.0f / 72.0f);
+		Checksum += Filtered[Iteration % NumChannels];
+	}
+	const double VectorSeconds = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("%d channels: per channel %.1f ns/frame, vectorized %.1f ns/frame (%.1fx), checksum %.1f"),
+		NumChannels, ScalarSeconds * 1.e9 / NumIterations, VectorSeconds * 1.e9 / NumIterations, ScalarSeconds / FMath::Max(VectorSeconds, UE_SMALL_NUMBER), Checksum));
+	TestTrue("The vectorized filter should be faster than filtering channel by channel", VectorSeconds < ScalarSeconds);
+
+	return true;
+}
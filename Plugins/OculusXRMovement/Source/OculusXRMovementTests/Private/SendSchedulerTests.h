@@ -0,0 +1,179 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/AutomationTest.h"
+#include "OculusXRBodyStateCodec.h"
+#include "OculusXRMovementSendScheduler.h"
+#include "OculusXRSyntheticMovementDataProvider.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+#if UE_VERSION_OLDER_THAN(5, 5, 0)
+#define SendSchedulerTestFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#else
+#define SendSchedulerTestFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#endif // UE_VERSION_OLDER_THAN(5, 5, 0)
+
+// These tests check that the send scheduler keeps a crowd of tracked avatars within a connection's budget.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementSendSchedulerDemotion, "OculusXRRetargetingTests.FMovementSendSchedulerDemotion", SendSchedulerTestFilters)
+inline bool FMovementSendSchedulerDemotion::RunTest(const FString& Parameters)
+{
+	const TSharedRef<const FOculusXRTieredBodyStateCodec> Codec = MakeShared<FOculusXRTieredBodyStateCodec>(FOculusXRBodyStateCodecSettings());
+	TestTrue("Dropping fingers should make packets smaller", Codec->GetMaxEncodedBits(EOculusXRBodyFidelityTier::NoFingers) < Codec->GetMaxEncodedBits(EOculusXRBodyFidelityTier::Full));
+	TestTrue("Core joints should make packets smaller still", Codec->GetMaxEncodedBits(EOculusXRBodyFidelityTier::CoreOnly) < Codec->GetMaxEncodedBits(EOculusXRBodyFidelityTier::NoFingers));
+
+	FOculusXRMovementSendSchedulerSettings Settings;
+	TMap<uint32, FOculusXRMovementSendRelevance> Avatars;
+	Avatars.Add(0).Distance = 100.0f;
+	Avatars.Add(1).Distance = 1500.0f;
+
+	// With room to spare, avatars get what their relevance allows
+	Settings.BytesPerSecond = 1024 * 1024;
+	FOculusXRMovementSendScheduler Unconstrained(Codec, Settings);
+	Unconstrained.Schedule(Avatars);
+	TestTrue("A close avatar should be sent in full", Unconstrained.FindDecision(0)->Tier == EOculusXRBodyFidelityTier::Full && Unconstrained.FindDecision(0)->NumDemotions == 0);
+	TestTrue("A far avatar should be sent less often", Unconstrained.FindDecision(1)->SendRate < Unconstrained.FindDecision(0)->SendRate);
+
+	// A tight budget demotes the far avatar first
+	Settings.BytesPerSecond = static_cast<int32>(Unconstrained.GetScheduledBytesPerSecond() * 0.8);
+	FOculusXRMovementSendScheduler Constrained(Codec, Settings);
+	Constrained.Schedule(Avatars);
+	TestTrue("The schedule should fit the budget", Constrained.GetScheduledBytesPerSecond() <= Settings.BytesPerSecond);
+	TestTrue("The far avatar should be demoted first", Constrained.FindDecision(1)->NumDemotions >= Constrained.FindDecision(0)->NumDemotions);
+
+	// Rates are honored without bursts
+	int32 NumSent = 0;
+	for (int32 Frame = 0; Frame < 720; ++Frame)
+	{
+		NumSent += Constrained.ShouldSend(0, Frame / 72.0) ? 1 : 0;
+	}
+	TestTrue("The send rate should be honored", FMath::Abs(NumSent - Constrained.FindDecision(0)->SendRate * 10.0f) <= 2.0f);
+	TestFalse("Unscheduled avatars should not be sent", Constrained.ShouldSend(7, 0.0));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementSendSchedulerCrowd, "OculusXRRetargetingTests.FMovementSendSchedulerCrowd", SendSchedulerTestFilters)
+inline bool FMovementSendSchedulerCrowd::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumAvatars = 64;
+	constexpr int32 FaceBytes = 64;
+	const TSharedRef<const FOculusXRTieredBodyStateCodec> Codec = MakeShared<FOculusXRTieredBodyStateCodec>(FOculusXRBodyStateCodecSettings());
+	FOculusXRMovementSendSchedulerSettings Settings;
+	Settings.RelevanceDistance = 4000.0f;
+	FOculusXRMovementSendScheduler Scheduler(Codec, Settings);
+
+	// A crowd spread from 1m to 33m, half of it in view, a few speakers
+	TArray<TSharedRef<FOculusXRSyntheticMovementDataProvider>> Sources;
+	TMap<uint32, FOculusXRMovementSendRelevance> Avatars;
+	for (int32 i = 0; i < NumAvatars; ++i)
+	{
+		FOculusXRSyntheticMovementSettings SourceSettings;
+		SourceSettings.Seed = i;
+		Sources.Add(MakeShared<FOculusXRSyntheticMovementDataProvider>(SourceSettings));
+		FOculusXRMovementSendRelevance& Relevance = Avatars.Add(i);
+		Relevance.Distance = 100.0f + i * 50.0f;
+		Relevance.bIsInView = i % 2 == 0;
+		Relevance.bIsSpeaking = i % 16 == 3;
+		Relevance.FaceBytes = FaceBytes;
+	}
+	Scheduler.Schedule(Avatars);
+
+	FOculusXRMovementSendSchedulerSettings UnlimitedSettings = Settings;
+	UnlimitedSettings.BytesPerSecond = MAX_int32;
+	FOculusXRMovementSendScheduler Unlimited(Codec, UnlimitedSettings);
+	Unlimited.Schedule(Avatars);
+
+	// Receiver side: the last decoded state of every avatar, held until the next update
+	TArray<FOculusXRBodyState> Received;
+	TArray<bool> bHasReceived;
+	Received.SetNum(NumAvatars);
+	bHasReceived.Init(false, NumAvatars);
+	bool bTiersMatch = true;
+
+	constexpr double Duration = 3.0;
+	int64 NumBytes = 0;
+	int64 NearBytes = 0;
+	int64 FarBytes = 0;
+	FOculusXRBodyStateCodecErrorStats NearStats, FarStats;
+	FOculusXRBodyState BodyState;
+	for (int32 Frame = 0; Frame < Duration * 72.0; ++Frame)
+	{
+		const double Time = Frame / 72.0;
+		for (int32 i = 0; i < NumAvatars; ++i)
+		{
+			if (!Scheduler.ShouldSend(i, Time))
+			{
+				continue;
+			}
+			Sources[i]->SetTime(Time);
+			Sources[i]->GetBodyState(BodyState, 100.0f);
+			FBitWriter Writer(Codec->GetMaxEncodedBits(EOculusXRBodyFidelityTier::Full), false);
+			Scheduler.WriteBodyState(i, BodyState, Writer);
+			const FOculusXRMovementSendDecision* Decision = Scheduler.FindDecision(i);
+			const int64 PacketBytes = Writer.GetNumBytes() + Settings.PacketOverheadBytes + (Decision->bSendFace ? FaceBytes : 0);
+			NumBytes += PacketBytes;
+			if (i < NumAvatars / 4)
+			{
+				NearBytes += PacketBytes;
+			}
+			else if (i >= NumAvatars * 3 / 4)
+			{
+				FarBytes += PacketBytes;
+			}
+
+			FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+			EOculusXRBodyFidelityTier Tier;
+			bHasReceived[i] = Codec->Decode(Reader, Received[i], Tier);
+			bTiersMatch &= bHasReceived[i] && Tier == Decision->Tier;
+		}
+
+		// Pose error of what the receiver shows, every few frames
+		if (Frame % 8 == 0 && Time > 0.5)
+		{
+			for (int32 i = 0; i < NumAvatars; ++i)
+			{
+				const bool bIsNear = i < NumAvatars / 4;
+				if (bHasReceived[i] && (bIsNear || i >= NumAvatars * 3 / 4))
+				{
+					Sources[i]->SetTime(Time);
+					Sources[i]->GetBodyState(BodyState, 100.0f);
+					(bIsNear ? NearStats : FarStats).Add(BodyState, Received[i]);
+				}
+			}
+		}
+	}
+
+	int32 TierCounts[static_cast<int32>(EOculusXRBodyFidelityTier::Frozen) + 1] = {};
+	for (int32 i = 0; i < NumAvatars; ++i)
+	{
+		++TierCounts[static_cast<int32>(Scheduler.FindDecision(i)->Tier)];
+	}
+
+	const double BytesPerSecond = NumBytes / Duration;
+	AddInfo(FString::Printf(TEXT("%.1f KB/s sent for a %.1f KB/s budget (%.1f KB/s unbudgeted), tiers %d full / %d no fingers / %d core / %d frozen"),
+		BytesPerSecond / 1024.0, Settings.BytesPerSecond / 1024.0, Unlimited.GetScheduledBytesPerSecond() / 1024.0,
+		TierCounts[0], TierCounts[1], TierCounts[2], TierCounts[3]));
+	AddInfo(FString::Printf(TEXT("Nearest quarter: %.1f KB/s, %s"), NearBytes / Duration / 1024.0, *NearStats.ToString()));
+	AddInfo(FString::Printf(TEXT("Farthest quarter: %.1f KB/s, %s"), FarBytes / Duration / 1024.0, *FarStats.ToString()));
+
+	TestTrue("Without a budget the crowd should saturate the connection", Unlimited.GetScheduledBytesPerSecond() > Settings.BytesPerSecond);
+	TestTrue("Sent bytes should fit the budget", BytesPerSecond <= Settings.BytesPerSecond * 1.05);
+	TestTrue("Receivers should decode with the tier the sender picked", bTiersMatch);
+	TestTrue("Close avatars should get more of the budget than far ones", NearBytes > FarBytes);
+	if (FarStats.NumJoints > 0)
+	{
+		TestTrue("Close avatars should be more accurate than far ones", NearStats.GetMeanRotationErrorDegrees() < FarStats.GetMeanRotationErrorDegrees());
+	}
+
+	return true;
+}
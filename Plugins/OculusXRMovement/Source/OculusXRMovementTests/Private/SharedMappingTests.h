@@ -0,0 +1,78 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/AutomationTest.h"
+#include "AnimNode_OculusXRBodyTracking.h"
+#include "AnimNode_OculusXRFaceTracking.h"
+#include "OculusXRBodyRemapAsset.h"
+#include "OculusXRFaceRetargetAsset.h"
+
+#if UE_VERSION_OLDER_THAN(5, 5, 0)
+#define SharedMappingTestFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#else
+#define SharedMappingTestFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#endif // UE_VERSION_OLDER_THAN(5, 5, 0)
+
+// These tests check that tracking nodes share their default mapping tables instead of each holding a copy.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSharedBodyRemapping, "OculusXRRetargetingTests.FSharedBodyRemapping", SharedMappingTestFilters)
+inline bool FSharedBodyRemapping::RunTest(const FString& Parameters)
+{
+	const FAnimNode_OculusXRBodyTracking FirstNode;
+	const FAnimNode_OculusXRBodyTracking SecondNode;
+	const TMap<EOculusXRBoneID, FName>& DefaultRemapping = UOculusXRBodyRemapAsset::GetDefaultBoneRemapping();
+	TestTrue("A new node should not hold a remapping of its own", FirstNode.BoneRemapping.IsEmpty());
+	TestEqual("Nodes should share the default remapping", &FirstNode.GetBoneRemapping(), &SecondNode.GetBoneRemapping());
+	TestEqual("The default remapping should be the mannequin's", &FirstNode.GetBoneRemapping(), &DefaultRemapping);
+	TestEqual("The default remapping should list every body joint", DefaultRemapping.Num(), 84);
+	TestEqual("The default remapping should map the hips to the pelvis", DefaultRemapping.FindRef(EOculusXRBoneID::BodyHips), FName("pelvis"));
+
+	// An asset is shared by every node referencing it, and replaces the node's own remapping
+	UOculusXRBodyRemapAsset* Asset = NewObject<UOculusXRBodyRemapAsset>();
+	TestTrue("A new asset should start from the default remapping", Asset->BoneRemapping.OrderIndependentCompareEqual(DefaultRemapping));
+	Asset->BoneRemapping.Add(EOculusXRBoneID::BodyHips, "hips");
+	FAnimNode_OculusXRBodyTracking AssetNode;
+	AssetNode.BoneRemapping.Add(EOculusXRBoneID::BodyHips, "pelvis_override");
+	TestEqual("A node's own remapping should be used without an asset", AssetNode.GetBoneRemapping().FindRef(EOculusXRBoneID::BodyHips), FName("pelvis_override"));
+	AssetNode.RemapAsset = Asset;
+	TestEqual("A node should use its asset's remapping", &AssetNode.GetBoneRemapping(), &Asset->BoneRemapping);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSharedFaceMatrix, "OculusXRRetargetingTests.FSharedFaceMatrix", SharedMappingTestFilters)
+inline bool FSharedFaceMatrix::RunTest(const FString& Parameters)
+{
+	const FAnimNode_OculusXRFaceTracking DefaultNode;
+	TestTrue("A new node should not hold expression names of its own", DefaultNode.ExpressionNames.IsEmpty());
+
+	// The default matrix is compiled once
+	const TSharedRef<const FOculusXRFaceRetargetMatrix> DefaultMatrix = UOculusXRFaceRetargetAsset::GetDefaultMatrix();
+	TestEqual("The default matrix should be shared", &DefaultMatrix.Get(), &UOculusXRFaceRetargetAsset::GetDefaultMatrix().Get());
+	const FOculusXRFaceRetargetMatrix Rebuilt = FOculusXRFaceRetargetMatrix::Build(UOculusXRFaceRetargetAsset::GetDefaultExpressionNames());
+	TestTrue("The default matrix should match the default names", DefaultMatrix->CurveNames == Rebuilt.CurveNames && DefaultMatrix->Columns == Rebuilt.Columns && DefaultMatrix->Values == Rebuilt.Values);
+	TestEqual("Every default expression should drive its own curve", DefaultMatrix->GetNumCurves(), UOculusXRFaceRetargetAsset::GetDefaultExpressionNames().Num());
+
+	// A recompiled asset leaves the matrix nodes already hold untouched
+	UOculusXRFaceRetargetAsset* Asset = NewObject<UOculusXRFaceRetargetAsset>();
+	FOculusXRFaceRetargetCurve& Curve = Asset->Curves.AddDefaulted_GetRef();
+	Curve.CurveName = "jawOpen";
+	Curve.Expressions.AddDefaulted_GetRef().Expression = EOculusXRFaceExpression::JawDrop;
+	Asset->CompileMatrix();
+	const TSharedRef<const FOculusXRFaceRetargetMatrix> HeldMatrix = Asset->GetSharedMatrix();
+	TestEqual("Readers should share the asset's matrix", &HeldMatrix.Get(), &Asset->GetMatrix());
+	Curve.CurveName = "mouthOpen";
+	Asset->CompileMatrix();
+	TestEqual("A held matrix should keep its curves", HeldMatrix->CurveNames[0], FName("jawOpen"));
+	TestEqual("The asset should use the recompiled matrix", Asset->GetMatrix().CurveNames[0], FName("mouthOpen"));
+
+	return true;
+}
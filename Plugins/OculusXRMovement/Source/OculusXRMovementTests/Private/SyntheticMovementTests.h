@@ -0,0 +1,87 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/AutomationTest.h"
+#include "OculusXRSyntheticMovementDataProvider.h"
+
+#if UE_VERSION_OLDER_THAN(5, 5, 0)
+#define SyntheticMovementTestFilters EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#else
+#define SyntheticMovementTestFilters EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::SmokeFilter
+#endif // UE_VERSION_OLDER_THAN(5, 5, 0)
+
+// These tests check that the synthetic provider is deterministic and honors its settings.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSyntheticMovementDeterminism, "OculusXRRetargetingTests.FSyntheticMovementDeterminism", SyntheticMovementTestFilters)
+inline bool FSyntheticMovementDeterminism::RunTest(const FString& Parameters)
+{
+	FOculusXRSyntheticMovementSettings Settings;
+	Settings.Seed = 7;
+	FOculusXRSyntheticMovementDataProvider ProviderA(Settings);
+	FOculusXRSyntheticMovementDataProvider ProviderB(Settings);
+	Settings.Seed = 8;
+	FOculusXRSyntheticMovementDataProvider ProviderC(Settings);
+	ProviderA.SetTime(1.25);
+	ProviderB.SetTime(1.25);
+	ProviderC.SetTime(1.25);
+
+	FOculusXRBodyState BodyStateA, BodyStateB, BodyStateC;
+	TestTrue("Body state should be returned", ProviderA.GetBodyState(BodyStateA, 100.0f));
+	ProviderB.GetBodyState(BodyStateB, 100.0f);
+	ProviderC.GetBodyState(BodyStateC, 100.0f);
+	TestEqual("Every joint should be reported", BodyStateA.Joints.Num(), static_cast<int32>(EOculusXRBoneID::COUNT));
+
+	const int32 HandIdx = static_cast<int32>(EOculusXRBoneID::BodyRightHandWrist);
+	TestEqual("Same seed and time should give the same pose", BodyStateA.Joints[HandIdx].Position, BodyStateB.Joints[HandIdx].Position);
+	TestFalse("Different seeds should give different poses", BodyStateA.Joints[HandIdx].Position.Equals(BodyStateC.Joints[HandIdx].Position));
+
+	const int32 HeadIdx = static_cast<int32>(EOculusXRBoneID::BodyHead);
+	TestTrue("Head should be above the hips", BodyStateA.Joints[HeadIdx].Position.Z > BodyStateA.Joints[static_cast<int32>(EOculusXRBoneID::BodyHips)].Position.Z);
+
+	FOculusXRFaceState FaceStateA, FaceStateB;
+	TestTrue("Face state should be returned", ProviderA.GetFaceState(FaceStateA));
+	ProviderB.GetFaceState(FaceStateB);
+	TestEqual("Every expression should be reported", FaceStateA.ExpressionWeights.Num(), static_cast<int32>(EOculusXRFaceExpression::COUNT));
+	TestTrue("Same seed and time should give the same expressions", FaceStateA.ExpressionWeights == FaceStateB.ExpressionWeights);
+
+	FOculusXREyeGazesState EyeGazesState;
+	TestTrue("Eye gazes should be returned", ProviderA.GetEyeGazesState(EyeGazesState, 100.0f));
+	TestEqual("Both eyes should be reported", EyeGazesState.EyeGazes.Num(), 2);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSyntheticMovementSettings, "OculusXRRetargetingTests.FSyntheticMovementSettings", SyntheticMovementTestFilters)
+inline bool FSyntheticMovementSettings::RunTest(const FString& Parameters)
+{
+	FOculusXRSyntheticMovementSettings Settings;
+	Settings.InvalidJointProbability = 1.0f;
+	Settings.SkeletonChangeInterval = 2.0f;
+	FOculusXRSyntheticMovementDataProvider Provider(Settings);
+
+	FOculusXRBodyState BodyState;
+	Provider.SetTime(1.0);
+	Provider.GetBodyState(BodyState, 100.0f);
+	TestFalse("Joints should all be invalid", BodyState.Joints.ContainsByPredicate([](const auto& Joint) { return Joint.bIsValid; }));
+	TestEqual("First skeleton should be reported", BodyState.SkeletonChangedCount, 1);
+
+	FOculusXRBodySkeleton SkeletonBefore, SkeletonAfter;
+	Provider.GetBodySkeleton(SkeletonBefore, 100.0f);
+	Provider.Advance(2.0);
+	Provider.GetBodyState(BodyState, 100.0f);
+	Provider.GetBodySkeleton(SkeletonAfter, 100.0f);
+	TestEqual("Skeleton should change after the interval", BodyState.SkeletonChangedCount, 2);
+	const int32 HeadIdx = static_cast<int32>(EOculusXRBoneID::BodyHead);
+	TestFalse("Changed skeleton should have different proportions", SkeletonBefore.Bones[HeadIdx].Position.Equals(SkeletonAfter.Bones[HeadIdx].Position));
+	TestTrue("Skeleton parents should be consistent", SkeletonAfter.Bones[static_cast<int32>(EOculusXRBoneID::BodyLeftHandThumbMetacarpal)].ParentBoneIndex == EOculusXRBoneID::BodyLeftHandWrist);
+
+	return true;
+}